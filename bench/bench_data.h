@@ -0,0 +1,120 @@
+#ifndef BENCH_DATA_H
+#define BENCH_DATA_H
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Deterministic synthetic inputs shared by the benchmarks, sized by the benchmark argument
+ */
+namespace BenchData
+{
+    inline constexpr std::array<std::string_view, 8> KANJI_KEYS = {
+        "実験心理学", "食べる", "飲み込む", "見出し", "辞書", "引き出し", "取り扱い", "心理"
+    };
+
+    inline constexpr std::array<std::string_view, 8> KANA_KEYS = {
+        "じっけんしんりがく", "たべる", "のみこむ", "みだし", "じしょ", "ひきだし", "とりあつかい", "しんり"
+    };
+
+    /**
+     * Gets a scratch directory for files written by a benchmark, emptied on every call
+     * @param name Name of the benchmark
+     * @return Path to the empty directory
+     */
+    inline std::filesystem::path getScratchDirectory(const std::string_view name)
+    {
+        const auto directory = std::filesystem::temp_directory_path() / "yomitan_dictionary_benchmarks" / name;
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        return directory;
+    }
+
+    /**
+     * Builds a mixed hiragana/katakana text
+     * @param characters Number of kana in the text
+     * @return UTF-8 text
+     */
+    inline std::string makeKanaText(const size_t characters)
+    {
+        std::string text;
+        text.reserve(characters * 3);
+
+        for (size_t i = 0; i < characters; ++i)
+        {
+            // alternate runs of hiragana (U+3041..) and katakana (U+30A1..)
+            const char32_t base = (i / 16) % 2 == 0 ? U'ぁ' : U'ァ';
+            const char32_t kana = base + static_cast<char32_t>(i % 80);
+            text += static_cast<char>(0xE0 | (kana >> 12));
+            text += static_cast<char>(0x80 | ((kana >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (kana & 0x3F));
+        }
+        return text;
+    }
+
+    /**
+     * Builds the keys of an entry the way the index lists them: kanji spellings and their readings
+     * @param count Number of keys
+     * @return Vector of keys
+     */
+    inline std::vector<std::string> makeEntryKeys(const size_t count)
+    {
+        std::vector<std::string> keys;
+        keys.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto& pool = i % 2 == 0 ? KANJI_KEYS : KANA_KEYS;
+            keys.emplace_back(pool[(i / 2) % pool.size()]);
+        }
+        return keys;
+    }
+
+    /**
+     * Builds a dictionary page with the elements a real page has: headwords, nested sections, links, images and ruby
+     * @param sections Number of meaning sections on the page
+     * @return XML document
+     */
+    inline std::string makePage(const size_t sections)
+    {
+        std::string page = R"(<?xml version="1.0" encoding="UTF-8"?><entry id="00207">)";
+        page += R"(<head><headword class="見出">実験心理学</headword><kana class="reading">じっけんしんりがく</kana></head>)";
+
+        for (size_t i = 0; i < sections; ++i)
+        {
+            const std::string number = std::to_string(i + 1);
+            page += R"(<section class="meaning level-)" + std::to_string(i % 3) + R"(" data-id=")" + number + R"(">)";
+            page += R"(<span class="num">)" + number + "</span>";
+            page += R"(<div class="gloss">人間の<ruby>行動<rt>こうどう</rt></ruby>を<b>実験</b>的に研究する)";
+            page += R"(<a href="00)" + std::to_string(200 + i) + R"(-C001">参照</a>)";
+            page += R"(<a href="00207-400)" + std::to_string(i % 10) + R"(">子項目</a></div>)";
+            page += R"(<img src="graphics/figure)" + number + R"(.png" class="figure"/>)";
+            page += R"(<SubItem id="00207-400)" + std::to_string(i % 10) + R"("><KoKomoku>関連語)" + number + "</KoKomoku></SubItem>";
+            page += "</section>";
+        }
+
+        page += "</entry>";
+        return page;
+    }
+
+    /**
+     * Writes an index in the TSV layout read by IndexReader: key, then the pages it appears on
+     * @param path Path of the index file
+     * @param lines Number of keys
+     */
+    inline void writeIndex(const std::filesystem::path& path, const size_t lines)
+    {
+        std::ofstream index(path, std::ios::out | std::ios::trunc);
+        for (size_t i = 0; i < lines; ++i)
+        {
+            const auto& pool = i % 2 == 0 ? KANJI_KEYS : KANA_KEYS;
+            index << pool[i % pool.size()] << i << '\t' << i / 3 << '\t' << (i / 3 + 1) << '\n';
+        }
+    }
+}
+
+#endif
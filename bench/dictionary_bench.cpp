@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+#include "bench_data.h"
+
+#include "yomitan_dictionary_builder/core/dictionary/yomitan_dictionary.h"
+#include "yomitan_dictionary_builder/index/index_reader.h"
+
+namespace
+{
+    /**
+     * Builds an entry shaped like a converted page: a div with numbered sections of text, ruby and links
+     * @param index Entry number
+     * @param sections Number of sections
+     * @return The dictionary entry
+     */
+    std::unique_ptr<DicEntry> makeEntry(const size_t index, const size_t sections)
+    {
+        const auto& term = BenchData::KANJI_KEYS[index % BenchData::KANJI_KEYS.size()];
+        const auto& reading = BenchData::KANA_KEYS[index % BenchData::KANA_KEYS.size()];
+        auto entry = std::make_unique<DicEntry>(std::string(term), std::string(reading));
+
+        const auto root = std::make_shared<HTMLElement>("div");
+        for (size_t i = 0; i < sections; ++i)
+        {
+            const auto section = std::make_shared<HTMLElement>("div");
+            section->setData({{"meaning", ""}, {"level", std::to_string(i % 3)}});
+            section->addContent(std::make_shared<HTMLElement>("span", std::to_string(i + 1)));
+            section->addContent("人間の行動を実験的に研究する心理学の一分野。");
+
+            const auto ruby = std::make_shared<HTMLElement>("ruby", "行動");
+            ruby->addContent(std::make_shared<HTMLElement>("rt", "こうどう"));
+            section->addContent(ruby);
+
+            const auto link = std::make_shared<HTMLElement>("a", "参照");
+            link->setHref("?query=" + std::string(term) + "&wildcards=off");
+            section->addContent(link);
+
+            root->addContent(section);
+        }
+
+        entry->addElement(root);
+        entry->setSequenceNumber(static_cast<long>(index));
+        return entry;
+    }
+}
+
+
+static void BM_DicEntrySerialization(benchmark::State& state)
+{
+    const auto entry = makeEntry(0, static_cast<size_t>(state.range(0)));
+
+    std::string json;
+    size_t bytes = 0;
+    for (auto _ : state)
+    {
+        json.clear();
+        if (glz::write_json(*entry, json))
+            state.SkipWithError("Failed to serialise entry");
+
+        bytes += json.size();
+        benchmark::DoNotOptimize(json.data());
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_DicEntrySerialization)->RangeMultiplier(4)->Range(1, 256);
+
+
+static void BM_FlushChunkToDisk(benchmark::State& state)
+{
+    const size_t chunkSize = static_cast<size_t>(state.range(0));
+    const bool formatPretty = state.range(1) != 0;
+
+    YomitanDictionaryConfig config;
+    config.title = "benchmark";
+    config.CHUNK_SIZE = chunkSize + 1;
+    config.formatPretty = formatPretty;
+    config.tempDir = BenchData::getScratchDirectory("flush_chunk");
+
+    YomitanDictionary dictionary(config);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (size_t i = 0; i < chunkSize; ++i)
+            dictionary.addEntry(makeEntry(i, 4));
+        state.ResumeTiming();
+
+        // Flushes the pending chunk to a new term bank
+        if (!dictionary.flush())
+            state.SkipWithError("Failed to flush chunk");
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * chunkSize));
+    state.SetLabel(formatPretty ? "pretty" : "minified");
+}
+BENCHMARK(BM_FlushChunkToDisk)->ArgsProduct({{100, 1000, 10000}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+
+static void BM_LoadIndex(benchmark::State& state)
+{
+    const auto directory = BenchData::getScratchDirectory("load_index");
+    const auto indexPath = directory / "index.tsv";
+    BenchData::writeIndex(indexPath, static_cast<size_t>(state.range(0)));
+
+    IndexReader indexReader(indexPath.string());
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(indexReader.loadIndex());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * state.range(0)));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * std::filesystem::file_size(indexPath)));
+}
+BENCHMARK(BM_LoadIndex)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
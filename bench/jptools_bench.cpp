@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+#include "bench_data.h"
+
+#include "yomitan_dictionary_builder/utils/jptools/kana_convert.h"
+#include "yomitan_dictionary_builder/utils/jptools/kanji_utils.h"
+
+
+static void BM_HiraganaToKatakana(benchmark::State& state)
+{
+    const std::string text = BenchData::makeKanaText(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(KanaConvert::hiraganaToKatakana(text));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_HiraganaToKatakana)->RangeMultiplier(8)->Range(8, 32 << 10);
+
+
+static void BM_KatakanaToHiragana(benchmark::State& state)
+{
+    const std::string text = BenchData::makeKanaText(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(KanaConvert::katakanaToHiragana(text));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_KatakanaToHiragana)->RangeMultiplier(8)->Range(8, 32 << 10);
+
+
+static void BM_NormalizeKeys(benchmark::State& state)
+{
+    const auto keys = BenchData::makeEntryKeys(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(KanaConvert::normalizeKeys(keys, "ひらがな"));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * keys.size()));
+}
+BENCHMARK(BM_NormalizeKeys)->RangeMultiplier(4)->Range(2, 256);
+
+
+static void BM_MatchKanaWithKanji(benchmark::State& state)
+{
+    const auto keys = BenchData::makeEntryKeys(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(KanjiUtils::matchKanaWithKanji(keys));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * keys.size()));
+}
+BENCHMARK(BM_MatchKanaWithKanji)->RangeMultiplier(4)->Range(2, 256);
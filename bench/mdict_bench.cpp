@@ -0,0 +1,154 @@
+#include <benchmark/benchmark.h>
+#include "bench_data.h"
+
+#include "yomitan_dictionary_builder/parsers/MDict/mdict_exporter.h"
+#include "yomitan_dictionary_builder/parsers/MDict/mdict_strategies.h"
+#include "yomitan_dictionary_builder/strategies/link/mdict_link_handling_strategy.h"
+
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    /**
+     * Builds hrefs of one of the kinds getNewHref distinguishes
+     * @param kind 0: internal, 1: sub item, 2: audio, 3: appendix
+     * @param count Number of hrefs
+     * @return Vector of hrefs
+     */
+    std::vector<std::string> makeHrefs(const int64_t kind, const size_t count)
+    {
+        std::vector<std::string> hrefs;
+        hrefs.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const std::string page = std::to_string(10000 + i);
+            switch (kind)
+            {
+                case 0: hrefs.emplace_back("0" + page + "-C001"); break;
+                case 1: hrefs.emplace_back("0" + page + "-400" + std::to_string(i % 10)); break;
+                case 2: hrefs.emplace_back("audio/" + page + ".aac"); break;
+                default: hrefs.emplace_back("appendix/KJT-XX-" + page + ".html#section"); break;
+            }
+        }
+        return hrefs;
+    }
+}
+
+
+static void BM_GetNewHref(benchmark::State& state)
+{
+    constexpr std::array<std::string_view, 4> kinds = {"internal", "sub item", "audio", "appendix"};
+
+    MDictConfig dictionaryConfig;
+    dictionaryConfig.appendixLinkIdentifier = "appendix/";
+    const MDictLinkHandlingStrategy strategy(dictionaryConfig);
+
+    const auto hrefs = makeHrefs(state.range(0), 256);
+
+    for (auto _ : state)
+    {
+        for (const auto& href : hrefs)
+        {
+            benchmark::DoNotOptimize(strategy.getNewHref(href));
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * hrefs.size()));
+    state.SetLabel(std::string(kinds[state.range(0)]));
+}
+BENCHMARK(BM_GetNewHref)->DenseRange(0, 3);
+
+
+/**
+ * Rewrites the links and images of a page through the strategies the MDict parser selects,
+ * argument 0 calls them virtually, 1 through their concrete types (staticStrategies)
+ */
+static void BM_MDictStrategies(benchmark::State& state)
+{
+    MDictConfig dictionaryConfig;
+    dictionaryConfig.appendixLinkIdentifier = "appendix/";
+
+    // Created the way the strategy factories do, so the compiler can't see the dynamic type
+    std::unique_ptr<MDictLinkHandlingStrategy> link = std::make_unique<MDictLinkHandlingStrategy>(dictionaryConfig);
+    std::unique_ptr<ImageHandlingStrategy> image = std::make_unique<DefaultImageHandlingStrategy>();
+    benchmark::DoNotOptimize(link.get());
+    benchmark::DoNotOptimize(image.get());
+
+    MDictStrategies strategies = DynamicMDictStrategies{link.get(), image.get()};
+    if (state.range(0) == 1)
+        strategies = std::move(createStaticMDictStrategies(ParserConfig{}, dictionaryConfig).value());
+
+    pugi::xml_document doc;
+    const std::string page = BenchData::makePage(20);
+    doc.load_buffer(page.data(), page.size());
+
+    std::vector<std::string> hrefs;
+    for (const auto kind : {0, 1, 2})
+    {
+        const auto kindHrefs = makeHrefs(kind, 64);
+        hrefs.insert(hrefs.end(), kindHrefs.begin(), kindHrefs.end());
+    }
+
+    for (auto _ : state)
+    {
+        std::visit([&](const auto& current) {
+            for (const auto& href : hrefs)
+            {
+                benchmark::DoNotOptimize(current.getNewHref(href));
+            }
+            current.processAllImageElements(doc);
+        }, strategies);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * hrefs.size()));
+    state.SetLabel(state.range(0) == 0 ? "virtual" : "static");
+}
+BENCHMARK(BM_MDictStrategies)->DenseRange(0, 1);
+
+
+static void BM_WriteKeySection(benchmark::State& state)
+{
+    // The key section is written when the export is finalised, after all the content
+    const size_t entryCount = static_cast<size_t>(state.range(0));
+    const auto directory = BenchData::getScratchDirectory("write_key_section");
+
+    MDictConfig dictionaryConfig;
+    dictionaryConfig.title = "benchmark";
+
+    ParserConfig config;
+    config.outputPath = directory;
+    config.descriptionPath = directory / "description.html";
+
+    const std::string content = BenchData::makePage(1);
+    size_t outputBytes = 0;
+
+    // finalize also looks for the mdict tool (a fixed cost of a few ms) and complains when it's missing
+    std::ostringstream discardedErrors;
+    std::streambuf* errorBuffer = std::cerr.rdbuf(discardedErrors.rdbuf());
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto exporter = std::make_unique<MDictExporter>(dictionaryConfig, config);
+        for (size_t i = 0; i < entryCount; ++i)
+        {
+            exporter->addEntry(MDictEntry(static_cast<long>(i), BenchData::makeEntryKeys(4), content));
+        }
+        state.ResumeTiming();
+
+        exporter->finalize();
+
+        state.PauseTiming();
+        outputBytes += std::filesystem::file_size(directory / "benchmark.txt");
+        exporter.reset();
+        state.ResumeTiming();
+    }
+
+    std::cerr.rdbuf(errorBuffer);
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * entryCount));
+    state.SetBytesProcessed(static_cast<int64_t>(outputBytes));
+}
+BENCHMARK(BM_WriteKeySection)->RangeMultiplier(10)->Range(100, 100000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,119 @@
+#include <benchmark/benchmark.h>
+#include "bench_data.h"
+
+#include "yomitan_dictionary_builder/core/xml_parser.h"
+
+namespace
+{
+    /**
+     * Exposes the conversion functions of XMLParser without a dictionary behind it
+     */
+    class BenchmarkParser final : public XMLParser
+    {
+    public:
+        explicit BenchmarkParser(const ParserConfig& config) : XMLParser(config) {}
+
+        using XMLParser::convertElementToYomitan;
+        using XMLParser::getClassList;
+        using XMLParser::getTargetTag;
+
+    protected:
+        int processFile([[maybe_unused]] FileUtils::PageFile& page) override
+        {
+            return 0;
+        }
+    };
+
+    /**
+     * Writes a tag map with the rules of a real dictionary, padded with unrelated rules
+     * @param path Path of the tag map
+     * @param rules Total number of rules
+     */
+    void writeTagMap(const std::filesystem::path& path, const size_t rules)
+    {
+        std::ofstream tagMap(path, std::ios::out | std::ios::trunc);
+        tagMap << R"({"headword": "span", "section.meaning": "div", "div.gloss": "div", "section span": "span", "SubItem KoKomoku": "span")";
+
+        for (size_t i = 0; i < rules; ++i)
+        {
+            tagMap << R"(, "rule)" << i << ".class" << i << R"(": "span")";
+        }
+        tagMap << "}";
+    }
+
+    ParserConfig makeConfig(const std::filesystem::path& directory, const size_t tagMapRules)
+    {
+        ParserConfig config;
+        config.dictionaryPath = directory / "pages";
+        config.tagMappingPath = directory / "tag_map.json";
+        config.useXmlArena = false;
+        config.readAheadPages = 0;
+
+        std::filesystem::create_directories(config.dictionaryPath);
+        writeTagMap(config.tagMappingPath.value(), tagMapRules);
+        return config;
+    }
+
+    void collectElements(const pugi::xml_node& node, std::vector<pugi::xml_node>& elements)
+    {
+        for (pugi::xml_node child = node.first_child(); child; child = child.next_sibling())
+        {
+            if (child.type() == pugi::node_element)
+            {
+                elements.push_back(child);
+                collectElements(child, elements);
+            }
+        }
+    }
+}
+
+
+static void BM_GetTargetTag(benchmark::State& state)
+{
+    const auto directory = BenchData::getScratchDirectory("get_target_tag");
+    const BenchmarkParser parser(makeConfig(directory, static_cast<size_t>(state.range(0))));
+
+    std::string page = BenchData::makePage(16);
+    pugi::xml_document document;
+    document.load_buffer_inplace(page.data(), page.size());
+
+    std::vector<pugi::xml_node> elements;
+    collectElements(document, elements);
+
+    std::vector<ClassList> classLists;
+    for (const auto& element : elements)
+        classLists.push_back(BenchmarkParser::getClassList(element));
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < elements.size(); ++i)
+        {
+            benchmark::DoNotOptimize(parser.getTargetTag(elements[i].name(), classLists[i], elements[i].parent(), 0));
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements.size()));
+    state.SetLabel(std::to_string(state.range(0)) + " rules");
+}
+BENCHMARK(BM_GetTargetTag)->RangeMultiplier(8)->Range(8, 4096);
+
+
+static void BM_ConvertElementToYomitan(benchmark::State& state)
+{
+    const auto directory = BenchData::getScratchDirectory("convert_element");
+    const BenchmarkParser parser(makeConfig(directory, 64));
+
+    std::string page = BenchData::makePage(static_cast<size_t>(state.range(0)));
+    const size_t pageSize = page.size();
+
+    pugi::xml_document document;
+    document.load_buffer_inplace(page.data(), page.size());
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(parser.convertElementToYomitan(document.document_element()));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * pageSize));
+}
+BENCHMARK(BM_ConvertElementToYomitan)->RangeMultiplier(4)->Range(1, 1024);
@@ -24,6 +24,9 @@ struct ParserConfig
     std::function<std::unique_ptr<ImageHandlingStrategy>()> createImageStrategy;
     std::function<std::unique_ptr<KeyExtractionStrategy>()> createKeyExtractionStrategy;
 
+    // Call the built-in link and image strategies through their concrete types instead of virtually
+    bool staticStrategies = false;
+
     // Paths
     std::filesystem::path dictionaryPath;
     std::optional<std::filesystem::path> tagMappingPath;
@@ -38,6 +41,12 @@ struct ParserConfig
     std::optional<std::filesystem::path> cssDirectory;
     std::optional<std::filesystem::path> descriptionPath;
     std::optional<std::filesystem::path> iconPath;
+    std::optional<std::filesystem::path> cacheDirectory;
+    std::optional<std::filesystem::path> checkpointPath;
+    std::optional<std::filesystem::path> runReportPath;
+    std::optional<std::filesystem::path> tracePath;
+    std::optional<std::filesystem::path> entryStorePath;
+    std::optional<std::filesystem::path> lookupIndexPath;
 
     // Optional features
     std::optional<std::set<std::string>> ignoredElements;
@@ -45,6 +54,28 @@ struct ParserConfig
     bool parseAllLinks = false;
     bool showProgress = false;
     int parsingBatchSize = 250;
+    bool pruneUnreferencedAssets = true;
+    bool useXmlArena = true;
+
+    // Writes the MDict output on a background thread while the next buffer is filled
+    bool writeBehindOutput = true;
+
+    // Read-ahead of upcoming pages (0 pages disables it)
+    size_t readAheadPages = 64;
+    size_t readAheadThreads = 2;
+    size_t readAheadMemoryLimit = 256 * 1024 * 1024; // 256MB
+
+    // Page cache size limit, used when a cacheDirectory is set
+    uint64_t cacheMaxBytes = 1024ULL * 1024 * 1024; // 1GB
+
+    // Pages converted between checkpoints, used when a checkpointPath is set
+    size_t checkpointInterval = 1000;
+
+    // Slowest pages listed in the run report, used when a runReportPath is set
+    size_t runReportSlowestPages = 20;
+
+    // Allocation counts per stage in the run report (complete in YOMITAN_ALLOCATION_PROFILING builds)
+    bool profileAllocations = false;
 
     bool hasAssets() const
     {
@@ -22,7 +22,11 @@ struct YAML::convert<YomitanDictionaryConfig>
         if (node["revision"]) config.revision = node["revision"].as<std::string>();
         if (node["format"]) config.format = node["format"].as<int>();
         if (node["chunk_size"]) config.CHUNK_SIZE = node["chunk_size"].as<long>();
+        if (node["chunk_bytes"]) config.CHUNK_BYTES = node["chunk_bytes"].as<size_t>();
         if (node["formatPretty"]) config.formatPretty = node["formatPretty"].as<bool>();
+        if (node["foldDuplicates"]) config.foldDuplicates = node["foldDuplicates"].as<bool>();
+        if (node["writeBehind"]) config.writeBehind = node["writeBehind"].as<bool>();
+        if (node["lookupIndexPath"]) config.lookupIndexPath = node["lookupIndexPath"].as<std::string>();
         if (node["tempDir"]) config.tempDir = node["tempDir"].as<std::string>();
 
         return true;
@@ -40,6 +44,7 @@ struct YAML::convert<MDictConfig>
         if (node["author"]) config.author = node["author"].as<std::string>();
         if (node["appendixLinkIdentifier"]) config.appendixLinkIdentifier = node["appendixLinkIdentifier"].as<std::string>();
         if (node["subElement"]) config.subElement = node["subElement"].as<std::string>();
+        if (node["deduplicateContent"]) config.deduplicateContent = node["deduplicateContent"].as<bool>();
 
         return true;
     }
@@ -71,6 +76,12 @@ struct YAML::convert<ParserConfig>
         if (node["cssDirectory"]) config.cssDirectory = node["cssDirectory"].as<std::string>();
         if (node["descriptionPath"]) config.descriptionPath = node["descriptionPath"].as<std::string>();
         if (node["iconPath"]) config.iconPath = node["iconPath"].as<std::string>();
+        if (node["cacheDirectory"]) config.cacheDirectory = node["cacheDirectory"].as<std::string>();
+        if (node["checkpointPath"]) config.checkpointPath = node["checkpointPath"].as<std::string>();
+        if (node["runReportPath"]) config.runReportPath = node["runReportPath"].as<std::string>();
+        if (node["tracePath"]) config.tracePath = node["tracePath"].as<std::string>();
+        if (node["entryStorePath"]) config.entryStorePath = node["entryStorePath"].as<std::string>();
+        if (node["lookupIndexPath"]) config.lookupIndexPath = node["lookupIndexPath"].as<std::string>();
 
         // Optional features
         if (node["ignoredElements"] && node["ignoredElements"].IsSequence())
@@ -86,6 +97,17 @@ struct YAML::convert<ParserConfig>
         if (node["parseAllLinks"]) config.parseAllLinks = node["parseAllLinks"].as<bool>();
         if (node["showProgress"]) config.showProgress = node["showProgress"].as<bool>();
         if (node["parsingBatchSize"]) config.parsingBatchSize = node["parsingBatchSize"].as<int>();
+        if (node["pruneUnreferencedAssets"]) config.pruneUnreferencedAssets = node["pruneUnreferencedAssets"].as<bool>();
+        if (node["useXmlArena"]) config.useXmlArena = node["useXmlArena"].as<bool>();
+        if (node["staticStrategies"]) config.staticStrategies = node["staticStrategies"].as<bool>();
+        if (node["writeBehindOutput"]) config.writeBehindOutput = node["writeBehindOutput"].as<bool>();
+        if (node["readAheadPages"]) config.readAheadPages = node["readAheadPages"].as<size_t>();
+        if (node["readAheadThreads"]) config.readAheadThreads = node["readAheadThreads"].as<size_t>();
+        if (node["readAheadMemoryLimit"]) config.readAheadMemoryLimit = node["readAheadMemoryLimit"].as<size_t>();
+        if (node["cacheMaxBytes"]) config.cacheMaxBytes = node["cacheMaxBytes"].as<uint64_t>();
+        if (node["checkpointInterval"]) config.checkpointInterval = node["checkpointInterval"].as<size_t>();
+        if (node["runReportSlowestPages"]) config.runReportSlowestPages = node["runReportSlowestPages"].as<size_t>();
+        if (node["profileAllocations"]) config.profileAllocations = node["profileAllocations"].as<bool>();
 
         return true;
     }
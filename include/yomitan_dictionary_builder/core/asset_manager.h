@@ -1,7 +1,11 @@
 #ifndef ASSET_MANAGER_H
 #define ASSET_MANAGER_H
 
+#include "yomitan_dictionary_builder/core/asset_registry.h"
+
 #include <filesystem>
+#include <string>
+#include <vector>
 
 struct AssetConfig
 {
@@ -31,6 +35,16 @@ struct AssetConfig
 };
 
 
+struct AssetReport
+{
+    size_t copiedFiles = 0;
+    size_t unreferencedFiles = 0;
+    std::uintmax_t copiedBytes = 0;
+    std::uintmax_t skippedBytes = 0;
+    std::vector<std::string> missingFiles;
+};
+
+
 class AssetManager
 {
 public:
@@ -39,8 +53,22 @@ public:
     /**
      * Copy all specified assets to the output directory
      * @param config Asset config specifying what to copy
+     * @param referencedAssets Optional registry of referenced assets, only these are copied from the asset directory
+     */
+    void copyAssets(const AssetConfig& config, const AssetRegistry* referencedAssets = nullptr);
+
+    /**
+     * Copy only the files in a directory that are referenced by the dictionary entries
+     * @param directoryPath Directory to copy from
+     * @param referencedAssets Registry of referenced assets (relative to the directory)
+     */
+    void copyReferencedAssets(const std::filesystem::path& directoryPath, const AssetRegistry& referencedAssets);
+
+    /**
+     * Gets the report of the last referenced asset copy
+     * @return Copied, unreferenced and missing asset statistics
      */
-    void copyAssets(const AssetConfig& config);
+    [[nodiscard]] const AssetReport& getReport() const;
 
     /**
      * Copy entire directory to output directory
@@ -69,6 +97,7 @@ private:
 
     std::filesystem::path outputDirectory;
     bool overWriteExisting = true;
+    AssetReport report;
 };
 
 
@@ -0,0 +1,63 @@
+#ifndef ASSET_REGISTRY_H
+#define ASSET_REGISTRY_H
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Thread-safe set of the asset files (images, audio) referenced by the converted entries
+ */
+class AssetRegistry
+{
+public:
+    AssetRegistry() = default;
+
+    /**
+     * Records an asset referenced by an entry, e.g. 'graphics/filename.png' or 'sound://audio/file.aac'
+     * @param reference The src attribute value or sound:// href
+     */
+    void recordReference(std::string_view reference);
+
+    /**
+     * Gets all the referenced assets
+     * @return Sorted vector of normalised asset paths
+     */
+    [[nodiscard]] std::vector<std::string> getReferences() const;
+
+    /**
+     * Gets the number of distinct referenced assets
+     * @return Number of referenced assets
+     */
+    [[nodiscard]] size_t size() const;
+
+    /**
+     * Starts collecting every reference recorded from now on, e.g. to cache the references of a page.
+     * Meant to be used from the thread converting the page.
+     */
+    void beginCapture();
+
+    /**
+     * Stops collecting references
+     * @return The normalised references recorded since beginCapture
+     */
+    std::vector<std::string> endCapture();
+
+    /**
+     * Normalises an asset reference to a relative path (e.g. "sound://audio/a.aac#t=1" -> "audio/a.aac")
+     * @param reference The reference to normalise
+     * @return Normalised relative path, or an empty string if the reference is not a local asset
+     */
+    static std::string normalizeReference(std::string_view reference);
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_set<std::string> references;
+    std::vector<std::string> capturedReferences;
+    bool capturing = false;
+};
+
+#endif
@@ -2,7 +2,10 @@
 #define BASE_PARSER_H
 
 #include "yomitan_dictionary_builder/config/parser_config.h"
+#include "yomitan_dictionary_builder/core/checkpoint.h"
+#include "yomitan_dictionary_builder/core/page_cache.h"
 #include "yomitan_dictionary_builder/utils/file_utils.h"
+#include "yomitan_dictionary_builder/utils/hash.h"
 #include "indicators.h"
 
 #include <chrono>
@@ -22,11 +25,11 @@ public:
 
 protected:
     /**
-     * Process a single file
-     * @param filePath XML file path
+     * Process a single page
+     * @param page Page file, either on disk or already read from an archive
      * @return Number of entries parsed from file
      */
-    virtual int processFile(const std::filesystem::path& filePath) = 0;
+    virtual int processFile(FileUtils::PageFile& page) = 0;
 
     /**
      * Initialise processing before handling files
@@ -40,23 +43,115 @@ protected:
      */
     virtual void finalizeProcessing() {}
 
+    /**
+     * Whether the parser can record and replay the output of a page through the page cache
+     * Override in derived classes that implement the capture and replay functions
+     */
+    [[nodiscard]] virtual bool supportsPageCache() const { return false; }
+
+    /**
+     * Adds everything in the configuration that affects the converted output to the page cache key
+     * Override in derived classes to add their own configuration
+     * @param hasher The hasher of the cache configuration
+     */
+    virtual void hashCacheConfig(HashUtils::Hasher& hasher) const;
+
+    /**
+     * Starts recording the output of the next page
+     */
+    virtual void beginPageCapture() {}
+
+    /**
+     * Stops recording and writes the output of the page
+     * @param record The record of the page to write to
+     * @return True if the page can be cached
+     */
+    virtual bool endPageCapture([[maybe_unused]] PageRecordWriter& record) { return false; }
+
+    /**
+     * Adds the output of a page from its cached record
+     * Should only add the output once the record has been read completely
+     * @param record The cached record of the page
+     * @return True if the page was replayed
+     */
+    virtual bool replayPage([[maybe_unused]] PageRecordReader& record) { return false; }
+
+    /**
+     * Whether the parser can save its output state to a checkpoint and resume from it
+     * Override in derived classes that implement the checkpoint functions
+     */
+    [[nodiscard]] virtual bool supportsCheckpoint() const { return false; }
+
+    /**
+     * Makes the output written so far durable and records its state in the checkpoint
+     * @param state The checkpoint to fill in
+     * @return True if the output state was saved
+     */
+    virtual bool saveCheckpointState([[maybe_unused]] CheckpointState& state) { return false; }
+
+    /**
+     * Restores the output to a checkpoint before processing starts.
+     * Also called with an empty checkpoint when starting over, to discard any previous output.
+     * @param state The checkpoint to restore
+     * @return True if the output was restored
+     */
+    virtual bool restoreCheckpointState([[maybe_unused]] const CheckpointState& state) { return false; }
+
     ParserConfig config;
     std::unique_ptr<indicators::ProgressBar> pbar;
 private:
 
     /**
      * Parses a batch of files
-     * @param filePaths A vector of files to parse
+     * @param pages A vector of pages to parse
      * @return The number of entries added from the batch processing
      */
-    int processBatch(const std::vector<std::filesystem::path>& filePaths);
+    int processBatch(std::vector<FileUtils::PageFile>& pages);
+
+    /**
+     * Processes a single page, replaying it from the page cache when possible
+     * @param page The page to process
+     * @return Number of entries parsed from the page
+     */
+    int processPage(FileUtils::PageFile& page);
+
+    /**
+     * Writes the stage timings of the run to the configured run report
+     */
+    void writeRunReport() const;
+
+    /**
+     * Writes the timeline of the run to the configured trace file
+     */
+    void writeTrace() const;
+
+    /**
+     * Prints the page cache hit statistics
+     */
+    void printCacheReport() const;
+
+    /**
+     * Loads the checkpoint and skips the pages it already covers, or starts over if it doesn't match
+     * @param configHash Hash of the output configuration
+     */
+    void resumeFromCheckpoint(uint64_t configHash);
+
+    /**
+     * Saves a checkpoint after the last completed batch
+     * @param configHash Hash of the output configuration
+     */
+    void saveCheckpoint(uint64_t configHash);
 
     /**
      * Updates the progress bar with current processing statistics
      */
     void updateProgress() const;
 
-    std::unique_ptr<FileUtils::FileIterator> fileIterator;
+    std::unique_ptr<FileUtils::PageSource> pageSource;
+    std::unique_ptr<PageCache> pageCache;
+    std::unique_ptr<Checkpoint> checkpoint;
+    std::string lastCompletedPage;
+    size_t pagesSinceCheckpoint{0};
     std::chrono::steady_clock::time_point startTime;
     size_t batchSize{1};
     int entriesProcessed{0};
@@ -0,0 +1,96 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <glaze/glaze.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The last durable point of a conversion, everything needed to resume it after a crash
+ */
+struct CheckpointState
+{
+    // Identifies the conversion the checkpoint belongs to
+    std::string builderVersion;
+    uint64_t configHash = 0;
+    std::string dictionaryPath;
+
+    // Pages that are completely converted and written
+    uint64_t pagesCompleted = 0;
+    std::string lastCompletedPage;
+    int64_t entriesProcessed = 0;
+
+    // Yomitan: term banks flushed to the temporary directory
+    std::vector<int> termBanks;
+    uint64_t dictionaryEntries = 0;
+
+    // MDict: bytes written to the content and key files
+    uint64_t contentOffset = 0;
+    uint64_t keyOffset = 0;
+    uint64_t exportedEntries = 0;
+    uint64_t exportedKeys = 0;
+    uint64_t duplicateEntries = 0;
+    uint64_t duplicateBytes = 0;
+    std::vector<std::string> assetReferences;
+};
+
+template<>
+struct glz::meta<CheckpointState>
+{
+    static constexpr auto value = glz::object(
+        "builderVersion", &CheckpointState::builderVersion,
+        "configHash", &CheckpointState::configHash,
+        "dictionaryPath", &CheckpointState::dictionaryPath,
+        "pagesCompleted", &CheckpointState::pagesCompleted,
+        "lastCompletedPage", &CheckpointState::lastCompletedPage,
+        "entriesProcessed", &CheckpointState::entriesProcessed,
+        "termBanks", &CheckpointState::termBanks,
+        "dictionaryEntries", &CheckpointState::dictionaryEntries,
+        "contentOffset", &CheckpointState::contentOffset,
+        "keyOffset", &CheckpointState::keyOffset,
+        "exportedEntries", &CheckpointState::exportedEntries,
+        "exportedKeys", &CheckpointState::exportedKeys,
+        "duplicateEntries", &CheckpointState::duplicateEntries,
+        "duplicateBytes", &CheckpointState::duplicateBytes,
+        "assetReferences", &CheckpointState::assetReferences
+    );
+};
+
+
+/**
+ * @brief Checkpoint manifest on disk, replaced atomically and synced on every save
+ */
+class Checkpoint
+{
+public:
+    explicit Checkpoint(std::filesystem::path manifestPath);
+
+    /**
+     * Loads the last saved checkpoint
+     * @return The checkpoint state, or nullopt if there is none or it can't be read
+     */
+    [[nodiscard]] std::optional<CheckpointState> load() const;
+
+    /**
+     * Saves a checkpoint, only returning once it is durable
+     * @param state The state to save
+     * @return True if the checkpoint was saved
+     */
+    bool save(const CheckpointState& state) const;
+
+    /**
+     * Removes the checkpoint once the conversion completed
+     */
+    void remove() const;
+
+    [[nodiscard]] const std::filesystem::path& getManifestPath() const;
+
+private:
+    std::filesystem::path manifestPath;
+};
+
+#endif
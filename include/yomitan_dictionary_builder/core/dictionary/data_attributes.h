@@ -0,0 +1,96 @@
+#ifndef DATA_ATTRIBUTES_H
+#define DATA_ATTRIBUTES_H
+
+#include "yomitan_dictionary_builder/core/dictionary/symbol_table.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Data attributes of an HTML element, kept in a vector sorted by key
+ *
+ * An element has a handful of attributes, so a flat vector takes a single allocation where a hash
+ * map takes one per attribute plus its buckets. Keys are interned symbols, the order is that of
+ * their names so the attributes are always written in the same order.
+ */
+class DataAttributes
+{
+public:
+    using value_type = std::pair<Symbol, std::string>;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    DataAttributes() = default;
+
+    /**
+     * @param values Key value pairs, a later pair replaces an earlier one with the same key
+     */
+    DataAttributes(const std::initializer_list<std::pair<std::string_view, std::string_view>> values)
+    {
+        attributes.reserve(values.size());
+        for (const auto& [key, value] : values)
+            set(key, value);
+    }
+
+    void reserve(const size_t count)
+    {
+        attributes.reserve(count);
+    }
+
+    /**
+     * Sets the value of an attribute, replacing the value if the key is already set
+     * @param key Attribute key
+     * @param value Attribute value
+     */
+    void set(const std::string_view key, const std::string_view value)
+    {
+        set(Symbol(key), value);
+    }
+
+    void set(const Symbol key, const std::string_view value)
+    {
+        if (const auto it = std::ranges::find(attributes, key, &value_type::first); it != attributes.end())
+        {
+            it->second.assign(value);
+            return;
+        }
+
+        const auto position = std::ranges::lower_bound(attributes, key.view(), {}, [](const value_type& attribute) {
+            return attribute.first.view();
+        });
+        attributes.emplace(position, key, value);
+    }
+
+    /**
+     * Gets the value of an attribute
+     * @param key Attribute key
+     * @return Pointer to the value, or nullptr if the key isn't set
+     */
+    [[nodiscard]] const std::string* find(const std::string_view key) const
+    {
+        const auto symbol = Symbol::find(key);
+        return symbol ? find(symbol.value()) : nullptr;
+    }
+
+    [[nodiscard]] const std::string* find(const Symbol key) const
+    {
+        const auto it = std::ranges::find(attributes, key, &value_type::first);
+        return it != attributes.end() ? &it->second : nullptr;
+    }
+
+    [[nodiscard]] size_t size() const { return attributes.size(); }
+    [[nodiscard]] bool empty() const { return attributes.empty(); }
+
+    [[nodiscard]] const_iterator begin() const { return attributes.begin(); }
+    [[nodiscard]] const_iterator end() const { return attributes.end(); }
+
+    bool operator==(const DataAttributes&) const = default;
+
+private:
+    std::vector<value_type> attributes;
+};
+
+#endif
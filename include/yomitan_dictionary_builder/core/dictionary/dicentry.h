@@ -63,17 +63,35 @@ public:
 	 */
 	void setSequenceNumber(long sequenceNumber);
 
+	/**
+	 * Gets the term of the entry
+	 * @return The term
+	 */
+	const std::string& getTerm() const;
+
+	/**
+	 * Gets the reading of the entry
+	 * @return The reading
+	 */
+	const std::string& getReading() const;
+
+	/**
+	 * Gets the HTML elements making up the entry contents
+	 * @return The elements
+	 */
+	const std::vector<std::shared_ptr<HTMLElement>>& getElements() const;
+
 	/**
 	 * Gets the info tag for the entry
 	 * @return The info tag
 	 */
-	std::string getInfoTag() const;
+	const std::string& getInfoTag() const;
 
 	/**
 	 * Gets the part-of-speech tag for the entry
 	 * @return The part-of-speech tag
 	 */
-	std::string getPosTag() const;
+	const std::string& getPosTag() const;
 
 	/**
 	 * Gets the search rank of the entry (negative values are rarer)
@@ -93,6 +111,18 @@ public:
 	 */
 	[[nodiscard]] DicEntryFormat toList() const;
 
+	/**
+	 * Estimates the size of the entry serialised to term bank JSON
+	 * @return Approximate number of bytes
+	 */
+	[[nodiscard]] size_t estimateSerializedSize() const;
+
+	/**
+	 * Hashes the term, reading, tags, search rank and content of the entry (not the sequence number)
+	 * @return 64-bit hash identifying duplicate entries
+	 */
+	[[nodiscard]] uint64_t getContentHash() const;
+
 	/**
 	 * Prints the full content of the entry in json format
 	 */
@@ -5,11 +5,11 @@
 #include <string>
 #include <vector>
 #include <optional>
-#include <unordered_map>
 #include <variant>
 #include <memory>
 
-#include "html_element.h"
+#include "yomitan_dictionary_builder/core/dictionary/data_attributes.h"
+#include "yomitan_dictionary_builder/utils/hash.h"
 
 class HTMLElement;
 
@@ -25,6 +25,12 @@ public:
      */
     explicit HTMLElement(const std::string&  tag);
 
+    /**
+     * Creates a new HTML element with an interned tag
+     * @param tag The tag symbol
+     */
+    explicit HTMLElement(Symbol tag);
+
     /**
      * Creates a new HTML element with a specified tag name and content
      * @param tag The tag name
@@ -64,10 +70,10 @@ public:
     void setHref(const std::string& value);
 
     /**
-     * Sets the data attributes for the element with a specified data map
-     * @param value The data map
+     * Sets the data attributes for the element
+     * @param value The data attributes
      */
-    void setData(const std::unordered_map<std::string, std::string>& value);
+    void setData(DataAttributes value);
 
 
     /**
@@ -76,6 +82,12 @@ public:
      */
     const std::string& getTag() const;
 
+    /**
+     * Gets the interned HTML tag of the element
+     * @return The tag symbol
+     */
+    Symbol getTagSymbol() const;
+
     /**
      * Gets the content of the element
      * @return The content or nullopt
@@ -89,28 +101,51 @@ public:
     std::optional<std::string> getHref() const;
 
     /**
-     * Gets the data map for the element
-     * @return The data map or nullopt
+     * Gets the data attributes for the element
+     * @return The data attributes or nullopt
+     */
+    const std::optional<DataAttributes>& getData() const;
+
+    /**
+     * Estimates the size of the element serialised to JSON, without walking the serialiser
+     * @return Approximate number of bytes (exact for content without escaped characters)
+     */
+    [[nodiscard]] size_t estimateSerializedSize() const;
+
+    /**
+     * Adds the element and its children to a hash, without serialising them
+     * @param hasher The hasher to update
      */
-    std::optional<std::unordered_map<std::string, std::string>> getData() const;
+    void updateHash(HashUtils::Hasher& hasher) const;
 
     void print();
 
 private:
-    std::string tag;
+    Symbol tag;
     std::optional<std::vector<HTMLElementContent>> content;
     std::optional<std::string> href;
-    std::optional<std::unordered_map<std::string, std::string>> data;
+    std::optional<DataAttributes> data;
 };
 
 template <>
 struct glz::meta<HTMLElement>
 {
+    // Symbols are resolved to their names when written, the data attributes as a single object
     static constexpr auto value = glz::object(
-        "tag", &HTMLElement::tag,
+        "tag", [](const HTMLElement& self) -> std::string_view { return self.getTag(); },
         "content", &HTMLElement::content,
         "href", &HTMLElement::href,
-        "data", &HTMLElement::data
+        "data", [](const HTMLElement& self) {
+            std::optional<std::vector<std::pair<std::string_view, std::string_view>>> data;
+            if (const auto& attributes = self.getData())
+            {
+                data.emplace();
+                data->reserve(attributes->size());
+                for (const auto& [key, value] : *attributes)
+                    data->emplace_back(key.view(), value);
+            }
+            return data;
+        }
     );
 };
 
@@ -0,0 +1,121 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief Interns the tag names and data keys of converted elements
+ *
+ * The same few hundred names repeat on every page, so elements keep a 32-bit symbol instead of
+ * a copy of the name. Names are never removed or moved, which keeps resolved references valid for
+ * the lifetime of the program and lets resolve read without locking. Each thread caches the ids
+ * it has looked up, so interning a known name doesn't lock either. Id 0 is the empty string.
+ */
+class SymbolTable
+{
+public:
+    static SymbolTable& getInstance()
+    {
+        static SymbolTable instance;
+        return instance;
+    }
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    /**
+     * Gets the id of a name, adding the name if it hasn't been seen before
+     * @param name The name
+     * @return Id of the name
+     */
+    uint32_t intern(std::string_view name);
+
+    /**
+     * Gets the id of a name without adding it
+     * @param name The name
+     * @return Id of the name, or nullopt if it was never interned
+     */
+    [[nodiscard]] std::optional<uint32_t> find(std::string_view name) const;
+
+    /**
+     * Gets the name of an id
+     * @param id An id returned by intern
+     * @return The name, valid for the lifetime of the program
+     */
+    [[nodiscard]] const std::string& resolve(const uint32_t id) const
+    {
+        return chunks[id / CHUNK_SIZE][id % CHUNK_SIZE];
+    }
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    static constexpr uint32_t CHUNK_SIZE = 4096;
+    static constexpr uint32_t MAX_CHUNKS = 4096;
+
+    SymbolTable();
+
+    uint32_t insert(std::string_view name);
+
+    mutable std::shared_mutex mutex;
+
+    // Chunks are allocated once and never reallocated, a name is published before its id
+    std::array<std::unique_ptr<std::string[]>, MAX_CHUNKS> chunks;
+    std::atomic<uint32_t> count{0};
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+
+/**
+ * @brief An interned name, compared by its id
+ */
+class Symbol
+{
+public:
+    Symbol() = default;
+
+    /**
+     * @param name The name, interned in the global symbol table
+     */
+    explicit Symbol(const std::string_view name) : id(SymbolTable::getInstance().intern(name)) {}
+
+    /**
+     * Gets the symbol of a name without interning it
+     * @param name The name
+     * @return The symbol, or nullopt if the name was never interned
+     */
+    static std::optional<Symbol> find(const std::string_view name)
+    {
+        if (const auto id = SymbolTable::getInstance().find(name))
+            return fromId(id.value());
+        return std::nullopt;
+    }
+
+    [[nodiscard]] uint32_t getId() const { return id; }
+
+    [[nodiscard]] const std::string& str() const { return SymbolTable::getInstance().resolve(id); }
+
+    [[nodiscard]] std::string_view view() const { return str(); }
+
+    bool operator==(const Symbol&) const = default;
+
+private:
+    static Symbol fromId(const uint32_t id)
+    {
+        Symbol symbol;
+        symbol.id = id;
+        return symbol;
+    }
+
+    uint32_t id = 0;
+};
+
+#endif
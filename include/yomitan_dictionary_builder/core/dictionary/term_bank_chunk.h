@@ -0,0 +1,118 @@
+#ifndef TERM_BANK_CHUNK_H
+#define TERM_BANK_CHUNK_H
+
+#include "yomitan_dictionary_builder/core/dictionary/dicentry.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief A term bank entry whose content is already serialised, e.g. kept in the page cache
+ */
+struct SerializedEntry
+{
+    std::string term;
+    std::string reading;
+    std::string infoTag;
+    std::string posTag;
+    int searchRank = 0;
+    long sequenceNumber = 0;
+
+    // JSON array of the content elements
+    std::string content;
+
+    // Size the entry counts towards the byte limit of a term bank
+    size_t estimatedSize = 0;
+};
+
+
+/**
+ * @brief Entries of a term bank being filled, stored column by column
+ *
+ * The term, reading and tags of all entries share one string buffer, the search ranks and sequence
+ * numbers are kept in arrays and the content of each entry is serialised into a single blob when it is
+ * added, so the element tree can be freed straight away. Writing the term bank walks these buffers in
+ * order, and clearing the chunk keeps them allocated for the next one.
+ */
+class TermBankChunk
+{
+public:
+    TermBankChunk();
+
+    /**
+     * Serialises the content of an entry once, to add it to a chunk later
+     * @param entry The entry
+     * @return The entry with its serialised content
+     */
+    [[nodiscard]] static SerializedEntry serialize(const DicEntry& entry);
+
+    /**
+     * Adds an entry, serialising its content
+     * @param entry The entry to add
+     */
+    void addEntry(const DicEntry& entry);
+
+    /**
+     * Adds an entry whose content is already serialised
+     * @param entry The entry to add
+     */
+    void addEntry(const SerializedEntry& entry);
+
+    /**
+     * Writes the entries as a term bank JSON array, in the order they were added
+     * @param json Buffer the array is written to, replacing its contents
+     */
+    void writeJson(std::string& json) const;
+
+    /**
+     * Appends one entry as a term bank row, the same JSON array writeJson writes for it
+     * @param index Index of the entry
+     * @param json Buffer the row is appended to
+     */
+    void appendEntryJson(size_t index, std::string& json) const;
+
+    /**
+     * Removes all entries, keeping the buffers for the next chunk
+     */
+    void clear();
+
+    [[nodiscard]] size_t size() const;
+
+    [[nodiscard]] bool empty() const;
+
+    [[nodiscard]] std::string_view getTerm(size_t index) const;
+
+    [[nodiscard]] std::string_view getReading(size_t index) const;
+
+private:
+    enum Field : size_t { Term, Reading, InfoTag, PosTag, FieldCount };
+
+    // Serialised the same way as the content member of glz::meta<DicEntry>
+    static void serializeContent(const DicEntry& entry, std::string& json);
+
+    void addFields(std::string_view term, std::string_view reading, std::string_view infoTag, std::string_view posTag,
+                   int searchRank, long sequenceNumber, std::string_view content);
+
+    [[nodiscard]] std::string_view getField(size_t index, Field field) const;
+
+    [[nodiscard]] std::string_view getContent(size_t index) const;
+
+    // FieldCount strings per entry, stringOffsets[i] is where string i starts
+    std::string strings;
+    std::vector<size_t> stringOffsets;
+
+    std::vector<int> searchRanks;
+    std::vector<long> sequenceNumbers;
+
+    std::string contents;
+    std::vector<size_t> contentOffsets;
+
+    // Reused for serialising the content of each entry
+    std::string contentJson;
+
+    // Reused for escaping the strings of the entries written, so a chunk is only written from one thread at a time
+    mutable std::string escapedString;
+};
+
+#endif
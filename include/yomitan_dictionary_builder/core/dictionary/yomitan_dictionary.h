@@ -3,6 +3,11 @@
 #define YOMITAN_DICTIONARY_H
 
 #include "yomitan_dictionary_builder/core/dictionary/dicentry.h"
+#include "yomitan_dictionary_builder/core/dictionary/term_bank_chunk.h"
+#include "yomitan_dictionary_builder/core/lookup_index.h"
+#include "yomitan_dictionary_builder/utils/output_sink.h"
+
+#include <unordered_set>
 
 struct YomitanDictionaryConfig
 {
@@ -19,8 +24,37 @@ struct YomitanDictionaryConfig
 
     // 辞書作成設定
     size_t CHUNK_SIZE = 10'000;
+    // Term banks are flushed at this estimated size (minified JSON) or CHUNK_SIZE entries, whichever comes first (0 disables)
+    size_t CHUNK_BYTES = 32 * 1024 * 1024;
     bool formatPretty = true;
     std::optional<std::filesystem::path> tempDir = std::nullopt;
+
+    // Drops entries identical to an earlier one in term, reading, tags and content
+    bool foldDuplicates = true;
+
+    // Writes a term bank on a background thread while the next chunk is serialised
+    bool writeBehind = true;
+
+    // Writes a lookup index of the entries by term and reading for dictionary_lookupd, each record being a term bank row
+    std::optional<std::filesystem::path> lookupIndexPath = std::nullopt;
+};
+
+/**
+ * @brief Entries dropped as duplicates of earlier entries
+ */
+struct DuplicateStats
+{
+    size_t entries = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * @brief Entries added during a capture, with the content hashes that identify duplicates
+ */
+struct CapturedEntries
+{
+    std::vector<SerializedEntry> entries;
+    std::vector<uint64_t> contentHashes;
 };
 
 class YomitanDictionary
@@ -53,6 +87,39 @@ public:
      */
     bool addEntry(std::unique_ptr<DicEntry>&& entry);
 
+    /**
+     * Adds an entry whose content is already serialised, e.g. replayed from the page cache
+     * @param entry The serialised entry
+     * @param contentHash DicEntry::getContentHash of the entry
+     * @return True if the entry was added successfully
+     */
+    bool addSerializedEntry(SerializedEntry entry, uint64_t contentHash);
+
+    /**
+     * Starts keeping every entry added from now on in serialised form, e.g. to cache the entries of a page
+     */
+    void beginCapture();
+
+    /**
+     * Stops keeping the added entries
+     * @return The entries added since beginCapture in the order they were added, duplicates included
+     */
+    CapturedEntries endCapture();
+
+    /**
+     * Flushes the current chunk and syncs all term banks written so far to disk
+     * @return Numbers of the term banks flushed so far, or nullopt if they could not be synced
+     */
+    std::optional<std::vector<int>> checkpoint();
+
+    /**
+     * Restores the temporary directory to a checkpoint, removing the term banks written after it
+     * @param termBanks Numbers of the term banks flushed at the checkpoint (empty to start over)
+     * @param entryCount Number of entries in those term banks
+     * @return True if all the term banks of the checkpoint are present
+     */
+    bool restoreCheckpoint(const std::vector<int>& termBanks, size_t entryCount);
+
 
     /**
      * Exports the dictionary to the specified path
@@ -73,6 +140,12 @@ public:
      */
     [[nodiscard]] size_t getEntryCount() const;
 
+    /**
+     * Gets the number and estimated size of the entries dropped as duplicates
+     * @return Duplicate statistics
+     */
+    [[nodiscard]] const DuplicateStats& getDuplicateStats() const;
+
     /**
      * Gets the configuration of the dictionary
      * @return Yomitan dictioanry configuration
@@ -90,6 +163,33 @@ private:
     // Flushes the current chunk of entries to disk
     bool flushChunkToDisk();
 
+    // Waits for the term bank still being written, returns false if it couldn't be written
+    bool finishTermBankWrite();
+
+    // Closes the last term bank and stops the term bank writer, returns false if the term bank couldn't be written
+    bool closeTermBankSink();
+
+    // Remembers the content hash of an entry, returns true if an earlier entry had the same hash
+    bool isDuplicate(uint64_t contentHash);
+
+    // File in the temporary directory keeping the content hashes of the checkpointed entries
+    [[nodiscard]] std::filesystem::path getContentHashPath() const;
+
+    // Restores the content hashes of the first entryCount entries from the checkpoint
+    [[nodiscard]] bool restoreContentHashes(size_t entryCount);
+
+    // Adds the entries of the chunk being flushed to a term bank to the lookup index
+    void indexChunkEntries();
+
+    // Whether the current chunk reached its entry or byte limit
+    [[nodiscard]] bool isChunkFull() const;
+
+    // Number of entries waiting in the current chunk
+    [[nodiscard]] size_t getChunkSize() const;
+
+    // Path of a term bank in the temporary directory
+    [[nodiscard]] std::filesystem::path getTermBankPath(int termBankNumber) const;
+
     // Creates and exports the index.json file
     [[nodiscard]] bool exportIndex(std::string_view outputPath) const;
 
@@ -103,9 +203,27 @@ private:
 
     YomitanDictionaryConfig config;
     std::filesystem::path tempDir;
-    std::vector<std::unique_ptr<DicEntry>> currentChunk;
+    TermBankChunk currentChunk;
+    size_t currentChunkBytes = 0;
+    CapturedEntries capturedEntries;
+    bool capturing = false;
+
+    // Only the 8 byte hashes are kept, in order of the entries so a checkpoint can store a prefix of them
+    std::unordered_set<uint64_t> contentHashes;
+    std::vector<uint64_t> uncheckpointedContentHashes;
+    DuplicateStats duplicateStats;
+
+    // Flushed entries by term and reading, written when a lookupIndexPath is set
+    std::unique_ptr<LookupIndexWriter> lookupIndex;
+
     size_t totalEntries = 0;
     int currentTermBankNumber;
+    std::vector<int> flushedTermBanks;
+    std::vector<int> unsyncedTermBanks;
+
+    // Writes the term banks, the last one in the background while the next chunk is filled.
+    // The same sink moves on from term bank to term bank, so its writer thread is started once
+    std::unique_ptr<FileUtils::OutputSink> termBankSink;
 };
 
 struct DictionaryIndex
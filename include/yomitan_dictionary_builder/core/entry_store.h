@@ -0,0 +1,150 @@
+#ifndef ENTRY_STORE_H
+#define ENTRY_STORE_H
+
+#include "yomitan_dictionary_builder/core/dictionary/yomitan_dictionary.h"
+#include "yomitan_dictionary_builder/core/page_cache.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Writes the converted entries of a dictionary to a binary entry store
+ *
+ * The store keeps every entry with the page it came from, so the outputs can be produced again
+ * without reading the XML pages. The layout is a header, the entry records, a table with the
+ * offset of every record and a footer locating the table, all integers little endian:
+ *
+ *   "YDBSTORE" version
+ *   record*        page id, term, reading, tags, rank, sequence number, element trees
+ *   offset*        one per record
+ *   count tableOffset "YDBSTEND"
+ *
+ * The store is written to a temporary file that is renamed once the table has been written.
+ */
+class EntryStoreWriter
+{
+public:
+    /**
+     * @param storePath Path of the store to create
+     */
+    explicit EntryStoreWriter(std::filesystem::path storePath);
+    ~EntryStoreWriter();
+
+    EntryStoreWriter(const EntryStoreWriter&) = delete;
+    EntryStoreWriter& operator=(const EntryStoreWriter&) = delete;
+
+    /**
+     * Appends an entry to the store
+     * @param pageId Page the entry was converted from
+     * @param entry The entry
+     */
+    void append(uint64_t pageId, const DicEntry& entry);
+
+    /**
+     * Appends an entry that is already encoded, e.g. replayed from the page cache
+     * @param pageId Page the entry was converted from
+     * @param encodedEntry The entry encoded by a capture
+     */
+    void appendEncoded(uint64_t pageId, std::string_view encodedEntry);
+
+    /**
+     * Starts keeping the encoding of every entry appended from now on
+     */
+    void beginCapture();
+
+    /**
+     * Stops keeping the encoded entries
+     * @return The entries appended since beginCapture, without their page ids
+     */
+    std::vector<std::string> endCapture();
+
+    /**
+     * Writes the offset table and moves the store into place, nothing can be appended afterwards
+     * @return True if the store was written
+     */
+    bool finish();
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    std::filesystem::path storePath;
+    std::filesystem::path tempPath;
+    std::ofstream file;
+
+    std::vector<uint64_t> offsets;
+    uint64_t offset = 0;
+
+    std::vector<std::string> capturedEntries;
+    bool capturing = false;
+    bool finished = false;
+};
+
+
+/**
+ * @brief Reads the entries of an entry store, mapping the file into memory where supported
+ */
+class EntryStoreReader
+{
+public:
+    struct StoredEntry
+    {
+        uint64_t pageId = 0;
+        std::unique_ptr<DicEntry> entry;
+    };
+
+    /**
+     * Opens a store, throws if the file is missing or not a complete store
+     * @param storePath Path of the store
+     */
+    explicit EntryStoreReader(const std::filesystem::path& storePath);
+    ~EntryStoreReader();
+
+    EntryStoreReader(const EntryStoreReader&) = delete;
+    EntryStoreReader& operator=(const EntryStoreReader&) = delete;
+
+    [[nodiscard]] size_t size() const;
+
+    /**
+     * Decodes an entry of the store
+     * @param index Index of the entry, in the order the entries were appended
+     * @return The entry and its page, or nullopt if the record is corrupt
+     */
+    [[nodiscard]] std::optional<StoredEntry> read(size_t index) const;
+
+    /**
+     * Adds every entry of the store to a Yomitan dictionary
+     * @param dictionary The dictionary to fill
+     * @return True if all entries were added
+     */
+    bool emit(YomitanDictionary& dictionary) const;
+
+    /**
+     * Renders the content of an entry as HTML, data attributes become data-sc-* as in Yomitan
+     * @param entry The entry
+     * @return The HTML of the entry's elements
+     */
+    static std::string renderHtml(const DicEntry& entry);
+
+private:
+    [[nodiscard]] std::string_view getRecord(size_t index) const;
+
+    void unmap();
+
+    // The offset table is read from the mapped file, not copied
+    std::string_view data;
+    size_t entryCount = 0;
+    uint64_t tableOffset = 0;
+
+    // Owns the bytes of data, a memory mapping or a copy of the file
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    std::string buffer;
+};
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef KEY_INDEX_H
+#define KEY_INDEX_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Builds the key section of a lookup index, the keys mapped to entry ids as a double-array trie
+ *
+ * Keys are normalised by folding katakana to hiragana and the trie is built over the bytes of the
+ * normalised keys. A node whose subtree holds a single key is a leaf, the rest of the key is compared
+ * against the stored key instead of being spelled out in nodes, which keeps the array small for
+ * dictionaries where most keys are unique after a few characters. Offsets are relative to the start
+ * of the section and all integers are little endian:
+ *
+ *   "YDBKEYIX" version
+ *   key bytes           normalised keys, then the original keys that differ from them
+ *   (base check)*       int32 pairs, base < 0 marks a leaf holding normalised key -base - 1
+ *   (offset length firstValue)*     uint32 per normalised key in sorted order, then a last row
+ *                                   whose firstValue is the number of values
+ *   (offset length entryId)*        uint32 uint32 uint64 per original key and entry id
+ *   nodeCount nodeTable keyCount keyTable valueCount valueTable "YDBKIEND"
+ *
+ * A child of node s on byte b is base[s] + b + 1 if its check is s, the end of a key uses 0.
+ */
+class KeyIndexWriter
+{
+public:
+    KeyIndexWriter();
+    ~KeyIndexWriter();
+
+    KeyIndexWriter(const KeyIndexWriter&) = delete;
+    KeyIndexWriter& operator=(const KeyIndexWriter&) = delete;
+
+    /**
+     * Adds a key of an entry, the same key and entry are only kept once
+     * @param key The key as exported
+     * @param entryId Id of the entry in the export
+     */
+    void addKey(std::string_view key, uint64_t entryId);
+
+    /**
+     * Builds the trie, nothing can be added afterwards
+     * @param index Buffer the section is written to, replacing its contents
+     * @return True if the section was built
+     */
+    bool build(std::string& index);
+
+    [[nodiscard]] size_t getKeyCount() const;
+
+private:
+    std::vector<std::pair<std::string, uint64_t>> keys;
+    bool finished = false;
+};
+
+
+/**
+ * @brief Looks up the entries of normalised keys and iterates over key prefixes in a key section
+ */
+class KeyIndexReader
+{
+public:
+    struct Match
+    {
+        std::string_view key;
+        uint64_t entryId = 0;
+    };
+
+    /**
+     * Reads a section built by KeyIndexWriter, throws if it is not a complete section
+     * @param index The section, which must outlive the reader
+     */
+    explicit KeyIndexReader(std::string_view index);
+
+    KeyIndexReader(const KeyIndexReader&) = delete;
+    KeyIndexReader& operator=(const KeyIndexReader&) = delete;
+
+    /**
+     * Gets the number of distinct normalised keys
+     */
+    [[nodiscard]] size_t getKeyCount() const;
+
+    /**
+     * Gets the number of keys and entry ids
+     */
+    [[nodiscard]] size_t getValueCount() const;
+
+    /**
+     * Gets a key and entry id in order of the normalised keys, e.g. to sample the keys of the index
+     * @param valueIndex Index of the key and entry id, less than getValueCount
+     * @return The key and entry id
+     */
+    [[nodiscard]] Match getValue(uint32_t valueIndex) const;
+
+    /**
+     * Finds the entries of every key that normalises to the same key, e.g. カタカナ and かたかな
+     * @param key The key
+     * @return The matches with their original keys
+     */
+    [[nodiscard]] std::vector<Match> find(std::string_view key) const;
+
+    /**
+     * Finds the entries of a key as it was exported
+     * @param key The key
+     * @return The matches
+     */
+    [[nodiscard]] std::vector<Match> findExact(std::string_view key) const;
+
+    /**
+     * Visits the keys whose normalised form starts with the normalised prefix, in order of the normalised keys
+     * @param prefix The prefix
+     * @param visit Called per key and entry id, returns false to stop
+     */
+    void forEachPrefix(std::string_view prefix, const std::function<bool(const Match&)>& visit) const;
+
+    /**
+     * Finds the keys whose normalised form starts with the normalised prefix
+     * @param prefix The prefix
+     * @param limit Maximum number of matches
+     * @return The matches, in order of the normalised keys
+     */
+    [[nodiscard]] std::vector<Match> findPrefix(std::string_view prefix, size_t limit = SIZE_MAX) const;
+
+private:
+    // Range of normalised keys starting with a normalised prefix
+    [[nodiscard]] std::pair<uint32_t, uint32_t> findKeyRange(std::string_view prefix) const;
+
+    // Follows the smallest (or largest) child until a leaf, giving the first (or last) key below a node
+    [[nodiscard]] uint32_t findOutermostKey(uint32_t node, bool last) const;
+
+    [[nodiscard]] int32_t getBase(uint32_t node) const;
+
+    [[nodiscard]] int32_t getCheck(uint32_t node) const;
+
+    [[nodiscard]] std::string_view getKey(uint32_t keyIndex) const;
+
+    [[nodiscard]] uint32_t getFirstValue(uint32_t keyIndex) const;
+
+    std::string_view data;
+    uint64_t nodeCount = 0;
+    uint64_t nodeTable = 0;
+    uint64_t keyCount = 0;
+    uint64_t keyTable = 0;
+    uint64_t valueCount = 0;
+    uint64_t valueTable = 0;
+};
+
+#endif
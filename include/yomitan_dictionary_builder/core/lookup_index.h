@@ -0,0 +1,158 @@
+#ifndef LOOKUP_INDEX_H
+#define LOOKUP_INDEX_H
+
+#include "yomitan_dictionary_builder/core/key_index.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Writes the keys and pages of a built dictionary to a lookup index
+ *
+ * The index answers lookups straight from a memory mapping of the file: the page contents come
+ * first, then the keys mapped to record ids as the double-array trie of KeyIndexWriter, so exact,
+ * prefix and kana insensitive lookups all walk the same trie. All integers are little endian:
+ *
+ *   "YDBLOOKP" version
+ *   record*          page contents, one after another
+ *   offset*          start of every record and the end of the last one
+ *   key index        the section built by KeyIndexWriter
+ *   recordCount recordTable keyIndexOffset keyIndexSize "YDBLKEND"
+ *
+ * The index is written to a temporary file that is renamed once the tables have been written.
+ */
+class LookupIndexWriter
+{
+public:
+    /**
+     * @param indexPath Path of the index to create
+     */
+    explicit LookupIndexWriter(std::filesystem::path indexPath);
+    ~LookupIndexWriter();
+
+    LookupIndexWriter(const LookupIndexWriter&) = delete;
+    LookupIndexWriter& operator=(const LookupIndexWriter&) = delete;
+
+    /**
+     * Appends the content of a page
+     * @param content The page content
+     * @return Id of the record, used to add its keys
+     */
+    uint64_t addRecord(std::string_view content);
+
+    /**
+     * Adds a key leading to a record, the same key and record are only kept once
+     * @param key The key
+     * @param recordId Id returned by addRecord
+     */
+    void addKey(std::string_view key, uint64_t recordId);
+
+    /**
+     * Writes the key tables and moves the index into place, nothing can be added afterwards
+     * @return True if the index was written
+     */
+    bool finish();
+
+    [[nodiscard]] size_t getRecordCount() const;
+
+private:
+    std::filesystem::path indexPath;
+    std::filesystem::path tempPath;
+    std::ofstream file;
+
+    std::vector<uint64_t> recordOffsets;
+    uint64_t offset = 0;
+
+    KeyIndexWriter keyIndex;
+    bool finished = false;
+};
+
+
+/**
+ * @brief Answers exact, prefix and kana insensitive lookups from a memory mapped lookup index
+ */
+class LookupIndexReader
+{
+public:
+    struct Match
+    {
+        std::string_view key;
+        uint64_t recordId = 0;
+    };
+
+    /**
+     * Opens an index, throws if the file is missing or not a complete index
+     * @param indexPath Path of the index
+     */
+    explicit LookupIndexReader(const std::filesystem::path& indexPath);
+    ~LookupIndexReader();
+
+    LookupIndexReader(const LookupIndexReader&) = delete;
+    LookupIndexReader& operator=(const LookupIndexReader&) = delete;
+
+    [[nodiscard]] size_t getRecordCount() const;
+
+    [[nodiscard]] size_t getKeyCount() const;
+
+    /**
+     * Gets the content of a record
+     * @param recordId Id of the record
+     * @return The content, empty if there is no such record
+     */
+    [[nodiscard]] std::string_view getRecord(uint64_t recordId) const;
+
+    /**
+     * Gets a key in order of the keys folded to hiragana, e.g. to sample the keys of the index
+     * @param index Index of the key, less than getKeyCount
+     * @return The key and its record
+     */
+    [[nodiscard]] Match getKey(size_t index) const;
+
+    /**
+     * Finds the records of a key
+     * @param key The key
+     * @param limit Maximum number of matches
+     * @return The matches, by record id
+     */
+    [[nodiscard]] std::vector<Match> findExact(std::string_view key, size_t limit = SIZE_MAX) const;
+
+    /**
+     * Finds the keys starting with a prefix
+     * @param prefix The prefix
+     * @param limit Maximum number of matches
+     * @return The matches, in order of the keys folded to hiragana
+     */
+    [[nodiscard]] std::vector<Match> findPrefix(std::string_view prefix, size_t limit) const;
+
+    /**
+     * Finds the keys equal to a key once both are folded to hiragana
+     * @param key The key
+     * @param limit Maximum number of matches
+     * @return The matches with their original keys
+     */
+    [[nodiscard]] std::vector<Match> findKanaInsensitive(std::string_view key, size_t limit = SIZE_MAX) const;
+
+private:
+    [[nodiscard]] uint64_t readAt(size_t position) const;
+
+    void unmap();
+
+    std::string_view data;
+    uint64_t recordCount = 0;
+    uint64_t recordTable = 0;
+
+    // Reads the key section of data
+    std::optional<KeyIndexReader> keyIndex;
+
+    // Owns the bytes of data, a memory mapping or a copy of the file
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    std::string buffer;
+};
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Builds the binary records stored in the page cache
+ */
+class PageRecordWriter
+{
+public:
+    void writeUint64(uint64_t value);
+
+    void writeString(std::string_view value);
+
+    void writeStrings(const std::vector<std::string>& values);
+
+    /**
+     * Takes the written record, leaving the writer empty
+     * @return The record bytes
+     */
+    [[nodiscard]] std::string take();
+
+private:
+    std::string data;
+};
+
+
+/**
+ * @brief Reads the fields of a page cache record in the order they were written
+ */
+class PageRecordReader
+{
+public:
+    explicit PageRecordReader(std::string_view data);
+
+    bool readUint64(uint64_t& value);
+
+    bool readString(std::string& value);
+
+    bool readStrings(std::vector<std::string>& values);
+
+    [[nodiscard]] bool atEnd() const;
+
+private:
+    std::string_view data;
+    size_t offset = 0;
+};
+
+
+/**
+ * @brief Persistent cache of converted pages, so unchanged pages can be replayed instead of reconverted
+ *
+ * Entries are keyed on the hash of the page contents, the hash of everything in the configuration
+ * that affects the output (tag map, index, strategies...) and the builder version.
+ * The least recently used entries are evicted once the cache grows over its size limit.
+ */
+class PageCache
+{
+public:
+    struct CacheStats
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t stored = 0;
+        size_t evicted = 0;
+        uint64_t storedBytes = 0;
+        uint64_t evictedBytes = 0;
+        uint64_t bytesOnDisk = 0;
+    };
+
+    /**
+     * @param cacheDirectory Directory the cache entries are stored in
+     * @param configHash Hash of the configuration affecting the converted output
+     * @param maxBytes Size limit of the cache directory
+     */
+    PageCache(std::filesystem::path cacheDirectory, uint64_t configHash, uint64_t maxBytes);
+
+    /**
+     * Creates the cache key of a page
+     * @param pagePath Path of the page, whose file name the parsers take the page id and keys from
+     * @param pageContents The raw page contents
+     * @return Cache key
+     */
+    [[nodiscard]] std::string makeKey(const std::filesystem::path& pagePath, std::string_view pageContents) const;
+
+    /**
+     * Looks up the record of a page, marking it as recently used
+     * @param key Cache key of the page
+     * @return The cached record, or nullopt on a miss
+     */
+    std::optional<std::string> lookup(const std::string& key);
+
+    /**
+     * Stores the record of a page
+     * @param key Cache key of the page
+     * @param record The record to store
+     * @return True if the record was written
+     */
+    bool store(const std::string& key, std::string_view record);
+
+    /**
+     * Removes the least recently used entries until the cache fits in its size limit
+     */
+    void evict();
+
+    [[nodiscard]] const CacheStats& getStats() const;
+
+    /**
+     * Gets the builder version that is part of every cache key
+     * @return Version string
+     */
+    static std::string_view getBuilderVersion();
+
+private:
+    [[nodiscard]] std::filesystem::path getEntryPath(const std::string& key) const;
+
+    std::filesystem::path cacheDirectory;
+    uint64_t configHash;
+    uint64_t maxBytes;
+    CacheStats stats;
+};
+
+#endif
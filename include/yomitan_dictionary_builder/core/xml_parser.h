@@ -5,7 +5,10 @@
 #include "yomitan_dictionary_builder/core/dictionary/yomitan_dictionary.h"
 #include "yomitan_dictionary_builder/index/index_reader.h"
 
+#include <array>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include <vector>
 
@@ -13,6 +16,43 @@ const std::unordered_set<std::string_view> ignoredAttributes = {
     "rel", "http-equiv", "xmlns", "hmhtml", "content", "media", "alt", "rowspan"
 };
 
+
+/**
+ * @brief Class names of an element, as views into its class attribute
+ *
+ * Up to INLINE_CLASSES names are kept without allocating. The views are only valid while the
+ * document is, and keep the names as written (XMLParser::appendClassName gives the key form).
+ */
+class ClassList
+{
+public:
+    static constexpr size_t INLINE_CLASSES = 8;
+
+    ClassList() = default;
+
+    /**
+     * Splits a class attribute on whitespace
+     * @param classValue Value of the class attribute
+     */
+    explicit ClassList(std::string_view classValue);
+
+    [[nodiscard]] std::span<const std::string_view> getClasses() const
+    {
+        return overflow.empty() ? std::span<const std::string_view>(inlineClasses.data(), count) : std::span<const std::string_view>(overflow);
+    }
+
+    [[nodiscard]] auto begin() const { return getClasses().begin(); }
+    [[nodiscard]] auto end() const { return getClasses().end(); }
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+
+private:
+    std::array<std::string_view, INLINE_CLASSES> inlineClasses{};
+    std::vector<std::string_view> overflow;
+    size_t count = 0;
+};
+
+
 class XMLParser : public BaseParser
 {
 public:
@@ -29,9 +69,9 @@ protected:
      * @param recursionDepth Current recursion depth
      * @return Target tag from tag mapping if found, otherwise 'span'
      */
-    [[nodiscard]] std::string getTargetTag(
+    [[nodiscard]] Symbol getTargetTag(
         const std::string& tagName,
-        const std::optional<std::vector<std::string>>& classList = std::nullopt,
+        const ClassList& classList = ClassList(),
         const std::optional<pugi::xml_node>& parent = std::nullopt,
         std::optional<int> recursionDepth = std::nullopt
     ) const;
@@ -39,16 +79,23 @@ protected:
     /**
      * Gets the class list for an XML element
      * @param node The XML element node
-     * @return Vector of classes
+     * @return Views of the classes, empty if the element has none
+     */
+    static ClassList getClassList(const pugi::xml_node& node);
+
+    /**
+     * Appends a class name the way it is used in tag mapping selectors and data keys ('-' becomes '_')
+     * @param out String to append to
+     * @param className The class name
      */
-    static std::optional<std::vector<std::string>> getClassList(const pugi::xml_node& node);
+    static void appendClassName(std::string& out, std::string_view className);
 
     /**
      * Gets the data attributes for an XML element
      * @param node The XMl element node
-     * @return Map of data string attributes
+     * @return Data attributes, with room for the classes of the element
      */
-    static std::unordered_map<std::string, std::string> getAttributeData(const pugi::xml_node& node);
+    static DataAttributes getAttributeData(const pugi::xml_node& node);
 
     /**
      * Recursively converts XML structure to Yomitan compatible format
@@ -66,7 +113,7 @@ protected:
      */
     static std::string getElementText(const pugi::xml_node& node, const std::optional<std::set<std::string>>& ignoredElements = std::nullopt);
 
-    std::unique_ptr<IndexReader> indexReader;
+    std::shared_ptr<IndexReader> indexReader;
 
 private:
     /**
@@ -75,7 +122,8 @@ private:
      */
     void loadTagMapping(const std::filesystem::path& filePath);
 
-    std::unordered_map<std::string, std::string> tagMapping;
+    // Selectors to their target tags, interned when the mapping is loaded
+    std::unordered_map<std::string, Symbol> tagMapping;
     bool hasParentSelectors = false;
 };
 
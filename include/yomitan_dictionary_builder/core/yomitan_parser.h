@@ -3,12 +3,17 @@
 
 #include "yomitan_dictionary_builder/core/dictionary/yomitan_dictionary.h"
 #include "yomitan_dictionary_builder/config/parser_config.h"
+#include "yomitan_dictionary_builder/core/entry_store.h"
 #include "yomitan_dictionary_builder/core/xml_parser.h"
 #include "yomitan_dictionary_builder/utils/file_utils.h"
 
+class DualTargetParser;
+
 class YomitanParser : public XMLParser
 {
 public:
+    friend class DualTargetParser;
+
     explicit YomitanParser(std::unique_ptr<YomitanDictionary> dictionary, const ParserConfig& parserConfig);
 
     ~YomitanParser() override;
@@ -46,6 +51,21 @@ public:
 
 protected:
 
+    /**
+     * Loads the page and converts it with processDocument
+     * @param page The XML page, on disk or read from an archive
+     * @return Number of entries added
+     */
+    int processFile(FileUtils::PageFile& page) override;
+
+    /**
+     * Converts the entries of a loaded page, without modifying the document
+     * @param page The XML page
+     * @param doc The loaded document of the page
+     * @return Number of entries added
+     */
+    virtual int processDocument(FileUtils::PageFile& page, const pugi::xml_document& doc) = 0;
+
     /**
      * Get part-of-speech tags for a term
      * @param term Term to get tags for
@@ -53,9 +73,49 @@ protected:
      */
     std::pair<std::string, std::string> getPartOfSpeechTags(std::string_view term);
 
+    /**
+     * Opens the entry store when an entryStorePath is configured
+     */
+    void initializeProcessing() override;
+
+    /**
+     * Completes the entry store
+     */
+    void finalizeProcessing() override;
+
+    [[nodiscard]] bool supportsPageCache() const override;
+
+    void hashCacheConfig(HashUtils::Hasher& hasher) const override;
+
+    /**
+     * Captures the serialised entries added for the page
+     */
+    void beginPageCapture() override;
+
+    bool endPageCapture(PageRecordWriter& record) override;
+
+    bool replayPage(PageRecordReader& record) override;
+
+    /**
+     * Checkpoints are not supported while writing an entry store, the store cannot be resumed
+     */
+    [[nodiscard]] bool supportsCheckpoint() const override;
+
+    /**
+     * Flushes and syncs the term banks written so far
+     */
+    bool saveCheckpointState(CheckpointState& state) override;
+
+    bool restoreCheckpointState(const CheckpointState& state) override;
+
 private:
 
     std::unique_ptr<YomitanDictionary> dictionary;
+    std::unique_ptr<EntryStoreWriter> entryStore;
+
+    // Page the converted entries are stored under in the entry store
+    uint64_t pageIndex = 0;
+    uint64_t pagesConverted = 0;
 };
 
 
@@ -1,6 +1,7 @@
 #ifndef INDEX_READER_H
 #define INDEX_READER_H
 
+#include <memory>
 #include <string_view>
 #include <vector>
 #include <unordered_map>
@@ -15,6 +16,14 @@ public:
      */
     explicit IndexReader(std::string_view indexPath);
 
+    /**
+     * Gets the index at a path, sharing it with every other user that still holds it
+     * (e.g. both targets of a DualTargetParser), so it is only loaded once
+     * @param indexPath Path to dictionary index
+     * @return The shared index
+     */
+    static std::shared_ptr<IndexReader> openShared(std::string_view indexPath);
+
     /**
      * Loads the index file and creates 'filename' -> 'keys' mapping
      * @return True if successful
@@ -0,0 +1,189 @@
+#ifndef LOOKUP_SERVER_H
+#define LOOKUP_SERVER_H
+
+#include "yomitan_dictionary_builder/core/lookup_index.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Lookup
+{
+    enum class Mode
+    {
+        Exact,
+        Prefix,
+        Kana
+    };
+
+    struct Request
+    {
+        Mode mode = Mode::Exact;
+        std::string key;
+        size_t limit = 0;
+    };
+
+    // Results of a prefix lookup when no limit is given, and the most any lookup returns
+    constexpr size_t DEFAULT_PREFIX_LIMIT = 50;
+    constexpr size_t MAX_LIMIT = 1000;
+
+    /**
+     * Parses a lookup mode
+     * @param name "exact", "prefix" or "kana"
+     * @return The mode, or nullopt if the name is unknown
+     */
+    std::optional<Mode> parseMode(std::string_view name);
+
+    /**
+     * Decodes a percent encoded URL component, '+' becomes a space
+     * @param text The encoded text
+     * @return The decoded text, or nullopt if an escape is malformed
+     */
+    std::optional<std::string> decodeUrlComponent(std::string_view text);
+
+
+    /**
+     * @brief Serves lookups on a lookup index over a Unix socket and local HTTP
+     *
+     * The socket protocol is line based, a request is "<exact|prefix|kana> <key>[\t<limit>]\n" and the
+     * response "OK <count>\n" followed by "<key>\t<record>\t<length>\n<content>\n" per match, or
+     * "ERR <message>\n". HTTP answers GET /lookup?q=<key>&mode=<mode>&limit=<limit> with JSON.
+     * Every connection is served by its own thread, the index is only read so it isn't locked.
+     */
+    class Server
+    {
+    public:
+        /**
+         * @param index The index to serve, must outlive the server
+         */
+        explicit Server(const LookupIndexReader& index);
+        ~Server();
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        /**
+         * Answers a request of the socket protocol
+         * @param line The request line, without the newline
+         * @return The response
+         */
+        [[nodiscard]] std::string handleLine(std::string_view line) const;
+
+        /**
+         * Answers an HTTP request
+         * @param requestHead Request line and headers
+         * @param keepAlive Set to whether the connection stays open afterwards
+         * @return The response, headers included
+         */
+        [[nodiscard]] std::string handleHttp(std::string_view requestHead, bool& keepAlive) const;
+
+        /**
+         * Starts listening on a Unix socket, replacing a stale socket file
+         * @param socketPath Path of the socket
+         * @return True if the socket is listening
+         */
+        bool listenUnix(const std::filesystem::path& socketPath);
+
+        /**
+         * Starts listening for HTTP on the loopback interface
+         * @param port TCP port, 0 picks a free one
+         * @return True if the port is listening
+         */
+        bool listenHttp(uint16_t port);
+
+        /**
+         * Gets the port HTTP is served on
+         * @return The port, 0 if HTTP isn't served
+         */
+        [[nodiscard]] uint16_t getHttpPort() const;
+
+        /**
+         * Accepts connections until stop is called, then closes all connections
+         */
+        void run();
+
+        /**
+         * Makes run return, safe to call from a signal handler
+         */
+        void stop();
+
+    private:
+        void serveLines(int fd) const;
+
+        void serveHttp(int fd) const;
+
+        [[nodiscard]] std::vector<LookupIndexReader::Match> lookup(const Request& request) const;
+
+        void reapConnectionThreads();
+
+        void closeConnections();
+
+        const LookupIndexReader& index;
+
+        int unixListener = -1;
+        int httpListener = -1;
+        uint16_t httpPort = 0;
+        std::filesystem::path socketPath;
+
+        // Written by stop to wake up the accept loop
+        int wakePipe[2] = {-1, -1};
+        std::atomic<bool> stopping = false;
+
+        std::mutex connectionsMutex;
+        std::set<int> connections;
+        std::vector<std::thread> connectionThreads;
+        std::vector<std::thread::id> finishedThreads;
+    };
+
+
+    /**
+     * @brief Client of the socket protocol, e.g. for load generation
+     */
+    class Client
+    {
+    public:
+        struct Response
+        {
+            bool ok = false;
+            std::string error;
+            std::vector<std::pair<std::string, std::string>> matches;
+        };
+
+        /**
+         * Connects to a server, throws if the socket can't be connected
+         * @param socketPath Path of the server's socket
+         */
+        explicit Client(const std::filesystem::path& socketPath);
+        ~Client();
+
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+
+        /**
+         * Sends a request and waits for its response
+         * @param mode Lookup mode
+         * @param key The key
+         * @param limit Maximum number of matches, 0 for the server's default
+         * @return The response, or nullopt if the connection failed
+         */
+        std::optional<Response> lookup(Mode mode, std::string_view key, size_t limit = 0);
+
+    private:
+        bool readLine(std::string& line);
+
+        bool readBytes(size_t count, std::string& bytes);
+
+        int fd = -1;
+        std::string buffer;
+        size_t bufferStart = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef DUAL_TARGET_PARSER_H
+#define DUAL_TARGET_PARSER_H
+
+#include "yomitan_dictionary_builder/core/yomitan_parser.h"
+#include "yomitan_dictionary_builder/parsers/MDict/mdict_parser.h"
+
+/**
+ * @brief Builds the Yomitan dictionary and the MDict of a dictionary in a single pass over its pages
+ *
+ * Every page is loaded once and handed to both targets, the Yomitan target first since the MDict
+ * target rewrites links and images in the document. Each target keeps its own strategies, and
+ * both share the dictionary index.
+ */
+class DualTargetParser final : public BaseParser
+{
+public:
+    /**
+     * @param yomitanTarget Parser producing the Yomitan dictionary, e.g. from ParserRegistry
+     * @param mdictTarget Parser producing the MDict
+     * @param config Parser configuration, the dictionary path the pages are read from
+     */
+    DualTargetParser(std::unique_ptr<YomitanParser> yomitanTarget, std::unique_ptr<MdictParser> mdictTarget, const ParserConfig& config);
+
+    /**
+     * Export the Yomitan dictionary, the MDict is exported when parsing finishes
+     * @param outputPath Path to export the dictionary to
+     * @return true if export was successful
+     */
+    [[nodiscard]] bool exportYomitanDictionary(std::string_view outputPath) const;
+
+protected:
+    /**
+     * Converts a page for both targets
+     * @param page The XML page, on disk or read from an archive
+     * @return Number of Yomitan entries added
+     */
+    int processFile(FileUtils::PageFile& page) override;
+
+    void initializeProcessing() override;
+
+    void finalizeProcessing() override;
+
+private:
+    std::unique_ptr<YomitanParser> yomitanTarget;
+    std::unique_ptr<MdictParser> mdictTarget;
+};
+
+#endif
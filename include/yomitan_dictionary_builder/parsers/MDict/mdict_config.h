@@ -11,6 +11,9 @@ struct MDictConfig
     std::string appendixLinkIdentifier;
     std::string subElement;
 
+    // Writes byte-identical page content once and links the later pages to it
+    bool deduplicateContent = true;
+
     AssetConfig assets;
 };
 
@@ -2,12 +2,20 @@
 #define MDICT_EXPORTER_H
 
 #include "yomitan_dictionary_builder/config/parser_config.h"
+#include "yomitan_dictionary_builder/core/entry_store.h"
+#include "yomitan_dictionary_builder/core/lookup_index.h"
 #include "yomitan_dictionary_builder/parsers/MDict/mdict_config.h"
+#include "yomitan_dictionary_builder/utils/output_sink.h"
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+/**
+ * @brief A page of the MDict output, only moved so its content is never copied on the way to the exporter
+ */
 struct MDictEntry
 {
     long pageId;
@@ -16,35 +24,193 @@ struct MDictEntry
 
     MDictEntry(const long id, std::vector<std::string> k, std::string c)
         : pageId(id), keys(std::move(k)), content(std::move(c)) {}
+
+    MDictEntry(const MDictEntry&) = delete;
+    MDictEntry& operator=(const MDictEntry&) = delete;
+    MDictEntry(MDictEntry&&) noexcept = default;
+    MDictEntry& operator=(MDictEntry&&) noexcept = default;
 };
 
 class MDictExporter
 {
 public:
+    struct ExportStats
+    {
+        size_t totalEntries = 0;
+        size_t totalKeys = 0;
+
+        // Pages whose content matched an earlier page and were written as a link to it
+        size_t duplicateEntries = 0;
+        uint64_t duplicateBytes = 0;
+    };
+
+    /**
+     * @brief Durable write position of the exporter, used to resume an interrupted export
+     */
+    struct ExportCheckpoint
+    {
+        uint64_t contentOffset = 0;
+        uint64_t keyOffset = 0;
+        ExportStats stats;
+    };
+
     explicit MDictExporter(MDictConfig& dictionaryConfig, ParserConfig& config);
+
+    /**
+     * Creates the exporter resuming an interrupted export
+     * @param dictionaryConfig MDict dictionary configuration
+     * @param config Parser configuration
+     * @param resumeFrom Checkpoint to resume from, the output files are truncated to its offsets
+     */
+    MDictExporter(MDictConfig& dictionaryConfig, ParserConfig& config, const ExportCheckpoint& resumeFrom);
     ~MDictExporter();
 
-    void addEntry(const MDictEntry& entry);
+    /**
+     * Adds an entry, the entry is kept without a copy while capturing
+     * @param entry The entry
+     */
+    void addEntry(MDictEntry&& entry);
+
+    /**
+     * Adds an entry whose content is only read while it is added, it is copied only while capturing
+     * @param pageId Page id of the entry
+     * @param keys Keys of the entry
+     * @param content Content of the entry
+     */
+    void addEntry(long pageId, std::vector<std::string> keys, std::string_view content);
+
+    /**
+     * Adds the entries of an entry store, the entries of a page become one entry keyed on their terms and readings
+     * @param store The entry store
+     */
+    void addStoredEntries(const EntryStoreReader& store);
 
     void finalize();
 
-    struct ExportStats
+    [[nodiscard]] ExportStats exportStats() const;
+
+    /**
+     * Flushes everything added so far and syncs it to disk
+     * @return The checkpoint to resume from
+     */
+    ExportCheckpoint checkpoint();
+
+    /**
+     * Check if the output files of an interrupted export are still there to resume from
+     * @param dictionaryConfig MDict dictionary configuration
+     * @param config Parser configuration
+     * @param resumeFrom The checkpoint to resume from
+     * @return True if both output files are at least as long as the checkpoint offsets
+     */
+    static bool canResume(const MDictConfig& dictionaryConfig, const ParserConfig& config, const ExportCheckpoint& resumeFrom);
+
+    /**
+     * Sets the directory that is packed into the MDD file (defaults to the configured asset directory)
+     * @param directoryPath Directory containing the assets to pack
+     */
+    void setMddSourceDirectory(const std::filesystem::path& directoryPath);
+
+    /**
+     * Starts keeping a copy of every entry added from now on, e.g. to cache the entries of a page
+     */
+    void beginCapture();
+
+    /**
+     * Stops keeping copies of added entries
+     * @return The entries added since beginCapture
+     */
+    std::vector<MDictEntry> endCapture();
+
+private:
+    /**
+     * @brief Where the content of a page written in full is in the content file
+     */
+    struct ContentPage
     {
-        size_t totalEntries = 0;
-        size_t totalKeys = 0;
+        long pageId;
+        uint64_t offset;
+        uint64_t size;
     };
 
-    [[nodiscard]] ExportStats exportStats() const;
+    static std::filesystem::path getContentFilePath(const std::filesystem::path& outputDirectory, const std::string& title);
 
-private:
-    void writeContentSection();
+    static std::filesystem::path getKeyFilePath(const std::filesystem::path& outputDirectory, const std::string& title);
+
+    /**
+     * Opens an output file, truncating it to the given offset
+     * @param filePath Path to the file
+     * @param offset Number of bytes to keep
+     * @return The sink writing the file
+     */
+    [[nodiscard]] std::unique_ptr<FileUtils::OutputSink> openOutputFile(const std::filesystem::path& filePath, uint64_t offset) const;
+
+    /**
+     * Writes the content and keys of an entry
+     * @param pageId Page id of the entry
+     * @param keys Keys of the entry
+     * @param content Content of the entry
+     */
+    void writeEntry(long pageId, const std::vector<std::string>& keys, std::string_view content);
+
+    /**
+     * Appends the content record of an entry, or a link to an earlier page with the same content
+     * @param pageId Page id of the entry
+     * @param content Content of the entry
+     * @return The page whose content the entry shows, the entry's own page unless it was linked
+     */
+    long appendContent(long pageId, std::string_view content);
+
+    /**
+     * Adds the keys of an entry to the lookup index, with the content of the page it shows stored once per page.
+     * The keys of a link page wait until the page it links to is added
+     * @param entryPageId Page id of the entry
+     * @param content Content of the entry
+     * @param contentPageId Page whose content the entry shows
+     * @param keys The keys of the entry as exported
+     */
+    void addLookupKeys(long entryPageId, std::string_view content, long contentPageId, std::vector<std::string> keys);
 
+    /**
+     * Appends a content record to the buffer
+     * @param pageId Page id of the record
+     * @param content Content of the record
+     * @return Offset of the content in the content file
+     */
+    uint64_t appendRecord(long pageId, std::string_view content);
+
+    /**
+     * Compares a page written in full with new content, reading the page back once it has left the buffer
+     * @param page The page written in full
+     * @param content The new content
+     * @return True if the page has the same content
+     */
+    bool hasContent(const ContentPage& page, std::string_view content);
+
+    /**
+     * Rebuilds the content hashes of the pages written before the checkpoint that is resumed from
+     * @param offset Length of the content section at the checkpoint
+     */
+    void restoreContentHashes(uint64_t offset);
+
+    /**
+     * Appends the hiragana and katakana keys of an entry to the key section
+     * @param entryPageId Page id of the entry
+     * @param rawKeys Keys of the entry
+     * @param lookupKeys Receives the appended keys when not null
+     */
+    void appendKeys(long entryPageId, const std::vector<std::string>& rawKeys, std::vector<std::string>* lookupKeys);
+
+    /**
+     * Appends the key section (kept in its own file while entries are added) after the content section
+     */
     void writeKeySection();
 
     void writeTitleFile() const;
 
     void flushBuffer();
 
+    void flushKeyBuffer();
+
     void runMdictConvert() const;
 
     MDictConfig& dictionaryConfig;
@@ -52,10 +218,33 @@ private:
 
     std::filesystem::path outputDirectory;
     std::filesystem::path outputTxtFile;
-    std::unique_ptr<std::ofstream> outputFile;
+    std::filesystem::path keyTxtFile;
+    std::filesystem::path mddSourceDirectory;
+    std::unique_ptr<FileUtils::OutputSink> outputFile;
+    std::unique_ptr<FileUtils::OutputSink> keyFile;
+
+    std::vector<MDictEntry> capturedEntries;
+    bool capturing = false;
+
+    // Keys and page contents for dictionary_lookupd, written when a lookupIndexPath is set
+    std::unique_ptr<LookupIndexWriter> lookupIndex;
+    std::unordered_map<long, uint64_t> lookupRecords;
+
+    // Keys of link pages added before the page they link to, keyed on that page
+    std::unordered_map<long, std::vector<std::string>> pendingLookupKeys;
+
+    // Every page written in full by content hash, a matching hash is only a candidate until the bytes are compared
+    std::unordered_multimap<uint64_t, ContentPage> contentPages;
+
+    // Reads pages back from the content file to compare them
+    std::ifstream contentReader;
+    std::string storedContent;
 
-    std::vector<MDictEntry> entries;
+    // Content and key records are streamed to disk as entries are added
     std::string buffer;
+    std::string keyBuffer;
+    uint64_t contentOffset = 0;
+    uint64_t keyOffset = 0;
 
     static constexpr size_t BUFFER_SIZE_LIMIT = 1 * 1024 * 1024; // 1MB
     static constexpr size_t MAX_BUFFER_SIZE = 2 * 1024 * 1024; // 2MB
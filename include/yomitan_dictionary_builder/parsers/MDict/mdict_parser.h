@@ -8,37 +8,83 @@
 #include "yomitan_dictionary_builder/parsers/MDict/mdict_config.h"
 #include "yomitan_dictionary_builder/parsers/MDict/subitem_processor.h"
 #include "yomitan_dictionary_builder/parsers/MDict/mdict_exporter.h"
+#include "yomitan_dictionary_builder/parsers/MDict/mdict_strategies.h"
 #include "yomitan_dictionary_builder/core/asset_manager.h"
+#include "yomitan_dictionary_builder/core/asset_registry.h"
+
+class DualTargetParser;
 
 class MdictParser final : public XMLParser
 {
 public:
+    friend class DualTargetParser;
+
     explicit MdictParser(const ParserConfig& config, const MDictConfig& dictionaryConfig);
     ~MdictParser() override;
 
 protected:
     /**
      * Process a single MDict XML file
-     * @param filePath Path to the XML file
+     * @param page The XML page, on disk or read from an archive
      * @return Number of keys added to the entry
      */
-    int processFile(const std::filesystem::path &filePath) override;
+    int processFile(FileUtils::PageFile& page) override;
+
+    /**
+     * Converts a loaded page, rewriting its links and images and removing its sub items in place
+     * @param page The XML page
+     * @param doc The loaded document of the page
+     * @return Number of keys added to the entry
+     */
+    int processDocument(const FileUtils::PageFile& page, pugi::xml_document& doc);
+
+    [[nodiscard]] bool supportsPageCache() const override;
+
+    void hashCacheConfig(HashUtils::Hasher& hasher) const override;
+
+    /**
+     * Captures the entries and asset references of the page
+     */
+    void beginPageCapture() override;
+
+    bool endPageCapture(PageRecordWriter& record) override;
+
+    bool replayPage(PageRecordReader& record) override;
+
+    [[nodiscard]] bool supportsCheckpoint() const override;
+
+    bool saveCheckpointState(CheckpointState& state) override;
+
+    /**
+     * Keeps the exporter offsets for initializeProcessing and restores the recorded asset references
+     */
+    bool restoreCheckpointState(const CheckpointState& state) override;
 
 private:
+    /**
+     * Rewrites the links and images of a page with the given strategies
+     * @param xmlDoc XML document
+     * @param strategies One of the MDictStrategies alternatives
+     */
+    template<typename Strategies>
+    static void rewriteReferences(const pugi::xml_document& xmlDoc, const Strategies& strategies);
+
     /**
      * Traverses the whole XML document and fixes link elements so that
      * they work in the converted MDict by adding entry://href_value
      * @param xmlDoc XML document
+     * @param strategies Strategies providing getNewHref
      */
-    void processAllLinkElements(const pugi::xml_document& xmlDoc) const;
+    template<typename Strategies>
+    static void processAllLinkElements(const pugi::xml_document& xmlDoc, const Strategies& strategies);
 
 
     /**
      * Get raw XML content as string
      * @param xmlDoc XML document
-     * @return Raw XML as string
+     * @return Raw XML, valid until the next call on this thread
      */
-    static std::string getXMLContent(const pugi::xml_document& xmlDoc);
+    static std::string_view getXMLContent(const pugi::xml_document& xmlDoc);
 
 
     /**
@@ -52,6 +98,12 @@ private:
      */
     void finalizeProcessing() override;
 
+
+    /**
+     * Prints the referenced asset copy statistics
+     */
+    void printAssetReport() const;
+
     MDictConfig dictionaryConfig;
     std::unique_ptr<JukugoIndexReader> jukugoIndexReader;
 
@@ -59,9 +111,14 @@ private:
     std::unique_ptr<MDictLinkHandlingStrategy> linkHandlingStrategy;
     std::unique_ptr<ImageHandlingStrategy> imageHandlingStrategy;
 
+    // Strategies used for links and images, selected once from the configuration
+    MDictStrategies strategies;
+
     std::unique_ptr<SubItemProcessor> subItemProcessor;
     std::unique_ptr<MDictExporter> exporter;
+    MDictExporter::ExportCheckpoint exportResumePoint;
     std::unique_ptr<AssetManager> assetManager;
+    std::unique_ptr<AssetRegistry> assetRegistry;
 };
 
 
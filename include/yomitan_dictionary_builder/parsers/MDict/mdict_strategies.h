@@ -0,0 +1,92 @@
+#ifndef MDICT_STRATEGIES_H
+#define MDICT_STRATEGIES_H
+
+#include "yomitan_dictionary_builder/config/parser_config.h"
+#include "yomitan_dictionary_builder/strategies/image/hashed_image_strategy.h"
+#include "yomitan_dictionary_builder/strategies/image/image_handling_strategy.h"
+#include "yomitan_dictionary_builder/strategies/link/mdict_link_handling_strategy.h"
+#include "yomitan_dictionary_builder/strategies/link/nds_link_extraction_strategy.h"
+
+#include <memory>
+#include <optional>
+#include <variant>
+
+/**
+ * @brief The link and image strategies of an MDict conversion, called through their base classes
+ *
+ * Works with any strategy registered in the strategy factories.
+ */
+struct DynamicMDictStrategies
+{
+    MDictLinkHandlingStrategy* link = nullptr;
+    ImageHandlingStrategy* image = nullptr;
+
+    [[nodiscard]] std::string getNewHref(const std::string& href) const
+    {
+        return link->getNewHref(href);
+    }
+
+    void processAllImageElements(const pugi::xml_document& xmlDoc) const
+    {
+        if (image)
+            image->processAllImageElements(xmlDoc);
+    }
+
+    void setAssetRegistry(AssetRegistry* registry)
+    {
+        link->setAssetRegistry(registry);
+        if (image)
+            image->setAssetRegistry(registry);
+    }
+};
+
+
+/**
+ * @brief The link and image strategies of an MDict conversion with their concrete types known
+ *
+ * The per-node calls name the concrete strategy, so the compiler can inline them instead of
+ * dispatching through the vtable for every link and image.
+ */
+template<typename LinkStrategy, typename ImageStrategy>
+struct StaticMDictStrategies
+{
+    std::unique_ptr<LinkStrategy> link;
+    std::unique_ptr<ImageStrategy> image;
+
+    [[nodiscard]] std::string getNewHref(const std::string& href) const
+    {
+        // Qualified call, the strategy was created with exactly this type
+        return link->LinkStrategy::getNewHref(href);
+    }
+
+    void processAllImageElements(const pugi::xml_document& xmlDoc) const
+    {
+        image->template processAllImageElementsAs<ImageStrategy>(xmlDoc);
+    }
+
+    void setAssetRegistry(AssetRegistry* registry)
+    {
+        link->setAssetRegistry(registry);
+        image->setAssetRegistry(registry);
+    }
+};
+
+
+using MDictStrategies = std::variant<
+    DynamicMDictStrategies,
+    StaticMDictStrategies<MDictLinkHandlingStrategy, DefaultImageHandlingStrategy>,
+    StaticMDictStrategies<MDictLinkHandlingStrategy, HashedImageStrategy>,
+    StaticMDictStrategies<NDSLinkExtractionStrategy, DefaultImageHandlingStrategy>,
+    StaticMDictStrategies<NDSLinkExtractionStrategy, HashedImageStrategy>
+>;
+
+
+/**
+ * Creates the statically typed strategies named by the parser configuration
+ * @param config Parser configuration, the mdictLinkStrategy and imageStrategyType are used
+ * @param dictionaryConfig The MDict config, must outlive the strategies
+ * @return The strategies, or nullopt if a strategy is not one of the built-in ones
+ */
+std::optional<MDictStrategies> createStaticMDictStrategies(const ParserConfig& config, const MDictConfig& dictionaryConfig);
+
+#endif
@@ -7,6 +7,7 @@
 
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct SubItemShell
@@ -19,27 +20,58 @@ struct SubItemShell
         : shellPrefix(std::move(prefix)), shellSuffix(std::move(suffix)) {}
 };
 
+/**
+ * @brief Splits the sub items of a page into their own entries
+ *
+ * The page is serialised once. Marker nodes placed around the sub items and the removed sub item
+ * groups record where they end up in the output, the sub item entries are built from those slices
+ * and the page content from the rest, so nothing is serialised twice.
+ */
 class SubItemProcessor
 {
 public:
 
     explicit SubItemProcessor(MDictConfig  dictionaryConfig);
 
-    int processSubItems(
+    /**
+     * Marks the sub items that have jukugo keys and the sub item groups to leave out of the page
+     * @param xmlDoc The page, marker nodes are added to it
+     * @param keys Jukugo keys of the page by item id
+     * @param pageId The page id
+     * @return Number of sub items that will get an entry
+     */
+    int markSubItems(
         const pugi::xml_document& xmlDoc,
-        std::unordered_map<int, std::vector<std::string>>& keys,
-        int pageId,
-        MDictExporter& mdictExporter);
+        const std::unordered_map<int, std::vector<std::string>>& keys,
+        int pageId);
+
+    /**
+     * Adds an entry for every marked sub item and assembles the page content without the marked groups
+     * @param serializedPage The marked page, serialised
+     * @param mdictExporter Exporter receiving the sub item entries
+     * @return The page content without markers, the serialised page itself when it has none, otherwise valid until the next call
+     */
+    std::string_view extractSubItems(std::string_view serializedPage, MDictExporter& mdictExporter);
 
 private:
-    void createSubItemShell(const pugi::xml_node& subItemNode);
+    struct PendingSubItem
+    {
+        long entryId;
+        std::vector<std::string> keys;
+    };
 
-    [[nodiscard]] std::string wrapContent(const pugi::xml_node& subItemNode) const;
+    void createSubItemShell(const pugi::xml_node& subItemNode);
 
     MDictConfig dictionaryConfig;
     /*EntryWriter& entryWriter;*/
     bool shellConstructed = false;
     SubItemShell subItemShell;
+
+    // Sub items marked on the current page, in document order
+    std::vector<PendingSubItem> pendingSubItems;
+
+    // Page content of pages with markers, reused from page to page
+    std::string content;
 };
 
 #endif
@@ -11,7 +11,8 @@ namespace YDP
 
         using ::YomitanParser::YomitanParser;
 
-        int processFile(const std::filesystem::path &filePath) override;
+    protected:
+        int processDocument(FileUtils::PageFile& page, const pugi::xml_document& doc) override;
 
     private:
         static std::string extractHeadword(const pugi::xml_node &node);
@@ -20,8 +20,6 @@ public:
      */
     [[nodiscard]] bool loadImageMap();
 
-protected:
-
     void processImageElement(const pugi::xml_node &xmlNode) const override;
 
 private:
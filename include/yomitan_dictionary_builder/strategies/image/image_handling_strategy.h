@@ -2,8 +2,13 @@
 #define IMAGE_HANDLING_STRATEGY_H
 
 #include "pugixml.h"
+#include "yomitan_dictionary_builder/core/asset_registry.h"
 
+#include <filesystem>
+#include <iostream>
 #include <optional>
+#include <set>
+#include <type_traits>
 
 class ImageHandlingStrategy
 {
@@ -18,9 +23,73 @@ public:
      */
     void processAllImageElements(const pugi::xml_document& xmlDoc) const;
 
+    /**
+     * Same as processAllImageElements, but calls processImageElement of the concrete strategy
+     * directly so it can be inlined instead of going through the vtable for every element
+     *
+     * @tparam Strategy The dynamic type of this strategy, with a public processImageElement
+     * @param xmlDoc XML document
+     */
+    template<typename Strategy>
+    void processAllImageElementsAs(const pugi::xml_document& xmlDoc) const
+    {
+        static_assert(std::is_base_of_v<ImageHandlingStrategy, Strategy> && std::is_final_v<Strategy>);
+
+        const auto& strategy = static_cast<const Strategy&>(*this);
+        forEachImageElement(xmlDoc, [&strategy](const pugi::xml_node& node) {
+            strategy.Strategy::processImageElement(node);
+        });
+    }
+
+    /**
+     * Sets the registry that records every image source path left in the processed documents
+     *
+     * @param registry Asset registry (not owned), or nullptr to disable recording
+     */
+    void setAssetRegistry(AssetRegistry* registry);
+
 
 protected:
 
+    /**
+     * Calls processElement once for every element with a src attribute, recording the resulting sources
+     *
+     * @param xmlDoc XML document
+     * @param processElement Rewrites the source of an element
+     */
+    template<typename ProcessElement>
+    void forEachImageElement(const pugi::xml_document& xmlDoc, ProcessElement&& processElement) const
+    {
+        try
+        {
+            // Use a set to track processed nodes and avoid duplicates
+            std::set<pugi::xml_node> processedNodes;
+
+            // Process all elements with src attributes
+            for (const auto imgNodes = xmlDoc.select_nodes("//*[@src]"); auto imgNode : imgNodes)
+            {
+                pugi::xml_node node = imgNode.node();
+
+                // Skip if already processed
+                if (processedNodes.contains(node))
+                    continue;
+
+                processElement(node);
+                processedNodes.insert(node);
+
+                if (assetRegistry)
+                {
+                    if (const auto srcAttr = node.attribute("src"))
+                        assetRegistry->recordReference(srcAttr.value());
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error processing image elements: " << e.what() << std::endl;
+        }
+    }
+
     /**
      * Processes a single image element
      *
@@ -37,8 +106,17 @@ protected:
      */
     static std::optional<std::filesystem::path> getImagePath(const pugi::xml_node& xmlNode);
 
+    AssetRegistry* assetRegistry = nullptr;
 };
 
-// TODO: add default handler
+
+class DefaultImageHandlingStrategy final : public ImageHandlingStrategy
+{
+public:
+    void processImageElement([[maybe_unused]] const pugi::xml_node& xmlNode) const override
+    {
+        // keep the original source paths
+    }
+};
 
 #endif
@@ -2,6 +2,7 @@
 #define MDICT_LINK_HANDLING_STRATEGY_H
 
 #include "yomitan_dictionary_builder/parsers/MDict/mdict_config.h"
+#include "yomitan_dictionary_builder/core/asset_registry.h"
 #include <regex>
 
 static const std::regex pageIdRegex{R"((\d+))"};
@@ -40,6 +41,12 @@ public:
      */
     static std::string extractItemId(const std::string& href);
 
+    /**
+     * Sets the registry that records every sound:// target produced by the strategy
+     * @param registry Asset registry (not owned), or nullptr to disable recording
+     */
+    void setAssetRegistry(AssetRegistry* registry);
+
 protected:
     /**
      * Gets the correct href for sub item entry. Prepends '80' to avoid collisions
@@ -50,6 +57,7 @@ protected:
     static std::string getSubItemHref(const std::string& href);
 
     const MDictConfig& dictionaryConfig;
+    AssetRegistry* assetRegistry = nullptr;
 
 private:
     /**
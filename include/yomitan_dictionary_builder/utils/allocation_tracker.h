@@ -0,0 +1,70 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Profiling
+{
+    /**
+     * @brief Counts allocations per pipeline stage into the thread's StageProfiler
+     *
+     * pugixml allocations are counted through its memory management hooks (installed by XMLLoader),
+     * everything else only in builds configured with YOMITAN_ALLOCATION_PROFILING, which replaces the
+     * global operator new. While tracking is disabled the hooks cost a single relaxed load.
+     */
+    class AllocationTracker
+    {
+    public:
+        /**
+         * Enables or disables allocation counting for all threads
+         * @param isEnabled Whether to count allocations
+         */
+        static void setEnabled(bool isEnabled);
+
+        static bool isEnabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Whether this build replaces the global operator new
+         * @return True if operator new allocations are counted
+         */
+        static bool isSupported();
+
+        /**
+         * Counts an operator new allocation towards the active stage of the calling thread
+         * @param bytes Size of the allocation
+         */
+        static void recordAllocation(const size_t bytes)
+        {
+            if (isEnabled())
+                record(bytes, false);
+        }
+
+        /**
+         * Counts a pugixml allocation towards the active stage of the calling thread
+         * @param bytes Size of the allocation
+         */
+        static void recordPugiAllocation(const size_t bytes)
+        {
+            if (isEnabled())
+                record(bytes, true);
+        }
+
+        /**
+         * Gets the peak resident set size of the process
+         * @return Peak RSS in bytes, or 0 where unavailable
+         */
+        static uint64_t getPeakResidentBytes();
+
+    private:
+        static void record(size_t bytes, bool fromPugi);
+
+        static inline std::atomic<bool> enabled{false};
+    };
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef ARCHIVE_ITERATOR_H
+#define ARCHIVE_ITERATOR_H
+
+#include "yomitan_dictionary_builder/utils/file_utils.h"
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+
+namespace FileUtils
+{
+    /**
+     * @brief Reads the members of an archive one after the other
+     */
+    class ArchiveReader
+    {
+    public:
+        virtual ~ArchiveReader() = default;
+
+        /**
+         * Reads the next XML member of the archive
+         * @return The page with its contents, or nullopt at the end of the archive
+         */
+        virtual std::optional<PageFile> next() = 0;
+    };
+
+
+    /**
+     * @brief Iterates the XML pages stored in a .zip, .tar, .tar.gz or .tgz archive,
+     * decompressing the members sequentially instead of requiring them to be extracted
+     */
+    class ArchiveIterator final : public PageSource
+    {
+    public:
+        explicit ArchiveIterator(const std::filesystem::path& archivePath);
+        ~ArchiveIterator() override;
+
+        std::vector<PageFile> getNextBatch(size_t batchSize) override;
+
+        [[nodiscard]] bool hasMore() const override;
+
+        [[nodiscard]] size_t getTotalFilesCount() const override;
+
+        /**
+         * Check if a path is a supported archive
+         * @param path The path to check
+         * @return True if the path is a .zip, .tar, .tar.gz or .tgz file
+         */
+        static bool isArchive(const std::filesystem::path& path);
+
+    private:
+        std::unique_ptr<ArchiveReader> reader;
+        std::optional<PageFile> nextPage;
+        // Only known for zip archives, whose central directory lists the members
+        size_t totalFiles = 0;
+    };
+
+
+    /**
+     * Opens the page source for a dictionary path, either a directory of XML files or an archive
+     * @param dictionaryPath Directory or archive path
+     * @return The page source
+     */
+    std::unique_ptr<PageSource> openPageSource(const std::filesystem::path& dictionaryPath);
+}
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef CORPUS_GENERATOR_H
+#define CORPUS_GENERATOR_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings of a synthetic dictionary corpus
+ */
+struct CorpusOptions
+{
+    std::filesystem::path outputDirectory;
+    std::string title = "合成辞典";
+    size_t pageCount = 10'000;
+    uint64_t seed = 1;
+
+    // Page shape
+    size_t maxSections = 6;
+    size_t maxSubItems = 4;
+    double imageRate = 0.3;
+    double audioRate = 0.1;
+
+    // Distinct images referenced by the pages
+    size_t imageCount = 500;
+
+    // Whether to write placeholder files for the referenced images and audio
+    bool writeAssets = true;
+};
+
+
+/**
+ * @brief Generates a synthetic dictionary in the layout of the real inputs, so conversions can be
+ * benchmarked and tested at any scale without the proprietary dictionaries.
+ *
+ * Written to the output directory:
+ *  pages/0000000001.xml       pages with headwords, meanings, ruby, links, images, audio and SubItem/KoKomoku groups
+ *  index/index_d.tsv          key -> page
+ *  index/jyukugo_prefix.tsv   sub item key -> page-item
+ *  tag_map.json, image_map.json, assets/, description.html
+ *  corpus.yaml                a dictionaries config converting the corpus
+ *
+ * The corpus only depends on the options, the same seed always produces the same files.
+ */
+class CorpusGenerator
+{
+public:
+    struct CorpusStats
+    {
+        size_t pages = 0;
+        size_t indexKeys = 0;
+        size_t subItems = 0;
+        size_t imageReferences = 0;
+        size_t audioReferences = 0;
+        uint64_t pageBytes = 0;
+    };
+
+    explicit CorpusGenerator(CorpusOptions options);
+
+    /**
+     * Generates the corpus, replacing the pages of a previous corpus in the output directory
+     * @return True if all the files were written
+     */
+    bool generate();
+
+    [[nodiscard]] const CorpusStats& getStats() const;
+
+    /**
+     * Gets the file name of a page (e.g. 207 -> "0000000207.xml")
+     * @param pageId The page number
+     * @return The file name
+     */
+    static std::string getPageFilename(uint64_t pageId);
+
+private:
+    struct Headword
+    {
+        std::string term;
+        std::string reading;
+    };
+
+    Headword makeHeadword(size_t minKanji, size_t maxKanji);
+
+    std::string makePage(uint64_t pageId, const Headword& headword, const std::vector<Headword>& subItems);
+
+    /**
+     * Appends a sentence with ruby, emphasis and links to other pages
+     */
+    void appendSentence(std::string& page, uint64_t pageId);
+
+    void writeIndexKeys(const Headword& headword, const std::string& target, std::ofstream& index);
+
+    bool writeTagMap() const;
+
+    bool writeImageMap() const;
+
+    bool writeAssets() const;
+
+    bool writeConfig() const;
+
+    [[nodiscard]] std::string getImageName(size_t image) const;
+
+    [[nodiscard]] static std::string getHashedImageName(size_t image);
+
+    [[nodiscard]] static std::string getAudioName(uint64_t pageId);
+
+    // Deterministic on every platform, unlike the standard distributions
+    uint64_t nextRandom();
+
+    size_t nextBelow(size_t bound);
+
+    bool chance(double probability);
+
+    CorpusOptions options;
+    uint64_t randomState;
+    std::vector<uint64_t> audioPages;
+    CorpusStats stats;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef FILE_SYNC_H
+#define FILE_SYNC_H
+
+#include <filesystem>
+#include <string_view>
+
+namespace FileUtils
+{
+    /**
+     * Flushes the contents of a file to stable storage (fsync)
+     * @param filePath Path to the file
+     * @return True if the file was synced
+     */
+    bool syncFile(const std::filesystem::path& filePath);
+
+    /**
+     * Flushes a directory entry list to stable storage, making renames and new files in it durable
+     * @param directoryPath Path to the directory
+     * @return True if the directory was synced
+     */
+    bool syncDirectory(const std::filesystem::path& directoryPath);
+
+    /**
+     * Atomically replaces a file with new contents: the contents are written to a temporary file,
+     * synced, and renamed over the target, so readers see either the old or the new file
+     * @param filePath Path to the file
+     * @param contents The new contents
+     * @return True if the file was replaced
+     */
+    bool writeFileAtomically(const std::filesystem::path& filePath, std::string_view contents);
+}
+
+#endif
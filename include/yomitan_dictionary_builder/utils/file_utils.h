@@ -1,6 +1,7 @@
 #ifndef FILE_UTILS_H
 #define FILE_UTILS_H
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <optional>
@@ -12,10 +13,68 @@
 
 namespace FileUtils
 {
+    /**
+     * @brief A dictionary page, either still on disk or already read into memory
+     */
+    struct PageFile
+    {
+        // file path, or the member name for pages read from an archive
+        std::filesystem::path path;
+        std::string contents;
+        bool loaded = false;
+
+        PageFile() = default;
+        explicit PageFile(std::filesystem::path path) : path(std::move(path)) {}
+        PageFile(std::filesystem::path path, std::string contents)
+            : path(std::move(path)), contents(std::move(contents)), loaded(true) {}
+    };
+
+
+    /**
+     * @brief Source of dictionary pages that are processed incrementally in batches
+     */
+    class PageSource
+    {
+    public:
+        virtual ~PageSource() = default;
+
+        /**
+         * Get the next batch of pages to process
+         * @param batchSize The size of the batch
+         * @return Next batch of pages to process (up to batchSize)
+         */
+        virtual std::vector<PageFile> getNextBatch(size_t batchSize) = 0;
+
+        /**
+         * Check if there are more pages to process
+         * @return True if there are more pages to process
+         */
+        [[nodiscard]] virtual bool hasMore() const = 0;
+
+        /**
+         * Get total page count
+         * @return Total count of pages in the source, 0 if the source cannot tell it without reading every page
+         */
+        [[nodiscard]] virtual size_t getTotalFilesCount() const = 0;
+
+        /**
+         * Skips pages, e.g. the pages already converted before resuming
+         * @param count Number of pages to skip
+         */
+        virtual void skip(const size_t count)
+        {
+            for (size_t skipped = 0; skipped < count && hasMore();)
+            {
+                skipped += getNextBatch(std::min<size_t>(count - skipped, 256)).size();
+            }
+        }
+    };
+
+
     /**
      * @brief File system iterator to process dictionary files incerementally
      */
-    class FileIterator
+    class FileIterator final : public PageSource
     {
     public:
         explicit FileIterator(const std::filesystem::path& directoryPath) : directoryPath(directoryPath)
@@ -32,6 +91,9 @@ namespace FileUtils
                     allFiles.emplace_back(entry.path().string());
                 }
             }
+
+            // A stable order lets an interrupted conversion resume where it stopped
+            std::ranges::sort(allFiles);
         }
 
         /**
@@ -39,9 +101,9 @@ namespace FileUtils
          * @param batchSize The size of the batch
          * @return Next batch of files to process (up to batchSize)
          */
-        std::vector<std::filesystem::path> getNextBatch(const size_t batchSize)
+        std::vector<PageFile> getNextBatch(const size_t batchSize) override
         {
-            std::vector<std::filesystem::path> batch;
+            std::vector<PageFile> batch;
 
             const size_t endIndex = std::min(currentIndex + batchSize, allFiles.size());
             for (size_t i = currentIndex; i < endIndex; ++i)
@@ -57,7 +119,7 @@ namespace FileUtils
          * Check if there are more files to process
          * @return True if there are more files to process
          */
-        [[nodiscard]] bool hasMore() const
+        [[nodiscard]] bool hasMore() const override
         {
             return currentIndex < allFiles.size();
         }
@@ -66,11 +128,16 @@ namespace FileUtils
          * Get total file count in directory
          * @return Total count of files in directory
          */
-        [[nodiscard]] size_t getTotalFilesCount() const
+        [[nodiscard]] size_t getTotalFilesCount() const override
         {
             return allFiles.size();
         }
 
+        void skip(const size_t count) override
+        {
+            currentIndex = std::min(currentIndex + count, allFiles.size());
+        }
+
     private:
         std::filesystem::path directoryPath;
         std::vector<std::filesystem::path> allFiles;
@@ -0,0 +1,109 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace HashUtils
+{
+    /**
+     * @brief Streaming 64-bit FNV-1a hasher
+     */
+    class Hasher
+    {
+    public:
+        Hasher& update(const std::string_view data)
+        {
+            for (const char c : data)
+            {
+                state ^= static_cast<unsigned char>(c);
+                state *= PRIME;
+            }
+            return *this;
+        }
+
+        Hasher& update(const uint64_t value)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                state ^= (value >> (i * 8)) & 0xFF;
+                state *= PRIME;
+            }
+            return *this;
+        }
+
+        /**
+         * Adds a field to the hash, prefixed by its length so adjacent fields can't run into each other
+         * @param field The field to add
+         */
+        Hasher& updateField(const std::string_view field)
+        {
+            update(static_cast<uint64_t>(field.size()));
+            return update(field);
+        }
+
+        /**
+         * Adds the contents of a file to the hash (nothing is added if it can't be read)
+         * @param filePath Path to the file
+         */
+        Hasher& updateFile(const std::filesystem::path& filePath)
+        {
+            std::ifstream file(filePath, std::ios::in | std::ios::binary);
+            if (!file.is_open())
+                return update(uint64_t{0});
+
+            char chunk[64 * 1024];
+            while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0)
+            {
+                update(std::string_view(chunk, static_cast<size_t>(file.gcount())));
+            }
+            return *this;
+        }
+
+        [[nodiscard]] uint64_t digest() const
+        {
+            return state;
+        }
+
+    private:
+        static constexpr uint64_t OFFSET_BASIS = 0xcbf29ce484222325ULL;
+        static constexpr uint64_t PRIME = 0x100000001b3ULL;
+
+        uint64_t state = OFFSET_BASIS;
+    };
+
+
+    /**
+     * Hashes a string with 64-bit FNV-1a
+     * @param data Data to hash
+     * @return The hash
+     */
+    inline uint64_t hash(const std::string_view data)
+    {
+        return Hasher().update(data).digest();
+    }
+
+
+    /**
+     * Formats a hash as a 16 digit hex string
+     * @param value The hash
+     * @return Lowercase hex string
+     */
+    inline std::string toHex(uint64_t value)
+    {
+        static constexpr char digits[] = "0123456789abcdef";
+
+        std::string hex(16, '0');
+        for (int i = 15; i >= 0; --i)
+        {
+            hex[i] = digits[value & 0xF];
+            value >>= 4;
+        }
+        return hex;
+    }
+}
+
+#endif
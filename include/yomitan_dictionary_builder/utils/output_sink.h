@@ -0,0 +1,78 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace FileUtils
+{
+    struct OutputSinkOptions
+    {
+        // Write on a background thread instead of the thread filling the buffers
+        bool writeBehind = true;
+
+        // Buffers waiting for the writer thread before write blocks, the caller fills another one meanwhile
+        size_t maxPendingBuffers = 2;
+    };
+
+
+    /**
+     * @brief Destination of a file being written in large buffers
+     *
+     * Buffers are handed over by swapping, so the caller keeps filling a buffer of the same capacity
+     * while the previous one is written. The file is only synced to disk when asked to.
+     */
+    class OutputSink
+    {
+    public:
+        virtual ~OutputSink() = default;
+
+        /**
+         * Appends the contents of a buffer to the file
+         * @param buffer The buffer, left empty (keeping a recycled capacity)
+         */
+        virtual void write(std::string& buffer) = 0;
+
+        /**
+         * Waits until everything handed to the sink is written to the file
+         */
+        virtual void flush() = 0;
+
+        /**
+         * Flushes the sink and its file's data to stable storage
+         */
+        virtual void sync() = 0;
+
+        /**
+         * Flushes and closes the file, nothing can be written afterwards
+         */
+        virtual void close() = 0;
+
+        /**
+         * Flushes and closes the file and continues in another one, keeping the writer thread
+         * @param filePath Path to the next file, truncated if it exists
+         */
+        virtual void switchFile(const std::filesystem::path& filePath) = 0;
+
+        /**
+         * Gets the size of the file once everything handed to the sink is written
+         * @return Size in bytes
+         */
+        [[nodiscard]] virtual uint64_t size() const = 0;
+    };
+
+
+    /**
+     * Opens a file for writing through a sink, throws if the file can't be opened.
+     * Errors of a background writer are thrown by the next call on the sink.
+     * @param filePath Path to the file
+     * @param offset Number of bytes of an existing file to keep, 0 to truncate it
+     * @param options Sink options
+     * @return The sink
+     */
+    std::unique_ptr<OutputSink> openOutputSink(const std::filesystem::path& filePath, uint64_t offset = 0, const OutputSinkOptions& options = {});
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef READ_AHEAD_SOURCE_H
+#define READ_AHEAD_SOURCE_H
+
+#include "yomitan_dictionary_builder/utils/file_utils.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FileUtils
+{
+    /**
+     * @brief Page source that prefetches upcoming pages of another source into memory on reader threads,
+     * so file I/O overlaps with parsing. Pages are still returned in the order of the wrapped source.
+     */
+    class ReadAheadPageSource final : public PageSource
+    {
+    public:
+        /**
+         * @param source The source to read ahead of
+         * @param maxPages Maximum number of pages buffered ahead of the parser
+         * @param readerThreads Number of threads reading pages
+         * @param memoryLimit Approximate limit in bytes for the buffered page contents
+         */
+        ReadAheadPageSource(std::unique_ptr<PageSource> source, size_t maxPages, size_t readerThreads, size_t memoryLimit);
+        ~ReadAheadPageSource() override;
+
+        ReadAheadPageSource(const ReadAheadPageSource&) = delete;
+        ReadAheadPageSource& operator=(const ReadAheadPageSource&) = delete;
+
+        std::vector<PageFile> getNextBatch(size_t batchSize) override;
+
+        [[nodiscard]] bool hasMore() const override;
+
+        [[nodiscard]] size_t getTotalFilesCount() const override;
+
+        /**
+         * Gets the number of times the parser had to wait for a page that was not read yet
+         * @return Stall count
+         */
+        [[nodiscard]] size_t getStallCount() const;
+
+    private:
+        struct Slot
+        {
+            PageFile page;
+            bool ready = false;
+        };
+
+        void readerLoop();
+
+        /**
+         * Reads the page contents into memory unless the source already did
+         * @param page The page to read
+         */
+        static void readPage(PageFile& page);
+
+        std::unique_ptr<PageSource> source;
+        const size_t totalFiles;
+        const size_t maxPages;
+        const size_t memoryLimit;
+
+        // guards access to the wrapped source, which hands out pages in order
+        std::mutex sourceMutex;
+
+        mutable std::mutex mutex;
+        std::condition_variable pageReady;
+        std::condition_variable spaceAvailable;
+        std::deque<Slot> slots;
+        size_t firstSlotIndex = 0;
+        size_t pagesInFlight = 0;
+        size_t bufferedBytes = 0;
+        size_t stallCount = 0;
+        bool sourceExhausted = false;
+        bool stopping = false;
+
+        std::vector<std::thread> readers;
+    };
+}
+
+#endif
@@ -0,0 +1,435 @@
+#ifndef STAGE_PROFILER_H
+#define STAGE_PROFILER_H
+
+#include <glaze/glaze.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Profiling
+{
+    /**
+     * @brief Pipeline stages timed by the profiler
+     */
+    enum class Stage : uint8_t
+    {
+        FileRead,
+        XmlLoad,
+        LinkRewrite,
+        ImageRewrite,
+        KeyExtraction,
+        SubItems,
+        TreeConversion,
+        Serialization,
+        DiskWrite,
+        PageCache,
+        Count
+    };
+
+    constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::Count);
+
+    /**
+     * Gets the name of a stage as used in the run report
+     * @param stage The stage
+     * @return Stage name
+     */
+    std::string_view getStageName(Stage stage);
+
+
+    /**
+     * @brief Log-linear latency histogram (8 buckets per power of two, ~6% error) with constant memory
+     */
+    class LatencyHistogram
+    {
+    public:
+        void record(uint64_t nanos);
+
+        void merge(const LatencyHistogram& other);
+
+        /**
+         * Gets the value at a percentile
+         * @param percentile Percentile between 0 and 100
+         * @return Approximate value in nanoseconds
+         */
+        [[nodiscard]] uint64_t getPercentile(double percentile) const;
+
+        [[nodiscard]] uint64_t getMax() const;
+
+        [[nodiscard]] uint64_t getCount() const;
+
+    private:
+        static constexpr size_t SUB_BUCKETS = 8;
+        static constexpr size_t BUCKET_COUNT = 16 + (64 - 4) * SUB_BUCKETS;
+
+        static size_t getBucketIndex(uint64_t nanos);
+
+        static uint64_t getBucketValue(size_t index);
+
+        std::array<uint64_t, BUCKET_COUNT> buckets{};
+        uint64_t count = 0;
+        uint64_t max = 0;
+    };
+
+
+    /**
+     * @brief Converted page with its time per stage
+     */
+    struct PageSample
+    {
+        std::string page;
+        uint64_t bytes = 0;
+        uint64_t totalNanos = 0;
+        std::array<uint64_t, STAGE_COUNT> stageNanos{};
+    };
+
+
+    /**
+     * @brief Totals of the run the report is written for
+     */
+    struct RunSummary
+    {
+        std::string dictionary;
+        uint64_t pages = 0;
+        int64_t entries = 0;
+        double wallSeconds = 0.0;
+
+        // Whether allocations were tracked during the run
+        bool includeAllocations = false;
+    };
+
+
+    struct StageReport
+    {
+        std::string stage;
+        uint64_t calls = 0;
+        double totalMs = 0.0;
+        double sharePercent = 0.0;
+        double p50Ms = 0.0;
+        double p90Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+
+    struct PageTimingReport
+    {
+        std::string page;
+        uint64_t bytes = 0;
+        double totalMs = 0.0;
+        std::map<std::string, double> stagesMs;
+    };
+
+
+    struct StageAllocationReport
+    {
+        std::string stage;
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        uint64_t pugiAllocations = 0;
+        uint64_t pugiBytes = 0;
+        double allocationsPerPage = 0.0;
+        double sharePercent = 0.0;
+    };
+
+
+    struct AllocationReport
+    {
+        // False when the build does not hook operator new, only pugixml allocations are counted then
+        bool operatorNewTracked = false;
+        uint64_t peakRssBytes = 0;
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        double allocationsPerPage = 0.0;
+        double bytesPerEntry = 0.0;
+        std::vector<StageAllocationReport> stages;
+    };
+
+
+    struct RunReport
+    {
+        std::string dictionary;
+        uint64_t pages = 0;
+        int64_t entries = 0;
+        uint64_t bytes = 0;
+        double wallSeconds = 0.0;
+        double pagesPerSecond = 0.0;
+        double megabytesPerSecond = 0.0;
+        double pageP50Ms = 0.0;
+        double pageP90Ms = 0.0;
+        double pageP99Ms = 0.0;
+        double pageMaxMs = 0.0;
+        std::vector<StageReport> stages;
+        std::vector<PageTimingReport> slowestPages;
+        std::optional<AllocationReport> allocations;
+    };
+
+
+    /**
+     * @brief Per-thread stage timer. Time is charged exclusively to the innermost active stage,
+     * so nested stages are not counted twice, and aggregated per page for the percentiles.
+     */
+    class StageProfiler
+    {
+    public:
+        /**
+         * Enables or disables profiling for all threads
+         * @param isEnabled Whether to record stage times
+         */
+        static void setEnabled(bool isEnabled);
+
+        static bool isEnabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Gets the profiler of the calling thread, registering it on first use
+         * @return Reference to the thread's profiler
+         */
+        static StageProfiler& forCurrentThread();
+
+        /**
+         * Gets the profiler of the calling thread like forCurrentThread, unless it is being registered
+         * @return Pointer to the thread's profiler, or nullptr during its registration
+         */
+        static StageProfiler* tryForCurrentThread();
+
+        /**
+         * Clears the recorded times of all threads.
+         * Must be called while no other thread is recording, the per-thread times are not locked.
+         * @param slowestPageCount Number of slowest pages to keep per thread
+         */
+        static void resetAll(size_t slowestPageCount);
+
+        void enterStage(Stage stage);
+
+        void exitStage();
+
+        /**
+         * Starts attributing stage times to a page
+         * @param name Page name
+         * @param bytes Size of the page
+         */
+        void beginPage(std::string_view name, uint64_t bytes);
+
+        void endPage();
+
+        /**
+         * Gets the stage currently active on this thread
+         * @return The innermost active stage, or Stage::Count outside of any stage
+         */
+        [[nodiscard]] Stage getCurrentStage() const;
+
+        /**
+         * Counts an allocation towards the active stage
+         * @param bytes Size of the allocation
+         * @param fromPugi Whether the allocation was made by pugixml
+         */
+        void recordAllocation(size_t bytes, bool fromPugi);
+
+        /**
+         * Merges the times of all threads into a run report.
+         * Must be called once the recording threads are joined or have handed over their last page,
+         * since their times are read without a lock.
+         * @param summary Totals of the run
+         * @return The run report
+         */
+        static RunReport buildReport(const RunSummary& summary);
+
+        /**
+         * Writes a run report as JSON
+         * @param reportPath Path of the report file
+         * @param report The report to write
+         * @return True if the report was written
+         */
+        static bool writeReport(const std::filesystem::path& reportPath, const RunReport& report);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        void reset(size_t slowestPages);
+
+        /**
+         * Charges the time since the last stage transition to the innermost active stage
+         */
+        void charge(Clock::time_point now);
+
+        static inline std::atomic<bool> enabled{false};
+
+        static constexpr size_t MAX_DEPTH = 16;
+
+        std::array<Stage, MAX_DEPTH> stageStack{};
+        size_t depth = 0;
+        Clock::time_point lastTransition;
+
+        std::array<uint64_t, STAGE_COUNT> totalNanos{};
+        std::array<uint64_t, STAGE_COUNT> calls{};
+        std::array<LatencyHistogram, STAGE_COUNT> stageHistograms;
+        LatencyHistogram pageHistogram;
+
+        bool inPage = false;
+        PageSample currentPage;
+        Clock::time_point pageStart;
+        uint64_t pageCount = 0;
+        uint64_t pageBytes = 0;
+
+        struct AllocationCounts
+        {
+            uint64_t allocations = 0;
+            uint64_t bytes = 0;
+            uint64_t pugiAllocations = 0;
+            uint64_t pugiBytes = 0;
+        };
+
+        // per stage, the last slot counts allocations made outside of any stage
+        std::array<AllocationCounts, STAGE_COUNT + 1> allocationCounts{};
+
+        // min-heap on the page time holding the slowest pages
+        std::vector<PageSample> slowestPages;
+        size_t slowestPageCount = 0;
+    };
+
+
+    /**
+     * @brief Times a stage for the lifetime of the scope (no-op while profiling is disabled)
+     */
+    class ScopedStage
+    {
+    public:
+        explicit ScopedStage(const Stage stage) : profiler(StageProfiler::isEnabled() ? &StageProfiler::forCurrentThread() : nullptr)
+        {
+            if (profiler)
+                profiler->enterStage(stage);
+        }
+
+        ~ScopedStage()
+        {
+            if (profiler)
+                profiler->exitStage();
+        }
+
+        ScopedStage(const ScopedStage&) = delete;
+        ScopedStage& operator=(const ScopedStage&) = delete;
+
+    private:
+        StageProfiler* profiler;
+    };
+
+
+    /**
+     * @brief Attributes the stages timed during the scope to a page
+     */
+    class ScopedPage
+    {
+    public:
+        ScopedPage(const std::string_view name, const uint64_t bytes)
+            : profiler(StageProfiler::isEnabled() ? &StageProfiler::forCurrentThread() : nullptr)
+        {
+            if (profiler)
+                profiler->beginPage(name, bytes);
+        }
+
+        ~ScopedPage()
+        {
+            if (profiler)
+                profiler->endPage();
+        }
+
+        ScopedPage(const ScopedPage&) = delete;
+        ScopedPage& operator=(const ScopedPage&) = delete;
+
+    private:
+        StageProfiler* profiler;
+    };
+}
+
+
+template<>
+struct glz::meta<Profiling::StageReport>
+{
+    using T = Profiling::StageReport;
+    static constexpr auto value = glz::object(
+        "stage", &T::stage,
+        "calls", &T::calls,
+        "totalMs", &T::totalMs,
+        "sharePercent", &T::sharePercent,
+        "p50Ms", &T::p50Ms,
+        "p90Ms", &T::p90Ms,
+        "p99Ms", &T::p99Ms,
+        "maxMs", &T::maxMs
+    );
+};
+
+template<>
+struct glz::meta<Profiling::PageTimingReport>
+{
+    using T = Profiling::PageTimingReport;
+    static constexpr auto value = glz::object(
+        "page", &T::page,
+        "bytes", &T::bytes,
+        "totalMs", &T::totalMs,
+        "stagesMs", &T::stagesMs
+    );
+};
+
+template<>
+struct glz::meta<Profiling::StageAllocationReport>
+{
+    using T = Profiling::StageAllocationReport;
+    static constexpr auto value = glz::object(
+        "stage", &T::stage,
+        "allocations", &T::allocations,
+        "bytes", &T::bytes,
+        "pugiAllocations", &T::pugiAllocations,
+        "pugiBytes", &T::pugiBytes,
+        "allocationsPerPage", &T::allocationsPerPage,
+        "sharePercent", &T::sharePercent
+    );
+};
+
+template<>
+struct glz::meta<Profiling::AllocationReport>
+{
+    using T = Profiling::AllocationReport;
+    static constexpr auto value = glz::object(
+        "operatorNewTracked", &T::operatorNewTracked,
+        "peakRssBytes", &T::peakRssBytes,
+        "allocations", &T::allocations,
+        "bytes", &T::bytes,
+        "allocationsPerPage", &T::allocationsPerPage,
+        "bytesPerEntry", &T::bytesPerEntry,
+        "stages", &T::stages
+    );
+};
+
+template<>
+struct glz::meta<Profiling::RunReport>
+{
+    using T = Profiling::RunReport;
+    static constexpr auto value = glz::object(
+        "dictionary", &T::dictionary,
+        "pages", &T::pages,
+        "entries", &T::entries,
+        "bytes", &T::bytes,
+        "wallSeconds", &T::wallSeconds,
+        "pagesPerSecond", &T::pagesPerSecond,
+        "megabytesPerSecond", &T::megabytesPerSecond,
+        "pageP50Ms", &T::pageP50Ms,
+        "pageP90Ms", &T::pageP90Ms,
+        "pageP99Ms", &T::pageP99Ms,
+        "pageMaxMs", &T::pageMaxMs,
+        "stages", &T::stages,
+        "slowestPages", &T::slowestPages,
+        "allocations", &T::allocations
+    );
+};
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <glaze/glaze.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Profiling
+{
+    /**
+     * @brief Event in the Chrome trace event format, as read by chrome://tracing and Perfetto
+     */
+    struct TraceEventJson
+    {
+        std::string name;
+        std::string cat;
+        std::string ph;
+        double ts = 0.0;
+        std::optional<double> dur;
+        uint32_t pid = 1;
+        uint32_t tid = 0;
+        std::map<std::string, std::string> args;
+    };
+
+
+    struct TraceFile
+    {
+        std::vector<TraceEventJson> traceEvents;
+        std::string displayTimeUnit = "ms";
+    };
+
+
+    /**
+     * @brief Records a timeline of the conversion into per-thread buffers
+     *
+     * Each thread only appends to its own buffer, the buffers are merged when the trace is written,
+     * so recording takes no locks. While tracing is disabled a scope costs a single relaxed load.
+     */
+    class TraceRecorder
+    {
+    public:
+        /**
+         * Enables or disables tracing for all threads
+         * @param isEnabled Whether to record events
+         */
+        static void setEnabled(bool isEnabled);
+
+        static bool isEnabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Gets the recorder of the calling thread, registering it on first use
+         * @return Reference to the thread's recorder
+         */
+        static TraceRecorder& forCurrentThread();
+
+        /**
+         * Drops the events of all threads and restarts the trace clock
+         */
+        static void clearAll();
+
+        /**
+         * Names the calling thread in the trace
+         * @param name Thread name
+         */
+        static void setThreadName(std::string_view name);
+
+        /**
+         * Gets the time since the trace clock started
+         * @return Nanoseconds since clearAll
+         */
+        static uint64_t now();
+
+        /**
+         * Adds a completed event to the thread's buffer
+         * @param name Event name (a string literal, it is stored as a pointer)
+         * @param category Event category (a string literal)
+         * @param startNanos Start of the event
+         * @param endNanos End of the event
+         * @param detail Detail shown with the event, may be empty
+         */
+        void record(const char* name, const char* category, uint64_t startNanos, uint64_t endNanos, std::string detail);
+
+        /**
+         * Merges the events of all threads into a trace file
+         * @return The trace, events ordered by start time
+         */
+        static TraceFile buildTrace();
+
+        /**
+         * Writes the trace of all threads as Chrome trace event JSON
+         * @param tracePath Path of the trace file
+         * @return True if the trace was written
+         */
+        static bool writeTrace(const std::filesystem::path& tracePath);
+
+    private:
+        struct Event
+        {
+            const char* name;
+            const char* category;
+            uint64_t startNanos;
+            uint64_t durationNanos;
+            std::string detail;
+        };
+
+        // Bounds the memory of a runaway trace, later events are counted as dropped
+        static constexpr size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+        static inline std::atomic<bool> enabled{false};
+        static inline std::atomic<int64_t> epochNanos{0};
+
+        uint32_t threadId = 0;
+        std::string threadName;
+        std::vector<Event> events;
+        uint64_t droppedEvents = 0;
+    };
+
+
+    /**
+     * @brief Records an event spanning the lifetime of the scope (no-op while tracing is disabled)
+     */
+    class ScopedTrace
+    {
+    public:
+        ScopedTrace(const char* name, const char* category)
+            : name(name), category(category), active(TraceRecorder::isEnabled()),
+              startNanos(active ? TraceRecorder::now() : 0)
+        {
+        }
+
+        ~ScopedTrace()
+        {
+            if (active)
+                TraceRecorder::forCurrentThread().record(name, category, startNanos, TraceRecorder::now(), std::move(detail));
+        }
+
+        ScopedTrace(const ScopedTrace&) = delete;
+        ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+        [[nodiscard]] bool isActive() const
+        {
+            return active;
+        }
+
+        /**
+         * Sets the detail shown with the event, only build it when isActive()
+         * @param value Detail, e.g. the page name
+         */
+        void setDetail(std::string value)
+        {
+            detail = std::move(value);
+        }
+
+    private:
+        const char* name;
+        const char* category;
+        bool active;
+        uint64_t startNanos;
+        std::string detail;
+    };
+}
+
+
+template<>
+struct glz::meta<Profiling::TraceEventJson>
+{
+    using T = Profiling::TraceEventJson;
+    static constexpr auto value = glz::object(
+        "name", &T::name,
+        "cat", &T::cat,
+        "ph", &T::ph,
+        "ts", &T::ts,
+        "dur", &T::dur,
+        "pid", &T::pid,
+        "tid", &T::tid,
+        "args", &T::args
+    );
+};
+
+template<>
+struct glz::meta<Profiling::TraceFile>
+{
+    using T = Profiling::TraceFile;
+    static constexpr auto value = glz::object(
+        "traceEvents", &T::traceEvents,
+        "displayTimeUnit", &T::displayTimeUnit
+    );
+};
+
+#endif
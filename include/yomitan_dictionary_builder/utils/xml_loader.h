@@ -0,0 +1,177 @@
+#ifndef XML_LOADER_H
+#define XML_LOADER_H
+
+#include "yomitan_dictionary_builder/utils/file_utils.h"
+#include "pugixml.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Bump allocator backing pugixml allocations made inside an XMLLoader::ArenaScope
+ *
+ * Memory is only reclaimed in bulk when the loader's next arena scope begins,
+ * so individual deallocations are free.
+ */
+class PugiArena
+{
+public:
+    void* allocate(size_t size);
+
+    /**
+     * Releases all allocations while keeping the blocks for reuse
+     */
+    void reset();
+
+    [[nodiscard]] size_t capacity() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+    };
+
+    static constexpr size_t BLOCK_SIZE = 1 * 1024 * 1024; // 1MB
+
+    std::vector<Block> blocks;
+    size_t currentBlock = 0;
+    size_t offset = 0;
+};
+
+
+/**
+ * @brief pugixml writer appending to a string, so a page can be saved into a buffer that keeps its capacity
+ */
+class StringXMLWriter final : public pugi::xml_writer
+{
+public:
+    /**
+     * @param buffer String the output is appended to, must outlive the writer
+     */
+    explicit StringXMLWriter(std::string& buffer);
+
+    void write(const void* data, size_t size) override;
+
+private:
+    std::string& buffer;
+};
+
+
+/**
+ * @brief Per-thread XML page loader that reuses its read buffer, document and arena between pages
+ *
+ * The pugixml memory hooks are installed once during static initialisation, before any document exists,
+ * so every allocation carries the header telling heap and arena memory apart.
+ */
+class XMLLoader
+{
+public:
+    /**
+     * @brief Serves the pugixml allocations of the calling thread from its loader's arena while alive
+     *
+     * Meant to cover loading and processing a single page: documents and xpath results created in
+     * the scope must not outlive it, since the next scope reuses the arena. Outside any scope
+     * pugixml allocates from the heap.
+     */
+    class ArenaScope
+    {
+    public:
+        /**
+         * Releases the loader's previous document and arena memory and activates the arena
+         * @param loader Loader of the calling thread
+         * @param useArena Whether to use the arena, the scope does nothing otherwise
+         */
+        ArenaScope(XMLLoader& loader, bool useArena);
+        ~ArenaScope();
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+
+    private:
+        // Whether this scope activated the arena, nested scopes leave it to the outermost one
+        bool active = false;
+    };
+
+    XMLLoader();
+    ~XMLLoader();
+
+    XMLLoader(const XMLLoader&) = delete;
+    XMLLoader& operator=(const XMLLoader&) = delete;
+
+    /**
+     * Gets the loader owned by the calling thread
+     * @return Reference to the thread's loader
+     */
+    static XMLLoader& forCurrentThread();
+
+    /**
+     * Reads an XML file into the recycled buffer and parses it in place.
+     * The returned document stays valid until the next load on this thread.
+     * @param filePath Path to the XML file
+     * @return The parsed document, or nullptr on failure
+     */
+    pugi::xml_document* load(const std::filesystem::path& filePath);
+
+    /**
+     * Parses XML bytes in place, taking ownership of the buffer until the next load.
+     * @param contents XML bytes (swapped with the recycled buffer)
+     * @param name Name of the page used in error messages
+     * @return The parsed document, or nullptr on failure
+     */
+    pugi::xml_document* loadBuffer(std::string& contents, std::string_view name);
+
+    /**
+     * Loads a page, parsing its contents directly when it was already read from an archive
+     * @param page The page to load (its contents are consumed)
+     * @return The parsed document, or nullptr on failure
+     */
+    pugi::xml_document* load(FileUtils::PageFile& page);
+
+    /**
+     * Gets the number of pages loaded by this loader
+     * @return Loaded page count
+     */
+    [[nodiscard]] size_t getPagesLoaded() const;
+
+    /**
+     * Gets the number of bytes parsed by this loader
+     * @return Loaded byte count
+     */
+    [[nodiscard]] size_t getBytesLoaded() const;
+
+    /**
+     * Reads a file into a buffer, growing the buffer only when it is too small
+     * @param filePath Path to the file
+     * @param buffer Buffer to read into
+     * @param size Set to the number of bytes read
+     * @return True if the file was read
+     */
+    static bool readFile(const std::filesystem::path& filePath, std::string& buffer, size_t& size);
+
+private:
+    /**
+     * Releases the previous document
+     */
+    void resetDocument();
+
+    /**
+     * Parses the current buffer contents in place
+     * @param size Number of bytes in the buffer to parse
+     * @param name Page name used in error messages
+     * @return The parsed document, or nullptr on failure
+     */
+    pugi::xml_document* parseBuffer(size_t size, std::string_view name);
+
+    // the arena must outlive the document that allocates from it
+    PugiArena arena;
+    std::string buffer;
+    pugi::xml_document document;
+    size_t pagesLoaded = 0;
+    size_t bytesLoaded = 0;
+};
+
+#endif
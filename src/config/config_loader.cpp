@@ -80,7 +80,11 @@ DictionaryConfigPair ConfigLoader::parseDictionaryConfig(const YAML::Node& dictN
         if (!yomitanConfig.description.empty()) config.yomitanConfig.description = yomitanConfig.description;
         if (!yomitanConfig.attribution.empty()) config.yomitanConfig.attribution = yomitanConfig.attribution;
         if (!yomitanConfig.revision.empty()) config.yomitanConfig.revision = yomitanConfig.revision;
-        if (!yomitanConfig.CHUNK_SIZE) config.yomitanConfig.CHUNK_SIZE = yomitanConfig.CHUNK_SIZE;
+        if (yomitanConfig.CHUNK_SIZE) config.yomitanConfig.CHUNK_SIZE = yomitanConfig.CHUNK_SIZE;
+        config.yomitanConfig.CHUNK_BYTES = yomitanConfig.CHUNK_BYTES;
+        config.yomitanConfig.foldDuplicates = yomitanConfig.foldDuplicates;
+        config.yomitanConfig.writeBehind = yomitanConfig.writeBehind;
+        if (yomitanConfig.lookupIndexPath) config.yomitanConfig.lookupIndexPath = yomitanConfig.lookupIndexPath;
     }
 
     if (dictNode["MDictConfig"])
@@ -91,6 +95,7 @@ DictionaryConfigPair ConfigLoader::parseDictionaryConfig(const YAML::Node& dictN
         if (!mdictConfig.author.empty()) config.mDictConfig.author = mdictConfig.author;
         if (!mdictConfig.appendixLinkIdentifier.empty()) config.mDictConfig.appendixLinkIdentifier = mdictConfig.appendixLinkIdentifier;
         if (!mdictConfig.subElement.empty()) config.mDictConfig.subElement = mdictConfig.subElement;
+        config.mDictConfig.deduplicateContent = mdictConfig.deduplicateContent;
     }
 
     if (dictNode["ParserConfig"])
@@ -115,7 +120,11 @@ YomitanDictionaryConfig ConfigLoader::parseYomitanConfig(const YAML::Node& node)
     if (node["revision"]) config.revision = node["revision"].as<std::string>();
     if (node["format"]) config.format = node["format"].as<int>();
     if (node["chunk_size"]) config.CHUNK_SIZE = node["chunk_size"].as<long>();
+    if (node["chunk_bytes"]) config.CHUNK_BYTES = node["chunk_bytes"].as<size_t>();
     if (node["formatPretty"]) config.formatPretty = node["formatPretty"].as<bool>();
+    if (node["foldDuplicates"]) config.foldDuplicates = node["foldDuplicates"].as<bool>();
+    if (node["writeBehind"]) config.writeBehind = node["writeBehind"].as<bool>();
+    if (node["lookupIndexPath"]) config.lookupIndexPath = node["lookupIndexPath"].as<std::string>();
     if (node["tempDir"]) config.tempDir = node["tempDir"].as<std::string>();
 
     return config;
@@ -129,6 +138,7 @@ MDictConfig ConfigLoader::parseMDictConfig(const YAML::Node& node)
     if (node["author"]) config.author = node["author"].as<std::string>();
     if (node["appendixLinkIdentifier"]) config.appendixLinkIdentifier = node["appendixLinkIdentifier"].as<std::string>();
     if (node["subElement"]) config.subElement = node["subElement"].as<std::string>();
+    if (node["deduplicateContent"]) config.deduplicateContent = node["deduplicateContent"].as<bool>();
 
     return config;
 }
@@ -140,6 +150,7 @@ ParserConfig ConfigLoader::parseParserConfig(const YAML::Node& node) const
     if (node["mDictLinkStrategyType"])
     {
         config.linkStrategyType = node["mDictLinkStrategyType"].as<std::string>();
+        config.mdictLinkStrategy = config.linkStrategyType;
         config.createMDictLinkStrategy = [strategyType = config.linkStrategyType](const MDictConfig& mDictConfig) {
             return MDictLinkStrategyFactory::getInstance().create(strategyType, mDictConfig);
         };
@@ -154,6 +165,7 @@ ParserConfig ConfigLoader::parseParserConfig(const YAML::Node& node) const
     if (node["keyExtractionStrategy"])
     {
         const auto strategyType = node["keyExtractionStrategy"].as<std::string>();
+        config.keyStrategyType = strategyType;
         config.createKeyExtractionStrategy = [strategyType]() {
             return KeyExtractionStrategyFactory::getInstance().create(strategyType);
         };
@@ -178,14 +190,27 @@ ParserConfig ConfigLoader::parseParserConfig(const YAML::Node& node) const
     if (node["cssDirectory"]) config.cssDirectory = resolvePath(node["cssDirectory"].as<std::string>());
     if (node["descriptionPath"]) config.descriptionPath = resolvePath(node["descriptionPath"].as<std::string>());
     if (node["iconPath"]) config.iconPath = resolvePath(node["iconPath"].as<std::string>());
+    if (node["cacheDirectory"]) config.cacheDirectory = resolvePath(node["cacheDirectory"].as<std::string>());
+    if (node["checkpointPath"]) config.checkpointPath = resolvePath(node["checkpointPath"].as<std::string>());
+    if (node["runReportPath"]) config.runReportPath = resolvePath(node["runReportPath"].as<std::string>());
+    if (node["tracePath"]) config.tracePath = resolvePath(node["tracePath"].as<std::string>());
+    if (node["entryStorePath"]) config.entryStorePath = resolvePath(node["entryStorePath"].as<std::string>());
+    if (node["lookupIndexPath"]) config.lookupIndexPath = resolvePath(node["lookupIndexPath"].as<std::string>());
     if (node["imageMappingPath"])
     {
         const auto imageMappingPath = resolvePath(node["imageMappingPath"].as<std::string>());
         config.imageMappingPath = imageMappingPath;
+        config.imageStrategyType = "hash";
         config.createImageStrategy = [imageMappingPath]() {
               return ImageStrategyFactory::getInstance().create("hash", ImageStrategyParams{.imageMapPath = imageMappingPath});
         };
     }
+    else
+    {
+        config.createImageStrategy = []() {
+            return ImageStrategyFactory::getInstance().create("default", ImageStrategyParams{});
+        };
+    }
 
     // Optional features
     if (node["ignoredElements"])
@@ -202,6 +227,17 @@ ParserConfig ConfigLoader::parseParserConfig(const YAML::Node& node) const
     if (node["parseAllLinks"]) config.parseAllLinks = node["parseAllLinks"].as<bool>();
     if (node["showProgress"]) config.showProgress = node["showProgress"].as<bool>();
     if (node["parsingBatchSize"]) config.parsingBatchSize = node["parsingBatchSize"].as<int>();
+    if (node["pruneUnreferencedAssets"]) config.pruneUnreferencedAssets = node["pruneUnreferencedAssets"].as<bool>();
+    if (node["useXmlArena"]) config.useXmlArena = node["useXmlArena"].as<bool>();
+    if (node["staticStrategies"]) config.staticStrategies = node["staticStrategies"].as<bool>();
+    if (node["writeBehindOutput"]) config.writeBehindOutput = node["writeBehindOutput"].as<bool>();
+    if (node["readAheadPages"]) config.readAheadPages = node["readAheadPages"].as<size_t>();
+    if (node["readAheadThreads"]) config.readAheadThreads = node["readAheadThreads"].as<size_t>();
+    if (node["readAheadMemoryLimit"]) config.readAheadMemoryLimit = node["readAheadMemoryLimit"].as<size_t>();
+    if (node["cacheMaxBytes"]) config.cacheMaxBytes = node["cacheMaxBytes"].as<uint64_t>();
+    if (node["checkpointInterval"]) config.checkpointInterval = node["checkpointInterval"].as<size_t>();
+    if (node["runReportSlowestPages"]) config.runReportSlowestPages = node["runReportSlowestPages"].as<size_t>();
+    if (node["profileAllocations"]) config.profileAllocations = node["profileAllocations"].as<bool>();
 
     return config;
 }
@@ -29,6 +29,10 @@ void registerAllStrategies()
     });
 
     auto& imageFactory = ImageStrategyFactory::getInstance();
+    imageFactory.registerStrategy("default", [](const ImageStrategyParams&) {
+        return std::make_unique<DefaultImageHandlingStrategy>();
+    });
+
     imageFactory.registerStrategy("hash", [](const ImageStrategyParams& params) {
         if (!params.imageMapPath.has_value())
             throw std::runtime_error("Hash image strategy requires imageMapPath parameter");
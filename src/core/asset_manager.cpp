@@ -1,6 +1,8 @@
 #include "yomitan_dictionary_builder/core/asset_manager.h"
+#include "yomitan_dictionary_builder/utils/trace_recorder.h"
 
 #include <iostream>
+#include <unordered_map>
 
 AssetManager::AssetManager(const std::filesystem::path& outputDirectory) : outputDirectory(outputDirectory)
 {
@@ -15,13 +17,17 @@ AssetManager::AssetManager(const std::filesystem::path& outputDirectory) : outpu
 }
 
 
-void AssetManager::copyAssets(const AssetConfig& config)
+void AssetManager::copyAssets(const AssetConfig& config, const AssetRegistry* referencedAssets)
 {
+    const Profiling::ScopedTrace trace("copyAssets", "assets");
     overWriteExisting = config.overwriteExisting;
 
     if (!config.assetDirectory.empty())
     {
-        copyDirectory(config.assetDirectory, true);
+        if (referencedAssets)
+            copyReferencedAssets(config.assetDirectory, *referencedAssets);
+        else
+            copyDirectory(config.assetDirectory, true);
     }
 
     if (!config.fontDirectory.empty())
@@ -82,6 +88,82 @@ void AssetManager::copyDirectory(const std::filesystem::path& directoryPath, con
 }
 
 
+void AssetManager::copyReferencedAssets(const std::filesystem::path& directoryPath, const AssetRegistry& referencedAssets)
+{
+    report = AssetReport{};
+
+    try
+    {
+        if (!std::filesystem::is_directory(directoryPath))
+        {
+            throw std::runtime_error("Path is not a directory: " + directoryPath.string());
+        }
+
+        // Map every trailing sub path of a reference back to it, so that references
+        // like "assets/graphics/a.png" still match "graphics/a.png" in the asset directory
+        const auto references = referencedAssets.getReferences();
+        std::unordered_map<std::string, size_t> suffixToReference;
+        for (size_t i = 0; i < references.size(); ++i)
+        {
+            std::string_view suffix = references[i];
+            while (!suffix.empty())
+            {
+                suffixToReference.try_emplace(std::string(suffix), i);
+
+                const auto slashPos = suffix.find('/');
+                if (slashPos == std::string_view::npos)
+                    break;
+                suffix.remove_prefix(slashPos + 1);
+            }
+        }
+
+        std::vector<bool> matchedReferences(references.size(), false);
+
+        const auto assetsDirectory = outputDirectory / "mdd";
+        std::filesystem::create_directories(assetsDirectory);
+
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directoryPath))
+        {
+            if (!entry.is_regular_file()) continue;
+
+            const auto relativePath = getRelativePath(entry.path(), directoryPath);
+            const auto it = suffixToReference.find(relativePath.generic_string());
+            if (it == suffixToReference.end())
+            {
+                report.unreferencedFiles++;
+                report.skippedBytes += entry.file_size();
+                continue;
+            }
+
+            matchedReferences[it->second] = true;
+
+            const auto destinationPath = assetsDirectory / relativePath;
+            std::filesystem::create_directories(destinationPath.parent_path());
+            copyFile(entry.path(), destinationPath);
+
+            report.copiedFiles++;
+            report.copiedBytes += entry.file_size();
+        }
+
+        for (size_t i = 0; i < references.size(); ++i)
+        {
+            if (!matchedReferences[i])
+                report.missingFiles.emplace_back(references[i]);
+        }
+    }
+    catch (std::filesystem::filesystem_error& e)
+    {
+        std::cerr << "Error copying referenced assets: " << directoryPath.string() << " - " << e.what() << std::endl;
+    }
+}
+
+
+const AssetReport& AssetManager::getReport() const
+{
+    return report;
+}
+
+
 void AssetManager::copyFile(const std::filesystem::path& source, const std::filesystem::path& destination) const
 {
     try
@@ -0,0 +1,81 @@
+#include "yomitan_dictionary_builder/core/asset_registry.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+
+void AssetRegistry::recordReference(const std::string_view reference)
+{
+    std::string normalized = normalizeReference(reference);
+    if (normalized.empty())
+        return;
+
+    std::lock_guard lock(mutex);
+    if (capturing)
+        capturedReferences.push_back(normalized);
+
+    references.emplace(std::move(normalized));
+}
+
+
+std::vector<std::string> AssetRegistry::getReferences() const
+{
+    std::vector<std::string> result;
+    {
+        std::lock_guard lock(mutex);
+        result.assign(references.begin(), references.end());
+    }
+
+    std::ranges::sort(result);
+    return result;
+}
+
+
+size_t AssetRegistry::size() const
+{
+    std::lock_guard lock(mutex);
+    return references.size();
+}
+
+
+void AssetRegistry::beginCapture()
+{
+    std::lock_guard lock(mutex);
+    capturedReferences.clear();
+    capturing = true;
+}
+
+
+std::vector<std::string> AssetRegistry::endCapture()
+{
+    std::lock_guard lock(mutex);
+    capturing = false;
+    return std::exchange(capturedReferences, {});
+}
+
+
+std::string AssetRegistry::normalizeReference(std::string_view reference)
+{
+    static constexpr std::array<std::string_view, 4> externalPrefixes {
+        "http://", "https://", "entry://", "data:"
+    };
+
+    if (std::ranges::any_of(externalPrefixes, [&](const auto prefix) { return reference.starts_with(prefix); }))
+        return "";
+
+    if (reference.starts_with("sound://"))
+        reference.remove_prefix(std::string_view{"sound://"}.size());
+
+    // Drop any fragment or query string
+    if (const auto pos = reference.find_first_of("#?"); pos != std::string_view::npos)
+        reference = reference.substr(0, pos);
+
+    while (reference.starts_with("./") || reference.starts_with('/'))
+        reference.remove_prefix(reference.starts_with('/') ? 1 : 2);
+
+    if (reference.empty())
+        return "";
+
+    return std::filesystem::path(reference).lexically_normal().generic_string();
+}
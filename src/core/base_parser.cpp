@@ -1,10 +1,17 @@
 #include "yomitan_dictionary_builder/core/base_parser.h"
+#include "yomitan_dictionary_builder/utils/allocation_tracker.h"
+#include "yomitan_dictionary_builder/utils/archive_iterator.h"
+#include "yomitan_dictionary_builder/utils/read_ahead_source.h"
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
+#include "yomitan_dictionary_builder/utils/trace_recorder.h"
+#include "yomitan_dictionary_builder/utils/xml_loader.h"
 
 
 BaseParser::BaseParser(const ParserConfig& config) : config(config)
 {
-    fileIterator = std::make_unique<FileUtils::FileIterator>(config.dictionaryPath);
+    pageSource = FileUtils::openPageSource(config.dictionaryPath);
     batchSize = config.parsingBatchSize;
+
     if (config.showProgress)
     {
         pbar = std::make_unique<indicators::ProgressBar>(
@@ -25,29 +32,99 @@ BaseParser::BaseParser(const ParserConfig& config) : config(config)
 
 int BaseParser::parse()
 {
-    if (!this->fileIterator)
+    if (!this->pageSource)
     {
         std::cerr << "No dictionary path set." << std::endl;
     }
 
-    const size_t totalFiles = fileIterator->getTotalFilesCount();
+    const size_t totalFiles = pageSource->getTotalFilesCount();
 
     if (config.showProgress)
     {
-        pbar->set_option(indicators::option::PrefixText{std::to_string(totalFiles) + std::string{"のファイルを処理中"}});
+        // A source that cannot tell its page count up front only shows the throughput
+        const std::string prefixText = totalFiles > 0 ? std::to_string(totalFiles) + "のファイルを処理中" : "ファイルを処理中";
+        pbar->set_option(indicators::option::PrefixText{prefixText});
         pbar->set_progress(0.0);
     }
 
-    startTime = std::chrono::high_resolution_clock::now();
+    startTime = std::chrono::steady_clock::now();
     entriesProcessed = 0;
     filesProcessed = 0;
 
+    // Hashing reads the tag map and index files, so it is only done when something needs it
+    uint64_t configHash = 0;
+    if (config.cacheDirectory.has_value() || config.checkpointPath.has_value())
+    {
+        HashUtils::Hasher hasher;
+        hashCacheConfig(hasher);
+        configHash = hasher.digest();
+    }
+
+    if (config.cacheDirectory.has_value() && supportsPageCache())
+    {
+        pageCache = std::make_unique<PageCache>(config.cacheDirectory.value(), configHash, config.cacheMaxBytes);
+    }
+
+    if (config.checkpointPath.has_value() && supportsCheckpoint())
+    {
+        resumeFromCheckpoint(configHash);
+    }
+
+    if (config.runReportPath.has_value())
+    {
+        Profiling::StageProfiler::resetAll(config.runReportSlowestPages);
+        Profiling::StageProfiler::setEnabled(true);
+
+        if (config.profileAllocations)
+        {
+            if (!Profiling::AllocationTracker::isSupported())
+                std::cerr << "Built without YOMITAN_ALLOCATION_PROFILING, only pugixml allocations are counted" << std::endl;
+
+            Profiling::AllocationTracker::setEnabled(true);
+        }
+    }
+
+    if (config.tracePath.has_value())
+    {
+        Profiling::TraceRecorder::clearAll();
+        Profiling::TraceRecorder::setEnabled(true);
+        Profiling::TraceRecorder::setThreadName("parser");
+    }
+
+    // Read-ahead starts after resuming so the skipped pages are never read
+    if (config.readAheadPages > 0)
+    {
+        pageSource = std::make_unique<FileUtils::ReadAheadPageSource>(
+            std::move(pageSource), config.readAheadPages, config.readAheadThreads, config.readAheadMemoryLimit);
+    }
+
     initializeProcessing();
 
-    while (fileIterator->hasMore())
+    while (pageSource->hasMore())
     {
-        auto batch = fileIterator->getNextBatch(batchSize);
-        this->entriesProcessed += processBatch(batch);
+        std::vector<FileUtils::PageFile> batch;
+        {
+            // Shows how long the parser waits for read-ahead
+            const Profiling::ScopedTrace trace("nextBatch", "parser");
+            batch = pageSource->getNextBatch(batchSize);
+        }
+
+        {
+            Profiling::ScopedTrace trace("batch", "parser");
+            if (trace.isActive())
+                trace.setDetail(std::to_string(batch.size()) + " pages");
+
+            this->entriesProcessed += processBatch(batch);
+        }
+
+        if (checkpoint && !batch.empty())
+        {
+            lastCompletedPage = batch.back().path.generic_string();
+            pagesSinceCheckpoint += batch.size();
+
+            if (pagesSinceCheckpoint >= config.checkpointInterval)
+                saveCheckpoint(configHash);
+        }
 
         if (config.showProgress)
         {
@@ -62,19 +139,53 @@ int BaseParser::parse()
         pbar->set_progress(100.0);
     }
 
-    finalizeProcessing();
+    const auto parseTime = std::chrono::steady_clock::now();
+
+    {
+        const Profiling::ScopedTrace trace("finalize", "parser");
+        finalizeProcessing();
+    }
+
+    // The conversion completed, there is nothing left to resume
+    if (checkpoint)
+        checkpoint->remove();
+
+    if (pageCache)
+    {
+        pageCache->evict();
+
+        if (config.showProgress)
+            printCacheReport();
+    }
+
+    // The read-ahead thread recorded its last page before handing it over, so no thread records anymore
+    if (config.runReportPath.has_value())
+        writeRunReport();
+
+    if (config.tracePath.has_value())
+        writeTrace();
+
+    if (config.showProgress)
+    {
+        const double seconds = std::chrono::duration<double>(parseTime - startTime).count();
+        const double pagesPerSecond = seconds > 0.0 ? static_cast<double>(filesProcessed) / seconds : 0.0;
+        std::cout << "Parsed " << filesProcessed << " pages in " << seconds << "s (" << pagesPerSecond << " pages/s)" << std::endl;
+
+        if (const auto* readAhead = dynamic_cast<const FileUtils::ReadAheadPageSource*>(pageSource.get()))
+            std::cout << "Read-ahead stalls: " << readAhead->getStallCount() << std::endl;
+    }
 
     return entriesProcessed;
 }
 
 
-int BaseParser::processBatch(const std::vector<std::filesystem::path>& filePaths)
+int BaseParser::processBatch(std::vector<FileUtils::PageFile>& pages)
 {
     int batchEntriesProcessed = 0;
 
-    for (const auto& filePath : filePaths)
+    for (auto& page : pages)
     {
-        if (const int entriesFromFile = processFile(filePath); entriesFromFile > 0)
+        if (const int entriesFromFile = processPage(page); entriesFromFile > 0)
         {
             batchEntriesProcessed += entriesFromFile;
         }
@@ -87,6 +198,230 @@ int BaseParser::processBatch(const std::vector<std::filesystem::path>& filePaths
 }
 
 
+int BaseParser::processPage(FileUtils::PageFile& page)
+{
+    Profiling::ScopedTrace trace("processFile", "parser");
+    if (trace.isActive())
+        trace.setDetail(page.path.filename().string());
+
+    // Everything pugixml allocates for the page comes from the thread's arena until the page is done
+    const XMLLoader::ArenaScope arenaScope(XMLLoader::forCurrentThread(), config.useXmlArena);
+
+    std::optional<Profiling::ScopedPage> pageScope;
+    if (Profiling::StageProfiler::isEnabled())
+    {
+        std::error_code ec;
+        const uint64_t bytes = page.loaded ? page.contents.size() : std::filesystem::file_size(page.path, ec);
+        pageScope.emplace(page.path.generic_string(), ec ? 0 : bytes);
+    }
+
+    if (!pageCache)
+        return processFile(page);
+
+    // The page contents are needed for the cache key
+    if (!page.loaded)
+    {
+        size_t size = 0;
+        if (!XMLLoader::readFile(page.path, page.contents, size))
+            return processFile(page);
+
+        page.contents.resize(size);
+        page.loaded = true;
+    }
+
+    std::string key;
+    {
+        const Profiling::ScopedStage stage(Profiling::Stage::PageCache);
+
+        key = pageCache->makeKey(page.path, page.contents);
+        if (const auto cachedRecord = pageCache->lookup(key); cachedRecord.has_value())
+        {
+            PageRecordReader reader(cachedRecord.value());
+            if (uint64_t entries = 0; reader.readUint64(entries) && replayPage(reader))
+                return static_cast<int>(entries);
+
+            std::cerr << "Failed to replay cached page: " << page.path.string() << std::endl;
+        }
+    }
+
+    beginPageCapture();
+    const int entries = processFile(page);
+
+    const Profiling::ScopedStage stage(Profiling::Stage::PageCache);
+
+    PageRecordWriter record;
+    record.writeUint64(static_cast<uint64_t>(std::max(entries, 0)));
+    if (endPageCapture(record))
+        pageCache->store(key, record.take());
+
+    return entries;
+}
+
+
+void BaseParser::resumeFromCheckpoint(const uint64_t configHash)
+{
+    checkpoint = std::make_unique<Checkpoint>(config.checkpointPath.value());
+
+    CheckpointState state;
+    state.builderVersion = PageCache::getBuilderVersion();
+    state.configHash = configHash;
+    state.dictionaryPath = config.dictionaryPath.generic_string();
+
+    bool resumed = false;
+    if (const auto saved = checkpoint->load(); saved.has_value() && saved->pagesCompleted > 0)
+    {
+        if (saved->builderVersion != state.builderVersion || saved->configHash != state.configHash ||
+            saved->dictionaryPath != state.dictionaryPath)
+        {
+            std::cerr << "Checkpoint belongs to a different configuration, starting over" << std::endl;
+        }
+        else
+        {
+            // The last completed page confirms the pages are still in the same order
+            pageSource->skip(saved->pagesCompleted - 1);
+            const auto lastPage = pageSource->getNextBatch(1);
+
+            if (!lastPage.empty() && lastPage.front().path.generic_string() == saved->lastCompletedPage &&
+                restoreCheckpointState(saved.value()))
+            {
+                state = saved.value();
+                resumed = true;
+            }
+            else
+            {
+                std::cerr << "Checkpoint does not match the dictionary files, starting over" << std::endl;
+                pageSource = FileUtils::openPageSource(config.dictionaryPath);
+            }
+        }
+    }
+
+    if (!resumed && !restoreCheckpointState(state))
+    {
+        throw std::runtime_error("Failed to reset the output for checkpointing");
+    }
+
+    filesProcessed = static_cast<int>(state.pagesCompleted);
+    entriesProcessed = static_cast<int>(state.entriesProcessed);
+    lastCompletedPage = state.lastCompletedPage;
+    pagesSinceCheckpoint = 0;
+
+    if (resumed && config.showProgress)
+    {
+        std::cout << "Resuming from checkpoint after " << filesProcessed << " pages (" << lastCompletedPage << ")" << std::endl;
+    }
+}
+
+
+void BaseParser::saveCheckpoint(const uint64_t configHash)
+{
+    CheckpointState state;
+    state.builderVersion = PageCache::getBuilderVersion();
+    state.configHash = configHash;
+    state.dictionaryPath = config.dictionaryPath.generic_string();
+    state.pagesCompleted = static_cast<uint64_t>(filesProcessed);
+    state.lastCompletedPage = lastCompletedPage;
+    state.entriesProcessed = entriesProcessed;
+
+    // The output is made durable first, so the manifest never points past what is on disk
+    if (!saveCheckpointState(state) || !checkpoint->save(state))
+    {
+        std::cerr << "Failed to save checkpoint after " << filesProcessed << " pages" << std::endl;
+        return;
+    }
+
+    pagesSinceCheckpoint = 0;
+}
+
+
+void BaseParser::hashCacheConfig(HashUtils::Hasher& hasher) const
+{
+    hasher.updateField(config.dictionaryType);
+    hasher.updateField(config.linkStrategyType);
+    hasher.updateField(config.mdictLinkStrategy);
+    hasher.updateField(config.imageStrategyType);
+    hasher.updateField(config.keyStrategyType);
+
+    // Files whose contents end up in the converted entries
+    for (const auto& path : {config.tagMappingPath, config.imageMappingPath, config.indexPath, config.jmdictPath})
+    {
+        if (path.has_value() && std::filesystem::is_regular_file(path.value()))
+            hasher.updateField(path->filename().string()).updateFile(path.value());
+        else
+            hasher.update(uint64_t{0});
+    }
+
+    for (const auto& path : {config.audioPath, config.appendixPath})
+    {
+        hasher.updateField(path.has_value() ? path->generic_string() : "");
+    }
+
+    if (config.ignoredElements.has_value())
+    {
+        hasher.update(static_cast<uint64_t>(config.ignoredElements->size()));
+        for (const auto& element : config.ignoredElements.value())
+            hasher.updateField(element);
+    }
+
+    hasher.updateField(config.expressionElement.value_or(""));
+    hasher.update(static_cast<uint64_t>(config.parseAllLinks));
+}
+
+
+void BaseParser::writeRunReport() const
+{
+    Profiling::StageProfiler::setEnabled(false);
+    Profiling::AllocationTracker::setEnabled(false);
+
+    const Profiling::RunSummary summary{
+        .dictionary = config.dictionaryPath.generic_string(),
+        .pages = static_cast<uint64_t>(filesProcessed),
+        .entries = entriesProcessed,
+        .wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count(),
+        .includeAllocations = config.profileAllocations
+    };
+
+    const auto& reportPath = config.runReportPath.value();
+    if (!Profiling::StageProfiler::writeReport(reportPath, Profiling::StageProfiler::buildReport(summary)))
+    {
+        std::cerr << "Failed to write run report: " << reportPath.string() << std::endl;
+        return;
+    }
+
+    if (config.showProgress)
+        std::cout << "Run report written to " << reportPath.string() << std::endl;
+}
+
+
+void BaseParser::writeTrace() const
+{
+    Profiling::TraceRecorder::setEnabled(false);
+
+    const auto& tracePath = config.tracePath.value();
+    if (!Profiling::TraceRecorder::writeTrace(tracePath))
+    {
+        std::cerr << "Failed to write trace: " << tracePath.string() << std::endl;
+        return;
+    }
+
+    if (config.showProgress)
+        std::cout << "Trace written to " << tracePath.string() << " (open in ui.perfetto.dev)" << std::endl;
+}
+
+
+void BaseParser::printCacheReport() const
+{
+    const auto& [hits, misses, stored, evicted, storedBytes, evictedBytes, bytesOnDisk] = pageCache->getStats();
+    const size_t lookups = hits + misses;
+    const double hitRate = lookups > 0 ? 100.0 * static_cast<double>(hits) / static_cast<double>(lookups) : 0.0;
+
+    std::cout << "Page cache" << '\n';
+    std::cout << "  Hits: " << hits << " / " << lookups << " (" << hitRate << "%)" << '\n';
+    std::cout << "  Stored: " << stored << " (" << storedBytes / 1024 << " KB)" << '\n';
+    std::cout << "  Evicted: " << evicted << " (" << evictedBytes / 1024 << " KB)" << '\n';
+    std::cout << "  Size on disk: " << bytesOnDisk / 1024 << " KB" << std::endl;
+}
+
+
 void BaseParser::updateProgress() const
 {
     if (!config.showProgress || pbar->is_completed())
@@ -94,11 +429,8 @@ void BaseParser::updateProgress() const
         return;
     }
 
-    const size_t totalFiles = fileIterator->getTotalFilesCount();
-    const double progress = 100.0 * static_cast<double>(filesProcessed) / static_cast<double>(totalFiles);
-
     // Calculate performance metrics
-    const auto currentTime = std::chrono::high_resolution_clock::now();
+    const auto currentTime = std::chrono::steady_clock::now();
     const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(currentTime - startTime).count();
     const double filesPerSecond = (filesProcessed > 0 && elapsed > 0) ?
         static_cast<double>(filesProcessed) / static_cast<double>(elapsed) : 0.0;
@@ -107,6 +439,14 @@ void BaseParser::updateProgress() const
     const std::string postfixText = std::to_string(filesPerSecond) + " ファイル/s | 項目：" + std::to_string(entriesProcessed);
     pbar->set_option(indicators::option::PostfixText{postfixText});
 
+    const size_t totalFiles = pageSource->getTotalFilesCount();
+    if (totalFiles == 0)
+    {
+        return;
+    }
+
+    const double progress = 100.0 * static_cast<double>(filesProcessed) / static_cast<double>(totalFiles);
+
     // Set progress (avoid 100% until completely done)
     if (progress >= 100.0)
     {
@@ -116,4 +456,5 @@ void BaseParser::updateProgress() const
     {
         pbar->set_progress(progress);
     }
-}
\ No newline at end of file
+}
+
@@ -0,0 +1,54 @@
+#include "yomitan_dictionary_builder/core/checkpoint.h"
+#include "yomitan_dictionary_builder/utils/file_sync.h"
+#include "yomitan_dictionary_builder/utils/file_utils.h"
+
+#include <iostream>
+
+
+Checkpoint::Checkpoint(std::filesystem::path manifestPath) : manifestPath(std::move(manifestPath))
+{
+    if (this->manifestPath.has_parent_path())
+        std::filesystem::create_directories(this->manifestPath.parent_path());
+}
+
+
+std::optional<CheckpointState> Checkpoint::load() const
+{
+    if (!std::filesystem::exists(manifestPath))
+        return std::nullopt;
+
+    const auto json = FileUtils::readFile(manifestPath);
+    if (!json.has_value())
+    {
+        std::cerr << "Failed to read checkpoint: " << manifestPath.string() << std::endl;
+        return std::nullopt;
+    }
+
+    return FileUtils::parseJson<CheckpointState>(json.value());
+}
+
+
+bool Checkpoint::save(const CheckpointState& state) const
+{
+    std::string json;
+    if (const auto ec = glz::write_json(state, json); ec)
+    {
+        std::cerr << "Error writing checkpoint: " << glz::format_error(ec, json) << std::endl;
+        return false;
+    }
+
+    return FileUtils::writeFileAtomically(manifestPath, glz::prettify_json(json));
+}
+
+
+void Checkpoint::remove() const
+{
+    std::error_code ec;
+    std::filesystem::remove(manifestPath, ec);
+}
+
+
+const std::filesystem::path& Checkpoint::getManifestPath() const
+{
+    return manifestPath;
+}
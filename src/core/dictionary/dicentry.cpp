@@ -51,12 +51,27 @@ void DicEntry::setSequenceNumber(const long sequenceNumber)
     this->sequenceNumber = sequenceNumber;
 }
 
-std::string DicEntry::getInfoTag() const
+const std::string& DicEntry::getTerm() const
+{
+    return term;
+}
+
+const std::string& DicEntry::getReading() const
+{
+    return reading;
+}
+
+const std::vector<std::shared_ptr<HTMLElement>>& DicEntry::getElements() const
+{
+    return content;
+}
+
+const std::string& DicEntry::getInfoTag() const
 {
     return infoTag;
 }
 
-std::string DicEntry::getPosTag() const
+const std::string& DicEntry::getPosTag() const
 {
     return posTag;
 }
@@ -91,6 +106,30 @@ DicEntryFormat DicEntry::toList() const
     return result;
 }
 
+size_t DicEntry::estimateSerializedSize() const
+{
+    // ["term","reading","info","pos",rank,[{"type":"structured-content","content":[...]}],sequence,""]
+    size_t size = 80 + term.size() + reading.size() + infoTag.size() + posTag.size();
+
+    for (const auto& element : content)
+        size += element->estimateSerializedSize() + 1;
+
+    return size;
+}
+
+uint64_t DicEntry::getContentHash() const
+{
+    HashUtils::Hasher hasher;
+    hasher.updateField(term).updateField(reading).updateField(infoTag).updateField(posTag);
+    hasher.update(static_cast<uint64_t>(static_cast<int64_t>(searchRank)));
+
+    hasher.update(static_cast<uint64_t>(content.size()));
+    for (const auto& element : content)
+        element->updateHash(hasher);
+
+    return hasher.digest();
+}
+
 void DicEntry::printContent() const
 {
     std::string json;
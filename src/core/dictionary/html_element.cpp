@@ -6,6 +6,10 @@ HTMLElement::HTMLElement(const std::string&  tag) : tag(tag)
 {
 }
 
+HTMLElement::HTMLElement(const Symbol tag) : tag(tag)
+{
+}
+
 HTMLElement::HTMLElement(const std::string& tag, const HTMLElementContent& content) : tag(tag), content(std::vector{content})
 {
 }
@@ -32,7 +36,7 @@ void HTMLElement::addContent(const std::shared_ptr<HTMLElement>& element)
 
 void HTMLElement::setTag(const std::string& value)
 {
-    tag = value;
+    tag = Symbol(value);
 }
 
 
@@ -41,12 +45,17 @@ void HTMLElement::setHref(const std::string& value)
     href = value;
 }
 
-void HTMLElement::setData(const std::unordered_map<std::string, std::string>& value)
+void HTMLElement::setData(DataAttributes value)
 {
-    data = value;
+    data = std::move(value);
 }
 
 const std::string& HTMLElement::getTag() const
+{
+    return tag.str();
+}
+
+Symbol HTMLElement::getTagSymbol() const
 {
     return tag;
 }
@@ -61,11 +70,85 @@ std::optional<std::string> HTMLElement::getHref() const
     return href;
 }
 
-std::optional<std::unordered_map<std::string, std::string>> HTMLElement::getData() const
+const std::optional<DataAttributes>& HTMLElement::getData() const
 {
     return data;
 }
 
+size_t HTMLElement::estimateSerializedSize() const
+{
+    // {"tag":""}
+    size_t size = 10 + tag.view().size();
+
+    if (content)
+    {
+        // ,"content":[]
+        size += 13;
+        for (const auto& item : *content)
+        {
+            if (const auto* text = std::get_if<std::string>(&item))
+                size += text->size() + 3;
+            else if (const auto& element = std::get<std::shared_ptr<HTMLElement>>(item))
+                size += element->estimateSerializedSize() + 1;
+        }
+    }
+
+    // ,"href":""
+    if (href)
+        size += 10 + href->size();
+
+    // ,"data":{} and "key":"value", per attribute
+    if (data)
+    {
+        size += 10;
+        for (const auto& [key, value] : *data)
+            size += key.view().size() + value.size() + 6;
+    }
+
+    return size;
+}
+
+void HTMLElement::updateHash(HashUtils::Hasher& hasher) const
+{
+    hasher.updateField(tag.view());
+
+    // Sizes and markers keep differently nested trees from hashing the same
+    hasher.update(content ? static_cast<uint64_t>(content->size()) : UINT64_MAX);
+    if (content)
+    {
+        for (const auto& item : *content)
+        {
+            if (const auto* text = std::get_if<std::string>(&item))
+            {
+                hasher.update(uint64_t{0}).updateField(*text);
+            }
+            else if (const auto& element = std::get<std::shared_ptr<HTMLElement>>(item))
+            {
+                hasher.update(uint64_t{1});
+                element->updateHash(hasher);
+            }
+            else
+            {
+                hasher.update(uint64_t{2});
+            }
+        }
+    }
+
+    hasher.update(static_cast<uint64_t>(href.has_value()));
+    if (href)
+        hasher.updateField(*href);
+
+    // Combined order independently, which keeps the hashes of entries converted before the attributes were sorted
+    hasher.update(data ? static_cast<uint64_t>(data->size()) : UINT64_MAX);
+    if (data)
+    {
+        uint64_t attributes = 0;
+        for (const auto& [key, value] : *data)
+            attributes += HashUtils::Hasher().updateField(key.view()).updateField(value).digest();
+        hasher.update(attributes);
+    }
+}
+
 void HTMLElement::print()
 {
     std::string json;
@@ -0,0 +1,74 @@
+#include "yomitan_dictionary_builder/core/dictionary/symbol_table.h"
+#include "yomitan_dictionary_builder/core/dictionary/common.h"
+
+#include <mutex>
+#include <stdexcept>
+
+
+SymbolTable::SymbolTable()
+{
+    intern("");
+
+    // The tags every converted element can end up with get the lowest ids
+    for (const auto& element : Yomitan::allowedElements)
+        intern(element);
+}
+
+
+uint32_t SymbolTable::intern(const std::string_view name)
+{
+    // Keys view the names in the table, which are never freed
+    thread_local std::unordered_map<std::string_view, uint32_t> cache;
+
+    if (const auto it = cache.find(name); it != cache.end())
+        return it->second;
+
+    const uint32_t id = insert(name);
+    cache.emplace(resolve(id), id);
+    return id;
+}
+
+
+uint32_t SymbolTable::insert(const std::string_view name)
+{
+    {
+        const std::shared_lock lock(mutex);
+        if (const auto it = ids.find(name); it != ids.end())
+            return it->second;
+    }
+
+    const std::unique_lock lock(mutex);
+    if (const auto it = ids.find(name); it != ids.end())
+        return it->second;
+
+    const uint32_t id = count.load(std::memory_order_relaxed);
+    if (id / CHUNK_SIZE >= MAX_CHUNKS)
+        throw std::length_error("Symbol table is full");
+
+    auto& chunk = chunks[id / CHUNK_SIZE];
+    if (!chunk)
+        chunk = std::make_unique<std::string[]>(CHUNK_SIZE);
+
+    std::string& stored = chunk[id % CHUNK_SIZE];
+    stored.assign(name);
+    ids.emplace(stored, id);
+
+    // Ids are handed out after the name is stored, readers never see a name being written
+    count.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+
+std::optional<uint32_t> SymbolTable::find(const std::string_view name) const
+{
+    const std::shared_lock lock(mutex);
+    if (const auto it = ids.find(name); it != ids.end())
+        return it->second;
+    return std::nullopt;
+}
+
+
+size_t SymbolTable::size() const
+{
+    return count.load(std::memory_order_acquire);
+}
@@ -0,0 +1,153 @@
+#include "yomitan_dictionary_builder/core/dictionary/term_bank_chunk.h"
+
+#include <charconv>
+#include <stdexcept>
+
+
+namespace
+{
+    template<typename T>
+    void appendNumber(std::string& json, const T value)
+    {
+        char digits[24];
+        const auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), value);
+        json.append(digits, end);
+    }
+}
+
+
+TermBankChunk::TermBankChunk() : stringOffsets{0}, contentOffsets{0}
+{
+}
+
+void TermBankChunk::serializeContent(const DicEntry& entry, std::string& json)
+{
+    if (const auto ec = glz::write_json(entry.getElements(), json); ec)
+    {
+        throw std::runtime_error("Failed to serialize entry content: " + glz::format_error(ec, json));
+    }
+}
+
+SerializedEntry TermBankChunk::serialize(const DicEntry& entry)
+{
+    SerializedEntry serialized{
+        entry.getTerm(),
+        entry.getReading(),
+        entry.getInfoTag(),
+        entry.getPosTag(),
+        entry.getSearchRank(),
+        entry.getSequenceNumber(),
+        {},
+        entry.estimateSerializedSize()
+    };
+
+    serializeContent(entry, serialized.content);
+    return serialized;
+}
+
+void TermBankChunk::addEntry(const DicEntry& entry)
+{
+    serializeContent(entry, contentJson);
+    addFields(entry.getTerm(), entry.getReading(), entry.getInfoTag(), entry.getPosTag(),
+              entry.getSearchRank(), entry.getSequenceNumber(), contentJson);
+}
+
+void TermBankChunk::addEntry(const SerializedEntry& entry)
+{
+    addFields(entry.term, entry.reading, entry.infoTag, entry.posTag, entry.searchRank, entry.sequenceNumber, entry.content);
+}
+
+void TermBankChunk::addFields(const std::string_view term, const std::string_view reading, const std::string_view infoTag,
+                              const std::string_view posTag, const int searchRank, const long sequenceNumber,
+                              const std::string_view content)
+{
+    for (const std::string_view field : {term, reading, infoTag, posTag})
+    {
+        strings += field;
+        stringOffsets.push_back(strings.size());
+    }
+
+    searchRanks.push_back(searchRank);
+    sequenceNumbers.push_back(sequenceNumber);
+
+    contents += content;
+    contentOffsets.push_back(contents.size());
+}
+
+void TermBankChunk::writeJson(std::string& json) const
+{
+    json.clear();
+    json.reserve(strings.size() + contents.size() + size() * 48 + 2);
+
+    json += '[';
+    for (size_t i = 0; i < size(); ++i)
+    {
+        if (i > 0)
+            json += ',';
+        appendEntryJson(i, json);
+    }
+    json += ']';
+}
+
+void TermBankChunk::appendEntryJson(const size_t index, std::string& json) const
+{
+    // ["term","reading","info","pos",rank,[content],sequence,""], as glz::meta<DicEntry> writes it
+    json += '[';
+    for (const Field field : {Term, Reading, InfoTag, PosTag})
+    {
+        if (const auto ec = glz::write_json(getField(index, field), escapedString); ec)
+        {
+            throw std::runtime_error("Failed to serialize entry string: " + glz::format_error(ec, escapedString));
+        }
+        json += escapedString;
+        json += ',';
+    }
+
+    appendNumber(json, searchRanks[index]);
+    json += ',';
+    json += getContent(index);
+    json += ',';
+    appendNumber(json, sequenceNumbers[index]);
+    json += R"(,""])";
+}
+
+void TermBankChunk::clear()
+{
+    strings.clear();
+    stringOffsets.resize(1);
+    searchRanks.clear();
+    sequenceNumbers.clear();
+    contents.clear();
+    contentOffsets.resize(1);
+}
+
+size_t TermBankChunk::size() const
+{
+    return searchRanks.size();
+}
+
+bool TermBankChunk::empty() const
+{
+    return searchRanks.empty();
+}
+
+std::string_view TermBankChunk::getTerm(const size_t index) const
+{
+    return getField(index, Term);
+}
+
+std::string_view TermBankChunk::getReading(const size_t index) const
+{
+    return getField(index, Reading);
+}
+
+std::string_view TermBankChunk::getField(const size_t index, const Field field) const
+{
+    const size_t string = index * FieldCount + field;
+    return std::string_view(strings).substr(stringOffsets[string], stringOffsets[string + 1] - stringOffsets[string]);
+}
+
+std::string_view TermBankChunk::getContent(const size_t index) const
+{
+    return std::string_view(contents).substr(contentOffsets[index], contentOffsets[index + 1] - contentOffsets[index]);
+}
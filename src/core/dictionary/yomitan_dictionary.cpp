@@ -1,7 +1,14 @@
 #include "yomitan_dictionary_builder/core/dictionary/yomitan_dictionary.h"
+#include "yomitan_dictionary_builder/utils/file_sync.h"
 #include "yomitan_dictionary_builder/utils/file_utils.h"
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
+#include "yomitan_dictionary_builder/utils/trace_recorder.h"
 
+#include <fstream>
 #include <iostream>
+#include <regex>
+#include <set>
+#include <utility>
 
 
 YomitanDictionary::YomitanDictionary(const YomitanDictionaryConfig &config) : config(config)
@@ -18,6 +25,9 @@ YomitanDictionary::YomitanDictionary(const YomitanDictionaryConfig &config) : co
     }
 
     currentTermBankNumber = FileUtils::getNextTermBankNumber(tempDir);
+
+    if (config.lookupIndexPath.has_value())
+        lookupIndex = std::make_unique<LookupIndexWriter>(config.lookupIndexPath.value());
 }
 
 YomitanDictionary::~YomitanDictionary()
@@ -26,6 +36,8 @@ YomitanDictionary::~YomitanDictionary()
     {
         if (currentChunk.empty())
             flush();
+
+        closeTermBankSink();
     }
     catch (const std::exception &e)
     {
@@ -34,6 +46,11 @@ YomitanDictionary::~YomitanDictionary()
 }
 
 bool YomitanDictionary::addEntry(std::unique_ptr<DicEntry>& entry)
+{
+    return addEntry(std::move(entry));
+}
+
+bool YomitanDictionary::addEntry(std::unique_ptr<DicEntry> &&entry)
 {
     try
     {
@@ -43,11 +60,38 @@ bool YomitanDictionary::addEntry(std::unique_ptr<DicEntry>& entry)
             return false;
         }
 
-        currentChunk.emplace_back(std::move(entry));
+        const uint64_t contentHash = config.foldDuplicates ? entry->getContentHash() : 0;
+
+        // The capture keeps the serialised content, the entry is added from it without serialising it again
+        if (capturing)
+        {
+            SerializedEntry serialized;
+            {
+                const Profiling::ScopedStage stage(Profiling::Stage::Serialization);
+                serialized = TermBankChunk::serialize(*entry);
+            }
+            entry.reset();
+            return addSerializedEntry(std::move(serialized), contentHash);
+        }
+
+        const size_t entryBytes = entry->estimateSerializedSize();
+        if (config.foldDuplicates && isDuplicate(contentHash))
+        {
+            duplicateStats.entries++;
+            duplicateStats.bytes += entryBytes;
+            return true;
+        }
+
+        currentChunkBytes += entryBytes;
+        {
+            const Profiling::ScopedStage stage(Profiling::Stage::Serialization);
+            currentChunk.addEntry(*entry);
+        }
+        entry.reset();
         totalEntries++;
 
         // Check if we should flush the current entry to disk
-        if (currentChunk.size() >= config.CHUNK_SIZE)
+        if (isChunkFull())
         {
             return flushChunkToDisk();
         }
@@ -66,78 +110,283 @@ bool YomitanDictionary::addEntry(std::unique_ptr<DicEntry>& entry)
     }
 }
 
-bool YomitanDictionary::addEntry(std::unique_ptr<DicEntry> &&entry)
+bool YomitanDictionary::addSerializedEntry(SerializedEntry entry, const uint64_t contentHash)
 {
-    try
+    // Sized by the same estimate as the entry it was serialised from, so a replayed page fills term banks
+    // exactly like converting it does
+    const bool duplicate = config.foldDuplicates && isDuplicate(contentHash);
+    if (duplicate)
     {
-        if (!entry)
+        duplicateStats.entries++;
+        duplicateStats.bytes += entry.estimatedSize;
+    }
+    else
+    {
+        currentChunkBytes += entry.estimatedSize;
+        currentChunk.addEntry(entry);
+        totalEntries++;
+    }
+
+    // Captured duplicates included, so a replayed page folds the same entries against the restored hashes
+    if (capturing)
+    {
+        capturedEntries.entries.push_back(std::move(entry));
+        capturedEntries.contentHashes.push_back(contentHash);
+    }
+
+    if (!duplicate && isChunkFull())
+    {
+        return flushChunkToDisk();
+    }
+
+    return true;
+}
+
+void YomitanDictionary::beginCapture()
+{
+    capturedEntries = {};
+    capturing = true;
+}
+
+CapturedEntries YomitanDictionary::endCapture()
+{
+    capturing = false;
+    return std::exchange(capturedEntries, {});
+}
+
+bool YomitanDictionary::isDuplicate(const uint64_t contentHash)
+{
+    if (!contentHashes.insert(contentHash).second)
+        return true;
+
+    uncheckpointedContentHashes.push_back(contentHash);
+    return false;
+}
+
+std::filesystem::path YomitanDictionary::getContentHashPath() const
+{
+    return tempDir / "content_hashes.bin";
+}
+
+size_t YomitanDictionary::getChunkSize() const
+{
+    return currentChunk.size();
+}
+
+bool YomitanDictionary::isChunkFull() const
+{
+    return getChunkSize() >= config.CHUNK_SIZE || (config.CHUNK_BYTES > 0 && currentChunkBytes >= config.CHUNK_BYTES);
+}
+
+std::filesystem::path YomitanDictionary::getTermBankPath(const int termBankNumber) const
+{
+    return tempDir / ("term_bank_" + std::to_string(termBankNumber) + ".json");
+}
+
+std::optional<std::vector<int>> YomitanDictionary::checkpoint()
+{
+    if (!flushChunkToDisk() || !finishTermBankWrite())
+        return std::nullopt;
+
+    const Profiling::ScopedStage stage(Profiling::Stage::DiskWrite);
+
+    for (const int termBankNumber : unsyncedTermBanks)
+    {
+        if (!FileUtils::syncFile(getTermBankPath(termBankNumber)))
         {
-            std::cerr << "Entry cannot be null" << std::endl;
-            return false;
+            std::cerr << "Failed to sync term bank " << termBankNumber << std::endl;
+            return std::nullopt;
         }
+    }
 
-        currentChunk.emplace_back(std::move(entry));
-        totalEntries++;
+    if (!unsyncedTermBanks.empty() && !FileUtils::syncDirectory(tempDir))
+        return std::nullopt;
+
+    unsyncedTermBanks.clear();
 
-        if (currentChunk.size() >= config.CHUNK_SIZE)
+    // The hashes of the kept entries follow the entries, so the checkpoint's entry count selects them on restore
+    if (!uncheckpointedContentHashes.empty())
+    {
+        const std::filesystem::path contentHashPath = getContentHashPath();
+        std::ofstream contentHashFile{contentHashPath, std::ios::binary | std::ios::app};
+        contentHashFile.write(reinterpret_cast<const char*>(uncheckpointedContentHashes.data()),
+                              static_cast<std::streamsize>(uncheckpointedContentHashes.size() * sizeof(uint64_t)));
+        contentHashFile.close();
+
+        if (contentHashFile.fail() || !FileUtils::syncFile(contentHashPath))
         {
-            return flushChunkToDisk();
+            std::cerr << "Failed to write the content hashes of the checkpoint" << std::endl;
+            return std::nullopt;
         }
 
+        uncheckpointedContentHashes.clear();
+    }
+
+    return flushedTermBanks;
+}
+
+bool YomitanDictionary::restoreContentHashes(const size_t entryCount)
+{
+    contentHashes.clear();
+    uncheckpointedContentHashes.clear();
+
+    const std::filesystem::path contentHashPath = getContentHashPath();
+    if (!config.foldDuplicates)
+    {
+        std::filesystem::remove(contentHashPath);
         return true;
     }
-    catch (const std::invalid_argument& e)
+
+    std::vector<uint64_t> hashes(entryCount);
+    if (entryCount > 0)
     {
-        std::cerr << "Invalid argument when adding entry: " << e.what() << std::endl;
-        return false;
+        std::ifstream contentHashFile{contentHashPath, std::ios::binary};
+        contentHashFile.read(reinterpret_cast<char*>(hashes.data()), static_cast<std::streamsize>(hashes.size() * sizeof(uint64_t)));
+        if (!contentHashFile)
+        {
+            std::cerr << "Content hashes of the checkpoint are missing" << std::endl;
+            return false;
+        }
     }
-    catch (const std::exception& e)
+
+    // Hashes written after the checkpoint belong to pages that will be converted again
+    if (std::filesystem::exists(contentHashPath))
+        std::filesystem::resize_file(contentHashPath, entryCount * sizeof(uint64_t));
+
+    contentHashes.insert(hashes.begin(), hashes.end());
+    return true;
+}
+
+void YomitanDictionary::indexChunkEntries()
+{
+    if (!lookupIndex)
+        return;
+
+    std::string entryJson;
+    for (size_t i = 0; i < currentChunk.size(); ++i)
     {
-        std::cerr << "Error when adding entry: " << e.what() << std::endl;
+        entryJson.clear();
+        currentChunk.appendEntryJson(i, entryJson);
+
+        const uint64_t record = lookupIndex->addRecord(entryJson);
+        lookupIndex->addKey(currentChunk.getTerm(i), record);
+        lookupIndex->addKey(currentChunk.getReading(i), record);
+    }
+}
+
+bool YomitanDictionary::restoreCheckpoint(const std::vector<int>& termBanks, const size_t entryCount)
+{
+    closeTermBankSink();
+
+    try
+    {
+        const std::set<int> keptTermBanks(termBanks.begin(), termBanks.end());
+        const std::regex termBankPattern(R"(term_bank_(\d+)\.json$)");
+
+        // Term banks written after the checkpoint belong to pages that will be converted again
+        for (const auto& entry : std::filesystem::directory_iterator(tempDir))
+        {
+            const std::string filename = entry.path().filename().string();
+            if (std::smatch match; entry.is_regular_file() && std::regex_match(filename, match, termBankPattern) &&
+                !keptTermBanks.contains(std::stoi(match[1].str())))
+            {
+                std::filesystem::remove(entry.path());
+            }
+        }
+
+        for (const int termBankNumber : keptTermBanks)
+        {
+            if (!std::filesystem::exists(getTermBankPath(termBankNumber)))
+            {
+                std::cerr << "Term bank " << termBankNumber << " of the checkpoint is missing" << std::endl;
+                return false;
+            }
+        }
+
+        if (!restoreContentHashes(entryCount))
+            return false;
+    }
+    catch (const std::filesystem::filesystem_error& e)
+    {
+        std::cerr << "Filesystem error when restoring checkpoint: " << e.what() << std::endl;
         return false;
     }
+
+    currentChunk.clear();
+    currentChunkBytes = 0;
+    flushedTermBanks = termBanks;
+    unsyncedTermBanks.clear();
+    totalEntries = entryCount;
+    currentTermBankNumber = termBanks.empty() ? 1 : *std::ranges::max_element(termBanks) + 1;
+    duplicateStats = {};
+
+    // The index can't be resumed, a resumed conversion leaves it out
+    if (lookupIndex && entryCount > 0)
+    {
+        std::cerr << "Resumed conversion, no lookup index is written" << std::endl;
+        lookupIndex.reset();
+    }
+    return true;
 }
 
 bool YomitanDictionary::flush()
 {
-    return flushChunkToDisk();
+    return flushChunkToDisk() && finishTermBankWrite();
 }
 
 bool YomitanDictionary::flushChunkToDisk()
 {
-    if (currentChunk.empty())
+    if (getChunkSize() == 0)
         return true;
 
+    Profiling::ScopedTrace trace("flushChunk", "dictionary");
+
     try
     {
         if (!ensureTempDirExits())
             return false;
 
-        const std::filesystem::path filename {"term_bank_" + std::to_string(currentTermBankNumber) + ".json"};
-        const std::filesystem::path termBankPath {tempDir / filename};
+        const int termBankNumber = currentTermBankNumber;
+        const std::filesystem::path termBankPath {getTermBankPath(termBankNumber)};
+
+        if (trace.isActive())
+            trace.setDetail(termBankPath.filename().string() + " (" + std::to_string(getChunkSize()) + " entries)");
 
         currentTermBankNumber++;
 
-        std::ofstream termBankFile {termBankPath, std::ios::trunc};
-        if (!termBankFile.is_open())
+        std::string termBankJson;
         {
-            throw std::runtime_error("Could not open term bank file");
+            const Profiling::ScopedStage stage(Profiling::Stage::Serialization);
+            currentChunk.writeJson(termBankJson);
+            termBankJson = config.formatPretty ? glz::prettify_json(termBankJson) : glz::minify_json(termBankJson);
         }
 
-        std::string termBankJson;
-        if (const auto ec = glz::write_json(currentChunk, termBankJson); ec)
-        {
-            std::cerr << "Error: when writing chunk to json: " << glz::format_error(ec, termBankJson) << std::endl;
+        // The previous term bank was written while this chunk was serialised
+        if (!finishTermBankWrite())
             return false;
-        }
 
-        if (config.formatPretty)
-            termBankFile << glz::prettify_json(termBankJson);
+        const Profiling::ScopedStage stage(Profiling::Stage::DiskWrite);
+        if (termBankSink)
+        {
+            termBankSink->switchFile(termBankPath);
+        }
         else
-            termBankFile << glz::minify_json(termBankJson);
+        {
+            FileUtils::OutputSinkOptions options;
+            options.writeBehind = config.writeBehind;
+            termBankSink = FileUtils::openOutputSink(termBankPath, 0, options);
+        }
+        termBankSink->write(termBankJson);
+        if (!config.writeBehind && !finishTermBankWrite())
+            return false;
+
+        flushedTermBanks.push_back(termBankNumber);
+        unsyncedTermBanks.push_back(termBankNumber);
+        indexChunkEntries();
 
-        // Clear the chunk after write
+        // Clear the chunk after write, its buffers are reused for the next one
         currentChunk.clear();
+        currentChunkBytes = 0;
         return true;
     }
     catch (std::filesystem::filesystem_error& e)
@@ -152,6 +401,47 @@ bool YomitanDictionary::flushChunkToDisk()
     }
 }
 
+bool YomitanDictionary::finishTermBankWrite()
+{
+    if (!termBankSink)
+        return true;
+
+    const Profiling::ScopedStage stage(Profiling::Stage::DiskWrite);
+
+    try
+    {
+        termBankSink->flush();
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Could not write term bank file: " << e.what() << std::endl;
+        termBankSink.reset();
+        return false;
+    }
+}
+
+bool YomitanDictionary::closeTermBankSink()
+{
+    if (!termBankSink)
+        return true;
+
+    const Profiling::ScopedStage stage(Profiling::Stage::DiskWrite);
+
+    try
+    {
+        termBankSink->close();
+        termBankSink.reset();
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Could not write term bank file: " << e.what() << std::endl;
+        termBankSink.reset();
+        return false;
+    }
+}
+
 bool YomitanDictionary::exportIndex(const std::string_view outputPath) const
 {
     try
@@ -279,15 +569,25 @@ size_t YomitanDictionary::getEntryCount() const
     return totalEntries;
 }
 
+const DuplicateStats& YomitanDictionary::getDuplicateStats() const
+{
+    return duplicateStats;
+}
+
 bool YomitanDictionary::exportDictionary(const std::string_view outputPath)
 {
     // first flush any remaining entries
-    if (!currentChunk.empty() && !flushChunkToDisk())
+    if (getChunkSize() > 0 && !flushChunkToDisk())
     {
         std::cerr << "Failed to flush remaining entries during exporting: " << std::endl;
         return false;
     }
 
+    if (!closeTermBankSink())
+    {
+        return false;
+    }
+
     // export index file
     if (!moveTermBanksToOutput(outputPath))
     {
@@ -298,6 +598,16 @@ bool YomitanDictionary::exportDictionary(const std::string_view outputPath)
     {
         return false;
     }
+
+    if (lookupIndex && !lookupIndex->finish())
+    {
+        return false;
+    }
+
+    if (duplicateStats.entries > 0)
+    {
+        std::cout << "Folded " << duplicateStats.entries << " duplicate entries (" << duplicateStats.bytes << " bytes)" << std::endl;
+    }
     return true;
 }
 
@@ -0,0 +1,570 @@
+#include "yomitan_dictionary_builder/core/entry_store.h"
+#include "yomitan_dictionary_builder/utils/file_sync.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr std::string_view STORE_MAGIC = "YDBSTORE";
+    constexpr std::string_view FOOTER_MAGIC = "YDBSTEND";
+    constexpr uint64_t STORE_VERSION = 1;
+
+    // magic, version
+    constexpr size_t HEADER_SIZE = 16;
+    // entry count, table offset, magic
+    constexpr size_t FOOTER_SIZE = 24;
+
+    // Deeper trees are taken as a corrupt record rather than recursed into
+    constexpr size_t MAX_ELEMENT_DEPTH = 512;
+
+    enum ElementFlags : uint64_t
+    {
+        HAS_HREF = 1,
+        HAS_DATA = 2,
+        HAS_CONTENT = 4
+    };
+
+    enum ContentKind : uint64_t
+    {
+        TEXT_CONTENT = 0,
+        ELEMENT_CONTENT = 1
+    };
+
+
+    void encodeElement(PageRecordWriter& record, const HTMLElement& element)
+    {
+        const auto href = element.getHref();
+        const auto& data = element.getData();
+        const auto& content = element.getContent();
+
+        uint64_t flags = 0;
+        if (href)
+            flags |= HAS_HREF;
+        if (data)
+            flags |= HAS_DATA;
+        if (content)
+            flags |= HAS_CONTENT;
+
+        record.writeString(element.getTag());
+        record.writeUint64(flags);
+
+        if (href)
+            record.writeString(href.value());
+
+        if (data)
+        {
+            // Sorted by key, so the same entry always encodes to the same bytes
+            record.writeUint64(data->size());
+            for (const auto& [key, value] : *data)
+            {
+                record.writeString(key.view());
+                record.writeString(value);
+            }
+        }
+
+        if (content)
+        {
+            record.writeUint64(content->size());
+            for (const auto& item : *content)
+            {
+                if (const auto* text = std::get_if<std::string>(&item))
+                {
+                    record.writeUint64(TEXT_CONTENT);
+                    record.writeString(*text);
+                }
+                else
+                {
+                    record.writeUint64(ELEMENT_CONTENT);
+                    encodeElement(record, *std::get<std::shared_ptr<HTMLElement>>(item));
+                }
+            }
+        }
+    }
+
+
+    std::shared_ptr<HTMLElement> decodeElement(PageRecordReader& record, const size_t depth)
+    {
+        std::string tag;
+        uint64_t flags = 0;
+        if (depth > MAX_ELEMENT_DEPTH || !record.readString(tag) || !record.readUint64(flags))
+            return nullptr;
+
+        std::string href;
+        if ((flags & HAS_HREF) && !record.readString(href))
+            return nullptr;
+
+        DataAttributes data;
+        if (flags & HAS_DATA)
+        {
+            uint64_t attributeCount = 0;
+            if (!record.readUint64(attributeCount))
+                return nullptr;
+
+            std::string key;
+            std::string value;
+            for (uint64_t i = 0; i < attributeCount; ++i)
+            {
+                if (!record.readString(key) || !record.readString(value))
+                    return nullptr;
+                data.set(key, value);
+            }
+        }
+
+        std::vector<HTMLElementContent> content;
+        if (flags & HAS_CONTENT)
+        {
+            uint64_t itemCount = 0;
+            if (!record.readUint64(itemCount))
+                return nullptr;
+
+            for (uint64_t i = 0; i < itemCount; ++i)
+            {
+                uint64_t kind = 0;
+                if (!record.readUint64(kind))
+                    return nullptr;
+
+                if (kind == TEXT_CONTENT)
+                {
+                    std::string text;
+                    if (!record.readString(text))
+                        return nullptr;
+                    content.emplace_back(std::move(text));
+                }
+                else if (kind == ELEMENT_CONTENT)
+                {
+                    const auto child = decodeElement(record, depth + 1);
+                    if (!child)
+                        return nullptr;
+                    content.emplace_back(child);
+                }
+                else
+                {
+                    return nullptr;
+                }
+            }
+        }
+
+        // An empty content list is kept, it serialises differently from no content
+        auto element = (flags & HAS_CONTENT) ? std::make_shared<HTMLElement>(tag, content) : std::make_shared<HTMLElement>(tag);
+
+        if (flags & HAS_HREF)
+            element->setHref(href);
+
+        if (flags & HAS_DATA)
+            element->setData(std::move(data));
+
+        return element;
+    }
+
+
+    void encodeEntry(PageRecordWriter& record, const DicEntry& entry)
+    {
+        record.writeString(entry.getTerm());
+        record.writeString(entry.getReading());
+        record.writeString(entry.getInfoTag());
+        record.writeString(entry.getPosTag());
+        record.writeUint64(static_cast<uint64_t>(static_cast<int64_t>(entry.getSearchRank())));
+        record.writeUint64(static_cast<uint64_t>(static_cast<int64_t>(entry.getSequenceNumber())));
+
+        record.writeUint64(entry.getElements().size());
+        for (const auto& element : entry.getElements())
+            encodeElement(record, *element);
+    }
+
+
+    std::unique_ptr<DicEntry> decodeEntry(PageRecordReader& record)
+    {
+        std::string term;
+        std::string reading;
+        std::string infoTag;
+        std::string posTag;
+        uint64_t searchRank = 0;
+        uint64_t sequenceNumber = 0;
+        uint64_t elementCount = 0;
+
+        if (!record.readString(term) || !record.readString(reading) || !record.readString(infoTag) ||
+            !record.readString(posTag) || !record.readUint64(searchRank) || !record.readUint64(sequenceNumber) ||
+            !record.readUint64(elementCount))
+        {
+            return nullptr;
+        }
+
+        auto entry = std::make_unique<DicEntry>(term, reading);
+        entry->setInfoTag(infoTag);
+        entry->setPosTag(posTag);
+        entry->setSearchRank(static_cast<int>(static_cast<int64_t>(searchRank)));
+        entry->setSequenceNumber(static_cast<long>(static_cast<int64_t>(sequenceNumber)));
+
+        for (uint64_t i = 0; i < elementCount; ++i)
+        {
+            const auto element = decodeElement(record, 0);
+            if (!element)
+                return nullptr;
+            entry->addElement(element);
+        }
+
+        return entry;
+    }
+
+
+    uint64_t readUint64At(const std::string_view data, const size_t position)
+    {
+        uint64_t value = 0;
+        PageRecordReader reader(data.substr(position, 8));
+        reader.readUint64(value);
+        return value;
+    }
+
+
+    void appendEscaped(std::string& html, const std::string_view text, const bool isAttribute)
+    {
+        for (const char c : text)
+        {
+            switch (c)
+            {
+                case '&': html += "&amp;"; break;
+                case '<': html += "&lt;"; break;
+                case '>': html += "&gt;"; break;
+                case '"':
+                    if (isAttribute)
+                        html += "&quot;";
+                    else
+                        html += c;
+                    break;
+                default: html += c;
+            }
+        }
+    }
+
+
+    void renderElement(std::string& html, const HTMLElement& element)
+    {
+        const std::string& tag = element.getTag();
+
+        html += '<';
+        html += tag;
+
+        if (const auto href = element.getHref())
+        {
+            html += " href=\"";
+            appendEscaped(html, href.value(), true);
+            html += '"';
+        }
+
+        if (const auto& data = element.getData())
+        {
+            for (const auto& [key, value] : *data)
+            {
+                html += " data-sc-";
+                html += key.view();
+                html += "=\"";
+                appendEscaped(html, value, true);
+                html += '"';
+            }
+        }
+
+        html += '>';
+
+        if (tag == "br" || tag == "img")
+            return;
+
+        if (const auto& content = element.getContent())
+        {
+            for (const auto& item : *content)
+            {
+                if (const auto* text = std::get_if<std::string>(&item))
+                    appendEscaped(html, *text, false);
+                else
+                    renderElement(html, *std::get<std::shared_ptr<HTMLElement>>(item));
+            }
+        }
+
+        html += "</";
+        html += tag;
+        html += '>';
+    }
+}
+
+
+EntryStoreWriter::EntryStoreWriter(std::filesystem::path storePath) : storePath(std::move(storePath))
+{
+    tempPath = this->storePath;
+    tempPath += ".tmp";
+
+    if (this->storePath.has_parent_path())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(this->storePath.parent_path(), ec);
+    }
+
+    file.open(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open entry store: " + tempPath.string());
+    }
+
+    PageRecordWriter header;
+    header.writeUint64(STORE_VERSION);
+    file << STORE_MAGIC << header.take();
+    offset = HEADER_SIZE;
+}
+
+
+EntryStoreWriter::~EntryStoreWriter()
+{
+    try
+    {
+        if (!finished)
+            finish();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error in EntryStoreWriter destructor: " << e.what() << std::endl;
+    }
+}
+
+
+void EntryStoreWriter::append(const uint64_t pageId, const DicEntry& entry)
+{
+    PageRecordWriter record;
+    encodeEntry(record, entry);
+    appendEncoded(pageId, record.take());
+}
+
+
+void EntryStoreWriter::appendEncoded(const uint64_t pageId, const std::string_view encodedEntry)
+{
+    if (finished)
+    {
+        throw std::runtime_error("Cannot append to a finished entry store");
+    }
+
+    PageRecordWriter record;
+    record.writeUint64(pageId);
+    file << record.take() << encodedEntry;
+
+    offsets.push_back(offset);
+    offset += 8 + encodedEntry.size();
+
+    if (capturing)
+        capturedEntries.emplace_back(encodedEntry);
+}
+
+
+void EntryStoreWriter::beginCapture()
+{
+    capturedEntries.clear();
+    capturing = true;
+}
+
+
+std::vector<std::string> EntryStoreWriter::endCapture()
+{
+    capturing = false;
+    return std::exchange(capturedEntries, {});
+}
+
+
+bool EntryStoreWriter::finish()
+{
+    if (finished)
+        return true;
+
+    finished = true;
+
+    PageRecordWriter table;
+    for (const uint64_t recordOffset : offsets)
+        table.writeUint64(recordOffset);
+    table.writeUint64(offsets.size());
+    table.writeUint64(offset);
+
+    file << table.take() << FOOTER_MAGIC;
+    file.close();
+    if (file.fail())
+    {
+        std::cerr << "Failed to write entry store: " << tempPath.string() << std::endl;
+        return false;
+    }
+
+    if (!FileUtils::syncFile(tempPath))
+        return false;
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, storePath, ec);
+    if (ec)
+    {
+        std::cerr << "Failed to move entry store into place: " << ec.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+size_t EntryStoreWriter::size() const
+{
+    return offsets.size();
+}
+
+
+EntryStoreReader::EntryStoreReader(const std::filesystem::path& storePath)
+{
+#ifdef _WIN32
+    std::ifstream file(storePath, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open entry store: " + storePath.string());
+    }
+
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = buffer;
+#else
+    const int fd = ::open(storePath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to open entry store: " + storePath.string());
+    }
+
+    struct stat status{};
+    if (::fstat(fd, &status) == 0 && status.st_size > 0)
+    {
+        mappingSize = static_cast<size_t>(status.st_size);
+        if (void* address = ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0); address != MAP_FAILED)
+        {
+            mapping = address;
+            data = std::string_view(static_cast<const char*>(mapping), mappingSize);
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (data.size() < HEADER_SIZE + FOOTER_SIZE || !data.starts_with(STORE_MAGIC) || !data.ends_with(FOOTER_MAGIC) ||
+        readUint64At(data, STORE_MAGIC.size()) != STORE_VERSION)
+    {
+        unmap();
+        throw std::runtime_error("Not a complete entry store: " + storePath.string());
+    }
+
+    const size_t footer = data.size() - FOOTER_SIZE;
+    const uint64_t count = readUint64At(data, footer);
+    tableOffset = readUint64At(data, footer + 8);
+
+    bool valid = tableOffset >= HEADER_SIZE && tableOffset <= footer && (footer - tableOffset) / 8 == count &&
+                 (footer - tableOffset) % 8 == 0;
+
+    // Records must follow each other, so reading one never runs into the next or the table
+    uint64_t previous = HEADER_SIZE;
+    for (uint64_t i = 0; valid && i < count; ++i)
+    {
+        const uint64_t recordOffset = readUint64At(data, tableOffset + i * 8);
+        valid = recordOffset >= previous && recordOffset + 8 <= tableOffset;
+        previous = recordOffset + 8;
+    }
+
+    if (!valid)
+    {
+        unmap();
+        throw std::runtime_error("Corrupt entry store table: " + storePath.string());
+    }
+
+    entryCount = count;
+}
+
+
+EntryStoreReader::~EntryStoreReader()
+{
+    unmap();
+}
+
+
+void EntryStoreReader::unmap()
+{
+#ifndef _WIN32
+    if (mapping)
+    {
+        ::munmap(mapping, mappingSize);
+        mapping = nullptr;
+    }
+#endif
+
+    data = {};
+}
+
+
+size_t EntryStoreReader::size() const
+{
+    return entryCount;
+}
+
+
+std::string_view EntryStoreReader::getRecord(const size_t index) const
+{
+    const uint64_t start = readUint64At(data, tableOffset + index * 8);
+    const uint64_t end = index + 1 < entryCount ? readUint64At(data, tableOffset + (index + 1) * 8) : tableOffset;
+    return data.substr(start, end - start);
+}
+
+
+std::optional<EntryStoreReader::StoredEntry> EntryStoreReader::read(const size_t index) const
+{
+    if (index >= entryCount)
+        return std::nullopt;
+
+    PageRecordReader record(getRecord(index));
+
+    StoredEntry stored;
+    if (!record.readUint64(stored.pageId))
+        return std::nullopt;
+
+    try
+    {
+        stored.entry = decodeEntry(record);
+    }
+    catch (const std::invalid_argument& e)
+    {
+        std::cerr << "Invalid entry in entry store: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+
+    if (!stored.entry || !record.atEnd())
+        return std::nullopt;
+
+    return stored;
+}
+
+
+bool EntryStoreReader::emit(YomitanDictionary& dictionary) const
+{
+    for (size_t i = 0; i < entryCount; ++i)
+    {
+        auto stored = read(i);
+        if (!stored.has_value())
+        {
+            std::cerr << "Entry " << i << " of the entry store is corrupt" << std::endl;
+            return false;
+        }
+
+        if (!dictionary.addEntry(std::move(stored->entry)))
+            return false;
+    }
+
+    return true;
+}
+
+
+std::string EntryStoreReader::renderHtml(const DicEntry& entry)
+{
+    std::string html;
+    for (const auto& element : entry.getElements())
+        renderElement(html, *element);
+    return html;
+}
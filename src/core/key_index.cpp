@@ -0,0 +1,591 @@
+#include "yomitan_dictionary_builder/core/key_index.h"
+#include "yomitan_dictionary_builder/utils/jptools/kana_convert.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::string_view INDEX_MAGIC = "YDBKEYIX";
+    constexpr std::string_view FOOTER_MAGIC = "YDBKIEND";
+    constexpr uint64_t INDEX_VERSION = 1;
+
+    // magic, version
+    constexpr size_t HEADER_SIZE = 16;
+    // node count, node table, key count, key table, value count, value table, magic
+    constexpr size_t FOOTER_SIZE = 56;
+
+    constexpr size_t NODE_SIZE = 8;
+    constexpr size_t KEY_ROW_SIZE = 12;
+    constexpr size_t VALUE_ROW_SIZE = 16;
+
+    // Byte b of a key leads to the child at base + b + 1, the end of a key to base + 0
+    constexpr int END_CODE = 0;
+    constexpr int MAX_CODE = 256;
+    constexpr uint32_t NO_KEY = std::numeric_limits<uint32_t>::max();
+
+
+    template<typename T>
+    void appendLittleEndian(std::string& out, const T value)
+    {
+        auto bits = static_cast<std::make_unsigned_t<T>>(value);
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+            out += static_cast<char>(bits & 0xFF);
+            bits >>= 8;
+        }
+    }
+
+
+    template<typename T>
+    T readLittleEndian(const std::string_view data, const size_t position)
+    {
+        T value;
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            std::memcpy(&value, data.data() + position, sizeof(T));
+        }
+        else
+        {
+            std::make_unsigned_t<T> bits = 0;
+            for (int i = sizeof(T) - 1; i >= 0; --i)
+                bits = (bits << 8) | static_cast<unsigned char>(data[position + i]);
+            value = static_cast<T>(bits);
+        }
+        return value;
+    }
+
+
+    /**
+     * @brief Lays out a trie over sorted, distinct keys in a double array
+     *
+     * The children of a node are placed at the first base where all their cells are free. The search
+     * for a base starts at the first cell that wasn't free in a search that found mostly used cells,
+     * so building doesn't rescan the densely filled start of the array for every node.
+     */
+    class DoubleArrayBuilder
+    {
+    public:
+        explicit DoubleArrayBuilder(const std::vector<std::string_view>& keys) : keys(keys)
+        {
+        }
+
+        /**
+         * Builds the array
+         * @return False if the array would be too large for 32 bit nodes
+         */
+        bool build()
+        {
+            base.assign(1, 0);
+            check.assign(1, 0);
+
+            if (!keys.empty())
+                insert(0, 0, keys.size(), 0);
+
+            return !tooLarge;
+        }
+
+        std::vector<int32_t> base;
+        std::vector<int32_t> check;
+
+    private:
+        struct Child
+        {
+            int code;
+            size_t first;
+            size_t last;
+        };
+
+        [[nodiscard]] int getCode(const size_t keyIndex, const size_t depth) const
+        {
+            const std::string_view key = keys[keyIndex];
+            return depth < key.size() ? static_cast<unsigned char>(key[depth]) + 1 : END_CODE;
+        }
+
+        void reserveCell(const size_t cell)
+        {
+            if (cell >= static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+            {
+                tooLarge = true;
+                return;
+            }
+
+            if (cell >= base.size())
+            {
+                base.resize(cell + 1, 0);
+                check.resize(cell + 1, -1);
+            }
+        }
+
+        void insert(const uint32_t node, const size_t first, const size_t last, const size_t depth)
+        {
+            // The rest of a single key is compared against the stored key
+            if (last - first == 1)
+            {
+                base[node] = -static_cast<int32_t>(first + 1);
+                return;
+            }
+
+            // The keys are sorted, so the keys of a child are next to each other and a key ending here comes first
+            std::vector<Child> children;
+            for (size_t i = first; i < last; ++i)
+            {
+                const int code = getCode(i, depth);
+                if (children.empty() || children.back().code != code)
+                    children.push_back({code, i, i + 1});
+                else
+                    children.back().last = i + 1;
+            }
+
+            const uint32_t childBase = findBase(children);
+            if (tooLarge)
+                return;
+
+            base[node] = static_cast<int32_t>(childBase);
+            for (const auto& child : children)
+                check[childBase + child.code] = static_cast<int32_t>(node);
+
+            for (const auto& child : children)
+            {
+                insert(childBase + child.code, child.first, child.last, depth + 1);
+                if (tooLarge)
+                    return;
+            }
+        }
+
+        uint32_t findBase(const std::vector<Child>& children)
+        {
+            const int firstCode = children.front().code;
+            const int lastCode = children.back().code;
+
+            size_t position = std::max<size_t>(firstCode + 1, nextCheckPosition) - 1;
+            size_t usedCells = 0;
+            bool firstFree = true;
+            size_t childBase = 0;
+
+            while (true)
+            {
+                reserveCell(++position);
+                if (tooLarge)
+                    return 0;
+
+                if (check[position] >= 0)
+                {
+                    ++usedCells;
+                    continue;
+                }
+
+                if (firstFree)
+                {
+                    nextCheckPosition = position;
+                    firstFree = false;
+                }
+
+                childBase = position - firstCode;
+                reserveCell(childBase + lastCode);
+                if (tooLarge)
+                    return 0;
+
+                if (std::ranges::all_of(children, [&](const Child& child) { return check[childBase + child.code] < 0; }))
+                    break;
+            }
+
+            if (usedCells * 20 >= (position - nextCheckPosition + 1) * 19)
+                nextCheckPosition = position;
+
+            return static_cast<uint32_t>(childBase);
+        }
+
+        const std::vector<std::string_view>& keys;
+        size_t nextCheckPosition = 1;
+        bool tooLarge = false;
+    };
+}
+
+
+KeyIndexWriter::KeyIndexWriter() = default;
+
+
+KeyIndexWriter::~KeyIndexWriter() = default;
+
+
+void KeyIndexWriter::addKey(const std::string_view key, const uint64_t entryId)
+{
+    if (finished)
+        throw std::runtime_error("Cannot add keys to a finished key index");
+
+    if (!key.empty())
+        keys.emplace_back(key, entryId);
+}
+
+
+size_t KeyIndexWriter::getKeyCount() const
+{
+    return keys.size();
+}
+
+
+bool KeyIndexWriter::build(std::string& index)
+{
+    if (finished)
+        throw std::runtime_error("Key index was already built");
+
+    finished = true;
+
+    struct Value
+    {
+        std::string normalized;
+        std::string key;
+        uint64_t entryId;
+
+        bool operator==(const Value&) const = default;
+    };
+
+    std::vector<Value> values;
+    values.reserve(keys.size());
+    for (auto& [key, entryId] : keys)
+    {
+        std::string normalized = KanaConvert::katakanaToHiragana(key);
+        values.push_back({std::move(normalized), std::move(key), entryId});
+    }
+    keys.clear();
+    keys.shrink_to_fit();
+
+    std::ranges::sort(values, [](const Value& a, const Value& b) {
+        if (a.normalized != b.normalized)
+            return a.normalized < b.normalized;
+        if (a.key != b.key)
+            return a.key < b.key;
+        return a.entryId < b.entryId;
+    });
+    const auto duplicates = std::ranges::unique(values);
+    values.erase(duplicates.begin(), duplicates.end());
+
+    // Normalised keys first, then the original keys that aren't their normalised key
+    std::string strings;
+    std::vector<std::string_view> normalizedKeys;
+    std::vector<uint32_t> keyOffsets;
+    std::vector<uint32_t> firstValues;
+    std::vector<uint32_t> valueOffsets(values.size());
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (normalizedKeys.empty() || normalizedKeys.back() != values[i].normalized)
+        {
+            normalizedKeys.emplace_back(values[i].normalized);
+            keyOffsets.push_back(static_cast<uint32_t>(HEADER_SIZE + strings.size()));
+            firstValues.push_back(static_cast<uint32_t>(i));
+            strings += values[i].normalized;
+        }
+    }
+
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (values[i].key == values[i].normalized)
+            valueOffsets[i] = keyOffsets[std::ranges::lower_bound(normalizedKeys, values[i].normalized) - normalizedKeys.begin()];
+        else if (i > 0 && values[i].key == values[i - 1].key)
+            valueOffsets[i] = valueOffsets[i - 1];
+        else
+        {
+            valueOffsets[i] = static_cast<uint32_t>(HEADER_SIZE + strings.size());
+            strings += values[i].key;
+        }
+
+        if (HEADER_SIZE + strings.size() > std::numeric_limits<uint32_t>::max())
+        {
+            std::cerr << "Too many keys for a key index" << std::endl;
+            return false;
+        }
+    }
+
+    DoubleArrayBuilder trie(normalizedKeys);
+    if (!trie.build())
+    {
+        std::cerr << "Too many keys for a key index" << std::endl;
+        return false;
+    }
+
+    index.assign(INDEX_MAGIC);
+    appendLittleEndian(index, INDEX_VERSION);
+    index.reserve(HEADER_SIZE + strings.size() + trie.base.size() * NODE_SIZE + (normalizedKeys.size() + 1) * KEY_ROW_SIZE +
+                  values.size() * VALUE_ROW_SIZE + FOOTER_SIZE);
+    index += strings;
+
+    const uint64_t nodeTable = HEADER_SIZE + strings.size();
+    for (size_t i = 0; i < trie.base.size(); ++i)
+    {
+        appendLittleEndian(index, trie.base[i]);
+        appendLittleEndian(index, trie.check[i]);
+    }
+
+    const uint64_t keyTable = nodeTable + trie.base.size() * NODE_SIZE;
+    for (size_t i = 0; i < normalizedKeys.size(); ++i)
+    {
+        appendLittleEndian(index, keyOffsets[i]);
+        appendLittleEndian(index, static_cast<uint32_t>(normalizedKeys[i].size()));
+        appendLittleEndian(index, firstValues[i]);
+    }
+    appendLittleEndian(index, uint32_t{0});
+    appendLittleEndian(index, uint32_t{0});
+    appendLittleEndian(index, static_cast<uint32_t>(values.size()));
+
+    const uint64_t valueTable = keyTable + (normalizedKeys.size() + 1) * KEY_ROW_SIZE;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        appendLittleEndian(index, valueOffsets[i]);
+        appendLittleEndian(index, static_cast<uint32_t>(values[i].key.size()));
+        appendLittleEndian(index, values[i].entryId);
+    }
+
+    appendLittleEndian(index, static_cast<uint64_t>(trie.base.size()));
+    appendLittleEndian(index, nodeTable);
+    appendLittleEndian(index, static_cast<uint64_t>(normalizedKeys.size()));
+    appendLittleEndian(index, keyTable);
+    appendLittleEndian(index, static_cast<uint64_t>(values.size()));
+    appendLittleEndian(index, valueTable);
+    index += FOOTER_MAGIC;
+    return true;
+}
+
+
+KeyIndexReader::KeyIndexReader(const std::string_view index) : data(index)
+{
+    auto readUint64 = [this](const size_t position) { return readLittleEndian<uint64_t>(data, position); };
+
+    if (data.size() < HEADER_SIZE + FOOTER_SIZE || !data.starts_with(INDEX_MAGIC) || !data.ends_with(FOOTER_MAGIC) ||
+        readUint64(INDEX_MAGIC.size()) != INDEX_VERSION)
+    {
+        throw std::runtime_error("Not a complete key index");
+    }
+
+    const size_t footer = data.size() - FOOTER_SIZE;
+    nodeCount = readUint64(footer);
+    nodeTable = readUint64(footer + 8);
+    keyCount = readUint64(footer + 16);
+    keyTable = readUint64(footer + 24);
+    valueCount = readUint64(footer + 32);
+    valueTable = readUint64(footer + 40);
+
+    bool valid = nodeCount > 0 && nodeCount < static_cast<uint64_t>(std::numeric_limits<int32_t>::max()) &&
+                 keyCount < NO_KEY && valueCount <= std::numeric_limits<uint32_t>::max() &&
+                 nodeTable >= HEADER_SIZE && nodeTable <= footer &&
+                 (footer - nodeTable) / NODE_SIZE >= nodeCount &&
+                 keyTable == nodeTable + nodeCount * NODE_SIZE &&
+                 (footer - keyTable) / KEY_ROW_SIZE >= keyCount + 1 &&
+                 valueTable == keyTable + (keyCount + 1) * KEY_ROW_SIZE &&
+                 (footer - valueTable) / VALUE_ROW_SIZE == valueCount &&
+                 valueTable + valueCount * VALUE_ROW_SIZE == footer;
+
+    // Everything a lookup reads is checked once here, so lookups need no checks of their own
+    for (uint32_t node = 0; valid && node < nodeCount; ++node)
+    {
+        const int32_t base = getBase(node);
+        const int32_t check = getCheck(node);
+        valid = (base >= 0 || static_cast<uint64_t>(-(static_cast<int64_t>(base) + 1)) < keyCount) &&
+                check >= -1 && static_cast<int64_t>(check) < static_cast<int64_t>(nodeCount);
+    }
+
+    auto validString = [this](const uint64_t offset, const uint64_t length) {
+        return offset >= HEADER_SIZE && length <= nodeTable && offset <= nodeTable - length;
+    };
+
+    uint32_t previousFirstValue = 0;
+    for (uint32_t key = 0; valid && key <= keyCount; ++key)
+    {
+        const size_t row = keyTable + key * KEY_ROW_SIZE;
+        const uint32_t firstValue = getFirstValue(key);
+        valid = firstValue >= previousFirstValue && firstValue <= valueCount &&
+                (key == keyCount ? firstValue == valueCount : validString(readUint64(row) & 0xFFFFFFFF, readUint64(row) >> 32));
+        previousFirstValue = firstValue;
+    }
+
+    for (uint32_t value = 0; valid && value < valueCount; ++value)
+    {
+        const size_t row = valueTable + value * VALUE_ROW_SIZE;
+        valid = validString(readUint64(row) & 0xFFFFFFFF, readUint64(row) >> 32);
+    }
+
+    if (!valid)
+    {
+        throw std::runtime_error("Corrupt key index tables");
+    }
+}
+
+
+int32_t KeyIndexReader::getBase(const uint32_t node) const
+{
+    return readLittleEndian<int32_t>(data, nodeTable + node * NODE_SIZE);
+}
+
+
+int32_t KeyIndexReader::getCheck(const uint32_t node) const
+{
+    return readLittleEndian<int32_t>(data, nodeTable + node * NODE_SIZE + 4);
+}
+
+
+std::string_view KeyIndexReader::getKey(const uint32_t keyIndex) const
+{
+    const size_t row = keyTable + keyIndex * KEY_ROW_SIZE;
+    return data.substr(readLittleEndian<uint32_t>(data, row), readLittleEndian<uint32_t>(data, row + 4));
+}
+
+
+uint32_t KeyIndexReader::getFirstValue(const uint32_t keyIndex) const
+{
+    return readLittleEndian<uint32_t>(data, keyTable + keyIndex * KEY_ROW_SIZE + 8);
+}
+
+
+KeyIndexReader::Match KeyIndexReader::getValue(const uint32_t valueIndex) const
+{
+    const size_t row = valueTable + valueIndex * VALUE_ROW_SIZE;
+    return {
+        data.substr(readLittleEndian<uint32_t>(data, row), readLittleEndian<uint32_t>(data, row + 4)),
+        readLittleEndian<uint64_t>(data, row + 8)
+    };
+}
+
+
+size_t KeyIndexReader::getKeyCount() const
+{
+    return keyCount;
+}
+
+
+size_t KeyIndexReader::getValueCount() const
+{
+    return valueCount;
+}
+
+
+std::vector<KeyIndexReader::Match> KeyIndexReader::find(const std::string_view key) const
+{
+    const std::string normalized = KanaConvert::katakanaToHiragana(key);
+
+    uint32_t node = 0;
+    for (size_t depth = 0;; ++depth)
+    {
+        const int32_t base = getBase(node);
+        if (base < 0)
+        {
+            const auto keyIndex = static_cast<uint32_t>(-(base + 1));
+            if (getKey(keyIndex) != normalized)
+                return {};
+
+            std::vector<Match> matches;
+            for (uint32_t value = getFirstValue(keyIndex); value < getFirstValue(keyIndex + 1); ++value)
+                matches.push_back(getValue(value));
+            return matches;
+        }
+
+        const int code = depth < normalized.size() ? static_cast<unsigned char>(normalized[depth]) + 1 : END_CODE;
+        const uint64_t child = static_cast<uint64_t>(base) + code;
+        if (child >= nodeCount || getCheck(child) != static_cast<int32_t>(node))
+            return {};
+
+        node = static_cast<uint32_t>(child);
+    }
+}
+
+
+std::vector<KeyIndexReader::Match> KeyIndexReader::findExact(const std::string_view key) const
+{
+    auto matches = find(key);
+    std::erase_if(matches, [key](const Match& match) { return match.key != key; });
+    return matches;
+}
+
+
+uint32_t KeyIndexReader::findOutermostKey(uint32_t node, const bool last) const
+{
+    // Bounded by the node count, so a corrupt file that loops can't hang the lookup
+    for (uint64_t steps = 0; steps < nodeCount; ++steps)
+    {
+        const int32_t base = getBase(node);
+        if (base < 0)
+            return static_cast<uint32_t>(-(base + 1));
+
+        bool found = false;
+        for (int i = 0; i <= MAX_CODE && !found; ++i)
+        {
+            const uint64_t child = static_cast<uint64_t>(base) + (last ? MAX_CODE - i : i);
+            if (child < nodeCount && getCheck(child) == static_cast<int32_t>(node))
+            {
+                node = static_cast<uint32_t>(child);
+                found = true;
+            }
+        }
+
+        if (!found)
+            return NO_KEY;
+    }
+
+    return NO_KEY;
+}
+
+
+std::pair<uint32_t, uint32_t> KeyIndexReader::findKeyRange(const std::string_view prefix) const
+{
+    if (keyCount == 0)
+        return {0, 0};
+
+    uint32_t node = 0;
+    for (size_t depth = 0; depth < prefix.size() && getBase(node) >= 0; ++depth)
+    {
+        const uint64_t child = static_cast<uint64_t>(getBase(node)) + static_cast<unsigned char>(prefix[depth]) + 1;
+        if (child >= nodeCount || getCheck(child) != static_cast<int32_t>(node))
+            return {0, 0};
+
+        node = static_cast<uint32_t>(child);
+    }
+
+    // A leaf can be reached before the end of the prefix, the rest is checked against its key
+    if (const int32_t base = getBase(node); base < 0)
+    {
+        const auto keyIndex = static_cast<uint32_t>(-(base + 1));
+        if (!getKey(keyIndex).starts_with(prefix))
+            return {0, 0};
+        return {keyIndex, keyIndex + 1};
+    }
+
+    const uint32_t first = findOutermostKey(node, false);
+    const uint32_t last = findOutermostKey(node, true);
+    if (first == NO_KEY || last == NO_KEY || first > last)
+        return {0, 0};
+
+    return {first, last + 1};
+}
+
+
+void KeyIndexReader::forEachPrefix(const std::string_view prefix, const std::function<bool(const Match&)>& visit) const
+{
+    const auto [first, last] = findKeyRange(KanaConvert::katakanaToHiragana(prefix));
+
+    if (first == last)
+        return;
+
+    for (uint32_t value = getFirstValue(first); value < getFirstValue(last); ++value)
+    {
+        if (!visit(getValue(value)))
+            return;
+    }
+}
+
+
+std::vector<KeyIndexReader::Match> KeyIndexReader::findPrefix(const std::string_view prefix, const size_t limit) const
+{
+    std::vector<Match> matches;
+    if (limit == 0)
+        return matches;
+
+    forEachPrefix(prefix, [&](const Match& match) {
+        matches.push_back(match);
+        return matches.size() < limit;
+    });
+    return matches;
+}
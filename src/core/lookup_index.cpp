@@ -0,0 +1,337 @@
+#include "yomitan_dictionary_builder/core/lookup_index.h"
+#include "yomitan_dictionary_builder/core/page_cache.h"
+#include "yomitan_dictionary_builder/utils/file_sync.h"
+#include "yomitan_dictionary_builder/utils/jptools/kana_convert.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr std::string_view INDEX_MAGIC = "YDBLOOKP";
+    constexpr std::string_view FOOTER_MAGIC = "YDBLKEND";
+    constexpr uint64_t INDEX_VERSION = 2;
+
+    // magic, version
+    constexpr size_t HEADER_SIZE = 16;
+    // record count, record table, key index offset, key index size, magic
+    constexpr size_t FOOTER_SIZE = 40;
+
+
+
+    /**
+     * Converts key index matches to lookup matches
+     * @param keys The key index matches, entry ids being record ids
+     * @param limit Maximum number of matches
+     * @return The first matches up to the limit
+     */
+    std::vector<LookupIndexReader::Match> toMatches(const std::vector<KeyIndexReader::Match>& keys, const size_t limit)
+    {
+        std::vector<LookupIndexReader::Match> matches;
+        matches.reserve(std::min(keys.size(), limit));
+        for (size_t i = 0; i < keys.size() && i < limit; ++i)
+            matches.push_back({keys[i].key, keys[i].entryId});
+        return matches;
+    }
+}
+
+
+LookupIndexWriter::LookupIndexWriter(std::filesystem::path indexPath) : indexPath(std::move(indexPath))
+{
+    tempPath = this->indexPath;
+    tempPath += ".tmp";
+
+    if (this->indexPath.has_parent_path())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(this->indexPath.parent_path(), ec);
+    }
+
+    file.open(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open lookup index: " + tempPath.string());
+    }
+
+    PageRecordWriter header;
+    header.writeUint64(INDEX_VERSION);
+    file << INDEX_MAGIC << header.take();
+    offset = HEADER_SIZE;
+}
+
+
+LookupIndexWriter::~LookupIndexWriter()
+{
+    if (!finished)
+    {
+        file.close();
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+    }
+}
+
+
+uint64_t LookupIndexWriter::addRecord(const std::string_view content)
+{
+    if (finished)
+        throw std::runtime_error("Cannot add records to a finished lookup index");
+
+    recordOffsets.push_back(offset);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    offset += content.size();
+
+    return recordOffsets.size() - 1;
+}
+
+
+void LookupIndexWriter::addKey(const std::string_view key, const uint64_t recordId)
+{
+    keyIndex.addKey(key, recordId);
+}
+
+
+bool LookupIndexWriter::finish()
+{
+    if (finished)
+        return true;
+
+    finished = true;
+
+    std::string keys;
+    if (!keyIndex.build(keys))
+    {
+        std::cerr << "Failed to build the keys of lookup index: " << indexPath.string() << std::endl;
+        file.close();
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    PageRecordWriter tables;
+
+    const uint64_t recordTable = offset;
+    for (const uint64_t recordOffset : recordOffsets)
+        tables.writeUint64(recordOffset);
+    tables.writeUint64(offset);
+
+    const uint64_t keyIndexOffset = recordTable + (recordOffsets.size() + 1) * 8;
+    file << tables.take() << keys;
+
+    tables.writeUint64(recordOffsets.size());
+    tables.writeUint64(recordTable);
+    tables.writeUint64(keyIndexOffset);
+    tables.writeUint64(keys.size());
+
+    file << tables.take() << FOOTER_MAGIC;
+    file.close();
+    if (file.fail())
+    {
+        std::cerr << "Failed to write lookup index: " << tempPath.string() << std::endl;
+        return false;
+    }
+
+    if (!FileUtils::syncFile(tempPath))
+        return false;
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, indexPath, ec);
+    if (ec)
+    {
+        std::cerr << "Failed to move lookup index into place: " << ec.message() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+size_t LookupIndexWriter::getRecordCount() const
+{
+    return recordOffsets.size();
+}
+
+
+LookupIndexReader::LookupIndexReader(const std::filesystem::path& indexPath)
+{
+#ifdef _WIN32
+    std::ifstream file(indexPath, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open lookup index: " + indexPath.string());
+    }
+
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = buffer;
+#else
+    const int fd = ::open(indexPath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to open lookup index: " + indexPath.string());
+    }
+
+    struct stat status{};
+    if (::fstat(fd, &status) == 0 && status.st_size > 0)
+    {
+        mappingSize = static_cast<size_t>(status.st_size);
+        if (void* address = ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0); address != MAP_FAILED)
+        {
+            mapping = address;
+            data = std::string_view(static_cast<const char*>(mapping), mappingSize);
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (data.size() < HEADER_SIZE + FOOTER_SIZE || !data.starts_with(INDEX_MAGIC) || !data.ends_with(FOOTER_MAGIC) ||
+        readAt(INDEX_MAGIC.size()) != INDEX_VERSION)
+    {
+        unmap();
+        throw std::runtime_error("Not a complete lookup index: " + indexPath.string());
+    }
+
+    const size_t footer = data.size() - FOOTER_SIZE;
+    recordCount = readAt(footer);
+    recordTable = readAt(footer + 8);
+    const uint64_t keyIndexOffset = readAt(footer + 16);
+    const uint64_t keyIndexSize = readAt(footer + 24);
+
+    bool valid = recordTable >= HEADER_SIZE && recordTable <= footer &&
+                 (footer - recordTable) / 8 >= recordCount + 1 &&
+                 keyIndexOffset == recordTable + (recordCount + 1) * 8 &&
+                 keyIndexSize == footer - keyIndexOffset;
+
+    // Everything a lookup reads must lie before the tables, so the reads need no checks of their own
+    uint64_t previous = HEADER_SIZE;
+    for (uint64_t i = 0; valid && i <= recordCount; ++i)
+    {
+        const uint64_t recordOffset = readAt(recordTable + i * 8);
+        valid = recordOffset >= previous && recordOffset <= recordTable;
+        previous = recordOffset;
+    }
+
+    if (valid)
+    {
+        try
+        {
+            keyIndex.emplace(data.substr(keyIndexOffset, keyIndexSize));
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::cerr << "Failed to read the keys of lookup index " << indexPath.string() << ": " << e.what() << std::endl;
+            valid = false;
+        }
+    }
+
+    for (uint32_t i = 0; valid && i < keyIndex->getValueCount(); ++i)
+        valid = keyIndex->getValue(i).entryId < recordCount;
+
+    if (!valid)
+    {
+        keyIndex.reset();
+        unmap();
+        throw std::runtime_error("Corrupt lookup index tables: " + indexPath.string());
+    }
+}
+
+
+LookupIndexReader::~LookupIndexReader()
+{
+    unmap();
+}
+
+
+void LookupIndexReader::unmap()
+{
+#ifndef _WIN32
+    if (mapping)
+    {
+        ::munmap(mapping, mappingSize);
+        mapping = nullptr;
+    }
+#endif
+
+    data = {};
+}
+
+
+uint64_t LookupIndexReader::readAt(const size_t position) const
+{
+    uint64_t value = 0;
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        std::memcpy(&value, data.data() + position, sizeof(value));
+    }
+    else
+    {
+        for (int i = 7; i >= 0; --i)
+            value = (value << 8) | static_cast<unsigned char>(data[position + i]);
+    }
+    return value;
+}
+
+
+size_t LookupIndexReader::getRecordCount() const
+{
+    return recordCount;
+}
+
+
+size_t LookupIndexReader::getKeyCount() const
+{
+    return keyIndex->getValueCount();
+}
+
+
+std::string_view LookupIndexReader::getRecord(const uint64_t recordId) const
+{
+    if (recordId >= recordCount)
+        return {};
+
+    const uint64_t start = readAt(recordTable + recordId * 8);
+    const uint64_t end = readAt(recordTable + (recordId + 1) * 8);
+    return data.substr(start, end - start);
+}
+
+
+LookupIndexReader::Match LookupIndexReader::getKey(const size_t index) const
+{
+    const auto [key, recordId] = keyIndex->getValue(static_cast<uint32_t>(index));
+    return {key, recordId};
+}
+
+
+std::vector<LookupIndexReader::Match> LookupIndexReader::findExact(const std::string_view key, const size_t limit) const
+{
+    return toMatches(keyIndex->findExact(key), limit);
+}
+
+
+std::vector<LookupIndexReader::Match> LookupIndexReader::findPrefix(const std::string_view prefix, const size_t limit) const
+{
+    std::vector<Match> matches;
+    if (limit == 0)
+        return matches;
+
+    // The trie is walked with the prefix folded, keys that only match once folded are skipped
+    keyIndex->forEachPrefix(prefix, [&](const KeyIndexReader::Match& match) {
+        if (match.key.starts_with(prefix))
+            matches.push_back({match.key, match.entryId});
+        return matches.size() < limit;
+    });
+    return matches;
+}
+
+
+std::vector<LookupIndexReader::Match> LookupIndexReader::findKanaInsensitive(const std::string_view key, const size_t limit) const
+{
+    return toMatches(keyIndex->find(key), limit);
+}
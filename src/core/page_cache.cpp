@@ -0,0 +1,282 @@
+#include "yomitan_dictionary_builder/core/page_cache.h"
+#include "yomitan_dictionary_builder/utils/file_utils.h"
+#include "yomitan_dictionary_builder/utils/hash.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+#ifndef YOMITAN_DICTIONARY_BUILDER_VERSION
+#define YOMITAN_DICTIONARY_BUILDER_VERSION "dev"
+#endif
+
+namespace
+{
+    constexpr std::string_view ENTRY_MAGIC = "YDBPAGE1";
+    constexpr std::string_view ENTRY_EXTENSION = ".page";
+}
+
+
+void PageRecordWriter::writeUint64(const uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        data += static_cast<char>((value >> (i * 8)) & 0xFF);
+    }
+}
+
+
+void PageRecordWriter::writeString(const std::string_view value)
+{
+    writeUint64(value.size());
+    data += value;
+}
+
+
+void PageRecordWriter::writeStrings(const std::vector<std::string>& values)
+{
+    writeUint64(values.size());
+    for (const auto& value : values)
+    {
+        writeString(value);
+    }
+}
+
+
+std::string PageRecordWriter::take()
+{
+    return std::exchange(data, {});
+}
+
+
+PageRecordReader::PageRecordReader(const std::string_view data) : data(data)
+{
+}
+
+
+bool PageRecordReader::readUint64(uint64_t& value)
+{
+    if (data.size() - offset < 8)
+        return false;
+
+    value = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[offset + i])) << (i * 8);
+    }
+
+    offset += 8;
+    return true;
+}
+
+
+bool PageRecordReader::readString(std::string& value)
+{
+    uint64_t size = 0;
+    if (!readUint64(size) || data.size() - offset < size)
+        return false;
+
+    value.assign(data.substr(offset, size));
+    offset += size;
+    return true;
+}
+
+
+bool PageRecordReader::readStrings(std::vector<std::string>& values)
+{
+    uint64_t count = 0;
+    if (!readUint64(count))
+        return false;
+
+    values.clear();
+    values.reserve(std::min<uint64_t>(count, data.size() - offset));
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (!readString(values.emplace_back()))
+            return false;
+    }
+    return true;
+}
+
+
+bool PageRecordReader::atEnd() const
+{
+    return offset == data.size();
+}
+
+
+PageCache::PageCache(std::filesystem::path cacheDirectory, const uint64_t configHash, const uint64_t maxBytes)
+    : cacheDirectory(std::move(cacheDirectory)), configHash(configHash), maxBytes(maxBytes)
+{
+    try
+    {
+        std::filesystem::create_directories(this->cacheDirectory);
+    }
+    catch (const std::filesystem::filesystem_error& e)
+    {
+        throw std::runtime_error("Failed to create cache directory: " + this->cacheDirectory.string() + " - " + e.what());
+    }
+}
+
+
+std::string PageCache::makeKey(const std::filesystem::path& pagePath, const std::string_view pageContents) const
+{
+    HashUtils::Hasher hasher;
+    hasher.update(configHash);
+    hasher.updateField(getBuilderVersion());
+
+    // Only the file name, so the cache still applies when the dictionary directory is moved
+    hasher.updateField(pagePath.filename().generic_string());
+    hasher.updateField(pageContents);
+
+    // the length keeps two pages with colliding hashes apart unless their sizes match too
+    return HashUtils::toHex(hasher.digest()) + "-" + std::to_string(pageContents.size());
+}
+
+
+std::optional<std::string> PageCache::lookup(const std::string& key)
+{
+    const auto entryPath = getEntryPath(key);
+
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(entryPath, ec))
+    {
+        stats.misses++;
+        return std::nullopt;
+    }
+
+    const auto contents = FileUtils::readFile(entryPath);
+
+    // Entry layout: magic, checksum of the record, record
+    constexpr size_t headerSize = ENTRY_MAGIC.size() + 8;
+    uint64_t checksum = 0;
+    bool valid = contents.has_value() && contents->size() >= headerSize && contents->starts_with(ENTRY_MAGIC);
+    if (valid)
+    {
+        PageRecordReader header(std::string_view(contents.value()).substr(ENTRY_MAGIC.size(), 8));
+        valid = header.readUint64(checksum) && HashUtils::hash(std::string_view(contents.value()).substr(headerSize)) == checksum;
+    }
+
+    if (!valid)
+    {
+        std::cerr << "Discarding corrupt cache entry: " << entryPath.string() << std::endl;
+        std::filesystem::remove(entryPath, ec);
+        stats.misses++;
+        return std::nullopt;
+    }
+
+    // The modification time doubles as the last use time for eviction
+    std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), ec);
+
+    stats.hits++;
+    return contents->substr(headerSize);
+}
+
+
+bool PageCache::store(const std::string& key, const std::string_view record)
+{
+    const auto entryPath = getEntryPath(key);
+    const auto tempPath = std::filesystem::path(entryPath).concat(".tmp");
+
+    try
+    {
+        std::filesystem::create_directories(entryPath.parent_path());
+
+        {
+            std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                return false;
+
+            PageRecordWriter header;
+            header.writeUint64(HashUtils::hash(record));
+            const std::string checksum = header.take();
+
+            file.write(ENTRY_MAGIC.data(), static_cast<std::streamsize>(ENTRY_MAGIC.size()));
+            file.write(checksum.data(), static_cast<std::streamsize>(checksum.size()));
+            file.write(record.data(), static_cast<std::streamsize>(record.size()));
+
+            if (!file.good())
+                return false;
+        }
+
+        // Readers never see a partially written entry
+        std::filesystem::rename(tempPath, entryPath);
+    }
+    catch (const std::filesystem::filesystem_error& e)
+    {
+        std::cerr << "Failed to store cache entry: " << e.what() << std::endl;
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    stats.stored++;
+    stats.storedBytes += ENTRY_MAGIC.size() + 8 + record.size();
+    return true;
+}
+
+
+void PageCache::evict()
+{
+    struct CachedEntry
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastUsed;
+        uint64_t size;
+    };
+
+    std::vector<CachedEntry> entries;
+    uint64_t totalBytes = 0;
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(cacheDirectory, ec))
+    {
+        if (!entry.is_regular_file(ec) || entry.path().extension() != ENTRY_EXTENSION)
+            continue;
+
+        const uint64_t size = entry.file_size(ec);
+        entries.push_back({entry.path(), entry.last_write_time(ec), size});
+        totalBytes += size;
+    }
+
+    if (totalBytes > maxBytes)
+    {
+        std::ranges::sort(entries, {}, &CachedEntry::lastUsed);
+
+        for (const auto& [path, lastUsed, size] : entries)
+        {
+            if (totalBytes <= maxBytes)
+                break;
+
+            if (std::filesystem::remove(path, ec))
+            {
+                totalBytes -= size;
+                stats.evicted++;
+                stats.evictedBytes += size;
+            }
+        }
+    }
+
+    stats.bytesOnDisk = totalBytes;
+}
+
+
+const PageCache::CacheStats& PageCache::getStats() const
+{
+    return stats;
+}
+
+
+std::string_view PageCache::getBuilderVersion()
+{
+    return YOMITAN_DICTIONARY_BUILDER_VERSION;
+}
+
+
+std::filesystem::path PageCache::getEntryPath(const std::string& key) const
+{
+    // Spread the entries over 256 sub directories to keep directory sizes reasonable
+    return cacheDirectory / key.substr(0, 2) / (key + std::string(ENTRY_EXTENSION));
+}
@@ -1,5 +1,31 @@
 #include "yomitan_dictionary_builder/core/xml_parser.h"
-#include <sstream>
+
+
+ClassList::ClassList(const std::string_view classValue)
+{
+    constexpr std::string_view whitespace = " \t\n\r\f\v";
+
+    size_t start = classValue.find_first_not_of(whitespace);
+    while (start != std::string_view::npos)
+    {
+        const size_t end = classValue.find_first_of(whitespace, start);
+        const std::string_view className = classValue.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+
+        if (count < INLINE_CLASSES)
+        {
+            inlineClasses[count] = className;
+        }
+        else
+        {
+            if (overflow.empty())
+                overflow.assign(inlineClasses.begin(), inlineClasses.end());
+            overflow.push_back(className);
+        }
+        ++count;
+
+        start = end == std::string_view::npos ? end : classValue.find_first_not_of(whitespace, end);
+    }
+}
 
 
 XMLParser::XMLParser(const ParserConfig& config) : BaseParser(config)
@@ -8,20 +34,20 @@ XMLParser::XMLParser(const ParserConfig& config) : BaseParser(config)
     {
         loadTagMapping(config.tagMappingPath.value());
     }
-    this->indexReader = config.indexPath.has_value() ? std::make_unique<IndexReader>(config.indexPath.value().string()) : nullptr;
+    this->indexReader = config.indexPath.has_value() ? IndexReader::openShared(config.indexPath.value().string()) : nullptr;
 }
 
 
 // NOLINTNEXTLINE(misc-no-recursion)
-std::string XMLParser::getTargetTag(
+Symbol XMLParser::getTargetTag(
     const std::string& tagName,
-    const std::optional<std::vector<std::string>>& classList,
+    const ClassList& classList,
     const std::optional<pugi::xml_node>& parent,
     const std::optional<int> recursionDepth) const
 {
     if (Yomitan::allowedElements.contains(tagName))
     {
-        return tagName;
+        return Symbol(tagName);
     }
 
     thread_local std::string selectorBuffer;
@@ -33,22 +59,19 @@ std::string XMLParser::getTargetTag(
         const char* parentName = parentNode.name();
 
         // Try parent.class + tag
-        if (const auto parentClassList = getClassList(parent.value()); parentClassList.has_value())
+        for (const auto parentClass : getClassList(parentNode))
         {
-            for (const auto& parentClass : parentClassList.value())
+            selectorBuffer.clear();
+            selectorBuffer.reserve(strlen(parentName) + parentClass.size() + tagName.size() + 2);
+            selectorBuffer.append(parentName);
+            selectorBuffer.append(".");
+            appendClassName(selectorBuffer, parentClass);
+            selectorBuffer.append(" ");
+            selectorBuffer.append(tagName);
+
+            if (const auto it = this->tagMapping.find(selectorBuffer); it != this->tagMapping.end())
             {
-                selectorBuffer.clear();
-                selectorBuffer.reserve(strlen(parentName) + parentClass.size() + tagName.size() + 2);
-                selectorBuffer.append(parentName);
-                selectorBuffer.append(".");
-                selectorBuffer.append(parentClass);
-                selectorBuffer.append(" ");
-                selectorBuffer.append(tagName);
-
-                if (const auto it = this->tagMapping.find(selectorBuffer); it != this->tagMapping.end())
-                {
-                    return it->second;
-                }
+                return it->second;
             }
         }
 
@@ -79,20 +102,17 @@ std::string XMLParser::getTargetTag(
     }
 
     // Try tag.class (no parent involvement)
-    if (classList.has_value())
+    for (const auto className : classList)
     {
-        for (const auto& className : classList.value())
-        {
-            selectorBuffer.clear();
-            selectorBuffer.reserve(tagName.size() + className.size() + 1);
-            selectorBuffer.append(tagName);
-            selectorBuffer.append(".");
-            selectorBuffer.append(className);
+        selectorBuffer.clear();
+        selectorBuffer.reserve(tagName.size() + className.size() + 1);
+        selectorBuffer.append(tagName);
+        selectorBuffer.append(".");
+        appendClassName(selectorBuffer, className);
 
-            if (const auto it = this->tagMapping.find(selectorBuffer); it != this->tagMapping.end())
-            {
-                return it->second;
-            }
+        if (const auto it = this->tagMapping.find(selectorBuffer); it != this->tagMapping.end())
+        {
+            return it->second;
         }
     }
 
@@ -102,37 +122,41 @@ std::string XMLParser::getTargetTag(
         return it->second;
     }
 
-    return "span";
+    static const Symbol defaultTag("span");
+    return defaultTag;
 }
 
 
-std::optional<std::vector<std::string>> XMLParser::getClassList(const pugi::xml_node &node)
+ClassList XMLParser::getClassList(const pugi::xml_node &node)
 {
     if (const pugi::xml_attribute classAttribute = node.attribute("class"))
-    {
-        if (const std::string classValue = classAttribute.value() ? classAttribute.value() : ""; !classValue.empty())
-        {
-            std::vector<std::string> classList;
-            std::istringstream iss(classValue);
-            std::string className;
-            while (iss >> className)
-            {
-                std::ranges::replace(className, '-', '_');
-            }
-            classList.emplace_back(className);
-            return classList;
-        }
-    }
-    return std::nullopt;
+        return ClassList(classAttribute.value());
+
+    return {};
+}
+
+
+void XMLParser::appendClassName(std::string& out, const std::string_view className)
+{
+    const size_t start = out.size();
+    out.append(className);
+    std::replace(out.begin() + static_cast<std::ptrdiff_t>(start), out.end(), '-', '_');
 }
 
 
-std::unordered_map<std::string, std::string> XMLParser::getAttributeData(const pugi::xml_node &node)
+DataAttributes XMLParser::getAttributeData(const pugi::xml_node &node)
 {
-    std::unordered_map<std::string, std::string> dataMap;
+    DataAttributes data;
 
     thread_local std::string processedName;
 
+    size_t attributeCount = 0;
+    for (pugi::xml_attribute attr = node.first_attribute(); attr; attr = attr.next_attribute())
+        ++attributeCount;
+
+    // The class attribute is replaced by one key per class, usually a single one
+    data.reserve(attributeCount);
+
     for (pugi::xml_attribute attr = node.first_attribute(); attr; attr = attr.next_attribute())
     {
         const char* attrNamePtr = attr.name();
@@ -155,9 +179,9 @@ std::unordered_map<std::string, std::string> XMLParser::getAttributeData(const p
 
         processedName.assign(attrName);
         std::ranges::replace(processedName, '-', '_');
-        dataMap.emplace(std::move(processedName), std::string{attrValue});
+        data.set(processedName, attrValue);
     }
-    return dataMap;
+    return data;
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
@@ -166,33 +190,34 @@ std::shared_ptr<HTMLElement> XMLParser::convertElementToYomitan(const pugi::xml_
     if (node == nullptr)
         return {nullptr};
 
-    auto dataMap = getAttributeData(node);
+    auto data = getAttributeData(node);
     const auto classList = getClassList(node);
-    const auto tagName = hasParentSelectors ? getTargetTag(node.name(), classList, node.parent()) : getTargetTag(node.name());
+    const Symbol tag = hasParentSelectors ? getTargetTag(node.name(), classList, node.parent()) : getTargetTag(node.name());
 
     std::shared_ptr<HTMLElement> element;
 
-    if (Yomitan::allowedElements.contains(tagName))
+    if (Yomitan::allowedElements.contains(tag.view()))
     {
-        element = std::make_shared<HTMLElement>(tagName);
+        element = std::make_shared<HTMLElement>(tag);
     }
     else
     {
-        element = std::make_shared<HTMLElement>("span");
-        element->setData({{tagName, ""}});
+        static const Symbol spanTag("span");
+        element = std::make_shared<HTMLElement>(spanTag);
+        element->setData({{tag.view(), ""}});
     }
 
-    if (classList.has_value())
+    thread_local std::string classKey;
+    for (const auto className : classList)
     {
-        for (const auto& className : classList.value())
-        {
-            dataMap[className] = "";
-        }
+        classKey.clear();
+        appendClassName(classKey, className);
+        data.set(classKey, "");
     }
 
-    if (!dataMap.empty())
+    if (!data.empty())
     {
-        element->setData(dataMap);
+        element->setData(std::move(data));
     }
 
     for (pugi::xml_node child = node.first_child(); child != nullptr; child = child.next_sibling())
@@ -254,9 +279,13 @@ void XMLParser::loadTagMapping(const std::filesystem::path &filePath)
 
     try
     {
-        if (const auto ec = glz::read_json(this->tagMapping, json.value()))
+        std::unordered_map<std::string, std::string> mapping;
+        if (const auto ec = glz::read_json(mapping, json.value()))
             std::cerr << "Error reading tag map: " << glz::format_error(ec, json.value()) << std::endl;
 
+        for (auto& [selector, targetTag] : mapping)
+            this->tagMapping.emplace(selector, Symbol(targetTag));
+
         // Check if there are any parent selectors in the tag mapping
         // to avoid unecessary recursion when getting tags later
         auto predicate = [](const std::string& s) {
@@ -2,10 +2,18 @@
 #include "yomitan_dictionary_builder/core/dictionary/dicentry.h"
 #include "yomitan_dictionary_builder/utils/jptools/kana_convert.h"
 #include "yomitan_dictionary_builder/utils/jptools/kanji_utils.h"
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
+#include "yomitan_dictionary_builder/utils/xml_loader.h"
 
 #include <iostream>
 #include <utility>
 
+namespace
+{
+    // Bumped whenever the layout of a page record changes, so older records are converted again
+    constexpr uint64_t PAGE_RECORD_FORMAT = 2;
+}
+
 
 YomitanParser::YomitanParser(std::unique_ptr<YomitanDictionary> dictionary, const ParserConfig& parserConfig) : XMLParser(parserConfig)
 {
@@ -16,6 +24,20 @@ YomitanParser::YomitanParser(std::unique_ptr<YomitanDictionary> dictionary, cons
 YomitanParser::~YomitanParser() = default;
 
 
+int YomitanParser::processFile(FileUtils::PageFile& page)
+{
+    pugi::xml_document* document = XMLLoader::forCurrentThread().load(page);
+    if (!document)
+    {
+        std::cerr << "Failed to load xml file " << page.path.string() << std::endl;
+        return 0;
+    }
+
+    pageIndex = pagesConverted++;
+    return processDocument(page, *document);
+}
+
+
 bool YomitanParser::parseEntry(
     const std::string& term,
     const std::string& reading,
@@ -54,7 +76,12 @@ bool YomitanParser::parseEntry(
         std::cerr << "XML has no root" << std::endl;
     }
 
-    const auto xmlTree = convertElementToYomitan(root);
+    std::shared_ptr<HTMLElement> xmlTree;
+    {
+        const Profiling::ScopedStage stage(Profiling::Stage::TreeConversion);
+        xmlTree = convertElementToYomitan(root);
+    }
+
     if (!xmlTree)
     {
         std::cerr << "Failed to parse xml" << std::endl;
@@ -62,6 +89,10 @@ bool YomitanParser::parseEntry(
     }
 
     entry->addElement(xmlTree);
+
+    if (entryStore)
+        entryStore->append(pageIndex, *entry);
+
     if (!dictionary->addEntry(entry))
     {
         std::cerr << "Failed to add entry '" << term << "' to dictionary\n" << std::endl;
@@ -82,4 +113,151 @@ bool YomitanParser::exportDictionary(const std::string_view outputPath) const
 
     std::cerr << "Failed to export dictionary to " << outputPath << std::endl;
     return false;
-}
\ No newline at end of file
+}
+
+
+void YomitanParser::initializeProcessing()
+{
+    if (config.entryStorePath.has_value())
+        entryStore = std::make_unique<EntryStoreWriter>(config.entryStorePath.value());
+}
+
+
+void YomitanParser::finalizeProcessing()
+{
+    if (!entryStore)
+        return;
+
+    if (entryStore->finish() && config.showProgress)
+        std::cout << "Wrote " << entryStore->size() << " entries to " << config.entryStorePath->string() << std::endl;
+
+    entryStore.reset();
+}
+
+
+bool YomitanParser::supportsPageCache() const
+{
+    return true;
+}
+
+
+void YomitanParser::hashCacheConfig(HashUtils::Hasher& hasher) const
+{
+    XMLParser::hashCacheConfig(hasher);
+
+    hasher.update(PAGE_RECORD_FORMAT);
+
+    // Records only hold the encoded store entries when a store is written
+    hasher.update(static_cast<uint64_t>(config.entryStorePath.has_value()));
+}
+
+
+void YomitanParser::beginPageCapture()
+{
+    dictionary->beginCapture();
+    if (entryStore)
+        entryStore->beginCapture();
+}
+
+
+bool YomitanParser::endPageCapture(PageRecordWriter& record)
+{
+    const CapturedEntries captured = dictionary->endCapture();
+
+    record.writeUint64(captured.entries.size());
+    for (size_t i = 0; i < captured.entries.size(); ++i)
+    {
+        const SerializedEntry& entry = captured.entries[i];
+        record.writeString(entry.term);
+        record.writeString(entry.reading);
+        record.writeString(entry.infoTag);
+        record.writeString(entry.posTag);
+        record.writeUint64(static_cast<uint64_t>(static_cast<int64_t>(entry.searchRank)));
+        record.writeUint64(static_cast<uint64_t>(entry.sequenceNumber));
+        record.writeString(entry.content);
+        record.writeUint64(entry.estimatedSize);
+        record.writeUint64(captured.contentHashes[i]);
+    }
+
+    record.writeStrings(entryStore ? entryStore->endCapture() : std::vector<std::string>{});
+    return true;
+}
+
+
+bool YomitanParser::replayPage(PageRecordReader& record)
+{
+    uint64_t entryCount = 0;
+    if (!record.readUint64(entryCount))
+        return false;
+
+    std::vector<SerializedEntry> entries;
+    std::vector<uint64_t> contentHashes;
+    for (uint64_t i = 0; i < entryCount; ++i)
+    {
+        SerializedEntry entry;
+        uint64_t searchRank = 0;
+        uint64_t sequenceNumber = 0;
+        uint64_t estimatedSize = 0;
+        uint64_t contentHash = 0;
+        if (!record.readString(entry.term) || !record.readString(entry.reading) ||
+            !record.readString(entry.infoTag) || !record.readString(entry.posTag) ||
+            !record.readUint64(searchRank) || !record.readUint64(sequenceNumber) ||
+            !record.readString(entry.content) || !record.readUint64(estimatedSize) || !record.readUint64(contentHash))
+        {
+            return false;
+        }
+
+        entry.searchRank = static_cast<int>(static_cast<int64_t>(searchRank));
+        entry.sequenceNumber = static_cast<long>(sequenceNumber);
+        entry.estimatedSize = estimatedSize;
+        entries.push_back(std::move(entry));
+        contentHashes.push_back(contentHash);
+    }
+
+    std::vector<std::string> storeEntries;
+    if (!record.readStrings(storeEntries) || !record.atEnd())
+        return false;
+
+    if (entryStore && storeEntries.size() != entries.size())
+        return false;
+
+    // Added in the order the page produced them, so a cached run writes the same term banks as a cold one
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (!dictionary->addSerializedEntry(std::move(entries[i]), contentHashes[i]))
+            return false;
+    }
+
+    pageIndex = pagesConverted++;
+    if (entryStore)
+    {
+        for (const auto& storeEntry : storeEntries)
+            entryStore->appendEncoded(pageIndex, storeEntry);
+    }
+
+    return true;
+}
+
+
+bool YomitanParser::supportsCheckpoint() const
+{
+    return !config.entryStorePath.has_value();
+}
+
+
+bool YomitanParser::saveCheckpointState(CheckpointState& state)
+{
+    const auto termBanks = dictionary->checkpoint();
+    if (!termBanks.has_value())
+        return false;
+
+    state.termBanks = termBanks.value();
+    state.dictionaryEntries = dictionary->getEntryCount();
+    return true;
+}
+
+
+bool YomitanParser::restoreCheckpointState(const CheckpointState& state)
+{
+    return dictionary->restoreCheckpoint(state.termBanks, state.dictionaryEntries);
+}
@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 
 IndexReader::IndexReader(const std::string_view indexPath) : indexPath(indexPath)
 {
@@ -13,6 +14,22 @@ IndexReader::IndexReader(const std::string_view indexPath) : indexPath(indexPath
     }
 }
 
+std::shared_ptr<IndexReader> IndexReader::openShared(const std::string_view indexPath)
+{
+    static std::mutex openMutex;
+    static std::unordered_map<std::string, std::weak_ptr<IndexReader>> openIndexes;
+
+    std::lock_guard lock(openMutex);
+
+    auto& openIndex = openIndexes[std::string(indexPath)];
+    if (auto index = openIndex.lock())
+        return index;
+
+    auto index = std::make_shared<IndexReader>(indexPath);
+    openIndex = index;
+    return index;
+}
+
 const std::vector<std::string>& IndexReader::getKeysForFile(const std::string_view filename)
 {
     if (const auto iter = fileToKeys.find(std::string(filename)); iter != fileToKeys.end())
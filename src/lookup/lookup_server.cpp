@@ -0,0 +1,804 @@
+#include "yomitan_dictionary_builder/lookup/lookup_server.h"
+
+#include <glaze/glaze.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <ranges>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Lookup
+{
+    struct MatchJson
+    {
+        std::string_view key;
+        uint64_t record = 0;
+        std::string_view content;
+    };
+
+    struct ResponseJson
+    {
+        std::vector<MatchJson> matches;
+    };
+
+    struct ErrorJson
+    {
+        std::string error;
+    };
+}
+
+
+template<>
+struct glz::meta<Lookup::MatchJson>
+{
+    using T = Lookup::MatchJson;
+    static constexpr auto value = glz::object(
+        "key", &T::key,
+        "record", &T::record,
+        "content", &T::content
+    );
+};
+
+template<>
+struct glz::meta<Lookup::ResponseJson>
+{
+    using T = Lookup::ResponseJson;
+    static constexpr auto value = glz::object(
+        "matches", &T::matches
+    );
+};
+
+template<>
+struct glz::meta<Lookup::ErrorJson>
+{
+    using T = Lookup::ErrorJson;
+    static constexpr auto value = glz::object(
+        "error", &T::error
+    );
+};
+
+
+namespace Lookup
+{
+    namespace
+    {
+        // Requests longer than this are refused instead of buffered
+        constexpr size_t MAX_REQUEST_SIZE = 64 * 1024;
+        constexpr size_t READ_SIZE = 16 * 1024;
+        constexpr int LISTEN_BACKLOG = 128;
+
+#ifdef MSG_NOSIGNAL
+        constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+        constexpr int SEND_FLAGS = 0;
+#endif
+
+        /**
+         * Keeps a socket from leaking into child processes, and on macOS from raising SIGPIPE
+         * @param fd The socket
+         */
+        void prepareSocket(const int fd)
+        {
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+            constexpr int enable = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+        }
+
+        bool sendAll(const int fd, const std::string_view data)
+        {
+            size_t sent = 0;
+            while (sent < data.size())
+            {
+                const ssize_t result = ::send(fd, data.data() + sent, data.size() - sent, SEND_FLAGS);
+                if (result < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+                sent += static_cast<size_t>(result);
+            }
+            return true;
+        }
+
+        std::optional<size_t> parseLimit(const std::string_view text)
+        {
+            size_t limit = 0;
+            const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), limit);
+            if (ec != std::errc() || end != text.data() + text.size())
+                return std::nullopt;
+            return limit;
+        }
+
+        std::string_view trimCarriageReturn(std::string_view line)
+        {
+            if (line.ends_with('\r'))
+                line.remove_suffix(1);
+            return line;
+        }
+
+        std::string httpResponse(const std::string_view status, const std::string_view body, const bool keepAlive)
+        {
+            std::string response;
+            response.reserve(body.size() + 128);
+            response += "HTTP/1.1 ";
+            response += status;
+            response += "\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: ";
+            response += std::to_string(body.size());
+            response += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+            response += body;
+            return response;
+        }
+
+        std::string httpError(const std::string_view status, const std::string_view message, const bool keepAlive)
+        {
+            std::string json;
+            if (const auto ec = glz::write_json(ErrorJson{std::string(message)}, json); ec)
+                json.clear();
+            return httpResponse(status, json, keepAlive);
+        }
+
+        bool equalsIgnoreCase(const std::string_view a, const std::string_view b)
+        {
+            return std::ranges::equal(a, b, [](const char x, const char y) {
+                return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+            });
+        }
+    }
+
+
+    std::optional<Mode> parseMode(const std::string_view name)
+    {
+        if (name == "exact")
+            return Mode::Exact;
+        if (name == "prefix")
+            return Mode::Prefix;
+        if (name == "kana")
+            return Mode::Kana;
+        return std::nullopt;
+    }
+
+
+    std::optional<std::string> decodeUrlComponent(const std::string_view text)
+    {
+        auto hexValue = [](const char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        };
+
+        std::string decoded;
+        decoded.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == '+')
+            {
+                decoded += ' ';
+            }
+            else if (text[i] == '%')
+            {
+                if (i + 2 >= text.size())
+                    return std::nullopt;
+
+                const int high = hexValue(text[i + 1]);
+                const int low = hexValue(text[i + 2]);
+                if (high < 0 || low < 0)
+                    return std::nullopt;
+
+                decoded += static_cast<char>(high * 16 + low);
+                i += 2;
+            }
+            else
+            {
+                decoded += text[i];
+            }
+        }
+        return decoded;
+    }
+
+
+    Server::Server(const LookupIndexReader& index) : index(index)
+    {
+        if (::pipe(wakePipe) != 0)
+            throw std::runtime_error(std::string("Failed to create the wake up pipe: ") + std::strerror(errno));
+
+        ::fcntl(wakePipe[0], F_SETFD, FD_CLOEXEC);
+        ::fcntl(wakePipe[1], F_SETFD, FD_CLOEXEC);
+        ::fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+    }
+
+
+    Server::~Server()
+    {
+        closeConnections();
+
+        for (const int fd : {unixListener, httpListener, wakePipe[0], wakePipe[1]})
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+
+        if (!socketPath.empty())
+        {
+            std::error_code ec;
+            std::filesystem::remove(socketPath, ec);
+        }
+    }
+
+
+    std::vector<LookupIndexReader::Match> Server::lookup(const Request& request) const
+    {
+        switch (request.mode)
+        {
+            case Mode::Prefix:
+                return index.findPrefix(request.key, request.limit);
+            case Mode::Kana:
+                return index.findKanaInsensitive(request.key, request.limit);
+            case Mode::Exact:
+            default:
+                return index.findExact(request.key, request.limit);
+        }
+    }
+
+
+    std::string Server::handleLine(std::string_view line) const
+    {
+        line = trimCarriageReturn(line);
+
+        const size_t modeEnd = line.find(' ');
+        if (modeEnd == std::string_view::npos)
+            return "ERR expected \"<exact|prefix|kana> <key>[\\t<limit>]\"\n";
+
+        const auto mode = parseMode(line.substr(0, modeEnd));
+        if (!mode.has_value())
+            return "ERR unknown mode\n";
+
+        Request request;
+        request.mode = mode.value();
+        request.limit = request.mode == Mode::Prefix ? DEFAULT_PREFIX_LIMIT : MAX_LIMIT;
+
+        // Keys may contain spaces, a limit is only taken from a trailing number after a tab
+        std::string_view key = line.substr(modeEnd + 1);
+        if (const size_t tab = key.rfind('\t'); tab != std::string_view::npos)
+        {
+            const auto limit = parseLimit(key.substr(tab + 1));
+            if (!limit.has_value())
+                return "ERR invalid limit\n";
+
+            request.limit = std::min(limit.value() == 0 ? request.limit : limit.value(), MAX_LIMIT);
+            key = key.substr(0, tab);
+        }
+        request.key = key;
+
+        const auto matches = lookup(request);
+
+        size_t size = 16;
+        for (const auto& match : matches)
+            size += match.key.size() + index.getRecord(match.recordId).size() + 32;
+
+        std::string response;
+        response.reserve(size);
+        response += "OK ";
+        response += std::to_string(matches.size());
+        response += '\n';
+        for (const auto& [matchKey, recordId] : matches)
+        {
+            const std::string_view content = index.getRecord(recordId);
+            response += matchKey;
+            response += '\t';
+            response += std::to_string(recordId);
+            response += '\t';
+            response += std::to_string(content.size());
+            response += '\n';
+            response += content;
+            response += '\n';
+        }
+        return response;
+    }
+
+
+    std::string Server::handleHttp(const std::string_view requestHead, bool& keepAlive) const
+    {
+        const size_t lineEnd = requestHead.find("\r\n");
+        const std::string_view requestLine = requestHead.substr(0, lineEnd);
+
+        const size_t methodEnd = requestLine.find(' ');
+        const size_t targetEnd = requestLine.rfind(' ');
+        if (methodEnd == std::string_view::npos || targetEnd <= methodEnd)
+        {
+            keepAlive = false;
+            return httpError("400 Bad Request", "malformed request line", false);
+        }
+
+        const std::string_view method = requestLine.substr(0, methodEnd);
+        const std::string_view target = requestLine.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+        const std::string_view version = requestLine.substr(targetEnd + 1);
+
+        // HTTP/1.1 keeps the connection open unless asked not to, HTTP/1.0 only when asked to
+        keepAlive = version == "HTTP/1.1";
+        for (size_t position = lineEnd; position != std::string_view::npos && position < requestHead.size();)
+        {
+            const size_t start = position + 2;
+            const size_t end = requestHead.find("\r\n", start);
+            const std::string_view header = requestHead.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+            position = end;
+
+            if (const size_t colon = header.find(':'); colon != std::string_view::npos && equalsIgnoreCase(header.substr(0, colon), "connection"))
+            {
+                std::string_view value = header.substr(colon + 1);
+                while (value.starts_with(' '))
+                    value.remove_prefix(1);
+
+                if (equalsIgnoreCase(value, "close"))
+                    keepAlive = false;
+                else if (equalsIgnoreCase(value, "keep-alive"))
+                    keepAlive = true;
+            }
+        }
+
+        if (method != "GET")
+            return httpError("405 Method Not Allowed", "only GET is supported", keepAlive);
+
+        const size_t queryStart = target.find('?');
+        if (target.substr(0, queryStart) != "/lookup")
+            return httpError("404 Not Found", "unknown path", keepAlive);
+
+        Request request;
+        std::optional<std::string> key;
+        std::optional<size_t> limit;
+
+        std::string_view query = queryStart == std::string_view::npos ? std::string_view() : target.substr(queryStart + 1);
+        while (!query.empty())
+        {
+            const size_t parameterEnd = query.find('&');
+            const std::string_view parameter = query.substr(0, parameterEnd);
+            query = parameterEnd == std::string_view::npos ? std::string_view() : query.substr(parameterEnd + 1);
+
+            const size_t equals = parameter.find('=');
+            const std::string_view name = parameter.substr(0, equals);
+            const auto value = decodeUrlComponent(equals == std::string_view::npos ? std::string_view() : parameter.substr(equals + 1));
+            if (!value.has_value())
+                return httpError("400 Bad Request", "malformed escape", keepAlive);
+
+            if (name == "q")
+            {
+                key = value;
+            }
+            else if (name == "mode")
+            {
+                const auto mode = parseMode(value.value());
+                if (!mode.has_value())
+                    return httpError("400 Bad Request", "unknown mode", keepAlive);
+                request.mode = mode.value();
+            }
+            else if (name == "limit")
+            {
+                limit = parseLimit(value.value());
+                if (!limit.has_value())
+                    return httpError("400 Bad Request", "invalid limit", keepAlive);
+            }
+        }
+
+        if (!key.has_value())
+            return httpError("400 Bad Request", "missing q", keepAlive);
+
+        request.key = std::move(key.value());
+        request.limit = request.mode == Mode::Prefix ? DEFAULT_PREFIX_LIMIT : MAX_LIMIT;
+        if (limit.has_value() && limit.value() > 0)
+            request.limit = std::min(limit.value(), MAX_LIMIT);
+
+        ResponseJson response;
+        for (const auto& [matchKey, recordId] : lookup(request))
+            response.matches.push_back({matchKey, recordId, index.getRecord(recordId)});
+
+        std::string json;
+        if (const auto ec = glz::write_json(response, json); ec)
+            return httpError("500 Internal Server Error", "could not write the response", keepAlive);
+
+        return httpResponse("200 OK", json, keepAlive);
+    }
+
+
+    bool Server::listenUnix(const std::filesystem::path& path)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.string().size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "Socket path is too long: " << path.string() << std::endl;
+            return false;
+        }
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            std::cerr << "Failed to create socket: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        prepareSocket(fd);
+
+        // A socket file left by a server that didn't shut down cleanly
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, LISTEN_BACKLOG) != 0)
+        {
+            std::cerr << "Failed to listen on " << path.string() << ": " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            return false;
+        }
+
+        unixListener = fd;
+        socketPath = path;
+        return true;
+    }
+
+
+    bool Server::listenHttp(const uint16_t port)
+    {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            std::cerr << "Failed to create socket: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        prepareSocket(fd);
+
+        constexpr int enable = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, LISTEN_BACKLOG) != 0)
+        {
+            std::cerr << "Failed to listen on port " << port << ": " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            return false;
+        }
+
+        socklen_t length = sizeof(address);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+
+        httpListener = fd;
+        httpPort = ntohs(address.sin_port);
+        return true;
+    }
+
+
+    uint16_t Server::getHttpPort() const
+    {
+        return httpPort;
+    }
+
+
+    void Server::run()
+    {
+        std::vector<pollfd> listeners;
+        listeners.push_back({wakePipe[0], POLLIN, 0});
+        if (unixListener >= 0)
+            listeners.push_back({unixListener, POLLIN, 0});
+        if (httpListener >= 0)
+            listeners.push_back({httpListener, POLLIN, 0});
+
+        while (!stopping)
+        {
+            if (::poll(listeners.data(), listeners.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                std::cerr << "Failed to wait for connections: " << std::strerror(errno) << std::endl;
+                break;
+            }
+
+            for (const auto& listener : listeners | std::views::drop(1))
+            {
+                if (!(listener.revents & POLLIN))
+                    continue;
+
+                const int connection = ::accept(listener.fd, nullptr, nullptr);
+                if (connection < 0)
+                    continue;
+                prepareSocket(connection);
+
+                const bool http = listener.fd == httpListener;
+                if (http)
+                {
+                    constexpr int enable = 1;
+                    ::setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+                }
+
+                std::lock_guard lock(connectionsMutex);
+                reapConnectionThreads();
+                connections.insert(connection);
+                connectionThreads.emplace_back([this, connection, http] {
+                    if (http)
+                        serveHttp(connection);
+                    else
+                        serveLines(connection);
+
+                    std::lock_guard connectionLock(connectionsMutex);
+                    if (connections.erase(connection) > 0)
+                        ::close(connection);
+                    finishedThreads.push_back(std::this_thread::get_id());
+                });
+            }
+        }
+
+        closeConnections();
+    }
+
+
+    void Server::stop()
+    {
+        stopping = true;
+        constexpr char wake = 1;
+        [[maybe_unused]] const auto written = ::write(wakePipe[1], &wake, 1);
+    }
+
+
+    void Server::reapConnectionThreads()
+    {
+        // Threads of closed connections are joined as new ones arrive, so a long running server doesn't collect them
+        for (const auto id : finishedThreads)
+        {
+            const auto thread = std::ranges::find(connectionThreads, id, &std::thread::get_id);
+            if (thread == connectionThreads.end())
+                continue;
+
+            thread->join();
+            connectionThreads.erase(thread);
+        }
+        finishedThreads.clear();
+    }
+
+
+    void Server::closeConnections()
+    {
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard lock(connectionsMutex);
+
+            // Wakes up the threads waiting for a request, they close their sockets on the way out
+            for (const int connection : connections)
+                ::shutdown(connection, SHUT_RDWR);
+
+            threads = std::move(connectionThreads);
+            connectionThreads.clear();
+            finishedThreads.clear();
+        }
+
+        for (auto& thread : threads)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+    }
+
+
+    void Server::serveLines(const int fd) const
+    {
+        std::string pending;
+        std::string responses;
+        char chunk[READ_SIZE];
+
+        while (true)
+        {
+            const ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                return;
+
+            pending.append(chunk, static_cast<size_t>(received));
+
+            // Pipelined requests are answered with a single send
+            size_t lineStart = 0;
+            for (size_t lineEnd = pending.find('\n'); lineEnd != std::string::npos; lineEnd = pending.find('\n', lineStart))
+            {
+                responses += handleLine(std::string_view(pending).substr(lineStart, lineEnd - lineStart));
+                lineStart = lineEnd + 1;
+            }
+            pending.erase(0, lineStart);
+
+            if (!responses.empty())
+            {
+                if (!sendAll(fd, responses))
+                    return;
+                responses.clear();
+            }
+
+            if (pending.size() > MAX_REQUEST_SIZE)
+            {
+                sendAll(fd, "ERR request too long\n");
+                return;
+            }
+        }
+    }
+
+
+    void Server::serveHttp(const int fd) const
+    {
+        std::string pending;
+        char chunk[READ_SIZE];
+
+        while (true)
+        {
+            const size_t headEnd = pending.find("\r\n\r\n");
+            if (headEnd == std::string::npos)
+            {
+                if (pending.size() > MAX_REQUEST_SIZE)
+                {
+                    sendAll(fd, httpError("431 Request Header Fields Too Large", "request too long", false));
+                    return;
+                }
+
+                const ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (received < 0 && errno == EINTR)
+                    continue;
+                if (received <= 0)
+                    return;
+
+                pending.append(chunk, static_cast<size_t>(received));
+                continue;
+            }
+
+            bool keepAlive = false;
+            const std::string response = handleHttp(std::string_view(pending).substr(0, headEnd), keepAlive);
+            pending.erase(0, headEnd + 4);
+
+            if (!sendAll(fd, response) || !keepAlive)
+                return;
+        }
+    }
+
+
+    Client::Client(const std::filesystem::path& socketPath)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.string().size() >= sizeof(address.sun_path))
+            throw std::runtime_error("Socket path is too long: " + socketPath.string());
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0)
+            prepareSocket(fd);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            const std::string error = std::strerror(errno);
+            if (fd >= 0)
+                ::close(fd);
+            throw std::runtime_error("Failed to connect to " + socketPath.string() + ": " + error);
+        }
+    }
+
+
+    Client::~Client()
+    {
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+
+    std::optional<Client::Response> Client::lookup(const Mode mode, const std::string_view key, const size_t limit)
+    {
+        std::string request;
+        request.reserve(key.size() + 32);
+        request += mode == Mode::Prefix ? "prefix " : mode == Mode::Kana ? "kana " : "exact ";
+        request += key;
+        if (limit > 0)
+        {
+            request += '\t';
+            request += std::to_string(limit);
+        }
+        request += '\n';
+
+        if (!sendAll(fd, request))
+            return std::nullopt;
+
+        std::string line;
+        if (!readLine(line))
+            return std::nullopt;
+
+        Response response;
+        if (line.starts_with("ERR "))
+        {
+            response.error = line.substr(4);
+            return response;
+        }
+
+        const auto count = line.starts_with("OK ") ? parseLimit(std::string_view(line).substr(3)) : std::nullopt;
+        if (!count.has_value())
+            return std::nullopt;
+
+        response.ok = true;
+        response.matches.reserve(count.value());
+        for (size_t i = 0; i < count.value(); ++i)
+        {
+            // "<key>\t<record>\t<length>\n<content>\n"
+            if (!readLine(line))
+                return std::nullopt;
+
+            const size_t keyEnd = line.find('\t');
+            const size_t recordEnd = keyEnd == std::string::npos ? std::string::npos : line.find('\t', keyEnd + 1);
+            const auto length = recordEnd == std::string::npos ? std::nullopt : parseLimit(std::string_view(line).substr(recordEnd + 1));
+            if (!length.has_value())
+                return std::nullopt;
+
+            std::string content;
+            if (!readBytes(length.value() + 1, content))
+                return std::nullopt;
+            content.pop_back();
+
+            response.matches.emplace_back(line.substr(0, keyEnd), std::move(content));
+        }
+        return response;
+    }
+
+
+    bool Client::readLine(std::string& line)
+    {
+        while (true)
+        {
+            if (const size_t end = buffer.find('\n', bufferStart); end != std::string::npos)
+            {
+                line.assign(buffer, bufferStart, end - bufferStart);
+                bufferStart = end + 1;
+                return true;
+            }
+
+            buffer.erase(0, bufferStart);
+            bufferStart = 0;
+
+            char chunk[READ_SIZE];
+            const ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                return false;
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+    }
+
+
+    bool Client::readBytes(const size_t count, std::string& bytes)
+    {
+        while (buffer.size() - bufferStart < count)
+        {
+            buffer.erase(0, bufferStart);
+            bufferStart = 0;
+
+            char chunk[READ_SIZE];
+            const ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                return false;
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+
+        bytes.assign(buffer, bufferStart, count);
+        bufferStart += count;
+        return true;
+    }
+}
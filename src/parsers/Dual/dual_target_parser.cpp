@@ -0,0 +1,53 @@
+#include "yomitan_dictionary_builder/parsers/Dual/dual_target_parser.h"
+#include "yomitan_dictionary_builder/utils/xml_loader.h"
+
+#include <iostream>
+
+
+DualTargetParser::DualTargetParser(std::unique_ptr<YomitanParser> yomitanTarget, std::unique_ptr<MdictParser> mdictTarget, const ParserConfig& config)
+    : BaseParser(config), yomitanTarget(std::move(yomitanTarget)), mdictTarget(std::move(mdictTarget))
+{
+    if (!this->yomitanTarget || !this->mdictTarget)
+    {
+        throw std::invalid_argument("Both targets are required for a dual target parser");
+    }
+}
+
+
+bool DualTargetParser::exportYomitanDictionary(const std::string_view outputPath) const
+{
+    return yomitanTarget->exportDictionary(outputPath);
+}
+
+
+int DualTargetParser::processFile(FileUtils::PageFile& page)
+{
+    pugi::xml_document* document = XMLLoader::forCurrentThread().load(page);
+    if (!document)
+    {
+        std::cerr << "Failed to load xml file " << page.path.string() << std::endl;
+        return 0;
+    }
+
+    // The Yomitan conversion only reads the document, the MDict target modifies it afterwards
+    yomitanTarget->pageIndex = yomitanTarget->pagesConverted++;
+    const int entries = yomitanTarget->processDocument(page, *document);
+
+    mdictTarget->processDocument(page, *document);
+
+    return entries;
+}
+
+
+void DualTargetParser::initializeProcessing()
+{
+    yomitanTarget->initializeProcessing();
+    mdictTarget->initializeProcessing();
+}
+
+
+void DualTargetParser::finalizeProcessing()
+{
+    yomitanTarget->finalizeProcessing();
+    mdictTarget->finalizeProcessing();
+}
@@ -1,9 +1,28 @@
 #include "yomitan_dictionary_builder/parsers/MDict/mdict_exporter.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
 #include <iostream>
+#include <utility>
 
+#include "yomitan_dictionary_builder/utils/hash.h"
 #include "yomitan_dictionary_builder/utils/jptools/kana_convert.h"
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
+#include "yomitan_dictionary_builder/utils/trace_recorder.h"
+
+namespace
+{
+    constexpr std::string_view LINK_PREFIX = "@@@LINK=";
+    constexpr std::string_view RECORD_END = "\n</>\n";
+}
+
 
 MDictExporter::MDictExporter(MDictConfig& dictionaryConfig, ParserConfig& config)
+    : MDictExporter(dictionaryConfig, config, ExportCheckpoint{})
+{
+}
+
+MDictExporter::MDictExporter(MDictConfig& dictionaryConfig, ParserConfig& config, const ExportCheckpoint& resumeFrom)
     : dictionaryConfig(dictionaryConfig), config(config)
 {
     try
@@ -19,14 +38,31 @@ MDictExporter::MDictExporter(MDictConfig& dictionaryConfig, ParserConfig& config
         throw std::runtime_error("Failed to create output directory: " + config.outputPath.value().string() + " - " + e.what());
     }
 
+    if (config.assetDirectory.has_value())
+        mddSourceDirectory = config.assetDirectory.value();
+
     try
     {
-        outputTxtFile = outputDirectory / std::filesystem::path{dictionaryConfig.title + ".txt"};
-        outputFile = std::make_unique<std::ofstream>(outputTxtFile, std::ios::out | std::ios::trunc);
+        outputTxtFile = getContentFilePath(outputDirectory, dictionaryConfig.title);
+        keyTxtFile = getKeyFilePath(outputDirectory, dictionaryConfig.title);
+
+        outputFile = openOutputFile(outputTxtFile, resumeFrom.contentOffset);
+        keyFile = openOutputFile(keyTxtFile, resumeFrom.keyOffset);
+
+        contentOffset = resumeFrom.contentOffset;
+        keyOffset = resumeFrom.keyOffset;
+        stats = resumeFrom.stats;
+
+        if (dictionaryConfig.deduplicateContent && contentOffset > 0)
+            restoreContentHashes(contentOffset);
 
-        if (!outputFile->is_open())
+        if (config.lookupIndexPath.has_value())
         {
-            throw std::runtime_error("Failed to open output file: " + config.outputPath.value().string());
+            // The index can't be resumed, a resumed export leaves it out
+            if (contentOffset == 0)
+                lookupIndex = std::make_unique<LookupIndexWriter>(config.lookupIndexPath.value());
+            else
+                std::cerr << "Resumed export, no lookup index is written" << std::endl;
         }
     }
     catch (std::exception& e)
@@ -45,7 +81,7 @@ MDictExporter::~MDictExporter()
             finalize();
         }
 
-        if (outputFile && outputFile->is_open())
+        if (outputFile)
         {
             outputFile->close();
         }
@@ -57,16 +93,132 @@ MDictExporter::~MDictExporter()
 }
 
 
-void MDictExporter::addEntry(const MDictEntry &entry)
+bool MDictExporter::canResume(const MDictConfig& dictionaryConfig, const ParserConfig& config, const ExportCheckpoint& resumeFrom)
+{
+    if (resumeFrom.contentOffset == 0 && resumeFrom.keyOffset == 0)
+        return true;
+
+    if (!config.outputPath.has_value())
+        return false;
+
+    auto hasBytes = [](const std::filesystem::path& filePath, const uint64_t offset) {
+        std::error_code ec;
+        return offset == 0 || (std::filesystem::exists(filePath, ec) && std::filesystem::file_size(filePath, ec) >= offset);
+    };
+
+    return hasBytes(getContentFilePath(config.outputPath.value(), dictionaryConfig.title), resumeFrom.contentOffset) &&
+           hasBytes(getKeyFilePath(config.outputPath.value(), dictionaryConfig.title), resumeFrom.keyOffset);
+}
+
+
+std::filesystem::path MDictExporter::getContentFilePath(const std::filesystem::path& outputDirectory, const std::string& title)
+{
+    return outputDirectory / std::filesystem::path{title + ".txt"};
+}
+
+
+std::filesystem::path MDictExporter::getKeyFilePath(const std::filesystem::path& outputDirectory, const std::string& title)
+{
+    return outputDirectory / std::filesystem::path{title + ".keys.txt"};
+}
+
+
+std::unique_ptr<FileUtils::OutputSink> MDictExporter::openOutputFile(const std::filesystem::path& filePath, const uint64_t offset) const
+{
+    // Resuming keeps everything up to the checkpoint and drops what was written after it
+    if (offset > 0 && (!std::filesystem::exists(filePath) || std::filesystem::file_size(filePath) < offset))
+    {
+        throw std::runtime_error("Output file is shorter than its checkpoint: " + filePath.string());
+    }
+
+    FileUtils::OutputSinkOptions options;
+    options.writeBehind = config.writeBehindOutput;
+    return FileUtils::openOutputSink(filePath, offset, options);
+}
+
+
+void MDictExporter::addEntry(MDictEntry&& entry)
+{
+    writeEntry(entry.pageId, entry.keys, entry.content);
+
+    if (capturing)
+        capturedEntries.push_back(std::move(entry));
+}
+
+
+void MDictExporter::addEntry(const long pageId, std::vector<std::string> keys, const std::string_view content)
+{
+    writeEntry(pageId, keys, content);
+
+    if (capturing)
+        capturedEntries.emplace_back(pageId, std::move(keys), std::string(content));
+}
+
+
+void MDictExporter::writeEntry(const long pageId, const std::vector<std::string>& keys, const std::string_view content)
 {
     if (finalized)
     {
         throw std::runtime_error("Cannot add entries after finalisation");
     }
 
-    entries.emplace_back(entry);
+    const long contentPageId = appendContent(pageId, content);
+
+    std::vector<std::string> lookupKeys;
+    appendKeys(pageId, keys, lookupIndex ? &lookupKeys : nullptr);
+
+    if (lookupIndex)
+        addLookupKeys(pageId, content, contentPageId, std::move(lookupKeys));
+
     stats.totalEntries++;
-    stats.totalKeys += entry.keys.size();
+    stats.totalKeys += keys.size();
+}
+
+
+void MDictExporter::addStoredEntries(const EntryStoreReader& store)
+{
+    std::optional<uint64_t> pageId;
+    std::vector<std::string> keys;
+    std::vector<std::string> bodies;
+
+    auto addPage = [&] {
+        if (!pageId.has_value())
+            return;
+
+        std::string content;
+        for (const auto& body : bodies)
+            content += body;
+
+        addEntry(MDictEntry(static_cast<long>(pageId.value()), std::exchange(keys, {}), std::move(content)));
+        bodies.clear();
+    };
+
+    // The entries of a page are stored one after another
+    for (size_t i = 0; i < store.size(); ++i)
+    {
+        const auto stored = store.read(i);
+        if (!stored.has_value())
+        {
+            throw std::runtime_error("Entry " + std::to_string(i) + " of the entry store is corrupt");
+        }
+
+        if (pageId != stored->pageId)
+        {
+            addPage();
+            pageId = stored->pageId;
+        }
+
+        for (const auto& key : {stored->entry->getTerm(), stored->entry->getReading()})
+        {
+            if (!key.empty() && std::ranges::find(keys, key) == keys.end())
+                keys.push_back(key);
+        }
+
+        if (std::string body = EntryStoreReader::renderHtml(*stored->entry); std::ranges::find(bodies, body) == bodies.end())
+            bodies.push_back(std::move(body));
+    }
+
+    addPage();
 }
 
 
@@ -76,13 +228,24 @@ void MDictExporter::finalize()
 
     try
     {
-        writeContentSection();
+        flushBuffer();
 
         writeKeySection();
 
-        writeTitleFile();
+        if (lookupIndex && !pendingLookupKeys.empty())
+        {
+            std::cerr << pendingLookupKeys.size() << " pages are only linked to and never added, "
+                      << "the keys linking to them are left out of the lookup index" << std::endl;
+        }
 
-        flushBuffer();
+        if (lookupIndex && !lookupIndex->finish())
+            std::cerr << "Failed to write the lookup index" << std::endl;
+
+        // The only sync of an export that isn't checkpointed, the mdict tool reads the file next
+        outputFile->sync();
+        outputFile->close();
+
+        writeTitleFile();
 
         runMdictConvert();
 
@@ -96,96 +259,297 @@ void MDictExporter::finalize()
 }
 
 
-void MDictExporter::writeContentSection()
+MDictExporter::ExportCheckpoint MDictExporter::checkpoint()
+{
+    const Profiling::ScopedStage stage(Profiling::Stage::DiskWrite);
+
+    flushBuffer();
+    flushKeyBuffer();
+
+    outputFile->sync();
+    keyFile->sync();
+
+    return ExportCheckpoint{contentOffset, keyOffset, stats};
+}
+
+
+long MDictExporter::appendContent(const long pageId, const std::string_view content)
 {
-    for (const auto& entry: entries)
+    // Pages that are already links are short enough, and are left out so a link never points at another link
+    if (!dictionaryConfig.deduplicateContent || content.starts_with(LINK_PREFIX))
     {
-        if (const size_t estimatedSize = entry.content.size() + 100; buffer.size() + estimatedSize > BUFFER_SIZE_LIMIT)
+        appendRecord(pageId, content);
+        return pageId;
+    }
+
+    const uint64_t contentHash = HashUtils::hash(content);
+    bool isKnown = false;
+    for (auto [page, end] = contentPages.equal_range(contentHash); page != end && !isKnown; ++page)
+    {
+        if (!hasContent(page->second, content))
+            continue;
+
+        isKnown = true;
+        if (const long target = page->second.pageId; target != pageId)
         {
-            flushBuffer();
+            const std::string link = std::string(LINK_PREFIX) + std::to_string(target);
+            if (link.size() < content.size())
+            {
+                stats.duplicateEntries++;
+                stats.duplicateBytes += content.size() - link.size();
+                appendRecord(pageId, link);
+                return target;
+            }
         }
+    }
+
+    const uint64_t offset = appendRecord(pageId, content);
+    if (!isKnown)
+        contentPages.emplace(contentHash, ContentPage{pageId, offset, content.size()});
+    return pageId;
+}
+
 
-        buffer += std::to_string(entry.pageId);
-        buffer += '\n';
-        buffer += entry.content;
-        buffer += "\n</>\n";
+bool MDictExporter::hasContent(const ContentPage& page, const std::string_view content)
+{
+    if (page.size != content.size())
+        return false;
+
+    // Still in the buffer, which starts where the content handed to the sink ends
+    if (page.offset >= contentOffset)
+        return std::string_view(buffer).substr(page.offset - contentOffset, page.size) == content;
 
-        // Emergency flush if buffer is too large
-        if (buffer.size() > MAX_BUFFER_SIZE)
+    outputFile->flush();
+    if (!contentReader.is_open())
+    {
+        contentReader.open(outputTxtFile, std::ios::in | std::ios::binary);
+        if (!contentReader.is_open())
+            throw std::runtime_error("Failed to open content file: " + outputTxtFile.string());
+    }
+
+    storedContent.resize(page.size);
+    contentReader.clear();
+    contentReader.seekg(static_cast<std::streamoff>(page.offset));
+    if (!contentReader.read(storedContent.data(), static_cast<std::streamsize>(page.size)))
+        throw std::runtime_error("Failed to read back page " + std::to_string(page.pageId) + " from " + outputTxtFile.string());
+
+    return storedContent == content;
+}
+
+
+void MDictExporter::addLookupKeys(const long entryPageId, const std::string_view content, const long contentPageId,
+                                  std::vector<std::string> keys)
+{
+    // A page that is itself a link shows the page it links to
+    long pageId = contentPageId;
+    const bool isLink = content.starts_with(LINK_PREFIX);
+    if (isLink)
+    {
+        const std::string_view target = content.substr(LINK_PREFIX.size());
+        if (const auto [end, ec] = std::from_chars(target.data(), target.data() + target.size(), pageId); ec != std::errc())
         {
-            flushBuffer();
+            std::cerr << "Page " << entryPageId << " links to an invalid page, its keys are left out of the lookup index" << std::endl;
+            return;
         }
     }
 
-    // Flush remaining content
-    flushBuffer();
+    if (const auto record = lookupRecords.find(pageId); record != lookupRecords.end())
+    {
+        for (const auto& key : keys)
+            lookupIndex->addKey(key, record->second);
+        return;
+    }
+
+    // The record has to hold the content of the target, so the keys wait until the target is added
+    if (isLink)
+    {
+        auto& pendingKeys = pendingLookupKeys[pageId];
+        pendingKeys.insert(pendingKeys.end(), std::make_move_iterator(keys.begin()), std::make_move_iterator(keys.end()));
+        return;
+    }
+
+    const uint64_t record = lookupIndex->addRecord(content);
+    lookupRecords.emplace(pageId, record);
+
+    for (const auto& key : keys)
+        lookupIndex->addKey(key, record);
+
+    if (const auto pending = pendingLookupKeys.find(pageId); pending != pendingLookupKeys.end())
+    {
+        for (const auto& key : pending->second)
+            lookupIndex->addKey(key, record);
+        pendingLookupKeys.erase(pending);
+    }
 }
 
 
-void MDictExporter::writeKeySection()
+uint64_t MDictExporter::appendRecord(const long pageId, const std::string_view content)
 {
-    for (const auto& entry : entries)
+    if (const size_t estimatedSize = content.size() + 100; buffer.size() + estimatedSize > BUFFER_SIZE_LIMIT)
     {
-        const auto rawKeys = entry.keys;
-        const auto hiraganaKeys = KanaConvert::normalizeKeys(rawKeys, "ひらがな");
-        const auto katakanaKeys = KanaConvert::normalizeKeys(rawKeys, "カタカナ");
+        flushBuffer();
+    }
 
-        // Export hiragana keys
-        for (const auto& key : hiraganaKeys)
-        {
-            if (const size_t estimatedSize = key.size() + 50; buffer.size() + estimatedSize > BUFFER_SIZE_LIMIT)
-            {
-                flushBuffer();
-            }
+    buffer += std::to_string(pageId);
+    buffer += '\n';
+    const uint64_t offset = contentOffset + buffer.size();
+    buffer += content;
+    buffer += RECORD_END;
 
-            if (key.find("〓") == 0)
-            {
-                continue;
-            }
+    // Emergency flush if buffer is too large
+    if (buffer.size() > MAX_BUFFER_SIZE)
+    {
+        flushBuffer();
+    }
 
-            buffer += key;
-            buffer += "\n@@@LINK=";
-            buffer += std::to_string(entry.pageId);
-            buffer += "\n</>\n";
+    return offset;
+}
 
-            // Emergency flush if buffer is too large
-            if (buffer.size() > MAX_BUFFER_SIZE)
-            {
-                flushBuffer();
-            }
+
+void MDictExporter::restoreContentHashes(const uint64_t offset)
+{
+    std::ifstream contentFile(outputTxtFile, std::ios::in | std::ios::binary);
+    if (!contentFile.is_open())
+    {
+        throw std::runtime_error("Failed to open content file: " + outputTxtFile.string());
+    }
+
+    std::vector<char> chunk(BUFFER_SIZE_LIMIT);
+    std::string pending;
+    // Offset of the start of pending in the content file
+    uint64_t pendingOffset = 0;
+    uint64_t remaining = offset;
+
+    while (remaining > 0)
+    {
+        contentFile.read(chunk.data(), static_cast<std::streamsize>(std::min<uint64_t>(chunk.size(), remaining)));
+        const auto bytesRead = static_cast<size_t>(contentFile.gcount());
+        if (bytesRead == 0)
+        {
+            throw std::runtime_error("Content file is shorter than its checkpoint: " + outputTxtFile.string());
         }
 
-        // Export katakana keys
-        for (const auto& key : katakanaKeys)
+        remaining -= bytesRead;
+        pending.append(chunk.data(), bytesRead);
+
+        // Records are "pageId\ncontent\n</>\n", the same pages are registered as when they were first added
+        size_t recordStart = 0;
+        for (size_t recordEnd = pending.find(RECORD_END); recordEnd != std::string::npos;
+             recordEnd = pending.find(RECORD_END, recordStart))
         {
-            if (!std::ranges::any_of(key, [](const auto& ch) { return KanjiUtils::isKatakana(ch); }) || key == "〆")
+            const std::string_view record(pending.data() + recordStart, recordEnd - recordStart);
+            const uint64_t recordOffset = pendingOffset + recordStart;
+            recordStart = recordEnd + RECORD_END.size();
+
+            const size_t idEnd = record.find('\n');
+            if (idEnd == std::string_view::npos)
                 continue;
 
-            if (key.find("〓") == 0)
-            {
+            const std::string_view content = record.substr(idEnd + 1);
+            if (content.starts_with(LINK_PREFIX))
                 continue;
-            }
 
-            if (const size_t estimatedSize = key.size() + 50; buffer.size() + estimatedSize > BUFFER_SIZE_LIMIT)
+            const uint64_t contentHash = HashUtils::hash(content);
+            const auto [first, end] = contentPages.equal_range(contentHash);
+            if (std::none_of(first, end, [&](const auto& page) { return hasContent(page.second, content); }))
             {
-                flushBuffer();
+                const ContentPage page{std::stol(std::string(record.substr(0, idEnd))), recordOffset + idEnd + 1, content.size()};
+                contentPages.emplace(contentHash, page);
             }
+        }
 
-            buffer += key;
-            buffer += "\n@@@LINK=";
-            buffer += std::to_string(entry.pageId);
-            buffer += "\n</>\n";
+        pendingOffset += recordStart;
+        pending.erase(0, recordStart);
+    }
+}
 
-            // Emergency flush if buffer is too large
-            if (buffer.size() > MAX_BUFFER_SIZE)
-            {
-                flushBuffer();
-            }
+
+void MDictExporter::appendKeys(const long entryPageId, const std::vector<std::string>& rawKeys, std::vector<std::string>* lookupKeys)
+{
+    const Profiling::ScopedStage stage(Profiling::Stage::KeyExtraction);
+
+    const auto hiraganaKeys = KanaConvert::normalizeKeys(rawKeys, "ひらがな");
+    const auto katakanaKeys = KanaConvert::normalizeKeys(rawKeys, "カタカナ");
+
+    const std::string pageId = std::to_string(entryPageId);
+
+    auto appendKey = [&](const std::string& key) {
+        if (const size_t estimatedSize = key.size() + 50; keyBuffer.size() + estimatedSize > BUFFER_SIZE_LIMIT)
+        {
+            flushKeyBuffer();
+        }
+
+        keyBuffer += key;
+        keyBuffer += "\n@@@LINK=";
+        keyBuffer += pageId;
+        keyBuffer += "\n</>\n";
+
+        if (lookupKeys)
+            lookupKeys->push_back(key);
+    };
+
+    // Export hiragana keys
+    for (const auto& key : hiraganaKeys)
+    {
+        if (key.find("〓") == 0)
+        {
+            continue;
         }
+
+        appendKey(key);
     }
 
-    // Flush remaining keys
-    flushBuffer();
+    // Export katakana keys
+    for (const auto& key : katakanaKeys)
+    {
+        if (!std::ranges::any_of(key, [](const auto& ch) { return KanjiUtils::isKatakana(ch); }) || key == "〆")
+            continue;
+
+        if (key.find("〓") == 0)
+        {
+            continue;
+        }
+
+        appendKey(key);
+    }
+
+    // Emergency flush if buffer is too large
+    if (keyBuffer.size() > MAX_BUFFER_SIZE)
+    {
+        flushKeyBuffer();
+    }
+}
+
+
+void MDictExporter::writeKeySection()
+{
+    const Profiling::ScopedTrace trace("writeKeySection", "mdict");
+    const Profiling::ScopedStage stage(Profiling::Stage::DiskWrite);
+
+    flushKeyBuffer();
+    keyFile->close();
+
+    {
+        std::ifstream keys(keyTxtFile, std::ios::in | std::ios::binary);
+        if (!keys.is_open())
+        {
+            throw std::runtime_error("Failed to open key file: " + keyTxtFile.string());
+        }
+
+        // Keys follow all the content records, in the order the entries were added
+        keyBuffer.resize(BUFFER_SIZE_LIMIT);
+        while (keys.read(keyBuffer.data(), static_cast<std::streamsize>(keyBuffer.size())) || keys.gcount() > 0)
+        {
+            keyBuffer.resize(static_cast<size_t>(keys.gcount()));
+            outputFile->write(keyBuffer);
+            keyBuffer.resize(BUFFER_SIZE_LIMIT);
+        }
+        keyBuffer.clear();
+
+        outputFile->flush();
+    }
+
+    std::filesystem::remove(keyTxtFile);
 }
 
 
@@ -194,7 +558,7 @@ void MDictExporter::writeTitleFile() const
     const std::filesystem::path titleFilePath = outputDirectory / "title.html";
 
     std::ofstream titleFile(titleFilePath, std::ios::out | std::ios::trunc);
-    if (!outputFile->is_open())
+    if (!titleFile.is_open())
     {
         std::cerr << "Failed to open title file: " << titleFilePath.string() << std::endl;
         return;
@@ -206,13 +570,15 @@ void MDictExporter::writeTitleFile() const
 
 void MDictExporter::flushBuffer()
 {
+    const Profiling::ScopedStage stage(Profiling::Stage::DiskWrite);
+
     try
     {
         if (outputFile && !buffer.empty())
         {
-            *outputFile << buffer;
-            outputFile->flush();
-            buffer.clear();
+            // The buffer is handed to the sink and replaced by an empty one to fill meanwhile
+            contentOffset += buffer.size();
+            outputFile->write(buffer);
         }
     }
     catch (std::exception& e)
@@ -223,6 +589,18 @@ void MDictExporter::flushBuffer()
 }
 
 
+void MDictExporter::flushKeyBuffer()
+{
+    const Profiling::ScopedStage stage(Profiling::Stage::DiskWrite);
+
+    if (keyFile && !keyBuffer.empty())
+    {
+        keyOffset += keyBuffer.size();
+        keyFile->write(keyBuffer);
+    }
+}
+
+
 void MDictExporter::runMdictConvert() const
 {
     // Only run if 'mdict' command is available
@@ -236,7 +614,7 @@ void MDictExporter::runMdictConvert() const
 
         const std::string mddCommand = "mdict --title \"" + outputDirectory.string() + "/title.html\" "
                             + "--description \"" + config.descriptionPath.value().string() + "\" "
-                            + "-a \"" + config.assetDirectory.value().string() + "\" \""
+                            + "-a \"" + mddSourceDirectory.string() + "\" \""
                             + outputDirectory.string() + "/" + dictionaryConfig.title + ".mdd\"";
 
 
@@ -247,7 +625,11 @@ void MDictExporter::runMdictConvert() const
             std::filesystem::remove(outputTxtFile);
         }
 
-        if (const int result = std::system(mddCommand.c_str()); result != 0)
+        if (mddSourceDirectory.empty() || !std::filesystem::exists(mddSourceDirectory))
+        {
+            std::filesystem::remove(outputDirectory.string() + "/title.html");
+        }
+        else if (const int result = std::system(mddCommand.c_str()); result != 0)
             std:: cerr << "mdict failed with exit code: " << result << std::endl;
         else
         {
@@ -265,3 +647,23 @@ MDictExporter::ExportStats MDictExporter::exportStats() const
 {
     return stats;
 }
+
+
+void MDictExporter::setMddSourceDirectory(const std::filesystem::path& directoryPath)
+{
+    mddSourceDirectory = directoryPath;
+}
+
+
+void MDictExporter::beginCapture()
+{
+    capturedEntries.clear();
+    capturing = true;
+}
+
+
+std::vector<MDictEntry> MDictExporter::endCapture()
+{
+    capturing = false;
+    return std::exchange(capturedEntries, {});
+}
\ No newline at end of file
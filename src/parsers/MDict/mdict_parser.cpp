@@ -1,7 +1,8 @@
 #include "yomitan_dictionary_builder/parsers/MDict/mdict_parser.h"
 #include "yomitan_dictionary_builder/utils/jptools/kanji_utils.h"
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
+#include "yomitan_dictionary_builder/utils/xml_loader.h"
 
-#include <complex>
 #include <vector>
 
 #include "yomitan_dictionary_builder/strategies/key/key_extraction_strategy.h"
@@ -14,8 +15,34 @@ MdictParser::MdictParser(const ParserConfig& config, const MDictConfig& dictiona
 
     // Create strategies
     this->keyExtractionStrategy = config.createKeyExtractionStrategy();
-    this->linkHandlingStrategy = config.createMDictLinkStrategy(dictionaryConfig);
-    this->imageHandlingStrategy = config.createImageStrategy();
+
+    std::optional<MDictStrategies> staticStrategies;
+    if (config.staticStrategies)
+    {
+        staticStrategies = createStaticMDictStrategies(config, this->dictionaryConfig);
+        if (!staticStrategies)
+            std::cerr << "Falling back to virtual strategy calls" << std::endl;
+    }
+
+    if (staticStrategies)
+    {
+        this->strategies = std::move(staticStrategies.value());
+    }
+    else
+    {
+        this->linkHandlingStrategy = config.createMDictLinkStrategy(this->dictionaryConfig);
+        if (config.createImageStrategy)
+            this->imageHandlingStrategy = config.createImageStrategy();
+
+        this->strategies = DynamicMDictStrategies{linkHandlingStrategy.get(), imageHandlingStrategy.get()};
+    }
+
+    // Record referenced images and audio so only those get packed into the MDD
+    if (config.pruneUnreferencedAssets && config.assetDirectory.has_value())
+    {
+        this->assetRegistry = std::make_unique<AssetRegistry>();
+        std::visit([this](auto& selected) { selected.setAssetRegistry(assetRegistry.get()); }, this->strategies);
+    }
 
     this->subItemProcessor = std::make_unique<SubItemProcessor>(dictionaryConfig);
 }
@@ -31,7 +58,9 @@ void MdictParser::initializeProcessing()
         throw std::runtime_error("Output path is required for MDict parser");
     }
 
-    exporter = std::make_unique<MDictExporter>(dictionaryConfig, config);
+    exporter = std::make_unique<MDictExporter>(dictionaryConfig, config, exportResumePoint);
+    if (assetRegistry)
+        exporter->setMddSourceDirectory(config.outputPath.value() / "mdd");
 
     if (config.hasAssets())
     {
@@ -55,7 +84,14 @@ void MdictParser::finalizeProcessing()
         if (config.iconPath.has_value())
             assetConfig.iconPath = config.iconPath.value();
 
-        assetManager->copyAssets(assetConfig);
+        // Without pruning the MDD is packed straight from the asset directory
+        if (assetRegistry)
+            assetConfig.assetDirectory = config.assetDirectory.value();
+
+        assetManager->copyAssets(assetConfig, assetRegistry.get());
+
+        if (assetRegistry && config.showProgress)
+            printAssetReport();
     }
 
     if (exporter)
@@ -64,71 +100,236 @@ void MdictParser::finalizeProcessing()
 
         if (config.showProgress)
         {
-            const auto [totalEntries, totalKeys] = exporter->exportStats();
+            const auto [totalEntries, totalKeys, duplicateEntries, duplicateBytes] = exporter->exportStats();
             std::cout << "Processing complete" << '\n';
             std::cout << "  Total entries: " << totalEntries << '\n';
-            std::cout << "  Total keys: " << totalKeys << std::endl;
+            std::cout << "  Total keys: " << totalKeys << '\n';
+            std::cout << "  Duplicate pages linked: " << duplicateEntries << " (" << duplicateBytes << " bytes saved)" << std::endl;
         }
     }
 }
 
 
-int MdictParser::processFile(const std::filesystem::path &filePath)
+void MdictParser::printAssetReport() const
 {
-    pugi::xml_document doc;
-    if (!FileUtils::loadXMLFile(doc, filePath))
+    const auto& [copiedFiles, unreferencedFiles, copiedBytes, skippedBytes, missingFiles] = assetManager->getReport();
+
+    std::cout << "Assets" << '\n';
+    std::cout << "  Referenced: " << assetRegistry->size() << '\n';
+    std::cout << "  Copied: " << copiedFiles << " (" << copiedBytes / 1024 << " KB)" << '\n';
+    std::cout << "  Unreferenced (skipped): " << unreferencedFiles << " (" << skippedBytes / 1024 << " KB)" << '\n';
+    std::cout << "  Missing: " << missingFiles.size() << std::endl;
+
+    for (const auto& missingFile : missingFiles)
     {
-        std::cerr << "Failed to load xml file " << filePath.string() << std::endl;
+        std::cerr << "Referenced asset not found: " << missingFile << std::endl;
+    }
+}
+
+
+int MdictParser::processFile(FileUtils::PageFile& page)
+{
+    pugi::xml_document* document = XMLLoader::forCurrentThread().load(page);
+    if (!document)
+    {
+        std::cerr << "Failed to load xml file " << page.path.string() << std::endl;
         return 0;
     }
 
-    const int pageID = MDictLinkHandlingStrategy::getPageId(filePath.filename().string());
+    return processDocument(page, *document);
+}
 
-    // fix all link elements e.g ensure "entry://...", "sound://..."
-    processAllLinkElements(doc);
-    if (this->imageHandlingStrategy)
-        this->imageHandlingStrategy->processAllImageElements(doc);
 
-    auto headEntryKeys = indexReader->getKeysForFile(filePath.stem().string());
+int MdictParser::processDocument(const FileUtils::PageFile& page, pugi::xml_document& doc)
+{
+    const std::filesystem::path& filePath = page.path;
+    const int pageID = MDictLinkHandlingStrategy::getPageId(filePath.filename().string());
+
+    std::visit([&doc](const auto& selected) { rewriteReferences(doc, selected); }, strategies);
 
-    // get any dictionary specific keys that are missing from the index
-    if (headEntryKeys.empty())
-        headEntryKeys = keyExtractionStrategy->extractKeys(doc, filePath);
+    std::vector<std::string> headEntryKeys;
+    {
+        const Profiling::ScopedStage stage(Profiling::Stage::KeyExtraction);
+        headEntryKeys = indexReader->getKeysForFile(filePath.stem().string());
 
-    auto jukugoKeys = jukugoIndexReader->getGroupedEntriesForPage(pageID);
+        // get any dictionary specific keys that are missing from the index
+        if (headEntryKeys.empty())
+            headEntryKeys = keyExtractionStrategy->extractKeys(doc, filePath);
+    }
 
     int subItemsProcessed{0};
-    if (!dictionaryConfig.subElement.empty())
-        subItemsProcessed = subItemProcessor->processSubItems(doc, jukugoKeys, pageID, *exporter);
+    {
+        const Profiling::ScopedStage stage(Profiling::Stage::SubItems);
+        const auto& jukugoKeys = jukugoIndexReader->getGroupedEntriesForPage(pageID);
+
+        // Marks the sub items and the subitem section, which is left out of the page content
+        subItemsProcessed = subItemProcessor->markSubItems(doc, jukugoKeys, pageID);
+    }
 
-    // Remove the subitem section
-    for (const auto subItemSelector = dictionaryConfig.subElement.empty() ? "SubItemG" : dictionaryConfig.subElement.c_str();
-         auto subItemGNode : doc.select_nodes((std::string("//") + subItemSelector).c_str()))
+    // The page is serialised once, the sub item entries are slices of it
+    const std::string_view serializedPage = getXMLContent(doc);
+    std::string_view xmlContent;
     {
-        subItemGNode.node().parent().remove_child(subItemGNode.node());
+        const Profiling::ScopedStage stage(Profiling::Stage::SubItems);
+        xmlContent = subItemProcessor->extractSubItems(serializedPage, *exporter);
     }
 
-    const std::string xmlContent = getXMLContent(doc);
     if (xmlContent.empty())
     {
         std::cerr << "No content extracted from file: " << filePath << std::endl;
         return 0;
     }
 
-    const MDictEntry entry(pageID, headEntryKeys, xmlContent);
-    exporter->addEntry(entry);
+    const int entriesProcessed = static_cast<int>(headEntryKeys.size()) + subItemsProcessed;
+    exporter->addEntry(pageID, std::move(headEntryKeys), xmlContent);
+
+    return entriesProcessed;
+}
+
+
+bool MdictParser::supportsPageCache() const
+{
+    return true;
+}
+
+
+void MdictParser::hashCacheConfig(HashUtils::Hasher& hasher) const
+{
+    XMLParser::hashCacheConfig(hasher);
 
-    return static_cast<int>(headEntryKeys.size()) + subItemsProcessed;
+    hasher.updateField(dictionaryConfig.appendixLinkIdentifier);
+    hasher.updateField(dictionaryConfig.subElement);
+    hasher.update(static_cast<uint64_t>(assetRegistry != nullptr));
+    hasher.updateFile(config.indexPath.value().parent_path() / "jyukugo_prefix.tsv");
+}
+
+
+void MdictParser::beginPageCapture()
+{
+    exporter->beginCapture();
+    if (assetRegistry)
+        assetRegistry->beginCapture();
 }
 
 
-std::string MdictParser::getXMLContent(const pugi::xml_document& xmlDoc)
+bool MdictParser::endPageCapture(PageRecordWriter& record)
+{
+    const auto entries = exporter->endCapture();
+    const auto references = assetRegistry ? assetRegistry->endCapture() : std::vector<std::string>{};
+
+    record.writeUint64(entries.size());
+    for (const auto& [pageId, keys, content] : entries)
+    {
+        record.writeUint64(static_cast<uint64_t>(pageId));
+        record.writeStrings(keys);
+        record.writeString(content);
+    }
+
+    record.writeStrings(references);
+    return true;
+}
+
+
+bool MdictParser::replayPage(PageRecordReader& record)
+{
+    uint64_t entryCount = 0;
+    if (!record.readUint64(entryCount))
+        return false;
+
+    std::vector<MDictEntry> entries;
+    for (uint64_t i = 0; i < entryCount; ++i)
+    {
+        uint64_t pageId = 0;
+        std::vector<std::string> keys;
+        std::string content;
+        if (!record.readUint64(pageId) || !record.readStrings(keys) || !record.readString(content))
+            return false;
+
+        entries.emplace_back(static_cast<long>(pageId), std::move(keys), std::move(content));
+    }
+
+    std::vector<std::string> references;
+    if (!record.readStrings(references) || !record.atEnd())
+        return false;
+
+    for (auto& entry : entries)
+        exporter->addEntry(std::move(entry));
+
+    if (assetRegistry)
+    {
+        for (const auto& reference : references)
+            assetRegistry->recordReference(reference);
+    }
+
+    return true;
+}
+
+
+bool MdictParser::supportsCheckpoint() const
+{
+    return true;
+}
+
+
+bool MdictParser::saveCheckpointState(CheckpointState& state)
 {
     try
     {
-        std::ostringstream oss;
-        xmlDoc.save(oss, "", pugi::format_raw, pugi::encoding_utf8);
-        return oss.str();
+        const auto [contentOffset, keyOffset, stats] = exporter->checkpoint();
+        state.contentOffset = contentOffset;
+        state.keyOffset = keyOffset;
+        state.exportedEntries = stats.totalEntries;
+        state.exportedKeys = stats.totalKeys;
+        state.duplicateEntries = stats.duplicateEntries;
+        state.duplicateBytes = stats.duplicateBytes;
+
+        if (assetRegistry)
+            state.assetReferences = assetRegistry->getReferences();
+
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error saving checkpoint: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+
+bool MdictParser::restoreCheckpointState(const CheckpointState& state)
+{
+    exportResumePoint = MDictExporter::ExportCheckpoint{
+        state.contentOffset,
+        state.keyOffset,
+        {state.exportedEntries, state.exportedKeys, state.duplicateEntries, state.duplicateBytes}
+    };
+
+    if (!MDictExporter::canResume(dictionaryConfig, config, exportResumePoint))
+        return false;
+
+    if (assetRegistry)
+    {
+        for (const auto& reference : state.assetReferences)
+            assetRegistry->recordReference(reference);
+    }
+
+    return true;
+}
+
+
+std::string_view MdictParser::getXMLContent(const pugi::xml_document& xmlDoc)
+{
+    const Profiling::ScopedStage stage(Profiling::Stage::Serialization);
+
+    // Grows to the largest page once, instead of a new stream and a copy of its contents per page
+    thread_local std::string pageBuffer;
+
+    try
+    {
+        pageBuffer.clear();
+        StringXMLWriter writer(pageBuffer);
+        xmlDoc.save(writer, "", pugi::format_raw, pugi::encoding_utf8);
+        return pageBuffer;
     }
     catch (const std::exception& e)
     {
@@ -138,7 +339,24 @@ std::string MdictParser::getXMLContent(const pugi::xml_document& xmlDoc)
 }
 
 
-void MdictParser::processAllLinkElements(const pugi::xml_document& xmlDoc) const
+template<typename Strategies>
+void MdictParser::rewriteReferences(const pugi::xml_document& xmlDoc, const Strategies& strategies)
+{
+    // fix all link elements e.g ensure "entry://...", "sound://..."
+    {
+        const Profiling::ScopedStage stage(Profiling::Stage::LinkRewrite);
+        processAllLinkElements(xmlDoc, strategies);
+    }
+
+    {
+        const Profiling::ScopedStage stage(Profiling::Stage::ImageRewrite);
+        strategies.processAllImageElements(xmlDoc);
+    }
+}
+
+
+template<typename Strategies>
+void MdictParser::processAllLinkElements(const pugi::xml_document& xmlDoc, const Strategies& strategies)
 {
     try
     {
@@ -168,7 +386,7 @@ void MdictParser::processAllLinkElements(const pugi::xml_document& xmlDoc) const
                     continue;
                 }
 
-                const std::string newHref = linkHandlingStrategy->getNewHref(href);
+                const std::string newHref = strategies.getNewHref(href);
                 if (tagName == "a")
                 {
                     // Direct href replacement for <a> tags
@@ -0,0 +1,42 @@
+#include "yomitan_dictionary_builder/parsers/MDict/mdict_strategies.h"
+
+#include <iostream>
+
+namespace
+{
+    template<typename LinkStrategy>
+    MDictStrategies createWithImageStrategy(const ParserConfig& config, const MDictConfig& dictionaryConfig)
+    {
+        auto link = std::make_unique<LinkStrategy>(dictionaryConfig);
+
+        if (config.imageStrategyType == "hash")
+        {
+            return StaticMDictStrategies<LinkStrategy, HashedImageStrategy>{
+                std::move(link), std::make_unique<HashedImageStrategy>(config.imageMappingPath.value().string())
+            };
+        }
+
+        return StaticMDictStrategies<LinkStrategy, DefaultImageHandlingStrategy>{
+            std::move(link), std::make_unique<DefaultImageHandlingStrategy>()
+        };
+    }
+}
+
+
+std::optional<MDictStrategies> createStaticMDictStrategies(const ParserConfig& config, const MDictConfig& dictionaryConfig)
+{
+    if (config.imageStrategyType != "default" && (config.imageStrategyType != "hash" || !config.imageMappingPath.has_value()))
+    {
+        std::cerr << "No static strategies for image strategy '" << config.imageStrategyType << "'" << std::endl;
+        return std::nullopt;
+    }
+
+    if (config.mdictLinkStrategy == "mdict")
+        return createWithImageStrategy<MDictLinkHandlingStrategy>(config, dictionaryConfig);
+
+    if (config.mdictLinkStrategy == "nds")
+        return createWithImageStrategy<NDSLinkExtractionStrategy>(config, dictionaryConfig);
+
+    std::cerr << "No static strategies for link strategy '" << config.mdictLinkStrategy << "'" << std::endl;
+    return std::nullopt;
+}
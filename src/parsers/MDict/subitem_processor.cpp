@@ -12,53 +12,154 @@ SubItemProcessor::SubItemProcessor(MDictConfig  dictionaryConfig) : dictionaryCo
 }
 
 
-int SubItemProcessor::processSubItems(const pugi::xml_document& xmlDoc, std::unordered_map<int, std::vector<std::string>>& keys, const int pageId, MDictExporter& mdictExporter)
+namespace
 {
-    int processedCount = 0;
-
-    try
+    // Processing instructions never come out of escaped text or attributes, so they can't be confused with content
+    constexpr std::string_view MARKER_START = "<?ydb-";
+    constexpr std::string_view ITEM_BEGIN = "<?ydb-item-begin?>";
+    constexpr std::string_view ITEM_END = "<?ydb-item-end?>";
+    constexpr std::string_view CUT_BEGIN = "<?ydb-cut-begin?>";
+    constexpr std::string_view CUT_END = "<?ydb-cut-end?>";
+
+    void insertMarker(pugi::xml_node marker, const std::string_view markerText)
     {
-        static const std::string query {"//" + dictionaryConfig.subElement};
-        for (auto subItemNode : xmlDoc.select_nodes(query.c_str()))
-        {
-            pugi::xml_attribute idAttr = subItemNode.node().attribute("id");
-            if (!idAttr) continue;
+        // "<?name?>" -> "name"
+        marker.set_name(std::string(markerText.substr(2, markerText.size() - 4)).c_str());
+    }
+}
+
 
-            const std::string subItemId = idAttr.value();
-            const std::string itemId = MDictLinkHandlingStrategy::extractItemId(subItemId);
-            const int itemIdVal = std::stoi(itemId);
+int SubItemProcessor::markSubItems(const pugi::xml_document& xmlDoc, const std::unordered_map<int, std::vector<std::string>>& keys, const int pageId)
+{
+    pendingSubItems.clear();
 
-            // Check if we have keys for this item ID
-            if (!keys.contains(itemIdVal))
+    if (!dictionaryConfig.subElement.empty())
+    {
+        try
+        {
+            const std::string query = "//" + dictionaryConfig.subElement;
+            for (auto subItemNode : xmlDoc.select_nodes(query.c_str()))
             {
-                std::cerr << "No jukugo keys found for item ID: " << itemId << " in page: " << std::to_string(pageId) << std::endl;
-                continue;
+                pugi::xml_node node = subItemNode.node();
+                pugi::xml_attribute idAttr = node.attribute("id");
+                if (!idAttr) continue;
+
+                const std::string subItemId = idAttr.value();
+                const std::string itemId = MDictLinkHandlingStrategy::extractItemId(subItemId);
+                const int itemIdVal = std::stoi(itemId);
+
+                // Check if we have keys for this item ID
+                const auto itemKeys = keys.find(itemIdVal);
+                if (itemKeys == keys.end())
+                {
+                    std::cerr << "No jukugo keys found for item ID: " << itemId << " in page: " << std::to_string(pageId) << std::endl;
+                    continue;
+                }
+
+                if (!shellConstructed)
+                    createSubItemShell(node);
+
+                // Create combined entry ID: pageID + itemID
+                const long entryId = std::stol(std::to_string(80) + std::to_string(pageId) + itemId);
+                pendingSubItems.push_back({entryId, itemKeys->second});
+
+                // Only the inner content of the SubItem goes into its entry
+                insertMarker(node.prepend_child(pugi::node_pi), ITEM_BEGIN);
+                insertMarker(node.append_child(pugi::node_pi), ITEM_END);
             }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error processing SubItems: " << e.what() << std::endl;
+        }
+    }
 
-            if (!shellConstructed)
-                createSubItemShell(subItemNode.node());
+    // The sub item section is left out of the page
+    const std::string groupQuery = "//" + (dictionaryConfig.subElement.empty() ? std::string("SubItemG") : dictionaryConfig.subElement);
+    for (auto groupNode : xmlDoc.select_nodes(groupQuery.c_str()))
+    {
+        pugi::xml_node node = groupNode.node();
+        pugi::xml_node parent = node.parent();
+        insertMarker(parent.insert_child_before(pugi::node_pi, node), CUT_BEGIN);
+        insertMarker(parent.insert_child_after(pugi::node_pi, node), CUT_END);
+    }
 
-            const std::string wrappedContent = wrapContent(subItemNode.node());
+    return static_cast<int>(pendingSubItems.size());
+}
 
-            // Create combined entry ID: pageID + itemID
-            const long entryId = std::stol(std::to_string(80) + std::to_string(pageId) + itemId);
 
-            // Get keys for this item
-            const std::vector<std::string>& itemKeys = keys[itemIdVal];
+std::string_view SubItemProcessor::extractSubItems(const std::string_view serializedPage, MDictExporter& mdictExporter)
+{
+    // Without markers nothing is left out, and no sub item was marked
+    if (serializedPage.find(MARKER_START) == std::string_view::npos)
+    {
+        pendingSubItems.clear();
+        return serializedPage;
+    }
 
-            MDictEntry entry(entryId, itemKeys, wrappedContent);
-            mdictExporter.addEntry(entry);
+    content.clear();
+    content.reserve(serializedPage.size());
 
-            processedCount++;
-        }
+    std::vector<std::string> subItemContents(pendingSubItems.size());
+    std::vector<size_t> openSubItems;
+    size_t subItemsStarted = 0;
+    int cutDepth = 0;
+
+    const auto appendSlice = [&](const std::string_view slice) {
+        if (cutDepth == 0)
+            content.append(slice);
+        for (const size_t index : openSubItems)
+            subItemContents[index].append(slice);
+    };
+
+    size_t position = 0;
+    while (position < serializedPage.size())
+    {
+        const size_t markerPosition = serializedPage.find(MARKER_START, position);
+        appendSlice(serializedPage.substr(position, markerPosition - position));
+        if (markerPosition == std::string_view::npos)
+            break;
 
+        const std::string_view rest = serializedPage.substr(markerPosition);
+        if (rest.starts_with(ITEM_BEGIN) && subItemsStarted < subItemContents.size())
+        {
+            const size_t index = subItemsStarted++;
+            subItemContents[index].reserve(subItemShell.shellPrefix.size() + subItemShell.shellSuffix.size() + 256);
+            subItemContents[index].append(subItemShell.shellPrefix);
+            openSubItems.push_back(index);
+            position = markerPosition + ITEM_BEGIN.size();
+        }
+        else if (rest.starts_with(ITEM_END) && !openSubItems.empty())
+        {
+            subItemContents[openSubItems.back()].append(subItemShell.shellSuffix);
+            openSubItems.pop_back();
+            position = markerPosition + ITEM_END.size();
+        }
+        else if (rest.starts_with(CUT_BEGIN))
+        {
+            ++cutDepth;
+            position = markerPosition + CUT_BEGIN.size();
+        }
+        else if (rest.starts_with(CUT_END) && cutDepth > 0)
+        {
+            --cutDepth;
+            position = markerPosition + CUT_END.size();
+        }
+        else
+        {
+            // Not one of ours, keep it as it is
+            appendSlice(MARKER_START);
+            position = markerPosition + MARKER_START.size();
+        }
     }
-    catch (const std::exception& e)
+
+    for (size_t i = 0; i < subItemsStarted; ++i)
     {
-        std::cerr << "Error processing SubItems: " << e.what() << std::endl;
+        mdictExporter.addEntry(MDictEntry(pendingSubItems[i].entryId, std::move(pendingSubItems[i].keys), std::move(subItemContents[i])));
     }
+    pendingSubItems.clear();
 
-    return processedCount;
+    return content;
 }
 
 
@@ -127,19 +228,3 @@ void SubItemProcessor::createSubItemShell(const pugi::xml_node& subItemNode)
     shellConstructed = true;
     subItemShell = SubItemShell(shellPrefix, shellSuffix);
 }
-
-
-std::string SubItemProcessor::wrapContent(const pugi::xml_node& subItemNode) const
-{
-    // Get only the inner content of the SubItem
-    std::ostringstream contentOss;
-    for (auto child : subItemNode.children())
-    {
-        child.print(contentOss, "", pugi::format_raw);
-    }
-    const std::string subItemContent = contentOss.str();
-
-    return subItemShell.shellPrefix + subItemContent + subItemShell.shellSuffix;
-}
-
-
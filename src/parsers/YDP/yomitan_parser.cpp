@@ -1,25 +1,25 @@
 #include "yomitan_dictionary_builder/parsers/YDP/yomitan_parser.h"
 #include "yomitan_dictionary_builder/utils/file_utils.h"
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
 #include "yomitan_dictionary_builder/utils/jptools/kanji_utils.h"
 #include "yomitan_dictionary_builder/utils/jptools/kana_convert.h"
 
 namespace YDP
 {
-    int YomitanParser::processFile(const std::filesystem::path &filePath)
+    int YomitanParser::processDocument(FileUtils::PageFile& page, const pugi::xml_document& doc)
     {
+        const std::filesystem::path& filePath = page.path;
         int count = 0;
         const auto entryKeys = indexReader->getKeysForFile(filePath.stem().string());
 
-        pugi::xml_document doc;
-        if (!FileUtils::loadXMLFile(doc, filePath))
+        std::vector<KanjiUtils::ResultPair> matchedKeys;
         {
-            std::cerr << "Failed to load xml file " << filePath.string() << std::endl;
-        }
-
-        const std::string headword = extractHeadword(doc.document_element());
+            const Profiling::ScopedStage stage(Profiling::Stage::KeyExtraction);
+            const std::string headword = extractHeadword(doc.document_element());
 
-        const auto normalizedKeys = KanaConvert::normalizeKeys(entryKeys, headword);
-        const auto matchedKeys = KanjiUtils::matchKanaWithKanji(normalizedKeys);
+            const auto normalizedKeys = KanaConvert::normalizeKeys(entryKeys, headword);
+            matchedKeys = KanjiUtils::matchKanaWithKanji(normalizedKeys);
+        }
 
         for (const auto& [kanjiPart, kanaPart] : matchedKeys)
         {
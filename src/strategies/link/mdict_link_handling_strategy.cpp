@@ -25,6 +25,8 @@ std::string MDictLinkHandlingStrategy::getNewHref(const std::string& href) const
     else if (href.find(".aac") != std::string::npos)
     {
         newHref = getAudioHref(href);
+        if (assetRegistry)
+            assetRegistry->recordReference(newHref);
     }
     else
     {
@@ -35,6 +37,12 @@ std::string MDictLinkHandlingStrategy::getNewHref(const std::string& href) const
 }
 
 
+void MDictLinkHandlingStrategy::setAssetRegistry(AssetRegistry* registry)
+{
+    assetRegistry = registry;
+}
+
+
 std::string MDictLinkHandlingStrategy::getAudioHref(const std::string& href)
 {
     std::string newHref;
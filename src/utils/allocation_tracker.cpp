@@ -0,0 +1,198 @@
+#include "yomitan_dictionary_builder/utils/allocation_tracker.h"
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace Profiling
+{
+    void AllocationTracker::setEnabled(const bool isEnabled)
+    {
+        enabled.store(isEnabled, std::memory_order_relaxed);
+    }
+
+
+    bool AllocationTracker::isSupported()
+    {
+#ifdef YOMITAN_ALLOCATION_PROFILING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+
+    void AllocationTracker::record(const size_t bytes, const bool fromPugi)
+    {
+        // Allocations made while the thread's profiler registers itself are not counted
+        if (StageProfiler* profiler = StageProfiler::tryForCurrentThread())
+            profiler->recordAllocation(bytes, fromPugi);
+    }
+
+
+    uint64_t AllocationTracker::getPeakResidentBytes()
+    {
+#ifdef _WIN32
+        return 0;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+
+#ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        // kilobytes on Linux
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+}
+
+
+#ifdef YOMITAN_ALLOCATION_PROFILING
+
+// Replacements of the global allocation functions. They live in this translation unit so they are
+// linked in whenever the tracker is used, and forward to malloc like the default implementations.
+namespace
+{
+    void* allocateCounted(size_t size)
+    {
+        Profiling::AllocationTracker::recordAllocation(size);
+
+        if (size == 0)
+            size = 1;
+
+        while (true)
+        {
+            if (void* ptr = std::malloc(size))
+                return ptr;
+
+            const std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void* allocateAlignedCounted(size_t size, const std::align_val_t alignment)
+    {
+        Profiling::AllocationTracker::recordAllocation(size);
+
+        const auto align = static_cast<size_t>(alignment);
+        size = size == 0 ? align : (size + align - 1) & ~(align - 1);
+
+        while (true)
+        {
+#ifdef _WIN32
+            if (void* ptr = _aligned_malloc(size, align))
+                return ptr;
+#else
+            if (void* ptr = std::aligned_alloc(align, size))
+                return ptr;
+#endif
+
+            const std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void freeAligned(void* ptr) noexcept
+    {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+}
+
+
+void* operator new(const size_t size)
+{
+    return allocateCounted(size);
+}
+
+void* operator new[](const size_t size)
+{
+    return allocateCounted(size);
+}
+
+void* operator new(const size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocateCounted(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](const size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocateCounted(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new(const size_t size, const std::align_val_t alignment)
+{
+    return allocateAlignedCounted(size, alignment);
+}
+
+void* operator new[](const size_t size, const std::align_val_t alignment)
+{
+    return allocateAlignedCounted(size, alignment);
+}
+
+void* operator new(const size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocateAlignedCounted(size, alignment);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](const size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocateAlignedCounted(size, alignment);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(ptr); }
+
+#endif
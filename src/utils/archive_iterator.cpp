@@ -0,0 +1,576 @@
+#include "yomitan_dictionary_builder/utils/archive_iterator.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace FileUtils
+{
+    namespace
+    {
+        uint16_t readUint16(const char* data)
+        {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+            return static_cast<uint16_t>(bytes[0] | bytes[1] << 8);
+        }
+
+        uint32_t readUint32(const char* data)
+        {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+            return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 |
+                   static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+        }
+
+        uint64_t readUint64(const char* data)
+        {
+            return static_cast<uint64_t>(readUint32(data)) | static_cast<uint64_t>(readUint32(data + 4)) << 32;
+        }
+
+        /**
+         * Check if an archive member is a dictionary page, skipping the resource forks added by macOS
+         */
+        bool isPageMember(const std::string_view name)
+        {
+            if (!name.ends_with(".xml") || name.contains("__MACOSX/"))
+                return false;
+
+            const auto slashPos = name.rfind('/');
+            const auto fileName = slashPos == std::string_view::npos ? name : name.substr(slashPos + 1);
+            return !fileName.starts_with("._");
+        }
+
+
+        /**
+         * @brief Reads zip archives through the central directory, visiting members in file order
+         */
+        class ZipReader final : public ArchiveReader
+        {
+        public:
+            explicit ZipReader(const std::filesystem::path& archivePath)
+                : file(archivePath, std::ios::in | std::ios::binary)
+            {
+                if (!file.is_open())
+                    throw std::runtime_error("Failed to open archive: " + archivePath.string());
+
+                readCentralDirectory();
+
+                // Reading in local header order keeps the file access sequential
+                std::ranges::sort(entries, {}, &Entry::localHeaderOffset);
+            }
+
+            std::optional<PageFile> next() override
+            {
+                while (index < entries.size())
+                {
+                    const Entry& entry = entries[index++];
+                    if (auto contents = readEntry(entry); contents.has_value())
+                        return PageFile{entry.name, std::move(contents.value())};
+
+                    std::cerr << "Failed to read archive member: " << entry.name << std::endl;
+                }
+                return std::nullopt;
+            }
+
+            [[nodiscard]] size_t size() const
+            {
+                return entries.size();
+            }
+
+        private:
+            struct Entry
+            {
+                std::string name;
+                uint16_t method = 0;
+                uint64_t compressedSize = 0;
+                uint64_t uncompressedSize = 0;
+                uint64_t localHeaderOffset = 0;
+            };
+
+            static constexpr uint32_t END_OF_CENTRAL_DIRECTORY = 0x06054b50;
+            static constexpr uint32_t ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR = 0x07064b50;
+            static constexpr uint32_t ZIP64_END_OF_CENTRAL_DIRECTORY = 0x06064b50;
+            static constexpr uint32_t CENTRAL_DIRECTORY_HEADER = 0x02014b50;
+            static constexpr uint32_t LOCAL_FILE_HEADER = 0x04034b50;
+            static constexpr uint16_t ZIP64_EXTRA_FIELD = 0x0001;
+
+            static constexpr uint16_t METHOD_STORED = 0;
+            static constexpr uint16_t METHOD_DEFLATE = 8;
+
+            bool readAt(const uint64_t offset, char* out, const size_t size)
+            {
+                file.clear();
+                file.seekg(static_cast<std::streamoff>(offset));
+                return static_cast<bool>(file.read(out, static_cast<std::streamsize>(size)));
+            }
+
+            void readCentralDirectory()
+            {
+                file.seekg(0, std::ios::end);
+                const uint64_t fileSize = file.tellg();
+
+                // The end of central directory record is at most 22 bytes + a 64KB comment from the end
+                const uint64_t tailSize = std::min<uint64_t>(fileSize, 22 + 0xFFFF);
+                std::string tail(tailSize, '\0');
+                if (!readAt(fileSize - tailSize, tail.data(), tailSize))
+                    throw std::runtime_error("Failed to read zip archive");
+
+                size_t eocdPos = std::string::npos;
+                for (size_t i = tailSize >= 22 ? tailSize - 22 + 1 : 0; i-- > 0;)
+                {
+                    if (readUint32(tail.data() + i) == END_OF_CENTRAL_DIRECTORY)
+                    {
+                        eocdPos = i;
+                        break;
+                    }
+                }
+
+                if (eocdPos == std::string::npos)
+                    throw std::runtime_error("Not a zip archive (end of central directory not found)");
+
+                const char* eocd = tail.data() + eocdPos;
+                uint64_t entryCount = readUint16(eocd + 10);
+                uint64_t directorySize = readUint32(eocd + 12);
+                uint64_t directoryOffset = readUint32(eocd + 16);
+
+                // Archives with more than 65535 members or over 4GB use the zip64 records
+                if (entryCount == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF)
+                {
+                    const uint64_t locatorOffset = fileSize - tailSize + eocdPos - 20;
+                    std::array<char, 20> locator{};
+                    if (!readAt(locatorOffset, locator.data(), locator.size()) ||
+                        readUint32(locator.data()) != ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR)
+                    {
+                        throw std::runtime_error("Zip64 end of central directory locator not found");
+                    }
+
+                    std::array<char, 56> zip64Record{};
+                    if (!readAt(readUint64(locator.data() + 8), zip64Record.data(), zip64Record.size()) ||
+                        readUint32(zip64Record.data()) != ZIP64_END_OF_CENTRAL_DIRECTORY)
+                    {
+                        throw std::runtime_error("Zip64 end of central directory record not found");
+                    }
+
+                    entryCount = readUint64(zip64Record.data() + 32);
+                    directorySize = readUint64(zip64Record.data() + 40);
+                    directoryOffset = readUint64(zip64Record.data() + 48);
+                }
+
+                std::string directory(directorySize, '\0');
+                if (!readAt(directoryOffset, directory.data(), directorySize))
+                    throw std::runtime_error("Failed to read zip central directory");
+
+                entries.reserve(entryCount);
+
+                size_t pos = 0;
+                for (uint64_t i = 0; i < entryCount && pos + 46 <= directory.size(); ++i)
+                {
+                    const char* header = directory.data() + pos;
+                    if (readUint32(header) != CENTRAL_DIRECTORY_HEADER)
+                        throw std::runtime_error("Corrupt zip central directory");
+
+                    const uint16_t nameLength = readUint16(header + 28);
+                    const uint16_t extraLength = readUint16(header + 30);
+                    const uint16_t commentLength = readUint16(header + 32);
+
+                    if (pos + 46 + nameLength + extraLength > directory.size())
+                        throw std::runtime_error("Corrupt zip central directory");
+
+                    Entry entry;
+                    entry.name.assign(header + 46, nameLength);
+                    entry.method = readUint16(header + 10);
+                    entry.compressedSize = readUint32(header + 20);
+                    entry.uncompressedSize = readUint32(header + 24);
+                    entry.localHeaderOffset = readUint32(header + 42);
+
+                    readZip64Extra(entry, header + 46 + nameLength, extraLength);
+
+                    pos += 46 + nameLength + extraLength + commentLength;
+
+                    if (isPageMember(entry.name))
+                        entries.emplace_back(std::move(entry));
+                }
+            }
+
+            static void readZip64Extra(Entry& entry, const char* extra, const uint16_t extraLength)
+            {
+                size_t pos = 0;
+                while (pos + 4 <= extraLength)
+                {
+                    const uint16_t id = readUint16(extra + pos);
+                    const uint16_t size = readUint16(extra + pos + 2);
+                    const char* data = extra + pos + 4;
+
+                    if (id == ZIP64_EXTRA_FIELD)
+                    {
+                        // Only the fields that overflowed in the central header are present, in this order
+                        size_t fieldPos = 0;
+                        auto readField = [&](uint64_t& field) {
+                            if (field == 0xFFFFFFFF && fieldPos + 8 <= size)
+                            {
+                                field = readUint64(data + fieldPos);
+                                fieldPos += 8;
+                            }
+                        };
+
+                        readField(entry.uncompressedSize);
+                        readField(entry.compressedSize);
+                        readField(entry.localHeaderOffset);
+                        return;
+                    }
+
+                    pos += 4 + size;
+                }
+            }
+
+            std::optional<std::string> readEntry(const Entry& entry)
+            {
+                std::array<char, 30> localHeader{};
+                if (!readAt(entry.localHeaderOffset, localHeader.data(), localHeader.size()) ||
+                    readUint32(localHeader.data()) != LOCAL_FILE_HEADER)
+                {
+                    return std::nullopt;
+                }
+
+                const uint64_t dataOffset = entry.localHeaderOffset + localHeader.size() +
+                                            readUint16(localHeader.data() + 26) + readUint16(localHeader.data() + 28);
+
+                std::string contents(entry.uncompressedSize, '\0');
+
+                if (entry.method == METHOD_STORED)
+                {
+                    if (!readAt(dataOffset, contents.data(), contents.size()))
+                        return std::nullopt;
+                    return contents;
+                }
+
+                if (entry.method != METHOD_DEFLATE)
+                {
+                    std::cerr << "Unsupported zip compression method " << entry.method << " for " << entry.name << std::endl;
+                    return std::nullopt;
+                }
+
+                compressed.resize(entry.compressedSize);
+                if (!readAt(dataOffset, compressed.data(), compressed.size()))
+                    return std::nullopt;
+
+                z_stream stream{};
+                if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+                    return std::nullopt;
+
+                stream.next_in = reinterpret_cast<Bytef*>(compressed.data());
+                stream.avail_in = static_cast<uInt>(compressed.size());
+                stream.next_out = reinterpret_cast<Bytef*>(contents.data());
+                stream.avail_out = static_cast<uInt>(contents.size());
+
+                const int result = inflate(&stream, Z_FINISH);
+                inflateEnd(&stream);
+
+                if (result != Z_STREAM_END || stream.total_out != contents.size())
+                    return std::nullopt;
+
+                return contents;
+            }
+
+            std::ifstream file;
+            std::vector<Entry> entries;
+            std::string compressed;
+            size_t index = 0;
+        };
+
+
+        /**
+         * @brief Streams ustar/pax/GNU tar archives, gzip compressed or not
+         */
+        class TarReader final : public ArchiveReader
+        {
+        public:
+            explicit TarReader(const std::filesystem::path& archivePath)
+            {
+                // gzread reads uncompressed files transparently
+                file = gzopen(archivePath.c_str(), "rb");
+                if (!file)
+                    throw std::runtime_error("Failed to open archive: " + archivePath.string());
+
+                gzbuffer(file, 256 * 1024);
+            }
+
+            ~TarReader() override
+            {
+                if (file)
+                    gzclose(file);
+            }
+
+            TarReader(const TarReader&) = delete;
+            TarReader& operator=(const TarReader&) = delete;
+
+            std::optional<PageFile> next() override
+            {
+                return readNext();
+            }
+
+        private:
+            static constexpr size_t BLOCK_SIZE = 512;
+
+            bool read(char* out, size_t size)
+            {
+                while (size > 0)
+                {
+                    const unsigned chunk = static_cast<unsigned>(std::min<size_t>(size, 1u << 30));
+                    const int bytesRead = gzread(file, out, chunk);
+                    if (bytesRead <= 0)
+                        return false;
+
+                    out += bytesRead;
+                    size -= static_cast<size_t>(bytesRead);
+                }
+                return true;
+            }
+
+            bool skip(const uint64_t size)
+            {
+                return size == 0 || gzseek(file, static_cast<z_off_t>(size), SEEK_CUR) >= 0;
+            }
+
+            static uint64_t paddedSize(const uint64_t size)
+            {
+                return (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+            }
+
+            static uint64_t parseSize(const char* field)
+            {
+                // GNU base-256 encoding for sizes over 8GB
+                if (static_cast<unsigned char>(field[0]) & 0x80)
+                {
+                    uint64_t value = static_cast<unsigned char>(field[0]) & 0x7F;
+                    for (size_t i = 1; i < 12; ++i)
+                        value = value << 8 | static_cast<unsigned char>(field[i]);
+                    return value;
+                }
+
+                uint64_t value = 0;
+                for (size_t i = 0; i < 12 && field[i] != '\0'; ++i)
+                {
+                    if (field[i] >= '0' && field[i] <= '7')
+                        value = value * 8 + (field[i] - '0');
+                }
+                return value;
+            }
+
+            static std::string readField(const char* field, const size_t maxLength)
+            {
+                return {field, strnlen(field, maxLength)};
+            }
+
+            /**
+             * Parses a decimal number making up all of a field
+             * @param text The field
+             * @return The number, or nullopt if the field is not a number
+             */
+            static std::optional<uint64_t> parseDecimal(const std::string_view text)
+            {
+                uint64_t value = 0;
+                const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+                if (ec != std::errc() || end != text.data() + text.size())
+                    return std::nullopt;
+                return value;
+            }
+
+            // Path and size a GNU long name or pax extended header gives the member after it
+            struct MemberOverrides
+            {
+                std::string path;
+                uint64_t size = 0;
+                bool hasSize = false;
+            };
+
+            /**
+             * Applies the path and size records of a pax extended header, stopping at the first malformed record
+             */
+            static void parsePaxHeader(const std::string_view records, MemberOverrides& overrides)
+            {
+                size_t pos = 0;
+                while (pos < records.size())
+                {
+                    // "<length> <key>=<value>\n", the length counting the whole record
+                    const size_t spacePos = records.find(' ', pos);
+                    const auto recordLength = spacePos == std::string_view::npos
+                        ? std::nullopt : parseDecimal(records.substr(pos, spacePos - pos));
+
+                    if (!recordLength || *recordLength < spacePos - pos + 2 || *recordLength > records.size() - pos ||
+                        records[pos + *recordLength - 1] != '\n')
+                    {
+                        std::cerr << "Skipping malformed pax header record at offset " << pos << std::endl;
+                        return;
+                    }
+
+                    const std::string_view record = records.substr(spacePos + 1, pos + *recordLength - spacePos - 2);
+                    if (const auto equalsPos = record.find('='); equalsPos != std::string_view::npos)
+                    {
+                        const auto key = record.substr(0, equalsPos);
+                        const auto value = record.substr(equalsPos + 1);
+
+                        if (key == "path")
+                        {
+                            overrides.path.assign(value);
+                        }
+                        else if (key == "size")
+                        {
+                            if (const auto parsedSize = parseDecimal(value))
+                            {
+                                overrides.size = *parsedSize;
+                                overrides.hasSize = true;
+                            }
+                            else
+                                std::cerr << "Skipping malformed pax size: " << value << std::endl;
+                        }
+                    }
+
+                    pos += *recordLength;
+                }
+            }
+
+            std::optional<PageFile> readNext()
+            {
+                MemberOverrides overrides;
+                std::array<char, BLOCK_SIZE> header{};
+
+                while (read(header.data(), header.size()))
+                {
+                    // Two zero blocks mark the end of the archive
+                    if (std::ranges::all_of(header, [](const char c) { return c == '\0'; }))
+                        return std::nullopt;
+
+                    const char typeFlag = header[156];
+                    const uint64_t size = overrides.hasSize ? overrides.size : parseSize(header.data() + 124);
+
+                    std::string name = readField(header.data(), 100);
+                    if (std::memcmp(header.data() + 257, "ustar", 5) == 0)
+                    {
+                        if (const std::string prefix = readField(header.data() + 345, 155); !prefix.empty())
+                            name = prefix + "/" + name;
+                    }
+
+                    if (typeFlag == 'L' || typeFlag == 'x')
+                    {
+                        // GNU long name or pax extended header describing the next member
+                        std::string data(paddedSize(size), '\0');
+                        if (!read(data.data(), data.size()))
+                            return std::nullopt;
+
+                        data.resize(size);
+                        if (typeFlag == 'L')
+                            overrides.path = readField(data.data(), data.size());
+                        else
+                            parsePaxHeader(data, overrides);
+
+                        continue;
+                    }
+
+                    if (!overrides.path.empty())
+                        name = std::move(overrides.path);
+
+                    overrides = MemberOverrides{};
+
+                    const bool isRegularFile = typeFlag == '0' || typeFlag == '\0';
+                    if (!isRegularFile || !isPageMember(name))
+                    {
+                        if (!skip(paddedSize(size)))
+                            return std::nullopt;
+                        continue;
+                    }
+
+                    std::string contents(size, '\0');
+                    if (!read(contents.data(), contents.size()) || !skip(paddedSize(size) - size))
+                    {
+                        std::cerr << "Truncated archive member: " << name << std::endl;
+                        return std::nullopt;
+                    }
+
+                    return PageFile{name, std::move(contents)};
+                }
+
+                return std::nullopt;
+            }
+
+            gzFile file = nullptr;
+        };
+    }
+
+
+    ArchiveIterator::ArchiveIterator(const std::filesystem::path& archivePath)
+    {
+        if (!std::filesystem::exists(archivePath))
+        {
+            throw std::runtime_error("Archive does not exist: " + archivePath.string());
+        }
+
+        if (archivePath.extension() == ".zip")
+        {
+            auto zipReader = std::make_unique<ZipReader>(archivePath);
+            totalFiles = zipReader->size();
+            reader = std::move(zipReader);
+        }
+        else
+        {
+            // A tar stream only tells its page count once it has been read to the end, so the total stays unknown
+            reader = std::make_unique<TarReader>(archivePath);
+        }
+
+        nextPage = reader->next();
+    }
+
+
+    ArchiveIterator::~ArchiveIterator() = default;
+
+
+    std::vector<PageFile> ArchiveIterator::getNextBatch(const size_t batchSize)
+    {
+        std::vector<PageFile> batch;
+        batch.reserve(batchSize);
+
+        while (batch.size() < batchSize && nextPage.has_value())
+        {
+            batch.emplace_back(std::move(nextPage.value()));
+            nextPage = reader->next();
+        }
+
+        return batch;
+    }
+
+
+    bool ArchiveIterator::hasMore() const
+    {
+        return nextPage.has_value();
+    }
+
+
+    size_t ArchiveIterator::getTotalFilesCount() const
+    {
+        return totalFiles;
+    }
+
+
+    bool ArchiveIterator::isArchive(const std::filesystem::path& path)
+    {
+        const std::string fileName = path.filename().string();
+        return fileName.ends_with(".zip") || fileName.ends_with(".tar") ||
+               fileName.ends_with(".tar.gz") || fileName.ends_with(".tgz");
+    }
+
+
+    std::unique_ptr<PageSource> openPageSource(const std::filesystem::path& dictionaryPath)
+    {
+        if (ArchiveIterator::isArchive(dictionaryPath) && std::filesystem::is_regular_file(dictionaryPath))
+        {
+            return std::make_unique<ArchiveIterator>(dictionaryPath);
+        }
+
+        return std::make_unique<FileIterator>(dictionaryPath);
+    }
+}
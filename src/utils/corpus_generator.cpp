@@ -0,0 +1,460 @@
+#include "yomitan_dictionary_builder/utils/corpus_generator.h"
+#include "yomitan_dictionary_builder/utils/hash.h"
+#include "yomitan_dictionary_builder/utils/jptools/kana_convert.h"
+
+#include <array>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+    struct KanjiReading
+    {
+        std::string_view kanji;
+        std::string_view reading;
+    };
+
+    constexpr std::array<KanjiReading, 48> KANJI = {{
+        {"漢", "かん"}, {"字", "じ"}, {"辞", "じ"}, {"書", "しょ"}, {"実", "じっ"}, {"験", "けん"},
+        {"心", "しん"}, {"理", "り"}, {"学", "がく"}, {"行", "こう"}, {"動", "どう"}, {"言", "げん"},
+        {"語", "ご"}, {"文", "ぶん"}, {"法", "ほう"}, {"意", "い"}, {"味", "み"}, {"発", "はつ"},
+        {"音", "おん"}, {"生", "せい"}, {"活", "かつ"}, {"社", "しゃ"}, {"会", "かい"}, {"自", "じ"},
+        {"然", "ぜん"}, {"科", "か"}, {"物", "ぶつ"}, {"化", "か"}, {"地", "ち"}, {"図", "ず"},
+        {"時", "じ"}, {"代", "だい"}, {"歴", "れき"}, {"史", "し"}, {"経", "けい"}, {"済", "ざい"},
+        {"政", "せい"}, {"治", "じ"}, {"教", "きょう"}, {"育", "いく"}, {"研", "けん"}, {"究", "きゅう"},
+        {"分", "ぶん"}, {"野", "や"}, {"記", "き"}, {"号", "ごう"}, {"数", "すう"}, {"量", "りょう"}
+    }};
+
+    constexpr std::array<std::string_view, 8> OKURIGANA = {"する", "な", "的", "る", "い", "く", "しい", "ぶ"};
+
+    constexpr std::array<std::string_view, 6> PHRASES = {
+        "に関する", "を表す", "の一種。", "によって生じる", "として用いられる", "の総称。"
+    };
+
+    // 1x1 transparent PNG, enough for the asset copy and pruning to find a file
+    constexpr std::array<unsigned char, 67> PLACEHOLDER_PNG = {
+        0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+        0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x06, 0x00, 0x00, 0x00, 0x1F, 0x15, 0xC4,
+        0x89, 0x00, 0x00, 0x00, 0x0A, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9C, 0x63, 0x00, 0x01, 0x00, 0x00,
+        0x05, 0x00, 0x01, 0x0D, 0x0A, 0x2D, 0xB4, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE,
+        0x42, 0x60, 0x82
+    };
+
+    std::string formatNumber(const uint64_t value, const int width)
+    {
+        std::ostringstream oss;
+        oss << std::setw(width) << std::setfill('0') << value;
+        return oss.str();
+    }
+
+    std::string getSubItemId(const uint64_t pageId, const size_t item)
+    {
+        // e.g. "0000000207-4001", the parsers use the leading page number and the last three digits
+        return formatNumber(pageId, 10) + "-4" + formatNumber(item, 3);
+    }
+
+    std::string escapeYaml(const std::filesystem::path& path)
+    {
+        std::string value = path.generic_string();
+        std::string escaped;
+        for (const char c : value)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return "\"" + escaped + "\"";
+    }
+}
+
+
+CorpusGenerator::CorpusGenerator(CorpusOptions options) : options(std::move(options)), randomState(this->options.seed)
+{
+    if (this->options.outputDirectory.empty())
+        throw std::runtime_error("No output directory set for the corpus");
+
+    if (this->options.imageCount == 0)
+        this->options.imageRate = 0.0;
+}
+
+
+bool CorpusGenerator::generate()
+{
+    stats = {};
+    audioPages.clear();
+    randomState = options.seed;
+
+    const auto pagesDirectory = options.outputDirectory / "pages";
+    const auto indexDirectory = options.outputDirectory / "index";
+
+    try
+    {
+        std::filesystem::remove_all(pagesDirectory);
+        std::filesystem::create_directories(pagesDirectory);
+        std::filesystem::create_directories(indexDirectory);
+    }
+    catch (const std::filesystem::filesystem_error& e)
+    {
+        std::cerr << "Failed to create corpus directories: " << e.what() << std::endl;
+        return false;
+    }
+
+    std::ofstream index(indexDirectory / "index_d.tsv", std::ios::out | std::ios::binary | std::ios::trunc);
+    std::ofstream jukugoIndex(indexDirectory / "jyukugo_prefix.tsv", std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!index.is_open() || !jukugoIndex.is_open())
+    {
+        std::cerr << "Failed to open corpus index files in " << indexDirectory.string() << std::endl;
+        return false;
+    }
+
+    for (uint64_t pageId = 1; pageId <= options.pageCount; ++pageId)
+    {
+        const Headword headword = makeHeadword(1, 3);
+
+        std::vector<Headword> subItems;
+        for (size_t i = 0, count = nextBelow(options.maxSubItems + 1); i < count; ++i)
+        {
+            // Compounds starting with the headword, like the jukugo listed under a kanji
+            Headword compound = makeHeadword(1, 2);
+            compound.term = headword.term + compound.term;
+            compound.reading = headword.reading + compound.reading;
+            subItems.push_back(std::move(compound));
+        }
+
+        const std::string page = makePage(pageId, headword, subItems);
+        const std::string filename = getPageFilename(pageId);
+
+        std::ofstream pageFile(pagesDirectory / filename, std::ios::out | std::ios::binary | std::ios::trunc);
+        pageFile.write(page.data(), static_cast<std::streamsize>(page.size()));
+        if (!pageFile.good())
+        {
+            std::cerr << "Failed to write corpus page: " << filename << std::endl;
+            return false;
+        }
+
+        writeIndexKeys(headword, std::filesystem::path(filename).stem().string(), index);
+
+        for (size_t item = 0; item < subItems.size(); ++item)
+        {
+            // the jukugo index addresses the item by page and item number (e.g. "207-001")
+            const std::string target = std::to_string(pageId) + "-" + formatNumber(item + 1, 3);
+            jukugoIndex << subItems[item].term << '\t' << target << '\n';
+            jukugoIndex << subItems[item].reading << '\t' << target << '\n';
+        }
+
+        stats.pages++;
+        stats.subItems += subItems.size();
+        stats.pageBytes += page.size();
+    }
+
+    index.close();
+    jukugoIndex.close();
+    if (index.fail() || jukugoIndex.fail())
+    {
+        std::cerr << "Failed to write corpus index files" << std::endl;
+        return false;
+    }
+
+    return writeTagMap() && writeImageMap() && writeAssets() && writeConfig();
+}
+
+
+const CorpusGenerator::CorpusStats& CorpusGenerator::getStats() const
+{
+    return stats;
+}
+
+
+std::string CorpusGenerator::getPageFilename(const uint64_t pageId)
+{
+    return formatNumber(pageId, 10) + ".xml";
+}
+
+
+CorpusGenerator::Headword CorpusGenerator::makeHeadword(const size_t minKanji, const size_t maxKanji)
+{
+    Headword headword;
+    const size_t length = minKanji + nextBelow(maxKanji - minKanji + 1);
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        const auto& [kanji, reading] = KANJI[nextBelow(KANJI.size())];
+        headword.term += kanji;
+        headword.reading += reading;
+    }
+
+    // Some headwords are verbs and adjectives
+    if (chance(0.15))
+    {
+        const auto okurigana = OKURIGANA[nextBelow(OKURIGANA.size())];
+        headword.term += okurigana;
+        headword.reading += okurigana == "的" ? "てき" : okurigana;
+    }
+
+    return headword;
+}
+
+
+std::string CorpusGenerator::makePage(const uint64_t pageId, const Headword& headword, const std::vector<Headword>& subItems)
+{
+    std::string page;
+    page.reserve(4096);
+
+    page += R"(<?xml version="1.0" encoding="UTF-8"?>)";
+    page += R"(<html><head><link rel="stylesheet" href="style.css" type="text/css"/></head><body>)";
+    page += R"(<div class="entry" id=")" + formatNumber(pageId, 10) + R"(">)";
+
+    page += R"(<HeadG><headword class="見出">)" + headword.term + "</headword>";
+    page += R"(<yomi class="読み">)" + headword.reading + "</yomi>";
+    if (chance(options.audioRate))
+    {
+        page += R"(<a class="audio" href=")" + getAudioName(pageId) + R"("><span>♪</span></a>)";
+        audioPages.push_back(pageId);
+        stats.audioReferences++;
+    }
+    page += "</HeadG>";
+
+    page += "<MeaningG>";
+    const size_t sections = 1 + nextBelow(std::max<size_t>(options.maxSections, 1));
+    for (size_t section = 1; section <= sections; ++section)
+    {
+        page += R"(<meaning class="level-)" + std::to_string(section % 3 + 1) + R"(" data-number=")" + std::to_string(section) + R"(">)";
+        page += "<num>" + std::to_string(section) + "</num>";
+
+        for (size_t sentence = 0, count = 1 + nextBelow(3); sentence < count; ++sentence)
+        {
+            appendSentence(page, pageId);
+        }
+
+        // Links to the sub items further down the page
+        if (!subItems.empty() && chance(0.5))
+        {
+            const size_t item = nextBelow(subItems.size());
+            page += R"(→<a href=")" + getSubItemId(pageId, item + 1) + R"(">)" + subItems[item].term + "</a>";
+        }
+
+        page += "</meaning>";
+    }
+    page += "</MeaningG>";
+
+    if (chance(options.imageRate))
+    {
+        const size_t image = nextBelow(options.imageCount);
+        page += R"(<figure class="図"><img src="graphics/)" + getImageName(image) + R"(" alt="図"/><caption>図)";
+        page += std::to_string(image + 1) + "</caption></figure>";
+        stats.imageReferences++;
+    }
+
+    if (!subItems.empty())
+    {
+        page += "<SubItemG>";
+        for (size_t item = 0; item < subItems.size(); ++item)
+        {
+            page += R"(<SubItem id=")" + getSubItemId(pageId, item + 1) + R"(">)";
+            page += "<KoKomoku><headword>" + subItems[item].term + "</headword>";
+            page += "<yomi>" + subItems[item].reading + "</yomi></KoKomoku>";
+            page += "<meaning>";
+            appendSentence(page, pageId);
+            page += "</meaning></SubItem>";
+        }
+        page += "</SubItemG>";
+    }
+
+    page += "</div></body></html>\n";
+    return page;
+}
+
+
+void CorpusGenerator::appendSentence(std::string& page, const uint64_t pageId)
+{
+    const auto& [kanji, reading] = KANJI[nextBelow(KANJI.size())];
+    const Headword word = makeHeadword(2, 3);
+
+    page += "<ruby>";
+    page += kanji;
+    page += "<rt>";
+    page += reading;
+    page += "</rt></ruby>";
+    page += PHRASES[nextBelow(PHRASES.size())];
+
+    if (chance(0.3))
+        page += "<b>" + word.term + "</b>";
+    else
+        page += word.term;
+
+    // Cross references to other pages, sometimes to the appendix
+    if (options.pageCount > 1 && chance(0.4))
+    {
+        uint64_t target = 1 + nextBelow(options.pageCount);
+        if (target == pageId)
+            target = target % options.pageCount + 1;
+
+        page += R"(（→<a href=")" + formatNumber(target, 10) + R"(">)" + word.term + "</a>）";
+    }
+    else if (chance(0.05))
+    {
+        page += R"(（→<a href="appendix/KJT-XX-)" + word.term + R"(.html#top">付録</a>）)";
+    }
+
+    page += PHRASES[nextBelow(PHRASES.size())];
+}
+
+
+void CorpusGenerator::writeIndexKeys(const Headword& headword, const std::string& target, std::ofstream& index)
+{
+    index << headword.term << '\t' << target << '\n';
+    index << headword.reading << '\t' << target << '\n';
+    stats.indexKeys += 2;
+
+    // Loanword-style katakana reading for some of the entries
+    if (chance(0.2))
+    {
+        index << KanaConvert::hiraganaToKatakana(headword.reading) << '\t' << target << '\n';
+        stats.indexKeys++;
+    }
+}
+
+
+bool CorpusGenerator::writeTagMap() const
+{
+    std::ofstream tagMap(options.outputDirectory / "tag_map.json", std::ios::out | std::ios::trunc);
+    tagMap << R"({
+  "HeadG": "div",
+  "headword": "span",
+  "yomi": "span",
+  "MeaningG": "div",
+  "meaning": "div",
+  "num": "span",
+  "figure": "div",
+  "caption": "span",
+  "SubItemG": "div",
+  "SubItem": "div",
+  "KoKomoku": "div",
+  "KoKomoku headword": "span",
+  "meaning.level-1": "div",
+  "HeadG a.audio": "a"
+}
+)";
+
+    return tagMap.good();
+}
+
+
+bool CorpusGenerator::writeImageMap() const
+{
+    std::ofstream imageMap(options.outputDirectory / "image_map.json", std::ios::out | std::ios::trunc);
+    imageMap << "{";
+    for (size_t image = 0; image < options.imageCount; ++image)
+    {
+        imageMap << (image == 0 ? "\n" : ",\n") << "  \"" << getImageName(image) << "\": \"" << getHashedImageName(image) << "\"";
+    }
+    imageMap << "\n}\n";
+
+    return imageMap.good();
+}
+
+
+bool CorpusGenerator::writeAssets() const
+{
+    const auto assetDirectory = options.outputDirectory / "assets";
+
+    try
+    {
+        std::filesystem::remove_all(assetDirectory);
+        std::filesystem::create_directories(assetDirectory / "graphics");
+        std::filesystem::create_directories(assetDirectory / "audio");
+
+        std::ofstream(options.outputDirectory / "description.html", std::ios::trunc)
+            << "<p>" << options.title << " (synthetic, seed " << options.seed << ", " << options.pageCount << " pages)</p>\n";
+
+        if (!options.writeAssets)
+            return true;
+
+        // the image map rewrites the references, so the files are stored under their hashed names
+        for (size_t image = 0; image < options.imageCount; ++image)
+        {
+            std::ofstream file(assetDirectory / "graphics" / getHashedImageName(image), std::ios::out | std::ios::binary);
+            file.write(reinterpret_cast<const char*>(PLACEHOLDER_PNG.data()), PLACEHOLDER_PNG.size());
+        }
+
+        for (const uint64_t pageId : audioPages)
+        {
+            std::ofstream(assetDirectory / getAudioName(pageId), std::ios::out | std::ios::binary) << "synthetic";
+        }
+    }
+    catch (const std::filesystem::filesystem_error& e)
+    {
+        std::cerr << "Failed to write corpus assets: " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+bool CorpusGenerator::writeConfig() const
+{
+    const auto& directory = options.outputDirectory;
+
+    std::ofstream config(directory / "corpus.yaml", std::ios::out | std::ios::trunc);
+    config << "# Generated corpus: " << options.pageCount << " pages, seed " << options.seed << "\n";
+    config << "dictionaries:\n";
+    config << "  SYNTHETIC:\n";
+    config << "    MDictConfig:\n";
+    config << "      title: \"" << options.title << "\"\n";
+    config << "      appendixLinkIdentifier: \"appendix/\"\n";
+    config << "      subElement: \"SubItem\"\n";
+    config << "    ParserConfig:\n";
+    config << "      dictionaryPath: " << escapeYaml(directory / "pages") << "\n";
+    config << "      indexPath: " << escapeYaml(directory / "index" / "index_d.tsv") << "\n";
+    config << "      tagMappingPath: " << escapeYaml(directory / "tag_map.json") << "\n";
+    config << "      imageMappingPath: " << escapeYaml(directory / "image_map.json") << "\n";
+    config << "      assetDirectory: " << escapeYaml(directory / "assets") << "\n";
+    config << "      descriptionPath: " << escapeYaml(directory / "description.html") << "\n";
+    config << "      outputPath: " << escapeYaml(directory / "converted") << "\n";
+
+    return config.good();
+}
+
+
+std::string CorpusGenerator::getImageName(const size_t image) const
+{
+    return "fig" + formatNumber(image + 1, 5) + ".png";
+}
+
+
+std::string CorpusGenerator::getHashedImageName(const size_t image)
+{
+    return HashUtils::toHex(HashUtils::hash("fig" + std::to_string(image))) + ".png";
+}
+
+
+std::string CorpusGenerator::getAudioName(const uint64_t pageId)
+{
+    return "audio/" + formatNumber(pageId, 10) + ".aac";
+}
+
+
+uint64_t CorpusGenerator::nextRandom()
+{
+    // splitmix64
+    uint64_t z = (randomState += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+size_t CorpusGenerator::nextBelow(const size_t bound)
+{
+    return bound == 0 ? 0 : static_cast<size_t>(nextRandom() % bound);
+}
+
+
+bool CorpusGenerator::chance(const double probability)
+{
+    return static_cast<double>(nextRandom() >> 11) * 0x1.0p-53 < probability;
+}
@@ -0,0 +1,87 @@
+#include "yomitan_dictionary_builder/utils/file_sync.h"
+
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace FileUtils
+{
+    namespace
+    {
+        bool syncPath(const std::filesystem::path& path, [[maybe_unused]] const int flags)
+        {
+#ifdef _WIN32
+            return std::filesystem::exists(path);
+#else
+            const int fd = ::open(path.c_str(), flags | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+
+            const bool synced = ::fsync(fd) == 0;
+            ::close(fd);
+            return synced;
+#endif
+        }
+    }
+
+
+    bool syncFile(const std::filesystem::path& filePath)
+    {
+#ifdef _WIN32
+        return syncPath(filePath, 0);
+#else
+        // fsync flushes the file's data regardless of the mode of the descriptor
+        return syncPath(filePath, O_RDONLY);
+#endif
+    }
+
+
+    bool syncDirectory(const std::filesystem::path& directoryPath)
+    {
+#ifdef _WIN32
+        return syncPath(directoryPath, 0);
+#else
+        return syncPath(directoryPath, O_RDONLY | O_DIRECTORY);
+#endif
+    }
+
+
+    bool writeFileAtomically(const std::filesystem::path& filePath, const std::string_view contents)
+    {
+        const auto tempPath = std::filesystem::path(filePath).concat(".tmp");
+
+        {
+            std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                std::cerr << "Failed to open file: " << tempPath.string() << std::endl;
+                return false;
+            }
+
+            file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            if (!file.good())
+                return false;
+        }
+
+        if (!syncFile(tempPath))
+        {
+            std::cerr << "Failed to sync file: " << tempPath.string() << std::endl;
+            return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, filePath, ec);
+        if (ec)
+        {
+            std::cerr << "Failed to replace file " << filePath.string() << ": " << ec.message() << std::endl;
+            return false;
+        }
+
+        const auto directory = filePath.has_parent_path() ? filePath.parent_path() : std::filesystem::current_path();
+        return syncDirectory(directory);
+    }
+}
@@ -0,0 +1,422 @@
+#include "yomitan_dictionary_builder/utils/output_sink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace FileUtils
+{
+    namespace
+    {
+        std::runtime_error fileError(const std::string& action, const std::filesystem::path& filePath)
+        {
+            return std::runtime_error("Failed to " + action + " " + filePath.string() + ": " + std::strerror(errno));
+        }
+
+
+        /**
+         * @brief Writes buffers to a file on the calling thread, several buffers at once with a vectored write
+         */
+        class FileOutputSink final : public OutputSink
+        {
+        public:
+            FileOutputSink(std::filesystem::path filePath, const uint64_t offset)
+            {
+                open(std::move(filePath), offset);
+            }
+
+            ~FileOutputSink() override
+            {
+                try
+                {
+                    close();
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Error closing output file: " << e.what() << std::endl;
+                }
+            }
+
+            FileOutputSink(const FileOutputSink&) = delete;
+            FileOutputSink& operator=(const FileOutputSink&) = delete;
+
+            void write(std::string& buffer) override
+            {
+                writeBuffers(std::span(&buffer, 1));
+                buffer.clear();
+            }
+
+            /**
+             * Appends buffers to the file in order
+             * @param buffers The buffers, left unchanged
+             */
+            void writeBuffers(const std::span<const std::string> buffers)
+            {
+#ifdef _WIN32
+                for (const auto& buffer : buffers)
+                {
+                    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                    offset += buffer.size();
+                }
+
+                if (!file.good())
+                    throw std::runtime_error("Failed to write output file: " + filePath.string());
+#else
+                if (fd < 0)
+                    throw std::runtime_error("Output file is closed: " + filePath.string());
+
+                std::vector<iovec> vectors;
+                vectors.reserve(buffers.size());
+                for (const auto& buffer : buffers)
+                {
+                    if (!buffer.empty())
+                        vectors.push_back({const_cast<char*>(buffer.data()), buffer.size()});
+                }
+
+                size_t first = 0;
+                while (first < vectors.size())
+                {
+                    const int count = static_cast<int>(std::min<size_t>(vectors.size() - first, MAX_VECTORS));
+                    const ssize_t written = ::writev(fd, vectors.data() + first, count);
+                    if (written < 0)
+                    {
+                        if (errno == EINTR)
+                            continue;
+                        throw fileError("write output file", filePath);
+                    }
+
+                    offset += static_cast<uint64_t>(written);
+
+                    // Skip what was written, a short write continues in the middle of a buffer
+                    auto remaining = static_cast<size_t>(written);
+                    while (first < vectors.size() && remaining >= vectors[first].iov_len)
+                        remaining -= vectors[first++].iov_len;
+
+                    if (remaining > 0)
+                    {
+                        vectors[first].iov_base = static_cast<char*>(vectors[first].iov_base) + remaining;
+                        vectors[first].iov_len -= remaining;
+                    }
+                }
+#endif
+            }
+
+            void flush() override
+            {
+#ifdef _WIN32
+                file.flush();
+#endif
+            }
+
+            void sync() override
+            {
+#ifdef _WIN32
+                file.flush();
+#else
+                if (fd < 0)
+                    return;
+
+#ifdef __APPLE__
+                const int result = ::fsync(fd);
+#else
+                // The size of the file is kept up to date by the data sync, the other metadata doesn't matter
+                const int result = ::fdatasync(fd);
+#endif
+                if (result != 0)
+                    throw fileError("sync output file", filePath);
+#endif
+            }
+
+            void close() override
+            {
+#ifdef _WIN32
+                if (file.is_open())
+                {
+                    file.close();
+                    if (file.fail())
+                        throw std::runtime_error("Failed to close output file: " + filePath.string());
+                }
+#else
+                if (fd < 0)
+                    return;
+
+                const int result = ::close(fd);
+                fd = -1;
+                if (result != 0)
+                    throw fileError("close output file", filePath);
+#endif
+            }
+
+            void switchFile(const std::filesystem::path& nextFilePath) override
+            {
+                close();
+                open(nextFilePath, 0);
+            }
+
+            [[nodiscard]] uint64_t size() const override
+            {
+                return offset;
+            }
+
+        private:
+            static constexpr size_t MAX_VECTORS = 64;
+
+            /**
+             * Opens the file, keeping the bytes up to the offset
+             * @param nextFilePath Path to the file
+             * @param nextOffset Number of bytes to keep, 0 to truncate the file
+             */
+            void open(std::filesystem::path nextFilePath, const uint64_t nextOffset)
+            {
+                filePath = std::move(nextFilePath);
+                offset = nextOffset;
+
+#ifdef _WIN32
+                if (offset > 0)
+                    std::filesystem::resize_file(filePath, offset);
+
+                file.open(filePath, std::ios::out | std::ios::binary | (offset > 0 ? std::ios::app : std::ios::trunc));
+                if (!file.is_open())
+                    throw std::runtime_error("Failed to open output file: " + filePath.string());
+#else
+                fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+                if (fd < 0)
+                    throw fileError("open output file", filePath);
+
+                // Resuming keeps the bytes up to the offset and continues after them
+                if (::ftruncate(fd, static_cast<off_t>(offset)) != 0 || ::lseek(fd, static_cast<off_t>(offset), SEEK_SET) < 0)
+                {
+                    const auto error = fileError("truncate output file", filePath);
+                    ::close(fd);
+                    fd = -1;
+                    throw error;
+                }
+#endif
+            }
+
+            std::filesystem::path filePath;
+            uint64_t offset = 0;
+#ifdef _WIN32
+            std::ofstream file;
+#else
+            int fd = -1;
+#endif
+        };
+
+
+        /**
+         * @brief Hands buffers to a thread writing them to a file, so the caller doesn't wait for the disk
+         *
+         * Buffers waiting for the writer are written together with one vectored write. Written buffers
+         * are kept to be handed back to the caller, so the same few allocations are used for the whole file.
+         */
+        class WriteBehindOutputSink final : public OutputSink
+        {
+        public:
+            WriteBehindOutputSink(std::unique_ptr<FileOutputSink> file, const size_t maxPendingBuffers)
+                : file(std::move(file)), maxPendingBuffers(std::max<size_t>(maxPendingBuffers, 1)),
+                  acceptedBytes(this->file->size())
+            {
+                writer = std::thread(&WriteBehindOutputSink::writerLoop, this);
+            }
+
+            ~WriteBehindOutputSink() override
+            {
+                try
+                {
+                    close();
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Error closing output file: " << e.what() << std::endl;
+                }
+            }
+
+            WriteBehindOutputSink(const WriteBehindOutputSink&) = delete;
+            WriteBehindOutputSink& operator=(const WriteBehindOutputSink&) = delete;
+
+            void write(std::string& buffer) override
+            {
+                if (buffer.empty())
+                    return;
+
+                std::unique_lock lock(mutex);
+                if (closed)
+                    throw std::runtime_error("Cannot write to a closed output sink");
+
+                spaceAvailable.wait(lock, [this] { return pending.size() < maxPendingBuffers || error; });
+                rethrowError();
+
+                acceptedBytes += buffer.size();
+                pending.push_back(std::move(buffer));
+
+                buffer = std::string();
+                if (!spareBuffers.empty())
+                {
+                    buffer.swap(spareBuffers.back());
+                    spareBuffers.pop_back();
+                }
+
+                workAvailable.notify_one();
+            }
+
+            void flush() override
+            {
+                std::unique_lock lock(mutex);
+                idle.wait(lock, [this] { return (pending.empty() && !writing) || error; });
+                rethrowError();
+            }
+
+            void sync() override
+            {
+                flush();
+
+                // The writer is idle until the next write, which comes from this thread
+                file->sync();
+            }
+
+            void close() override
+            {
+                {
+                    std::unique_lock lock(mutex);
+                    if (closed)
+                        return;
+
+                    idle.wait(lock, [this] { return (pending.empty() && !writing) || error; });
+                    closed = true;
+                    stopping = true;
+                }
+
+                workAvailable.notify_one();
+                if (writer.joinable())
+                    writer.join();
+
+                {
+                    std::lock_guard lock(mutex);
+                    rethrowError();
+                }
+
+                file->close();
+            }
+
+            void switchFile(const std::filesystem::path& filePath) override
+            {
+                std::unique_lock lock(mutex);
+                if (closed)
+                    throw std::runtime_error("Cannot switch the file of a closed output sink");
+
+                idle.wait(lock, [this] { return (pending.empty() && !writing) || error; });
+                rethrowError();
+
+                // The writer waits for the next buffer, which can only come from this thread
+                file->switchFile(filePath);
+                acceptedBytes = file->size();
+            }
+
+            [[nodiscard]] uint64_t size() const override
+            {
+                std::lock_guard lock(mutex);
+                return acceptedBytes;
+            }
+
+        private:
+            void writerLoop()
+            {
+                std::unique_lock lock(mutex);
+                while (true)
+                {
+                    workAvailable.wait(lock, [this] { return stopping || !pending.empty(); });
+                    if (pending.empty())
+                        return;
+
+                    batch.assign(std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end()));
+                    pending.clear();
+                    writing = true;
+                    spaceAvailable.notify_one();
+
+                    lock.unlock();
+                    std::exception_ptr writeError;
+                    try
+                    {
+                        if (!error)
+                            file->writeBuffers(batch);
+                    }
+                    catch (...)
+                    {
+                        writeError = std::current_exception();
+                    }
+                    lock.lock();
+
+                    if (writeError && !error)
+                        error = writeError;
+
+                    for (auto& buffer : batch)
+                    {
+                        if (spareBuffers.size() >= maxPendingBuffers)
+                            break;
+
+                        buffer.clear();
+                        spareBuffers.push_back(std::move(buffer));
+                    }
+                    batch.clear();
+                    writing = false;
+
+                    idle.notify_all();
+                    spaceAvailable.notify_one();
+                }
+            }
+
+            void rethrowError() const
+            {
+                if (error)
+                    std::rethrow_exception(error);
+            }
+
+            std::unique_ptr<FileOutputSink> file;
+            const size_t maxPendingBuffers;
+
+            mutable std::mutex mutex;
+            std::condition_variable workAvailable;
+            std::condition_variable spaceAvailable;
+            std::condition_variable idle;
+
+            std::deque<std::string> pending;
+            std::vector<std::string> batch;
+            std::vector<std::string> spareBuffers;
+            uint64_t acceptedBytes;
+            std::exception_ptr error;
+            bool writing = false;
+            bool stopping = false;
+            bool closed = false;
+
+            std::thread writer;
+        };
+    }
+
+
+    std::unique_ptr<OutputSink> openOutputSink(const std::filesystem::path& filePath, const uint64_t offset, const OutputSinkOptions& options)
+    {
+        auto file = std::make_unique<FileOutputSink>(filePath, offset);
+        if (!options.writeBehind)
+            return file;
+
+        return std::make_unique<WriteBehindOutputSink>(std::move(file), options.maxPendingBuffers);
+    }
+}
@@ -0,0 +1,182 @@
+#include "yomitan_dictionary_builder/utils/read_ahead_source.h"
+#include "yomitan_dictionary_builder/utils/trace_recorder.h"
+#include "yomitan_dictionary_builder/utils/xml_loader.h"
+
+#include <algorithm>
+
+namespace FileUtils
+{
+    ReadAheadPageSource::ReadAheadPageSource(std::unique_ptr<PageSource> source, const size_t maxPages,
+                                             const size_t readerThreads, const size_t memoryLimit)
+        : source(std::move(source)),
+          totalFiles(this->source->getTotalFilesCount()),
+          maxPages(std::max<size_t>(maxPages, 1)),
+          memoryLimit(memoryLimit)
+    {
+        sourceExhausted = !this->source->hasMore();
+
+        const size_t threadCount = std::max<size_t>(readerThreads, 1);
+        readers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            readers.emplace_back(&ReadAheadPageSource::readerLoop, this);
+        }
+    }
+
+
+    ReadAheadPageSource::~ReadAheadPageSource()
+    {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        spaceAvailable.notify_all();
+
+        for (auto& reader : readers)
+        {
+            if (reader.joinable())
+                reader.join();
+        }
+    }
+
+
+    std::vector<PageFile> ReadAheadPageSource::getNextBatch(const size_t batchSize)
+    {
+        std::vector<PageFile> batch;
+        batch.reserve(batchSize);
+
+        std::unique_lock lock(mutex);
+        while (batch.size() < batchSize)
+        {
+            auto isFinished = [&] { return slots.empty() && sourceExhausted && pagesInFlight == 0; };
+            auto isFrontReady = [&] { return !slots.empty() && slots.front().ready; };
+
+            if (!isFrontReady())
+            {
+                if (isFinished())
+                    break;
+
+                stallCount++;
+                pageReady.wait(lock, [&] { return isFrontReady() || isFinished(); });
+
+                if (!isFrontReady())
+                    break;
+            }
+
+            Slot& slot = slots.front();
+            bufferedBytes -= slot.page.contents.size();
+            batch.emplace_back(std::move(slot.page));
+            slots.pop_front();
+            firstSlotIndex++;
+
+            spaceAvailable.notify_all();
+        }
+
+        return batch;
+    }
+
+
+    bool ReadAheadPageSource::hasMore() const
+    {
+        std::lock_guard lock(mutex);
+        return !slots.empty() || pagesInFlight > 0 || !sourceExhausted;
+    }
+
+
+    size_t ReadAheadPageSource::getTotalFilesCount() const
+    {
+        return totalFiles;
+    }
+
+
+    size_t ReadAheadPageSource::getStallCount() const
+    {
+        std::lock_guard lock(mutex);
+        return stallCount;
+    }
+
+
+    void ReadAheadPageSource::readerLoop()
+    {
+        Profiling::TraceRecorder::setThreadName("readAhead");
+
+        while (true)
+        {
+            {
+                std::unique_lock lock(mutex);
+                spaceAvailable.wait(lock, [&] {
+                    const bool hasPageSpace = slots.size() + pagesInFlight < maxPages;
+                    // always allow one page so a single page larger than the limit can't stall the parser
+                    const bool hasMemorySpace = bufferedBytes < memoryLimit || slots.empty();
+                    return stopping || sourceExhausted || (hasPageSpace && hasMemorySpace);
+                });
+
+                if (stopping || sourceExhausted)
+                    return;
+
+                pagesInFlight++;
+            }
+
+            PageFile page;
+            size_t slotIndex = 0;
+            bool hasPage = false;
+            {
+                // Taking the page and reserving its slot under the source lock keeps the slots in source order
+                std::lock_guard sourceLock(sourceMutex);
+                auto next = source->getNextBatch(1);
+
+                std::lock_guard lock(mutex);
+                pagesInFlight--;
+
+                if (!next.empty())
+                {
+                    page = std::move(next.front());
+                    slotIndex = firstSlotIndex + slots.size();
+                    slots.emplace_back();
+                    hasPage = true;
+                }
+
+                if (!source->hasMore())
+                {
+                    sourceExhausted = true;
+                    pageReady.notify_all();
+                    spaceAvailable.notify_all();
+                }
+            }
+
+            if (!hasPage)
+                continue;
+
+            readPage(page);
+
+            {
+                std::lock_guard lock(mutex);
+                bufferedBytes += page.contents.size();
+
+                Slot& slot = slots[slotIndex - firstSlotIndex];
+                slot.page = std::move(page);
+                slot.ready = true;
+            }
+            pageReady.notify_all();
+        }
+    }
+
+
+    void ReadAheadPageSource::readPage(PageFile& page)
+    {
+        if (page.loaded)
+            return;
+
+        Profiling::ScopedTrace trace("readPage", "readAhead");
+        if (trace.isActive())
+            trace.setDetail(page.path.filename().string());
+
+        // On failure the page is left unloaded so the parser reports the error when it reads the file itself
+        size_t size = 0;
+        if (XMLLoader::readFile(page.path, page.contents, size))
+        {
+            page.contents.resize(size);
+            page.loaded = true;
+        }
+    }
+}
@@ -0,0 +1,457 @@
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
+#include "yomitan_dictionary_builder/utils/allocation_tracker.h"
+#include "yomitan_dictionary_builder/utils/file_sync.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace Profiling
+{
+    namespace
+    {
+        constexpr std::array<std::string_view, STAGE_COUNT> STAGE_NAMES = {
+            "fileRead",
+            "xmlLoad",
+            "linkRewrite",
+            "imageRewrite",
+            "keyExtraction",
+            "subItems",
+            "treeConversion",
+            "serialization",
+            "diskWrite",
+            "pageCache"
+        };
+
+        // Profilers are never freed, so the times of finished threads remain available for the report
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<StageProfiler>> registry;
+        size_t registrySlowestPageCount = 0;
+
+        thread_local StageProfiler* threadProfiler = nullptr;
+        thread_local bool registering = false;
+
+        double toMilliseconds(const uint64_t nanos)
+        {
+            return static_cast<double>(nanos) / 1e6;
+        }
+
+        bool isFaster(const PageSample& a, const PageSample& b)
+        {
+            return a.totalNanos > b.totalNanos;
+        }
+    }
+
+
+    std::string_view getStageName(const Stage stage)
+    {
+        return STAGE_NAMES[static_cast<size_t>(stage)];
+    }
+
+
+    void LatencyHistogram::record(const uint64_t nanos)
+    {
+        buckets[getBucketIndex(nanos)]++;
+        count++;
+        max = std::max(max, nanos);
+    }
+
+
+    void LatencyHistogram::merge(const LatencyHistogram& other)
+    {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        max = std::max(max, other.max);
+    }
+
+
+    uint64_t LatencyHistogram::getPercentile(const double percentile) const
+    {
+        if (count == 0)
+            return 0;
+
+        const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(count))));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            seen += buckets[i];
+            if (seen >= target)
+                return std::min(getBucketValue(i), max);
+        }
+        return max;
+    }
+
+
+    uint64_t LatencyHistogram::getMax() const
+    {
+        return max;
+    }
+
+
+    uint64_t LatencyHistogram::getCount() const
+    {
+        return count;
+    }
+
+
+    size_t LatencyHistogram::getBucketIndex(const uint64_t nanos)
+    {
+        if (nanos < 16)
+            return nanos;
+
+        // 8 linear sub buckets within each power of two
+        const int exponent = std::bit_width(nanos) - 1;
+        const auto subBucket = static_cast<size_t>((nanos >> (exponent - 3)) & (SUB_BUCKETS - 1));
+        return 16 + static_cast<size_t>(exponent - 4) * SUB_BUCKETS + subBucket;
+    }
+
+
+    uint64_t LatencyHistogram::getBucketValue(const size_t index)
+    {
+        if (index < 16)
+            return index;
+
+        const size_t exponent = (index - 16) / SUB_BUCKETS + 4;
+        const uint64_t subBucket = (index - 16) % SUB_BUCKETS;
+        const uint64_t width = uint64_t{1} << (exponent - 3);
+
+        // middle of the bucket
+        return (SUB_BUCKETS + subBucket) * width + width / 2;
+    }
+
+
+    void StageProfiler::setEnabled(const bool isEnabled)
+    {
+        enabled.store(isEnabled, std::memory_order_relaxed);
+    }
+
+
+    StageProfiler& StageProfiler::forCurrentThread()
+    {
+        if (!threadProfiler)
+        {
+            // Registering allocates, which the allocation tracker must not count into a half registered profiler
+            registering = true;
+            {
+                std::lock_guard lock(registryMutex);
+                StageProfiler* profiler = registry.emplace_back(std::make_unique<StageProfiler>()).get();
+                profiler->reset(registrySlowestPageCount);
+                threadProfiler = profiler;
+            }
+            registering = false;
+        }
+
+        return *threadProfiler;
+    }
+
+
+    StageProfiler* StageProfiler::tryForCurrentThread()
+    {
+        return registering ? nullptr : &forCurrentThread();
+    }
+
+
+    void StageProfiler::resetAll(const size_t slowestPageCount)
+    {
+        std::lock_guard lock(registryMutex);
+        registrySlowestPageCount = slowestPageCount;
+        for (const auto& profiler : registry)
+        {
+            profiler->reset(slowestPageCount);
+        }
+    }
+
+
+    void StageProfiler::reset(const size_t slowestPages)
+    {
+        depth = 0;
+        totalNanos.fill(0);
+        calls.fill(0);
+        stageHistograms.fill({});
+        pageHistogram = {};
+        allocationCounts.fill({});
+        inPage = false;
+        pageCount = 0;
+        pageBytes = 0;
+        this->slowestPages.clear();
+        slowestPageCount = slowestPages;
+    }
+
+
+    void StageProfiler::enterStage(const Stage stage)
+    {
+        charge(Clock::now());
+
+        // Deeper nesting than this is only counted towards the outer stage
+        if (depth < MAX_DEPTH)
+            stageStack[depth] = stage;
+        depth++;
+
+        calls[static_cast<size_t>(stage)]++;
+    }
+
+
+    void StageProfiler::exitStage()
+    {
+        if (depth == 0)
+            return;
+
+        charge(Clock::now());
+        depth--;
+    }
+
+
+    void StageProfiler::beginPage(const std::string_view name, const uint64_t bytes)
+    {
+        const auto now = Clock::now();
+        charge(now);
+
+        inPage = true;
+        pageStart = now;
+        currentPage.page.assign(name);
+        currentPage.bytes = bytes;
+        currentPage.stageNanos.fill(0);
+    }
+
+
+    void StageProfiler::endPage()
+    {
+        if (!inPage)
+            return;
+
+        const auto now = Clock::now();
+        charge(now);
+        inPage = false;
+
+        currentPage.totalNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(now - pageStart).count();
+        pageHistogram.record(currentPage.totalNanos);
+        pageCount++;
+        pageBytes += currentPage.bytes;
+
+        for (size_t i = 0; i < STAGE_COUNT; ++i)
+        {
+            if (currentPage.stageNanos[i] > 0)
+                stageHistograms[i].record(currentPage.stageNanos[i]);
+        }
+
+        if (slowestPageCount == 0)
+            return;
+
+        if (slowestPages.size() < slowestPageCount)
+        {
+            slowestPages.push_back(currentPage);
+            std::ranges::push_heap(slowestPages, isFaster);
+        }
+        else if (currentPage.totalNanos > slowestPages.front().totalNanos)
+        {
+            std::ranges::pop_heap(slowestPages, isFaster);
+            slowestPages.back() = currentPage;
+            std::ranges::push_heap(slowestPages, isFaster);
+        }
+    }
+
+
+    Stage StageProfiler::getCurrentStage() const
+    {
+        if (depth == 0)
+            return Stage::Count;
+
+        return stageStack[std::min(depth, MAX_DEPTH) - 1];
+    }
+
+
+    void StageProfiler::recordAllocation(const size_t bytes, const bool fromPugi)
+    {
+        // Stage::Count (outside of any stage) maps to the last slot
+        AllocationCounts& counts = allocationCounts[static_cast<size_t>(getCurrentStage())];
+        if (fromPugi)
+        {
+            counts.pugiAllocations++;
+            counts.pugiBytes += bytes;
+        }
+        else
+        {
+            counts.allocations++;
+            counts.bytes += bytes;
+        }
+    }
+
+
+    void StageProfiler::charge(const Clock::time_point now)
+    {
+        if (depth > 0)
+        {
+            const auto stage = static_cast<size_t>(getCurrentStage());
+            const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastTransition).count();
+
+            totalNanos[stage] += elapsed;
+            if (inPage)
+                currentPage.stageNanos[stage] += elapsed;
+        }
+
+        lastTransition = now;
+    }
+
+
+    RunReport StageProfiler::buildReport(const RunSummary& summary)
+    {
+        std::array<uint64_t, STAGE_COUNT> totalNanos{};
+        std::array<uint64_t, STAGE_COUNT> calls{};
+        std::array<LatencyHistogram, STAGE_COUNT> stageHistograms;
+        LatencyHistogram pageHistogram;
+        std::vector<PageSample> slowestPages;
+        size_t slowestPageCount = 0;
+        uint64_t pageBytes = 0;
+        std::array<AllocationCounts, STAGE_COUNT + 1> allocationCounts{};
+
+        {
+            std::lock_guard lock(registryMutex);
+            slowestPageCount = registrySlowestPageCount;
+            for (const auto& profiler : registry)
+            {
+                for (size_t i = 0; i < STAGE_COUNT; ++i)
+                {
+                    totalNanos[i] += profiler->totalNanos[i];
+                    calls[i] += profiler->calls[i];
+                    stageHistograms[i].merge(profiler->stageHistograms[i]);
+                }
+
+                for (size_t i = 0; i <= STAGE_COUNT; ++i)
+                {
+                    allocationCounts[i].allocations += profiler->allocationCounts[i].allocations;
+                    allocationCounts[i].bytes += profiler->allocationCounts[i].bytes;
+                    allocationCounts[i].pugiAllocations += profiler->allocationCounts[i].pugiAllocations;
+                    allocationCounts[i].pugiBytes += profiler->allocationCounts[i].pugiBytes;
+                }
+
+                pageHistogram.merge(profiler->pageHistogram);
+                pageBytes += profiler->pageBytes;
+                slowestPages.insert(slowestPages.end(), profiler->slowestPages.begin(), profiler->slowestPages.end());
+            }
+        }
+
+        RunReport report;
+        report.dictionary = summary.dictionary;
+        report.pages = summary.pages;
+        report.entries = summary.entries;
+        report.bytes = pageBytes;
+        report.wallSeconds = summary.wallSeconds;
+
+        if (summary.wallSeconds > 0.0)
+        {
+            report.pagesPerSecond = static_cast<double>(summary.pages) / summary.wallSeconds;
+            report.megabytesPerSecond = static_cast<double>(pageBytes) / (1024.0 * 1024.0) / summary.wallSeconds;
+        }
+
+        report.pageP50Ms = toMilliseconds(pageHistogram.getPercentile(50));
+        report.pageP90Ms = toMilliseconds(pageHistogram.getPercentile(90));
+        report.pageP99Ms = toMilliseconds(pageHistogram.getPercentile(99));
+        report.pageMaxMs = toMilliseconds(pageHistogram.getMax());
+
+        uint64_t stageTotal = 0;
+        for (const auto nanos : totalNanos)
+        {
+            stageTotal += nanos;
+        }
+
+        for (size_t i = 0; i < STAGE_COUNT; ++i)
+        {
+            if (calls[i] == 0)
+                continue;
+
+            const auto& histogram = stageHistograms[i];
+            report.stages.push_back({
+                .stage = std::string(getStageName(static_cast<Stage>(i))),
+                .calls = calls[i],
+                .totalMs = toMilliseconds(totalNanos[i]),
+                .sharePercent = stageTotal > 0 ? 100.0 * static_cast<double>(totalNanos[i]) / static_cast<double>(stageTotal) : 0.0,
+                .p50Ms = toMilliseconds(histogram.getPercentile(50)),
+                .p90Ms = toMilliseconds(histogram.getPercentile(90)),
+                .p99Ms = toMilliseconds(histogram.getPercentile(99)),
+                .maxMs = toMilliseconds(histogram.getMax())
+            });
+        }
+
+        // Every thread kept its own slowest pages, the overall slowest are among them
+        std::ranges::sort(slowestPages, isFaster);
+        if (slowestPages.size() > slowestPageCount)
+            slowestPages.resize(slowestPageCount);
+
+        for (const auto& sample : slowestPages)
+        {
+            PageTimingReport& page = report.slowestPages.emplace_back();
+            page.page = sample.page;
+            page.bytes = sample.bytes;
+            page.totalMs = toMilliseconds(sample.totalNanos);
+
+            for (size_t i = 0; i < STAGE_COUNT; ++i)
+            {
+                if (sample.stageNanos[i] > 0)
+                    page.stagesMs[std::string(getStageName(static_cast<Stage>(i)))] = toMilliseconds(sample.stageNanos[i]);
+            }
+        }
+
+        if (summary.includeAllocations)
+        {
+            AllocationReport& allocations = report.allocations.emplace();
+            allocations.operatorNewTracked = AllocationTracker::isSupported();
+            allocations.peakRssBytes = AllocationTracker::getPeakResidentBytes();
+
+            for (const auto& counts : allocationCounts)
+            {
+                allocations.allocations += counts.allocations + counts.pugiAllocations;
+                allocations.bytes += counts.bytes + counts.pugiBytes;
+            }
+
+            const auto pages = static_cast<double>(std::max<uint64_t>(summary.pages, 1));
+            allocations.allocationsPerPage = static_cast<double>(allocations.allocations) / pages;
+            allocations.bytesPerEntry = static_cast<double>(allocations.bytes) / static_cast<double>(std::max<int64_t>(summary.entries, 1));
+
+            for (size_t i = 0; i <= STAGE_COUNT; ++i)
+            {
+                const auto& counts = allocationCounts[i];
+                const uint64_t stageAllocations = counts.allocations + counts.pugiAllocations;
+                if (stageAllocations == 0)
+                    continue;
+
+                allocations.stages.push_back({
+                    .stage = i < STAGE_COUNT ? std::string(getStageName(static_cast<Stage>(i))) : "other",
+                    .allocations = counts.allocations,
+                    .bytes = counts.bytes,
+                    .pugiAllocations = counts.pugiAllocations,
+                    .pugiBytes = counts.pugiBytes,
+                    .allocationsPerPage = static_cast<double>(stageAllocations) / pages,
+                    .sharePercent = 100.0 * static_cast<double>(stageAllocations) / static_cast<double>(allocations.allocations)
+                });
+            }
+        }
+
+        return report;
+    }
+
+
+    bool StageProfiler::writeReport(const std::filesystem::path& reportPath, const RunReport& report)
+    {
+        std::string json;
+        if (const auto ec = glz::write_json(report, json); ec)
+        {
+            std::cerr << "Error writing run report: " << glz::format_error(ec, json) << std::endl;
+            return false;
+        }
+
+        if (reportPath.has_parent_path())
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(reportPath.parent_path(), ec);
+        }
+
+        return FileUtils::writeFileAtomically(reportPath, glz::prettify_json(json));
+    }
+}
@@ -0,0 +1,164 @@
+#include "yomitan_dictionary_builder/utils/trace_recorder.h"
+#include "yomitan_dictionary_builder/utils/file_sync.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace Profiling
+{
+    namespace
+    {
+        // Recorders are never freed, so the events of finished threads remain available for the trace
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<TraceRecorder>> registry;
+
+        int64_t getClockNanos()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        double toMicroseconds(const uint64_t nanos)
+        {
+            return static_cast<double>(nanos) / 1e3;
+        }
+    }
+
+
+    void TraceRecorder::setEnabled(const bool isEnabled)
+    {
+        enabled.store(isEnabled, std::memory_order_relaxed);
+    }
+
+
+    TraceRecorder& TraceRecorder::forCurrentThread()
+    {
+        thread_local TraceRecorder* recorder = []
+        {
+            std::lock_guard lock(registryMutex);
+            TraceRecorder* threadRecorder = registry.emplace_back(std::make_unique<TraceRecorder>()).get();
+            threadRecorder->threadId = static_cast<uint32_t>(registry.size());
+            return threadRecorder;
+        }();
+
+        return *recorder;
+    }
+
+
+    void TraceRecorder::clearAll()
+    {
+        std::lock_guard lock(registryMutex);
+        for (const auto& recorder : registry)
+        {
+            recorder->events.clear();
+            recorder->droppedEvents = 0;
+        }
+
+        epochNanos.store(getClockNanos(), std::memory_order_relaxed);
+    }
+
+
+    void TraceRecorder::setThreadName(const std::string_view name)
+    {
+        if (isEnabled())
+            forCurrentThread().threadName.assign(name);
+    }
+
+
+    uint64_t TraceRecorder::now()
+    {
+        return static_cast<uint64_t>(std::max<int64_t>(getClockNanos() - epochNanos.load(std::memory_order_relaxed), 0));
+    }
+
+
+    void TraceRecorder::record(const char* name, const char* category, const uint64_t startNanos, const uint64_t endNanos, std::string detail)
+    {
+        if (events.size() >= MAX_EVENTS_PER_THREAD)
+        {
+            droppedEvents++;
+            return;
+        }
+
+        events.push_back({name, category, startNanos, endNanos - startNanos, std::move(detail)});
+    }
+
+
+    TraceFile TraceRecorder::buildTrace()
+    {
+        TraceFile trace;
+
+        std::lock_guard lock(registryMutex);
+
+        size_t eventCount = 0;
+        for (const auto& recorder : registry)
+        {
+            eventCount += recorder->events.size() + 1;
+        }
+        trace.traceEvents.reserve(eventCount);
+
+        for (const auto& recorder : registry)
+        {
+            if (recorder->events.empty())
+                continue;
+
+            TraceEventJson& threadName = trace.traceEvents.emplace_back();
+            threadName.name = "thread_name";
+            threadName.ph = "M";
+            threadName.tid = recorder->threadId;
+            threadName.args["name"] = recorder->threadName.empty() ? "thread " + std::to_string(recorder->threadId) : recorder->threadName;
+
+            if (recorder->droppedEvents > 0)
+            {
+                std::cerr << "Trace buffer of " << threadName.args["name"] << " was full, dropped "
+                          << recorder->droppedEvents << " events" << std::endl;
+            }
+
+            for (const auto& event : recorder->events)
+            {
+                TraceEventJson& json = trace.traceEvents.emplace_back();
+                json.name = event.name;
+                json.cat = event.category;
+                json.ph = "X";
+                json.ts = toMicroseconds(event.startNanos);
+                json.dur = toMicroseconds(event.durationNanos);
+                json.tid = recorder->threadId;
+
+                if (!event.detail.empty())
+                    json.args["detail"] = event.detail;
+            }
+        }
+
+        // Metadata first, then by start time with longer events first so nested events follow their parents
+        std::ranges::stable_sort(trace.traceEvents, [](const TraceEventJson& a, const TraceEventJson& b) {
+            if ((a.ph == "M") != (b.ph == "M"))
+                return a.ph == "M";
+            if (a.ts != b.ts)
+                return a.ts < b.ts;
+            return a.dur.value_or(0.0) > b.dur.value_or(0.0);
+        });
+
+        return trace;
+    }
+
+
+    bool TraceRecorder::writeTrace(const std::filesystem::path& tracePath)
+    {
+        const TraceFile trace = buildTrace();
+
+        std::string json;
+        if (const auto ec = glz::write_json(trace, json); ec)
+        {
+            std::cerr << "Error writing trace: " << glz::format_error(ec, json) << std::endl;
+            return false;
+        }
+
+        if (tracePath.has_parent_path())
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(tracePath.parent_path(), ec);
+        }
+
+        return FileUtils::writeFileAtomically(tracePath, json);
+    }
+}
@@ -0,0 +1,290 @@
+#include "yomitan_dictionary_builder/utils/xml_loader.h"
+#include "yomitan_dictionary_builder/utils/allocation_tracker.h"
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Every allocation handed to pugixml is prefixed with a header recording where it came from,
+    // so memory allocated outside an arena scope can still be freed correctly
+    constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+    constexpr unsigned char HEAP_ALLOCATION = 0;
+    constexpr unsigned char ARENA_ALLOCATION = 1;
+
+    thread_local PugiArena* activeArena = nullptr;
+
+    void* allocateTagged(const size_t size)
+    {
+        Profiling::AllocationTracker::recordPugiAllocation(size);
+
+        std::byte* base = nullptr;
+        unsigned char tag = HEAP_ALLOCATION;
+
+        if (activeArena)
+        {
+            try
+            {
+                base = static_cast<std::byte*>(activeArena->allocate(size + HEADER_SIZE));
+                tag = ARENA_ALLOCATION;
+            }
+            catch (const std::bad_alloc&)
+            {
+                return nullptr;
+            }
+        }
+        else
+        {
+            base = static_cast<std::byte*>(std::malloc(size + HEADER_SIZE));
+        }
+
+        if (!base)
+            return nullptr;
+
+        *reinterpret_cast<unsigned char*>(base) = tag;
+        return base + HEADER_SIZE;
+    }
+
+    void deallocateTagged(void* ptr)
+    {
+        if (!ptr)
+            return;
+
+        // Arena memory is reclaimed in bulk by PugiArena::reset
+        if (std::byte* base = static_cast<std::byte*>(ptr) - HEADER_SIZE; *reinterpret_cast<unsigned char*>(base) == HEAP_ALLOCATION)
+            std::free(base);
+    }
+
+    // Installed before main, ahead of any pugixml allocation, so no block without a header is ever freed here
+    [[maybe_unused]] const bool hooksInstalled = [] {
+        pugi::set_memory_management_functions(allocateTagged, deallocateTagged);
+        return true;
+    }();
+}
+
+
+void* PugiArena::allocate(const size_t size)
+{
+    const size_t alignedSize = (size + HEADER_SIZE - 1) & ~(HEADER_SIZE - 1);
+
+    while (currentBlock < blocks.size())
+    {
+        if (Block& block = blocks[currentBlock]; offset + alignedSize <= block.size)
+        {
+            void* ptr = block.data.get() + offset;
+            offset += alignedSize;
+            return ptr;
+        }
+
+        currentBlock++;
+        offset = 0;
+    }
+
+    const size_t blockSize = std::max(BLOCK_SIZE, alignedSize);
+    blocks.push_back(Block{std::make_unique_for_overwrite<std::byte[]>(blockSize), blockSize});
+    currentBlock = blocks.size() - 1;
+    offset = alignedSize;
+    return blocks.back().data.get();
+}
+
+
+void PugiArena::reset()
+{
+    currentBlock = 0;
+    offset = 0;
+}
+
+
+size_t PugiArena::capacity() const
+{
+    size_t total = 0;
+    for (const auto& block : blocks)
+        total += block.size;
+    return total;
+}
+
+
+StringXMLWriter::StringXMLWriter(std::string& buffer) : buffer(buffer)
+{
+}
+
+
+void StringXMLWriter::write(const void* data, const size_t size)
+{
+    buffer.append(static_cast<const char*>(data), size);
+}
+
+
+XMLLoader::ArenaScope::ArenaScope(XMLLoader& loader, const bool useArena)
+{
+    if (!useArena || activeArena)
+        return;
+
+    // The document is released before the arena it lives in is reused
+    loader.document.reset();
+    loader.arena.reset();
+    activeArena = &loader.arena;
+    active = true;
+}
+
+
+XMLLoader::ArenaScope::~ArenaScope()
+{
+    if (active)
+        activeArena = nullptr;
+}
+
+
+XMLLoader::XMLLoader() = default;
+
+
+XMLLoader::~XMLLoader()
+{
+    document.reset();
+    if (activeArena == &arena)
+        activeArena = nullptr;
+}
+
+
+XMLLoader& XMLLoader::forCurrentThread()
+{
+    thread_local XMLLoader loader;
+    return loader;
+}
+
+
+pugi::xml_document* XMLLoader::load(const std::filesystem::path& filePath)
+{
+    resetDocument();
+
+    size_t size = 0;
+    if (!readFile(filePath, buffer, size))
+    {
+        std::cerr << "Failed to read file '" << filePath.string() << "'" << std::endl;
+        return nullptr;
+    }
+
+    return parseBuffer(size, filePath.filename().string());
+}
+
+
+pugi::xml_document* XMLLoader::loadBuffer(std::string& contents, const std::string_view name)
+{
+    resetDocument();
+
+    buffer.swap(contents);
+    return parseBuffer(buffer.size(), name);
+}
+
+
+pugi::xml_document* XMLLoader::load(FileUtils::PageFile& page)
+{
+    if (!page.loaded)
+        return load(page.path);
+
+    page.loaded = false;
+    return loadBuffer(page.contents, page.path.filename().string());
+}
+
+
+size_t XMLLoader::getPagesLoaded() const
+{
+    return pagesLoaded;
+}
+
+
+size_t XMLLoader::getBytesLoaded() const
+{
+    return bytesLoaded;
+}
+
+
+void XMLLoader::resetDocument()
+{
+    // Arena memory of the previous document is only reclaimed when the next arena scope begins
+    document.reset();
+}
+
+
+pugi::xml_document* XMLLoader::parseBuffer(const size_t size, const std::string_view name)
+{
+    const Profiling::ScopedStage stage(Profiling::Stage::XmlLoad);
+
+    if (const pugi::xml_parse_result result = document.load_buffer_inplace(buffer.data(), size); !result)
+    {
+        std::cerr << "Failed to read xml: " << name << " (" << result.description() << ")" << std::endl;
+        return nullptr;
+    }
+
+    pagesLoaded++;
+    bytesLoaded += size;
+    return &document;
+}
+
+
+bool XMLLoader::readFile(const std::filesystem::path& filePath, std::string& buffer, size_t& size)
+{
+    const Profiling::ScopedStage stage(Profiling::Stage::FileRead);
+
+#ifdef _WIN32
+    std::ifstream file(filePath, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+
+    size = static_cast<size_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+
+    if (buffer.size() < size)
+        buffer.resize(size);
+
+    return static_cast<bool>(file.read(buffer.data(), static_cast<std::streamsize>(size)));
+#else
+    // A private mmap would take a copy-on-write fault on nearly every page since in-place parsing
+    // writes terminators throughout the buffer, so a single read into a recycled buffer is cheaper
+    const int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat{};
+    if (::fstat(fd, &fileStat) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size = static_cast<size_t>(fileStat.st_size);
+    if (buffer.size() < size)
+        buffer.resize(size);
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    size_t totalRead = 0;
+    while (totalRead < size)
+    {
+        const ssize_t bytesRead = ::read(fd, buffer.data() + totalRead, size - totalRead);
+        if (bytesRead < 0 && errno == EINTR)
+            continue;
+
+        if (bytesRead <= 0)
+            break;
+
+        totalRead += static_cast<size_t>(bytesRead);
+    }
+
+    ::close(fd);
+    size = totalRead;
+    return true;
+#endif
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/utils/allocation_tracker.h"
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
+#include "pugixml.h"
+
+#include <memory>
+
+using Profiling::AllocationTracker;
+using Profiling::ScopedStage;
+using Profiling::Stage;
+using Profiling::StageProfiler;
+
+namespace
+{
+    const Profiling::StageAllocationReport* findStage(const Profiling::AllocationReport& report, const std::string_view name)
+    {
+        for (const auto& stage : report.stages)
+        {
+            if (stage.stage == name)
+                return &stage;
+        }
+        return nullptr;
+    }
+
+    Profiling::RunReport buildReport(const uint64_t pages, const int64_t entries)
+    {
+        return StageProfiler::buildReport({.dictionary = "test", .pages = pages, .entries = entries, .includeAllocations = true});
+    }
+}
+
+
+class AllocationTrackerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        StageProfiler::resetAll(0);
+        StageProfiler::setEnabled(true);
+        AllocationTracker::setEnabled(true);
+    }
+
+    void TearDown() override
+    {
+        AllocationTracker::setEnabled(false);
+        StageProfiler::setEnabled(false);
+    }
+};
+
+
+TEST_F(AllocationTrackerTest, CountsTowardsActiveStage)
+{
+    {
+        ScopedStage stage(Stage::TreeConversion);
+        AllocationTracker::recordAllocation(100);
+        AllocationTracker::recordAllocation(300);
+
+        {
+            ScopedStage inner(Stage::Serialization);
+            AllocationTracker::recordAllocation(1000);
+        }
+
+        AllocationTracker::recordPugiAllocation(64);
+    }
+    AllocationTracker::setEnabled(false);
+
+    const auto report = buildReport(2, 4);
+    ASSERT_TRUE(report.allocations.has_value());
+
+    const auto* conversion = findStage(*report.allocations, "treeConversion");
+    ASSERT_NE(conversion, nullptr);
+    EXPECT_EQ(conversion->allocations, 2);
+    EXPECT_EQ(conversion->bytes, 400);
+    EXPECT_EQ(conversion->pugiAllocations, 1);
+    EXPECT_EQ(conversion->pugiBytes, 64);
+
+    const auto* serialization = findStage(*report.allocations, "serialization");
+    ASSERT_NE(serialization, nullptr);
+    EXPECT_EQ(serialization->allocations, 1);
+    EXPECT_EQ(serialization->bytes, 1000);
+
+    // Without the operator new hook these are the only allocations
+    if (!AllocationTracker::isSupported())
+    {
+        EXPECT_EQ(report.allocations->allocations, 4);
+        EXPECT_EQ(report.allocations->bytes, 1464);
+        EXPECT_DOUBLE_EQ(report.allocations->allocationsPerPage, 2.0);
+        EXPECT_DOUBLE_EQ(report.allocations->bytesPerEntry, 366.0);
+    }
+
+#ifndef _WIN32
+    EXPECT_GT(report.allocations->peakRssBytes, 0);
+#endif
+}
+
+TEST_F(AllocationTrackerTest, CountsPugiAndOperatorNew)
+{
+    {
+        ScopedStage stage(Stage::XmlLoad);
+        pugi::xml_document document;
+        document.append_child("entry").append_child("headword").text().set("見出し");
+
+        auto value = std::make_unique<std::string>(64, 'x');
+    }
+    AllocationTracker::setEnabled(false);
+
+    const auto report = buildReport(1, 1);
+    ASSERT_TRUE(report.allocations.has_value());
+
+    const auto* xmlLoad = findStage(*report.allocations, "xmlLoad");
+    ASSERT_NE(xmlLoad, nullptr);
+    EXPECT_GT(xmlLoad->pugiAllocations, 0);
+    EXPECT_EQ(xmlLoad->allocations > 0, AllocationTracker::isSupported());
+}
+
+TEST_F(AllocationTrackerTest, DisabledCountsNothing)
+{
+    AllocationTracker::setEnabled(false);
+
+    {
+        ScopedStage stage(Stage::DiskWrite);
+        AllocationTracker::recordAllocation(100);
+    }
+
+    const auto report = buildReport(1, 1);
+    ASSERT_TRUE(report.allocations.has_value());
+    EXPECT_EQ(findStage(*report.allocations, "diskWrite"), nullptr);
+    EXPECT_FALSE(StageProfiler::buildReport({.dictionary = "test"}).allocations.has_value());
+}
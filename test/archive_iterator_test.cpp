@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/utils/archive_iterator.h"
+
+#include <filesystem>
+
+namespace
+{
+    std::filesystem::path archivePath(const std::string& name)
+    {
+        return std::filesystem::path(YOMITAN_TEST_DATA_DIR) / "archives" / name;
+    }
+
+    std::vector<FileUtils::PageFile> readAllPages(FileUtils::PageSource& source)
+    {
+        std::vector<FileUtils::PageFile> pages;
+        while (source.hasMore())
+        {
+            for (auto& page : source.getNextBatch(1))
+                pages.emplace_back(std::move(page));
+        }
+        return pages;
+    }
+}
+
+TEST(ArchiveIteratorTest, TestIsArchive)
+{
+    EXPECT_TRUE(FileUtils::ArchiveIterator::isArchive("pages.zip"));
+    EXPECT_TRUE(FileUtils::ArchiveIterator::isArchive("pages.tar"));
+    EXPECT_TRUE(FileUtils::ArchiveIterator::isArchive("pages.tar.gz"));
+    EXPECT_TRUE(FileUtils::ArchiveIterator::isArchive("pages.tgz"));
+    EXPECT_FALSE(FileUtils::ArchiveIterator::isArchive("pages"));
+    EXPECT_FALSE(FileUtils::ArchiveIterator::isArchive("pages.gz"));
+}
+
+TEST(ArchiveIteratorTest, TestReadZip)
+{
+    FileUtils::ArchiveIterator iterator{archivePath("pages.zip")};
+    EXPECT_EQ(iterator.getTotalFilesCount(), 2);
+
+    const auto pages = readAllPages(iterator);
+    ASSERT_EQ(pages.size(), 2);
+
+    // stored member
+    EXPECT_EQ(pages[0].path.stem().string(), "0000001920");
+    EXPECT_TRUE(pages[0].loaded);
+    EXPECT_NE(pages[0].contents.find("<head>実験</head>"), std::string::npos);
+
+    // deflated member
+    EXPECT_EQ(pages[1].path.stem().string(), "0000001921");
+    EXPECT_TRUE(pages[1].contents.starts_with("<entry><head>心理</head>"));
+    EXPECT_TRUE(pages[1].contents.ends_with("</body></entry>"));
+}
+
+TEST(ArchiveIteratorTest, TestReadTarGz)
+{
+    FileUtils::ArchiveIterator iterator{archivePath("pages.tar.gz")};
+
+    // Counting the members would mean decompressing the stream twice
+    EXPECT_EQ(iterator.getTotalFilesCount(), 0);
+
+    const auto pages = readAllPages(iterator);
+    ASSERT_EQ(pages.size(), 2);
+
+    EXPECT_EQ(pages[0].path.string(), "0000001920.xml");
+    EXPECT_NE(pages[0].contents.find("<head>実験</head>"), std::string::npos);
+
+    // member name longer than the ustar header allows, stored in a pax record
+    EXPECT_EQ(pages[1].path.stem().string(), "0000001921");
+    EXPECT_GT(pages[1].path.string().size(), 100);
+    EXPECT_TRUE(pages[1].contents.ends_with("</body></entry>"));
+}
+
+TEST(ArchiveIteratorTest, TestOpenPageSource)
+{
+    const auto source = FileUtils::openPageSource(archivePath("pages.zip"));
+    EXPECT_NE(dynamic_cast<FileUtils::ArchiveIterator*>(source.get()), nullptr);
+    EXPECT_EQ(source->getTotalFilesCount(), 2);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/core/checkpoint.h"
+#include "yomitan_dictionary_builder/utils/file_utils.h"
+
+#include <filesystem>
+#include <fstream>
+
+TEST(CheckpointTest, TestSaveAndLoad)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "checkpoint_test";
+    std::filesystem::remove_all(directory);
+
+    const Checkpoint checkpoint{directory / "checkpoint.json"};
+    EXPECT_FALSE(checkpoint.load().has_value());
+
+    CheckpointState state;
+    state.builderVersion = "0.0.1";
+    state.configHash = 0xFFFFFFFFFFFFFFFFULL;
+    state.dictionaryPath = "resources/parsers/YDP/pages";
+    state.pagesCompleted = 1000;
+    state.lastCompletedPage = "resources/parsers/YDP/pages/0000001920.xml";
+    state.entriesProcessed = 2345;
+    state.termBanks = {1, 2, 3};
+    state.contentOffset = 123456;
+    state.assetReferences = {"graphics/実験.png", "audio/a.aac"};
+
+    EXPECT_TRUE(checkpoint.save(state));
+    EXPECT_FALSE(std::filesystem::exists(directory / "checkpoint.json.tmp"));
+
+    const auto loaded = checkpoint.load();
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->configHash, state.configHash);
+    EXPECT_EQ(loaded->pagesCompleted, 1000);
+    EXPECT_EQ(loaded->lastCompletedPage, state.lastCompletedPage);
+    EXPECT_EQ(loaded->entriesProcessed, 2345);
+    EXPECT_EQ(loaded->termBanks, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(loaded->contentOffset, 123456);
+    EXPECT_EQ(loaded->assetReferences, state.assetReferences);
+
+    checkpoint.remove();
+    EXPECT_FALSE(checkpoint.load().has_value());
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(CheckpointTest, TestFileIteratorSkipKeepsOrder)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "checkpoint_pages_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    for (const auto* name : {"0003.xml", "0001.xml", "0002.xml", "0004.xml"})
+        std::ofstream(directory / name) << "<page/>";
+
+    FileUtils::FileIterator iterator{directory};
+    iterator.skip(2);
+
+    const auto batch = iterator.getNextBatch(10);
+    ASSERT_EQ(batch.size(), 2);
+    EXPECT_EQ(batch[0].path.filename().string(), "0003.xml");
+    EXPECT_EQ(batch[1].path.filename().string(), "0004.xml");
+    EXPECT_FALSE(iterator.hasMore());
+
+    std::filesystem::remove_all(directory);
+}
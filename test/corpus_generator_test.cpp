@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/utils/corpus_generator.h"
+#include "yomitan_dictionary_builder/index/index_reader.h"
+#include "yomitan_dictionary_builder/index/jukugo_index_reader.h"
+#include "pugixml.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    std::string readFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    CorpusOptions makeOptions(const std::filesystem::path& directory, const uint64_t seed)
+    {
+        CorpusOptions options;
+        options.outputDirectory = directory;
+        options.pageCount = 50;
+        options.seed = seed;
+        options.imageCount = 10;
+        return options;
+    }
+}
+
+
+TEST(CorpusGeneratorTest, TestGeneratesConsistentIndexes)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "corpus_generator_test";
+    std::filesystem::remove_all(directory);
+
+    CorpusGenerator generator(makeOptions(directory, 1));
+    ASSERT_TRUE(generator.generate());
+
+    const auto& stats = generator.getStats();
+    EXPECT_EQ(stats.pages, 50);
+    EXPECT_GE(stats.indexKeys, 100);
+    EXPECT_GT(stats.pageBytes, 0);
+
+    for (const auto* file : {"index/index_d.tsv", "index/jyukugo_prefix.tsv", "tag_map.json", "image_map.json", "corpus.yaml"})
+        EXPECT_TRUE(std::filesystem::exists(directory / file)) << file;
+
+    // Every page has its headword and reading in the index
+    IndexReader indexReader((directory / "index" / "index_d.tsv").string());
+    ASSERT_TRUE(indexReader.loadIndex());
+    for (uint64_t pageId = 1; pageId <= 50; ++pageId)
+    {
+        const auto pageFile = directory / "pages" / CorpusGenerator::getPageFilename(pageId);
+        pugi::xml_document document;
+        ASSERT_TRUE(document.load_file(pageFile.c_str())) << pageFile.string();
+        EXPECT_TRUE(document.select_node("//headword[@class='見出']"));
+
+        EXPECT_GE(indexReader.getKeysForFile(pageFile.stem().string()).size(), 2);
+    }
+
+    // Every sub item has its term and reading under the page and item number of its SubItem id
+    JukugoIndexReader jukugoIndexReader((directory / "index" / "jyukugo_prefix.tsv").string());
+    size_t subItems = 0;
+    for (int pageId = 1; pageId <= 50; ++pageId)
+    {
+        const std::string page = readFile(directory / "pages" / CorpusGenerator::getPageFilename(pageId));
+        for (const auto& [itemId, keys] : jukugoIndexReader.getGroupedEntriesForPage(pageId))
+        {
+            std::ostringstream subItemId;
+            subItemId << std::setw(10) << std::setfill('0') << pageId << "-4" << std::setw(3) << itemId;
+
+            EXPECT_NE(page.find(R"(<SubItem id=")" + subItemId.str() + "\""), std::string::npos) << subItemId.str();
+            EXPECT_EQ(keys.size(), 2);
+            subItems++;
+        }
+    }
+    EXPECT_EQ(subItems, stats.subItems);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(CorpusGeneratorTest, TestSameSeedSameCorpus)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "corpus_generator_seed_test";
+    std::filesystem::remove_all(directory);
+
+    CorpusGenerator first(makeOptions(directory / "a", 7));
+    CorpusGenerator second(makeOptions(directory / "b", 7));
+    CorpusGenerator other(makeOptions(directory / "c", 8));
+    ASSERT_TRUE(first.generate());
+    ASSERT_TRUE(second.generate());
+    ASSERT_TRUE(other.generate());
+
+    for (const auto* file : {"pages/0000000001.xml", "pages/0000000050.xml", "index/index_d.tsv", "index/jyukugo_prefix.tsv"})
+        EXPECT_EQ(readFile(directory / "a" / file), readFile(directory / "b" / file)) << file;
+
+    EXPECT_NE(readFile(directory / "a" / "index/index_d.tsv"), readFile(directory / "c" / "index/index_d.tsv"));
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/core/entry_store.h"
+#include "yomitan_dictionary_builder/parsers/MDict/mdict_exporter.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    std::unique_ptr<DicEntry> makeEntry(const std::string& term, const std::string& reading, const std::string& meaning)
+    {
+        auto entry = std::make_unique<DicEntry>(term, reading);
+        entry->setInfoTag("名");
+        entry->setSearchRank(-1);
+        entry->setSequenceNumber(207);
+
+        const auto root = std::make_shared<HTMLElement>("div");
+        root->setData({{"meaning", ""}, {"level", "1"}});
+        root->addContent(std::make_shared<HTMLElement>("span", meaning));
+        root->addContent(std::make_shared<HTMLElement>("span", std::vector<HTMLElementContent>{}));
+
+        const auto link = std::make_shared<HTMLElement>("a", "参照 <1>");
+        link->setHref("?query=" + term + "&wildcards=off");
+        root->addContent(link);
+
+        entry->addElement(root);
+        return entry;
+    }
+
+    std::string readFile(const std::filesystem::path& filePath)
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+}
+
+
+class EntryStoreTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() / "entry_store_test";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        storePath = directory / "entries.store";
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::path directory;
+    std::filesystem::path storePath;
+};
+
+
+TEST_F(EntryStoreTest, EntriesRoundTrip)
+{
+    const auto first = makeEntry("実験", "じっけん", "人間の行動を研究する。");
+    const auto second = makeEntry("試験", "しけん", "能力を調べる。");
+
+    {
+        EntryStoreWriter writer(storePath);
+        writer.append(3, *first);
+        writer.append(4, *second);
+        ASSERT_TRUE(writer.finish());
+    }
+    EXPECT_FALSE(std::filesystem::exists(directory / "entries.store.tmp"));
+
+    const EntryStoreReader reader(storePath);
+    ASSERT_EQ(reader.size(), 2);
+
+    const auto stored = reader.read(1);
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_EQ(stored->pageId, 4);
+    EXPECT_EQ(stored->entry->getTerm(), "試験");
+    EXPECT_EQ(stored->entry->getReading(), "しけん");
+    EXPECT_EQ(stored->entry->getInfoTag(), "名");
+    EXPECT_EQ(stored->entry->getSearchRank(), -1);
+    EXPECT_EQ(stored->entry->getSequenceNumber(), 207);
+    EXPECT_EQ(stored->entry->getContentHash(), second->getContentHash());
+
+    const auto& emptySpan = std::get<std::shared_ptr<HTMLElement>>(stored->entry->getElements()[0]->getContent()->at(1));
+    ASSERT_TRUE(emptySpan->getContent().has_value());
+    EXPECT_TRUE(emptySpan->getContent()->empty());
+
+    EXPECT_FALSE(reader.read(2).has_value());
+}
+
+TEST_F(EntryStoreTest, IncompleteStoreIsRejected)
+{
+    {
+        EntryStoreWriter writer(storePath);
+        writer.append(1, *makeEntry("実験", "じっけん", "研究"));
+        ASSERT_TRUE(writer.finish());
+    }
+
+    std::filesystem::resize_file(storePath, std::filesystem::file_size(storePath) - 4);
+    EXPECT_THROW(EntryStoreReader{storePath}, std::runtime_error);
+    EXPECT_THROW(EntryStoreReader{directory / "missing.store"}, std::runtime_error);
+}
+
+TEST_F(EntryStoreTest, CapturedEntriesCanBeReplayed)
+{
+    {
+        EntryStoreWriter writer(storePath);
+        writer.beginCapture();
+        writer.append(1, *makeEntry("実験", "じっけん", "研究"));
+        const auto captured = writer.endCapture();
+        ASSERT_EQ(captured.size(), 1);
+
+        writer.appendEncoded(2, captured[0]);
+        ASSERT_TRUE(writer.finish());
+    }
+
+    const EntryStoreReader reader(storePath);
+    ASSERT_EQ(reader.size(), 2);
+    EXPECT_EQ(reader.read(1)->pageId, 2);
+    EXPECT_EQ(reader.read(0)->entry->getContentHash(), reader.read(1)->entry->getContentHash());
+}
+
+TEST_F(EntryStoreTest, RendersHtml)
+{
+    const auto entry = makeEntry("実験", "じっけん", "a & b");
+    EXPECT_EQ(EntryStoreReader::renderHtml(*entry),
+              "<div data-sc-level=\"1\" data-sc-meaning=\"\"><span>a &amp; b</span><span></span>"
+              "<a href=\"?query=実験&amp;wildcards=off\">参照 &lt;1&gt;</a></div>");
+}
+
+TEST_F(EntryStoreTest, EmitsToYomitanAndMDict)
+{
+    {
+        EntryStoreWriter writer(storePath);
+        writer.append(0, *makeEntry("実験", "じっけん", "研究"));
+        writer.append(0, *makeEntry("実験的", "じっけんてき", "研究"));
+        writer.append(1, *makeEntry("試験", "しけん", "調査"));
+        ASSERT_TRUE(writer.finish());
+    }
+
+    const EntryStoreReader reader(storePath);
+
+    YomitanDictionaryConfig yomitanConfig;
+    yomitanConfig.title = "test";
+    yomitanConfig.tempDir = directory / "term_banks";
+    {
+        YomitanDictionary dictionary(yomitanConfig);
+        ASSERT_TRUE(reader.emit(dictionary));
+        EXPECT_EQ(dictionary.getEntryCount(), 3);
+        ASSERT_TRUE(dictionary.flush());
+    }
+
+    MDictConfig dictionaryConfig;
+    dictionaryConfig.title = "test";
+    ParserConfig parserConfig;
+    parserConfig.outputPath = directory / "mdict";
+    parserConfig.descriptionPath = directory / "description.html";
+
+    MDictExporter exporter(dictionaryConfig, parserConfig);
+    exporter.addStoredEntries(reader);
+    exporter.checkpoint();
+
+    // One MDict entry per page, keyed on the terms and readings of its entries
+    const auto stats = exporter.exportStats();
+    EXPECT_EQ(stats.totalEntries, 2);
+    EXPECT_EQ(stats.totalKeys, 6);
+
+    const std::string content = readFile(directory / "mdict" / "test.txt");
+    EXPECT_TRUE(content.starts_with("0\n<div"));
+    EXPECT_NE(content.find("\n</>\n1\n<div"), std::string::npos);
+}
@@ -14,3 +14,22 @@ TEST(HTMLElementTest, CreateElement)
     EXPECT_NO_THROW(HTMLElement("details", "collapsible element content"));
 }
 
+
+TEST(HTMLElementTest, DataAttributesAreSortedByKey)
+{
+    DataAttributes data{{"meaning", ""}, {"level", "1"}};
+    data.set("example", "a");
+    data.set("level", "2");
+
+    ASSERT_EQ(data.size(), 3);
+    EXPECT_EQ(data.begin()->first.view(), "example");
+    EXPECT_EQ(*data.find("level"), "2");
+    EXPECT_EQ(data.find("missing"), nullptr);
+
+    HTMLElement element("div");
+    element.setData(data);
+
+    std::string json;
+    ASSERT_FALSE(glz::write_json(element, json));
+    EXPECT_EQ(json, R"({"tag":"div","data":{"example":"a","level":"2","meaning":""}})");
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/core/key_index.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <ranges>
+
+namespace
+{
+    std::vector<std::pair<std::string, uint64_t>> toPairs(const std::vector<KeyIndexReader::Match>& matches)
+    {
+        std::vector<std::pair<std::string, uint64_t>> pairs;
+        for (const auto& match : matches)
+            pairs.emplace_back(match.key, match.entryId);
+        return pairs;
+    }
+
+    using Pairs = std::vector<std::pair<std::string, uint64_t>>;
+}
+
+
+class KeyIndexTest : public ::testing::Test
+{
+protected:
+    void writeIndex(const Pairs& keys)
+    {
+        KeyIndexWriter writer;
+        for (const auto& [key, entryId] : keys)
+            writer.addKey(key, entryId);
+        ASSERT_TRUE(writer.build(index));
+    }
+
+    std::string index;
+};
+
+
+TEST_F(KeyIndexTest, KeysAreFoundWithKanaFolded)
+{
+    writeIndex({{"じっけん", 1}, {"ジッケン", 1}, {"実験", 1}, {"しけん", 2}, {"試験", 2}, {"しけん", 3}, {"しけん", 3}, {"テスト", 3}});
+
+    const KeyIndexReader reader(index);
+    EXPECT_EQ(reader.getKeyCount(), 5);
+    EXPECT_EQ(reader.getValueCount(), 7);
+
+    EXPECT_EQ(toPairs(reader.find("じっけん")), (Pairs{{"じっけん", 1}, {"ジッケン", 1}}));
+    EXPECT_EQ(toPairs(reader.find("ジッケン")), (Pairs{{"じっけん", 1}, {"ジッケン", 1}}));
+    EXPECT_EQ(toPairs(reader.findExact("ジッケン")), (Pairs{{"ジッケン", 1}}));
+    EXPECT_EQ(toPairs(reader.find("しけん")), (Pairs{{"しけん", 2}, {"しけん", 3}}));
+    EXPECT_EQ(toPairs(reader.find("てすと")), (Pairs{{"テスト", 3}}));
+    EXPECT_EQ(toPairs(reader.find("実験")), (Pairs{{"実験", 1}}));
+
+    EXPECT_TRUE(reader.find("しけ").empty());
+    EXPECT_TRUE(reader.find("しけんかん").empty());
+    EXPECT_TRUE(reader.find("").empty());
+}
+
+TEST_F(KeyIndexTest, PrefixesAreIteratedInKeyOrder)
+{
+    writeIndex({{"しけん", 2}, {"しけんかん", 4}, {"シケイ", 5}, {"じっけん", 1}, {"し", 6}});
+
+    const KeyIndexReader reader(index);
+    EXPECT_EQ(toPairs(reader.findPrefix("し")), (Pairs{{"し", 6}, {"シケイ", 5}, {"しけん", 2}, {"しけんかん", 4}}));
+    EXPECT_EQ(toPairs(reader.findPrefix("シケン")), (Pairs{{"しけん", 2}, {"しけんかん", 4}}));
+    EXPECT_EQ(toPairs(reader.findPrefix("しけんか")), (Pairs{{"しけんかん", 4}}));
+    EXPECT_EQ(toPairs(reader.findPrefix("し", 2)), (Pairs{{"し", 6}, {"シケイ", 5}}));
+    EXPECT_EQ(reader.findPrefix("").size(), 5);
+    EXPECT_TRUE(reader.findPrefix("しけんかんご").empty());
+    EXPECT_TRUE(reader.findPrefix("ぱ").empty());
+
+    ASSERT_EQ(reader.getValueCount(), 5);
+    EXPECT_EQ(reader.getValue(0).key, "し");
+    EXPECT_EQ(reader.getValue(4).entryId, 1);
+
+    size_t visited = 0;
+    reader.forEachPrefix("し", [&](const KeyIndexReader::Match&) { return ++visited < 3; });
+    EXPECT_EQ(visited, 3);
+}
+
+TEST_F(KeyIndexTest, EmptyAndSingleKeyIndexes)
+{
+    writeIndex({});
+    {
+        const KeyIndexReader reader(index);
+        EXPECT_EQ(reader.getKeyCount(), 0);
+        EXPECT_TRUE(reader.find("し").empty());
+        EXPECT_TRUE(reader.findPrefix("").empty());
+    }
+
+    writeIndex({{"しけん", 2}});
+    const KeyIndexReader reader(index);
+    EXPECT_EQ(toPairs(reader.find("シケン")), (Pairs{{"しけん", 2}}));
+    EXPECT_EQ(toPairs(reader.findPrefix("しけ")), (Pairs{{"しけん", 2}}));
+    EXPECT_TRUE(reader.findPrefix("しか").empty());
+}
+
+TEST_F(KeyIndexTest, ManyKeysMatchASortedMap)
+{
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> length(1, 6);
+    std::uniform_int_distribution<int> character(0, 5);
+    const std::vector<std::string> characters{"あ", "い", "ア", "イ", "a", "漢"};
+
+    std::multimap<std::string, uint64_t> expected;
+    Pairs keys;
+    for (uint64_t i = 0; i < 5000; ++i)
+    {
+        std::string key;
+        for (int j = length(random); j > 0; --j)
+            key += characters[character(random)];
+
+        keys.emplace_back(key, i);
+        expected.emplace(key, i);
+    }
+    writeIndex(keys);
+
+    const KeyIndexReader reader(index);
+    for (const auto& [key, entryId] : keys)
+    {
+        const auto matches = reader.findExact(key);
+        EXPECT_EQ(matches.size(), expected.count(key)) << key;
+        EXPECT_TRUE(std::ranges::any_of(matches, [&](const auto& match) { return match.entryId == entryId; })) << key;
+    }
+
+    size_t prefixed = 0;
+    for (const auto& key : expected | std::views::keys)
+        prefixed += key.starts_with("あい") || key.starts_with("あイ") || key.starts_with("アい") || key.starts_with("アイ");
+    EXPECT_EQ(reader.findPrefix("あい").size(), prefixed);
+}
+
+TEST_F(KeyIndexTest, IncompleteIndexIsRejected)
+{
+    writeIndex({{"しけん", 2}, {"じっけん", 1}});
+
+    EXPECT_NO_THROW(KeyIndexReader{index});
+    EXPECT_THROW(KeyIndexReader{std::string_view(index).substr(0, index.size() - 1)}, std::runtime_error);
+    EXPECT_THROW(KeyIndexReader{std::string_view(index).substr(1)}, std::runtime_error);
+    EXPECT_THROW(KeyIndexReader{std::string_view()}, std::runtime_error);
+}
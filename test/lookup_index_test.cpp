@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/core/lookup_index.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    std::vector<std::string> keysOf(const std::vector<LookupIndexReader::Match>& matches)
+    {
+        std::vector<std::string> keys;
+        for (const auto& match : matches)
+            keys.emplace_back(match.key);
+        return keys;
+    }
+}
+
+
+class LookupIndexTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() / "lookup_index_test";
+        std::filesystem::remove_all(directory);
+        indexPath = directory / "test.lookup";
+
+        LookupIndexWriter writer(indexPath);
+        const uint64_t experiment = writer.addRecord("<div>実験</div>");
+        const uint64_t exam = writer.addRecord("<div>試験</div>");
+        const uint64_t test = writer.addRecord("<div>テスト</div>");
+
+        writer.addKey("じっけん", experiment);
+        writer.addKey("実験", experiment);
+        writer.addKey("ジッケン", experiment);
+        writer.addKey("しけん", exam);
+        writer.addKey("試験", exam);
+        writer.addKey("しけん", test);
+        writer.addKey("テスト", test);
+        writer.addKey("テスト", test);
+        ASSERT_TRUE(writer.finish());
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::path directory;
+    std::filesystem::path indexPath;
+};
+
+
+TEST_F(LookupIndexTest, ExactLookupFindsEveryRecordOfAKey)
+{
+    const LookupIndexReader index(indexPath);
+    EXPECT_EQ(index.getRecordCount(), 3);
+    EXPECT_EQ(index.getKeyCount(), 7);
+
+    const auto matches = index.findExact("しけん");
+    ASSERT_EQ(matches.size(), 2);
+    EXPECT_EQ(index.getRecord(matches[0].recordId), "<div>試験</div>");
+    EXPECT_EQ(index.getRecord(matches[1].recordId), "<div>テスト</div>");
+
+    EXPECT_EQ(index.findExact("しけん", 1).size(), 1);
+    EXPECT_TRUE(index.findExact("しけ").empty());
+    EXPECT_TRUE(index.findExact("ん").empty());
+    EXPECT_TRUE(index.getRecord(3).empty());
+}
+
+TEST_F(LookupIndexTest, PrefixLookupReturnsKeysInOrder)
+{
+    const LookupIndexReader index(indexPath);
+
+    EXPECT_EQ(keysOf(index.findPrefix("し", 10)), (std::vector<std::string>{"しけん", "しけん"}));
+    EXPECT_EQ(keysOf(index.findPrefix("じっ", 10)), (std::vector<std::string>{"じっけん"}));
+    EXPECT_EQ(index.findPrefix("", 10).size(), 7);
+    EXPECT_EQ(index.findPrefix("", 2).size(), 2);
+    EXPECT_TRUE(index.findPrefix("ぱ", 10).empty());
+}
+
+TEST_F(LookupIndexTest, KanaInsensitiveLookupMatchesBothScripts)
+{
+    const LookupIndexReader index(indexPath);
+
+    for (const std::string_view key : {"じっけん", "ジッケン"})
+    {
+        const auto matches = index.findKanaInsensitive(key);
+        EXPECT_EQ(keysOf(matches), (std::vector<std::string>{"じっけん", "ジッケン"}));
+        for (const auto& match : matches)
+            EXPECT_EQ(index.getRecord(match.recordId), "<div>実験</div>");
+    }
+
+    EXPECT_EQ(keysOf(index.findKanaInsensitive("てすと")), (std::vector<std::string>{"テスト"}));
+    EXPECT_TRUE(index.findKanaInsensitive("じっけ").empty());
+}
+
+TEST_F(LookupIndexTest, IncompleteIndexIsRejected)
+{
+    const auto size = std::filesystem::file_size(indexPath);
+    std::filesystem::resize_file(indexPath, size - 1);
+    EXPECT_THROW(LookupIndexReader{indexPath}, std::runtime_error);
+
+    std::filesystem::resize_file(indexPath, 0);
+    EXPECT_THROW(LookupIndexReader{indexPath}, std::runtime_error);
+
+    EXPECT_THROW(LookupIndexReader{directory / "missing.lookup"}, std::runtime_error);
+}
+
+TEST_F(LookupIndexTest, UnfinishedIndexLeavesNoFile)
+{
+    const auto unfinishedPath = directory / "unfinished.lookup";
+    {
+        LookupIndexWriter writer(unfinishedPath);
+        writer.addKey("じっけん", writer.addRecord("<div>実験</div>"));
+    }
+
+    EXPECT_FALSE(std::filesystem::exists(unfinishedPath));
+    EXPECT_FALSE(std::filesystem::exists(directory / "unfinished.lookup.tmp"));
+}
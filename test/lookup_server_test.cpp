@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/lookup/lookup_server.h"
+
+#include <filesystem>
+#include <thread>
+
+class LookupServerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() / "lookup_server_test";
+        std::filesystem::remove_all(directory);
+        indexPath = directory / "test.lookup";
+
+        {
+            LookupIndexWriter writer(indexPath);
+            const uint64_t experiment = writer.addRecord("<div>実験\nの記録</div>");
+            const uint64_t exam = writer.addRecord("<div>試験</div>");
+            writer.addKey("じっけん", experiment);
+            writer.addKey("ジッケン", experiment);
+            writer.addKey("しけん", exam);
+            writer.addKey("しけんかん", exam);
+            writer.addKey("くう き", exam);
+            ASSERT_TRUE(writer.finish());
+        }
+
+        index = std::make_unique<LookupIndexReader>(indexPath);
+        server = std::make_unique<Lookup::Server>(*index);
+    }
+
+    void TearDown() override
+    {
+        if (serverThread.joinable())
+        {
+            server->stop();
+            serverThread.join();
+        }
+
+        server.reset();
+        index.reset();
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::path directory;
+    std::filesystem::path indexPath;
+    std::unique_ptr<LookupIndexReader> index;
+    std::unique_ptr<Lookup::Server> server;
+    std::thread serverThread;
+};
+
+
+TEST_F(LookupServerTest, LinesAreAnsweredWithCountedRecords)
+{
+    EXPECT_EQ(server->handleLine("exact しけん"), "OK 1\nしけん\t1\t17\n<div>試験</div>\n");
+    EXPECT_EQ(server->handleLine("prefix しけ\t1\r"), "OK 1\nしけん\t1\t17\n<div>試験</div>\n");
+    EXPECT_EQ(server->handleLine("exact くう き"), "OK 1\nくう き\t1\t17\n<div>試験</div>\n");
+    EXPECT_EQ(server->handleLine("exact ぱ"), "OK 0\n");
+
+    EXPECT_TRUE(server->handleLine("fuzzy しけん").starts_with("ERR "));
+    EXPECT_TRUE(server->handleLine("exact").starts_with("ERR "));
+    EXPECT_TRUE(server->handleLine("exact しけん\tmany").starts_with("ERR "));
+}
+
+TEST_F(LookupServerTest, HttpAnswersLookupsAndErrors)
+{
+    bool keepAlive = false;
+    const std::string response = server->handleHttp(
+        "GET /lookup?q=%E3%81%97%E3%81%91%E3%82%93&mode=exact HTTP/1.1\r\nHost: localhost", keepAlive);
+    EXPECT_TRUE(response.starts_with("HTTP/1.1 200 OK\r\n"));
+    EXPECT_TRUE(keepAlive);
+
+    EXPECT_FALSE(server->handleHttp("GET /lookup?q=a HTTP/1.1\r\nConnection: close", keepAlive).empty());
+    EXPECT_FALSE(keepAlive);
+    EXPECT_FALSE(server->handleHttp("GET /lookup?q=a HTTP/1.0", keepAlive).empty());
+    EXPECT_FALSE(keepAlive);
+
+    EXPECT_TRUE(server->handleHttp("GET /lookup?mode=exact HTTP/1.1", keepAlive).starts_with("HTTP/1.1 400 "));
+    EXPECT_TRUE(server->handleHttp("GET /lookup?q=a&mode=fuzzy HTTP/1.1", keepAlive).starts_with("HTTP/1.1 400 "));
+    EXPECT_TRUE(server->handleHttp("GET /lookup?q=%E3%8 HTTP/1.1", keepAlive).starts_with("HTTP/1.1 400 "));
+    EXPECT_TRUE(server->handleHttp("GET /search?q=a HTTP/1.1", keepAlive).starts_with("HTTP/1.1 404 "));
+    EXPECT_TRUE(server->handleHttp("POST /lookup?q=a HTTP/1.1", keepAlive).starts_with("HTTP/1.1 405 "));
+}
+
+TEST_F(LookupServerTest, UrlComponentsAreDecoded)
+{
+    EXPECT_EQ(Lookup::decodeUrlComponent("%E5%AE%9F+a%2Bb"), "実 a+b");
+    EXPECT_FALSE(Lookup::decodeUrlComponent("%E").has_value());
+    EXPECT_FALSE(Lookup::decodeUrlComponent("%ZZ").has_value());
+}
+
+TEST_F(LookupServerTest, ClientsAreServedOverTheSocket)
+{
+    const auto socketPath = directory / "lookupd.sock";
+    ASSERT_TRUE(server->listenUnix(socketPath));
+
+    serverThread = std::thread([this] { server->run(); });
+
+    {
+        Lookup::Client first(socketPath);
+        Lookup::Client second(socketPath);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            const auto kana = first.lookup(Lookup::Mode::Kana, "じっけん");
+            ASSERT_TRUE(kana.has_value());
+            ASSERT_TRUE(kana->ok);
+            ASSERT_EQ(kana->matches.size(), 2);
+            EXPECT_EQ(kana->matches[1].first, "ジッケン");
+            EXPECT_EQ(kana->matches[1].second, "<div>実験\nの記録</div>");
+
+            const auto prefix = second.lookup(Lookup::Mode::Prefix, "しけ", 1);
+            ASSERT_TRUE(prefix.has_value());
+            ASSERT_EQ(prefix->matches.size(), 1);
+            EXPECT_EQ(prefix->matches[0].first, "しけん");
+        }
+
+        const auto missing = second.lookup(Lookup::Mode::Exact, "ぱ");
+        ASSERT_TRUE(missing.has_value());
+        EXPECT_TRUE(missing->ok);
+        EXPECT_TRUE(missing->matches.empty());
+    }
+
+    // Connections still open are closed when the server stops
+    Lookup::Client idle(socketPath);
+    ASSERT_TRUE(idle.lookup(Lookup::Mode::Exact, "しけん").has_value());
+    server->stop();
+    serverThread.join();
+
+    EXPECT_FALSE(idle.lookup(Lookup::Mode::Exact, "しけん").has_value());
+}
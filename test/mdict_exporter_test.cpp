@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/parsers/MDict/mdict_exporter.h"
+#include "yomitan_dictionary_builder/core/lookup_index.h"
+#include "yomitan_dictionary_builder/utils/hash.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    std::string readFile(const std::filesystem::path& filePath)
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    const std::string PAGE_CONTENT = "<div class=\"entry\"><span>実験</span>人間の行動を実験的に研究する。</div>";
+
+    // Different pages with the same 64-bit content hash
+    const std::string COLLIDING_CONTENT = "<p>4cb440bfb354fcfd</p><p>人間の行動を実験的に研究する。</p>";
+    const std::string OTHER_COLLIDING_CONTENT = "<p>9c075e80309c4b6d</p><p>人間の行動を実験的に研究する。</p>";
+}
+
+
+class MDictExporterTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() / "mdict_exporter_test";
+        std::filesystem::remove_all(directory);
+
+        dictionaryConfig.title = "test";
+        config.outputPath = directory;
+        config.descriptionPath = directory / "description.html";
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::path directory;
+    MDictConfig dictionaryConfig;
+    ParserConfig config;
+};
+
+
+TEST_F(MDictExporterTest, DuplicateContentIsLinked)
+{
+    MDictExporter exporter(dictionaryConfig, config);
+    exporter.addEntry(MDictEntry(1, {"じっけん"}, PAGE_CONTENT));
+    exporter.addEntry(MDictEntry(2, {"しけん"}, "<div>試験</div>"));
+    exporter.addEntry(MDictEntry(3, {"じっけん"}, PAGE_CONTENT));
+    exporter.checkpoint();
+
+    const std::string content = readFile(directory / "test.txt");
+    EXPECT_EQ(content, "1\n" + PAGE_CONTENT + "\n</>\n2\n<div>試験</div>\n</>\n3\n@@@LINK=1\n</>\n");
+
+    const auto stats = exporter.exportStats();
+    EXPECT_EQ(stats.totalEntries, 3);
+    EXPECT_EQ(stats.duplicateEntries, 1);
+    EXPECT_EQ(stats.duplicateBytes, PAGE_CONTENT.size() - std::string("@@@LINK=1").size());
+}
+
+TEST_F(MDictExporterTest, ResumedExportLinksToEarlierPages)
+{
+    const auto snapshot = directory / "snapshot";
+
+    MDictExporter::ExportCheckpoint checkpoint;
+    {
+        MDictExporter exporter(dictionaryConfig, config);
+        exporter.addEntry(MDictEntry(1, {"じっけん"}, PAGE_CONTENT));
+        exporter.addEntry(MDictEntry(2, {"じっけん"}, PAGE_CONTENT));
+        checkpoint = exporter.checkpoint();
+
+        // The output as an interrupted export leaves it, before the exporter finalises
+        std::filesystem::create_directories(snapshot);
+        std::filesystem::copy_file(directory / "test.txt", snapshot / "test.txt");
+        std::filesystem::copy_file(directory / "test.keys.txt", snapshot / "test.keys.txt");
+    }
+
+    std::filesystem::copy_file(snapshot / "test.txt", directory / "test.txt", std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::copy_file(snapshot / "test.keys.txt", directory / "test.keys.txt", std::filesystem::copy_options::overwrite_existing);
+
+    MDictExporter exporter(dictionaryConfig, config, checkpoint);
+    exporter.addEntry(MDictEntry(3, {"じっけん"}, PAGE_CONTENT));
+    exporter.checkpoint();
+
+    const std::string content = readFile(directory / "test.txt");
+    EXPECT_TRUE(content.ends_with("3\n@@@LINK=1\n</>\n"));
+    EXPECT_EQ(exporter.exportStats().duplicateEntries, 2);
+}
+
+TEST_F(MDictExporterTest, CollidingContentIsNotLinked)
+{
+    ASSERT_EQ(HashUtils::hash(COLLIDING_CONTENT), HashUtils::hash(OTHER_COLLIDING_CONTENT));
+
+    MDictExporter exporter(dictionaryConfig, config);
+    exporter.addEntry(MDictEntry(1, {"じっけん"}, COLLIDING_CONTENT));
+    exporter.addEntry(MDictEntry(2, {"しけん"}, OTHER_COLLIDING_CONTENT));
+    exporter.addEntry(MDictEntry(3, {"しけん"}, OTHER_COLLIDING_CONTENT));
+    exporter.addEntry(MDictEntry(4, {"じっけん"}, COLLIDING_CONTENT));
+    exporter.checkpoint();
+
+    EXPECT_EQ(readFile(directory / "test.txt"), "1\n" + COLLIDING_CONTENT + "\n</>\n2\n" + OTHER_COLLIDING_CONTENT +
+              "\n</>\n3\n@@@LINK=2\n</>\n4\n@@@LINK=1\n</>\n");
+    EXPECT_EQ(exporter.exportStats().duplicateEntries, 2);
+}
+
+TEST_F(MDictExporterTest, ResumedExportComparesCollidingContent)
+{
+    const auto snapshot = directory / "snapshot";
+
+    MDictExporter::ExportCheckpoint checkpoint;
+    {
+        MDictExporter exporter(dictionaryConfig, config);
+        exporter.addEntry(MDictEntry(1, {"じっけん"}, COLLIDING_CONTENT));
+        exporter.addEntry(MDictEntry(2, {"しけん"}, OTHER_COLLIDING_CONTENT));
+        checkpoint = exporter.checkpoint();
+
+        std::filesystem::create_directories(snapshot);
+        std::filesystem::copy_file(directory / "test.txt", snapshot / "test.txt");
+        std::filesystem::copy_file(directory / "test.keys.txt", snapshot / "test.keys.txt");
+    }
+
+    std::filesystem::copy_file(snapshot / "test.txt", directory / "test.txt", std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::copy_file(snapshot / "test.keys.txt", directory / "test.keys.txt", std::filesystem::copy_options::overwrite_existing);
+
+    // Both pages are only in the content file now, so they are read back to be compared
+    MDictExporter exporter(dictionaryConfig, config, checkpoint);
+    exporter.addEntry(MDictEntry(3, {"しけん"}, OTHER_COLLIDING_CONTENT));
+    exporter.addEntry(MDictEntry(4, {"じっけん"}, COLLIDING_CONTENT));
+    exporter.checkpoint();
+
+    const std::string content = readFile(directory / "test.txt");
+    EXPECT_TRUE(content.ends_with("3\n@@@LINK=2\n</>\n4\n@@@LINK=1\n</>\n"));
+    EXPECT_EQ(exporter.exportStats().duplicateEntries, 2);
+}
+
+TEST_F(MDictExporterTest, DeduplicationCanBeDisabled)
+{
+    dictionaryConfig.deduplicateContent = false;
+
+    MDictExporter exporter(dictionaryConfig, config);
+    exporter.addEntry(MDictEntry(1, {"じっけん"}, PAGE_CONTENT));
+    exporter.addEntry(MDictEntry(2, {"じっけん"}, PAGE_CONTENT));
+    exporter.checkpoint();
+
+    EXPECT_EQ(readFile(directory / "test.txt"), "1\n" + PAGE_CONTENT + "\n</>\n2\n" + PAGE_CONTENT + "\n</>\n");
+    EXPECT_EQ(exporter.exportStats().duplicateEntries, 0);
+}
+
+TEST_F(MDictExporterTest, LookupIndexSharesRecordsOfLinkedPages)
+{
+    config.lookupIndexPath = directory / "test.lookup";
+
+    {
+        MDictExporter exporter(dictionaryConfig, config);
+        exporter.addEntry(MDictEntry(1, {"じっけん"}, PAGE_CONTENT));
+        exporter.addEntry(MDictEntry(2, {"しけん"}, "<div>試験</div>"));
+        exporter.addEntry(MDictEntry(3, {"実験"}, PAGE_CONTENT));
+        exporter.addEntry(MDictEntry(4, {"ためし"}, "@@@LINK=2"));
+        exporter.finalize();
+    }
+
+    const LookupIndexReader index(config.lookupIndexPath.value());
+    EXPECT_EQ(index.getRecordCount(), 2);
+
+    const auto experiment = index.findExact("実験");
+    ASSERT_EQ(experiment.size(), 1);
+    EXPECT_EQ(index.getRecord(experiment[0].recordId), PAGE_CONTENT);
+    EXPECT_EQ(index.findExact("じっけん")[0].recordId, experiment[0].recordId);
+
+    const auto linked = index.findExact("ためし");
+    ASSERT_EQ(linked.size(), 1);
+    EXPECT_EQ(index.getRecord(linked[0].recordId), "<div>試験</div>");
+}
+
+TEST_F(MDictExporterTest, LookupIndexResolvesLinksAddedBeforeTheirPage)
+{
+    config.lookupIndexPath = directory / "test.lookup";
+
+    {
+        MDictExporter exporter(dictionaryConfig, config);
+        exporter.addEntry(MDictEntry(4, {"ためし"}, "@@@LINK=2"));
+        exporter.addEntry(MDictEntry(5, {"こころみ"}, "@@@LINK=2"));
+        exporter.addEntry(MDictEntry(2, {"しけん"}, "<div>試験</div>"));
+        exporter.addEntry(MDictEntry(6, {"まぼろし"}, "@@@LINK=9"));
+        exporter.finalize();
+    }
+
+    const LookupIndexReader index(config.lookupIndexPath.value());
+    ASSERT_EQ(index.getRecordCount(), 1);
+    EXPECT_EQ(index.getRecord(0), "<div>試験</div>");
+
+    for (const std::string_view key : {"ためし", "こころみ", "しけん"})
+    {
+        const auto matches = index.findExact(key);
+        ASSERT_EQ(matches.size(), 1) << key;
+        EXPECT_EQ(matches[0].recordId, 0) << key;
+    }
+
+    EXPECT_TRUE(index.findExact("まぼろし").empty());
+}
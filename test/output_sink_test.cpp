@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/utils/output_sink.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    std::string readFile(const std::filesystem::path& filePath)
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    std::string makeBuffer(const size_t index)
+    {
+        return std::string(1000 + index * 37, static_cast<char>('a' + index % 26)) + "\n";
+    }
+}
+
+
+class OutputSinkTest : public ::testing::TestWithParam<bool>
+{
+protected:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() / "output_sink_test";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+
+        options.writeBehind = GetParam();
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::path directory;
+    FileUtils::OutputSinkOptions options;
+};
+
+
+TEST_P(OutputSinkTest, BuffersAreWrittenInOrder)
+{
+    const auto filePath = directory / "out.txt";
+    std::string expected;
+
+    auto sink = FileUtils::openOutputSink(filePath, 0, options);
+    std::string buffer;
+    for (size_t i = 0; i < 200; ++i)
+    {
+        buffer = makeBuffer(i);
+        expected += buffer;
+        sink->write(buffer);
+        EXPECT_TRUE(buffer.empty());
+    }
+
+    EXPECT_EQ(sink->size(), expected.size());
+    sink->flush();
+    EXPECT_EQ(readFile(filePath), expected);
+
+    sink->close();
+    EXPECT_EQ(std::filesystem::file_size(filePath), expected.size());
+}
+
+TEST_P(OutputSinkTest, OffsetKeepsTheStartOfTheFile)
+{
+    const auto filePath = directory / "out.txt";
+    std::ofstream(filePath, std::ios::binary) << "kept|dropped";
+
+    {
+        auto sink = FileUtils::openOutputSink(filePath, 5, options);
+        EXPECT_EQ(sink->size(), 5);
+
+        std::string buffer = "appended";
+        sink->write(buffer);
+        sink->sync();
+        EXPECT_EQ(readFile(filePath), "kept|appended");
+    }
+
+    // Closed by the destructor
+    EXPECT_EQ(readFile(filePath), "kept|appended");
+}
+
+TEST_P(OutputSinkTest, SwitchingFilesFinishesThePreviousOne)
+{
+    auto sink = FileUtils::openOutputSink(directory / "first.txt", 0, options);
+
+    std::string buffer = makeBuffer(0);
+    const std::string first = buffer;
+    sink->write(buffer);
+
+    std::ofstream(directory / "second.txt", std::ios::binary) << "truncated";
+    sink->switchFile(directory / "second.txt");
+    EXPECT_EQ(readFile(directory / "first.txt"), first);
+    EXPECT_EQ(sink->size(), 0);
+
+    buffer = makeBuffer(1);
+    const std::string second = buffer;
+    sink->write(buffer);
+    EXPECT_EQ(sink->size(), second.size());
+
+    sink->close();
+    EXPECT_EQ(readFile(directory / "second.txt"), second);
+    EXPECT_EQ(readFile(directory / "first.txt"), first);
+}
+
+TEST_P(OutputSinkTest, WritingAfterCloseThrows)
+{
+    const auto filePath = directory / "out.txt";
+
+    auto sink = FileUtils::openOutputSink(filePath, 0, options);
+    sink->close();
+
+    std::string buffer = "late";
+    EXPECT_THROW(sink->write(buffer), std::runtime_error);
+}
+
+INSTANTIATE_TEST_SUITE_P(SinkModes, OutputSinkTest, ::testing::Bool(), [](const auto& info) {
+    return info.param ? "WriteBehind" : "Direct";
+});
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/core/base_parser.h"
+#include "yomitan_dictionary_builder/core/page_cache.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    std::filesystem::path makeCacheDirectory(const std::string& name)
+    {
+        const auto directory = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove_all(directory);
+        return directory;
+    }
+
+    /**
+     * Takes the output of a page from its file name, like the page ids and index keys of the real parsers
+     */
+    class PageNameParser final : public BaseParser
+    {
+    public:
+        explicit PageNameParser(const ParserConfig& config) : BaseParser(config) {}
+
+        std::vector<std::string> converted;
+        std::vector<std::string> replayed;
+
+    protected:
+        int processFile(FileUtils::PageFile& page) override
+        {
+            converted.push_back(page.path.stem().string());
+            return 1;
+        }
+
+        [[nodiscard]] bool supportsPageCache() const override { return true; }
+
+        bool endPageCapture(PageRecordWriter& record) override
+        {
+            record.writeString(converted.back());
+            return true;
+        }
+
+        bool replayPage(PageRecordReader& record) override
+        {
+            std::string name;
+            if (!record.readString(name) || !record.atEnd())
+                return false;
+
+            replayed.push_back(std::move(name));
+            return true;
+        }
+    };
+}
+
+TEST(PageCacheTest, TestRecordRoundTrip)
+{
+    PageRecordWriter writer;
+    writer.writeUint64(42);
+    writer.writeString("実験心理学");
+    writer.writeStrings({"じっけん", "", "experimental psychology"});
+    const std::string record = writer.take();
+
+    PageRecordReader reader(record);
+    uint64_t number = 0;
+    std::string text;
+    std::vector<std::string> list;
+
+    EXPECT_TRUE(reader.readUint64(number));
+    EXPECT_TRUE(reader.readString(text));
+    EXPECT_TRUE(reader.readStrings(list));
+    EXPECT_TRUE(reader.atEnd());
+
+    EXPECT_EQ(number, 42);
+    EXPECT_EQ(text, "実験心理学");
+    EXPECT_EQ(list, (std::vector<std::string>{"じっけん", "", "experimental psychology"}));
+
+    // Truncated records are rejected instead of read past the end
+    PageRecordReader truncated(std::string_view(record).substr(0, record.size() - 3));
+    EXPECT_TRUE(truncated.readUint64(number));
+    EXPECT_TRUE(truncated.readString(text));
+    EXPECT_FALSE(truncated.readStrings(list));
+}
+
+TEST(PageCacheTest, TestKeyDependsOnConfigAndName)
+{
+    const auto directory = makeCacheDirectory("page_cache_key_test");
+    const PageCache cache(directory, 1, 1024);
+    const PageCache otherConfigCache(directory, 2, 1024);
+
+    EXPECT_EQ(cache.makeKey("1.xml", "<page/>"), cache.makeKey("1.xml", "<page/>"));
+    EXPECT_NE(cache.makeKey("1.xml", "<page/>"), cache.makeKey("1.xml", "<page />"));
+    EXPECT_NE(cache.makeKey("1.xml", "<page/>"), otherConfigCache.makeKey("1.xml", "<page/>"));
+
+    // The page id and keys come from the file name, the directory does not matter
+    EXPECT_NE(cache.makeKey("1.xml", "<page/>"), cache.makeKey("2.xml", "<page/>"));
+    EXPECT_EQ(cache.makeKey("pages/1.xml", "<page/>"), cache.makeKey("moved/1.xml", "<page/>"));
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PageCacheTest, TestStoreAndLookup)
+{
+    const auto directory = makeCacheDirectory("page_cache_lookup_test");
+    PageCache cache(directory, 1, 1024 * 1024);
+
+    const std::string key = cache.makeKey("1.xml", "<page>1</page>");
+    EXPECT_FALSE(cache.lookup(key).has_value());
+
+    EXPECT_TRUE(cache.store(key, "record"));
+    EXPECT_EQ(cache.lookup(key).value_or(""), "record");
+
+    // Entries survive the cache object
+    PageCache reopened(directory, 1, 1024 * 1024);
+    EXPECT_EQ(reopened.lookup(key).value_or(""), "record");
+
+    EXPECT_EQ(cache.getStats().hits, 1);
+    EXPECT_EQ(cache.getStats().misses, 1);
+    EXPECT_EQ(cache.getStats().stored, 1);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PageCacheTest, TestCorruptEntryIsAMiss)
+{
+    const auto directory = makeCacheDirectory("page_cache_corrupt_test");
+    PageCache cache(directory, 1, 1024 * 1024);
+
+    const std::string key = cache.makeKey("1.xml", "<page>1</page>");
+    EXPECT_TRUE(cache.store(key, "record"));
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+        if (entry.is_regular_file())
+            std::ofstream(entry.path(), std::ios::app) << "garbage";
+    }
+
+    EXPECT_FALSE(cache.lookup(key).has_value());
+    EXPECT_EQ(cache.getStats().misses, 1);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PageCacheTest, TestEvictsLeastRecentlyUsed)
+{
+    const auto directory = makeCacheDirectory("page_cache_evict_test");
+    const std::string record(1000, 'x');
+
+    // Room for two entries
+    PageCache cache(directory, 1, 2100);
+
+    const std::string first = cache.makeKey("1.xml", "1");
+    const std::string second = cache.makeKey("1.xml", "2");
+    const std::string third = cache.makeKey("1.xml", "3");
+
+    EXPECT_TRUE(cache.store(first, record));
+    EXPECT_TRUE(cache.store(second, record));
+    EXPECT_TRUE(cache.store(third, record));
+
+    // Make the first entry the least recently used, then touch the third
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+        if (entry.is_regular_file())
+            std::filesystem::last_write_time(entry.path(), std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+    }
+    EXPECT_TRUE(cache.lookup(second).has_value());
+    EXPECT_TRUE(cache.lookup(third).has_value());
+
+    cache.evict();
+
+    EXPECT_EQ(cache.getStats().evicted, 1);
+    EXPECT_LE(cache.getStats().bytesOnDisk, 2100);
+    EXPECT_FALSE(cache.lookup(first).has_value());
+    EXPECT_TRUE(cache.lookup(second).has_value());
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PageCacheTest, TestPagesWithTheSameContentsKeepTheirNames)
+{
+    const auto directory = makeCacheDirectory("page_cache_name_test");
+    std::filesystem::create_directories(directory / "pages");
+    for (const auto& name : {"100.xml", "200.xml"})
+        std::ofstream(directory / "pages" / name) << "<page>同じ内容</page>";
+
+    ParserConfig config;
+    config.dictionaryPath = directory / "pages";
+    config.cacheDirectory = directory / "cache";
+    config.readAheadPages = 0;
+
+    PageNameParser firstRun(config);
+    EXPECT_EQ(firstRun.parse(), 2);
+    EXPECT_EQ(firstRun.converted, (std::vector<std::string>{"100", "200"}));
+    EXPECT_TRUE(firstRun.replayed.empty());
+
+    PageNameParser secondRun(config);
+    EXPECT_EQ(secondRun.parse(), 2);
+    EXPECT_TRUE(secondRun.converted.empty());
+    EXPECT_EQ(secondRun.replayed, (std::vector<std::string>{"100", "200"}));
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/utils/read_ahead_source.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    /**
+     * In-memory page source handing out numbered pages, some of them only as paths on disk
+     */
+    class TestPageSource final : public FileUtils::PageSource
+    {
+    public:
+        TestPageSource(const std::filesystem::path& directory, const size_t pageCount) : pageCount(pageCount)
+        {
+            std::filesystem::create_directories(directory);
+            for (size_t i = 0; i < pageCount; ++i)
+            {
+                const auto path = directory / (std::to_string(i) + ".xml");
+                if (i % 2 == 0)
+                {
+                    std::ofstream(path) << "<page>" << i << "</page>";
+                    pages.emplace_back(path);
+                }
+                else
+                {
+                    pages.emplace_back(path, "<page>" + std::to_string(i) + "</page>");
+                }
+            }
+        }
+
+        std::vector<FileUtils::PageFile> getNextBatch(const size_t batchSize) override
+        {
+            std::vector<FileUtils::PageFile> batch;
+            while (batch.size() < batchSize && index < pages.size())
+                batch.emplace_back(std::move(pages[index++]));
+            return batch;
+        }
+
+        [[nodiscard]] bool hasMore() const override { return index < pages.size(); }
+        [[nodiscard]] size_t getTotalFilesCount() const override { return pageCount; }
+
+    private:
+        std::vector<FileUtils::PageFile> pages;
+        size_t pageCount;
+        size_t index = 0;
+    };
+
+    std::vector<FileUtils::PageFile> readAll(FileUtils::PageSource& source, const size_t batchSize)
+    {
+        std::vector<FileUtils::PageFile> pages;
+        while (source.hasMore())
+        {
+            for (auto& page : source.getNextBatch(batchSize))
+                pages.emplace_back(std::move(page));
+        }
+        return pages;
+    }
+}
+
+TEST(ReadAheadSourceTest, TestPagesKeepSourceOrder)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "read_ahead_source_test";
+    constexpr size_t pageCount = 500;
+
+    FileUtils::ReadAheadPageSource source{std::make_unique<TestPageSource>(directory, pageCount), 16, 4, 1024 * 1024};
+    EXPECT_EQ(source.getTotalFilesCount(), pageCount);
+
+    const auto pages = readAll(source, 7);
+    ASSERT_EQ(pages.size(), pageCount);
+
+    for (size_t i = 0; i < pageCount; ++i)
+    {
+        EXPECT_TRUE(pages[i].loaded);
+        EXPECT_EQ(pages[i].path.stem().string(), std::to_string(i));
+        EXPECT_EQ(pages[i].contents, "<page>" + std::to_string(i) + "</page>");
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ReadAheadSourceTest, TestTinyMemoryLimit)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "read_ahead_source_limit_test";
+
+    // A limit smaller than any page still lets one page through at a time
+    FileUtils::ReadAheadPageSource source{std::make_unique<TestPageSource>(directory, 50), 8, 2, 1};
+    EXPECT_EQ(readAll(source, 3).size(), 50);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ReadAheadSourceTest, TestEmptySource)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "read_ahead_source_empty_test";
+
+    FileUtils::ReadAheadPageSource source{std::make_unique<TestPageSource>(directory, 0), 8, 2, 1024};
+    EXPECT_FALSE(source.hasMore());
+    EXPECT_TRUE(source.getNextBatch(10).empty());
+
+    std::filesystem::remove_all(directory);
+}
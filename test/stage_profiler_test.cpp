@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/utils/stage_profiler.h"
+
+#include <thread>
+
+using Profiling::LatencyHistogram;
+using Profiling::ScopedPage;
+using Profiling::ScopedStage;
+using Profiling::Stage;
+using Profiling::StageProfiler;
+
+namespace
+{
+    void busyWait(const std::chrono::microseconds duration)
+    {
+        const auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end)
+        {
+        }
+    }
+
+    const Profiling::StageReport* findStage(const Profiling::RunReport& report, const std::string_view name)
+    {
+        for (const auto& stage : report.stages)
+        {
+            if (stage.stage == name)
+                return &stage;
+        }
+        return nullptr;
+    }
+}
+
+
+class StageProfilerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        StageProfiler::resetAll(3);
+        StageProfiler::setEnabled(true);
+    }
+
+    void TearDown() override
+    {
+        StageProfiler::setEnabled(false);
+    }
+};
+
+
+TEST(LatencyHistogramTest, PercentilesAreWithinBucketError)
+{
+    LatencyHistogram histogram;
+    for (uint64_t i = 1; i <= 1000; ++i)
+    {
+        histogram.record(i * 1000);
+    }
+
+    EXPECT_EQ(histogram.getCount(), 1000);
+    EXPECT_EQ(histogram.getMax(), 1000000);
+    EXPECT_NEAR(static_cast<double>(histogram.getPercentile(50)), 500000.0, 500000.0 * 0.07);
+    EXPECT_NEAR(static_cast<double>(histogram.getPercentile(99)), 990000.0, 990000.0 * 0.07);
+    EXPECT_EQ(histogram.getPercentile(100), 1000000);
+}
+
+
+TEST(LatencyHistogramTest, MergeCombinesCounts)
+{
+    LatencyHistogram a;
+    LatencyHistogram b;
+    a.record(5);
+    b.record(1u << 20);
+
+    a.merge(b);
+    EXPECT_EQ(a.getCount(), 2);
+    EXPECT_EQ(a.getMax(), 1u << 20);
+    EXPECT_EQ(a.getPercentile(50), 5);
+}
+
+
+TEST_F(StageProfilerTest, NestedStagesAreChargedExclusively)
+{
+    {
+        ScopedPage page("page.xml", 100);
+        ScopedStage outer(Stage::SubItems);
+        busyWait(std::chrono::microseconds(2000));
+        {
+            ScopedStage inner(Stage::Serialization);
+            EXPECT_EQ(StageProfiler::forCurrentThread().getCurrentStage(), Stage::Serialization);
+            busyWait(std::chrono::microseconds(2000));
+        }
+        EXPECT_EQ(StageProfiler::forCurrentThread().getCurrentStage(), Stage::SubItems);
+    }
+    EXPECT_EQ(StageProfiler::forCurrentThread().getCurrentStage(), Stage::Count);
+
+    const auto report = StageProfiler::buildReport({.dictionary = "test", .pages = 1, .entries = 1, .wallSeconds = 1.0});
+    const auto* subItems = findStage(report, "subItems");
+    const auto* serialization = findStage(report, "serialization");
+    ASSERT_NE(subItems, nullptr);
+    ASSERT_NE(serialization, nullptr);
+
+    EXPECT_EQ(subItems->calls, 1);
+    EXPECT_GE(subItems->totalMs, 2.0);
+    EXPECT_GE(serialization->totalMs, 2.0);
+
+    // the inner stage is not counted towards the outer one
+    ASSERT_EQ(report.slowestPages.size(), 1);
+    const auto& page = report.slowestPages.front();
+    EXPECT_EQ(page.bytes, 100);
+    EXPECT_GE(page.totalMs, subItems->totalMs + serialization->totalMs);
+}
+
+
+TEST_F(StageProfilerTest, KeepsSlowestPagesAcrossThreads)
+{
+    auto convertPages = [](const std::string& prefix, const int delayMicroseconds)
+    {
+        for (int i = 1; i <= 4; ++i)
+        {
+            ScopedPage page(prefix + std::to_string(i), 10);
+            ScopedStage stage(Stage::XmlLoad);
+            busyWait(std::chrono::microseconds(delayMicroseconds * i));
+        }
+    };
+
+    // Only the worker waits, its slowest page taking 20ms against next to nothing for the main pages
+    std::thread worker(convertPages, "worker", 5000);
+    convertPages("main", 0);
+    worker.join();
+
+    const auto report = StageProfiler::buildReport({.dictionary = "test", .pages = 8, .entries = 8, .wallSeconds = 1.0});
+
+    EXPECT_EQ(report.bytes, 80);
+    ASSERT_EQ(report.slowestPages.size(), 3);
+    EXPECT_EQ(report.slowestPages[0].page, "worker4");
+    EXPECT_TRUE(report.slowestPages[0].stagesMs.contains("xmlLoad"));
+
+    const auto* xmlLoad = findStage(report, "xmlLoad");
+    ASSERT_NE(xmlLoad, nullptr);
+    EXPECT_EQ(xmlLoad->calls, 8);
+    EXPECT_GE(xmlLoad->maxMs, xmlLoad->p50Ms);
+}
+
+
+TEST(StageProfilerDisabledTest, RecordsNothingWhileDisabled)
+{
+    StageProfiler::resetAll(3);
+    StageProfiler::setEnabled(false);
+    {
+        ScopedPage page("page.xml", 100);
+        ScopedStage stage(Stage::DiskWrite);
+    }
+
+    const auto report = StageProfiler::buildReport({});
+    EXPECT_TRUE(report.stages.empty());
+    EXPECT_TRUE(report.slowestPages.empty());
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/parsers/MDict/subitem_processor.h"
+
+#include <filesystem>
+#include <sstream>
+
+namespace
+{
+    const std::string PAGE =
+        "<html><head><title>実験</title></head><body><div class=\"entry\">"
+        "<span>実験</span>人間の行動を実験的に研究する。"
+        "<SubItemG><SubItem id=\"0001-0001\"><b>実験的</b>試みとして。</SubItem>"
+        "<SubItem id=\"0001-0002\"><b>実験室</b></SubItem>"
+        "<SubItem id=\"0001-0003\"><b>未登録</b></SubItem></SubItemG>"
+        "</div></body></html>";
+
+    std::string serialize(const pugi::xml_document& doc)
+    {
+        std::ostringstream oss;
+        doc.save(oss, "", pugi::format_raw | pugi::format_no_declaration, pugi::encoding_utf8);
+        return oss.str();
+    }
+}
+
+
+class SubItemProcessorTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() / "subitem_processor_test";
+        std::filesystem::remove_all(directory);
+
+        dictionaryConfig.title = "test";
+        config.outputPath = directory;
+        config.descriptionPath = directory / "description.html";
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::path directory;
+    MDictConfig dictionaryConfig;
+    ParserConfig config;
+};
+
+
+TEST_F(SubItemProcessorTest, SubItemsAreSlicedFromThePage)
+{
+    dictionaryConfig.subElement = "SubItem";
+    const std::unordered_map<int, std::vector<std::string>> keys = {{1, {"じっけんてき"}}, {2, {"じっけんしつ"}}};
+
+    pugi::xml_document doc;
+    ASSERT_TRUE(doc.load_string(PAGE.c_str()));
+
+    MDictExporter exporter(dictionaryConfig, config);
+    SubItemProcessor processor(dictionaryConfig);
+    EXPECT_EQ(processor.markSubItems(doc, keys, 12), 2);
+
+    exporter.beginCapture();
+    const std::string content(processor.extractSubItems(serialize(doc), exporter));
+    const auto entries = exporter.endCapture();
+
+    EXPECT_EQ(content,
+        "<html><head><title>実験</title></head><body><div class=\"entry\">"
+        "<span>実験</span>人間の行動を実験的に研究する。<SubItemG></SubItemG></div></body></html>");
+
+    ASSERT_EQ(entries.size(), 2);
+    const std::string prefix = "<html><head><title>実験</title></head><body><div><SubItemG>";
+    const std::string suffix = "</SubItemG></div></body></html>";
+
+    EXPECT_EQ(entries[0].pageId, 8012001);
+    EXPECT_EQ(entries[0].keys, std::vector<std::string>{"じっけんてき"});
+    EXPECT_EQ(entries[0].content, prefix + "<b>実験的</b>試みとして。" + suffix);
+
+    EXPECT_EQ(entries[1].pageId, 8012002);
+    EXPECT_EQ(entries[1].content, prefix + "<b>実験室</b>" + suffix);
+}
+
+TEST_F(SubItemProcessorTest, SubItemGroupIsLeftOutWithoutSubElement)
+{
+    pugi::xml_document doc;
+    ASSERT_TRUE(doc.load_string(PAGE.c_str()));
+
+    MDictExporter exporter(dictionaryConfig, config);
+    SubItemProcessor processor(dictionaryConfig);
+    EXPECT_EQ(processor.markSubItems(doc, {}, 12), 0);
+
+    exporter.beginCapture();
+    const std::string content(processor.extractSubItems(serialize(doc), exporter));
+    EXPECT_TRUE(exporter.endCapture().empty());
+
+    EXPECT_EQ(content,
+        "<html><head><title>実験</title></head><body><div class=\"entry\">"
+        "<span>実験</span>人間の行動を実験的に研究する。</div></body></html>");
+}
+
+TEST_F(SubItemProcessorTest, ForeignProcessingInstructionsAreKept)
+{
+    MDictExporter exporter(dictionaryConfig, config);
+    SubItemProcessor processor(dictionaryConfig);
+
+    pugi::xml_document doc;
+    ASSERT_TRUE(doc.load_string("<div>a<?ydb-other?>b</div>", pugi::parse_default | pugi::parse_pi));
+    EXPECT_EQ(processor.markSubItems(doc, {}, 1), 0);
+
+    EXPECT_EQ(processor.extractSubItems(serialize(doc), exporter), "<div>a<?ydb-other?>b</div>");
+}
+
+TEST_F(SubItemProcessorTest, PagesWithoutMarkersAreNotCopied)
+{
+    MDictExporter exporter(dictionaryConfig, config);
+    SubItemProcessor processor(dictionaryConfig);
+
+    pugi::xml_document doc;
+    ASSERT_TRUE(doc.load_string("<div>実験</div>"));
+    EXPECT_EQ(processor.markSubItems(doc, {}, 1), 0);
+
+    const std::string page = serialize(doc);
+    const std::string_view content = processor.extractSubItems(page, exporter);
+    EXPECT_EQ(content.data(), page.data());
+    EXPECT_EQ(content, page);
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/core/dictionary/common.h"
+#include "yomitan_dictionary_builder/core/dictionary/html_element.h"
+
+#include <thread>
+
+TEST(SymbolTableTest, InternsEachNameOnce)
+{
+    const Symbol headword("見出しG");
+    const Symbol again(std::string("見出し") + "G");
+
+    EXPECT_EQ(headword, again);
+    EXPECT_EQ(headword.view(), "見出しG");
+    EXPECT_NE(headword, Symbol("KoKomoku"));
+    EXPECT_EQ(Symbol().view(), "");
+}
+
+TEST(SymbolTableTest, AllowedElementsArePreinterned)
+{
+    for (const auto& element : Yomitan::allowedElements)
+        EXPECT_TRUE(Symbol::find(element).has_value()) << element;
+
+    EXPECT_FALSE(Symbol::find("symbol_table_test_never_interned").has_value());
+}
+
+TEST(SymbolTableTest, ConcurrentInterningAgrees)
+{
+    std::vector<uint32_t> ids(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        threads.emplace_back([&ids, i] {
+            for (int n = 0; n < 1000; ++n)
+                Symbol("symbol_" + std::to_string(n));
+            ids[i] = Symbol("symbol_999").getId();
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    for (const auto id : ids)
+        EXPECT_EQ(id, ids.front());
+}
+
+TEST(SymbolTableTest, ElementsResolveTheirTags)
+{
+    HTMLElement element("ruby");
+    EXPECT_EQ(element.getTag(), "ruby");
+    EXPECT_EQ(element.getTagSymbol(), Symbol("ruby"));
+
+    element.setTag("rt");
+    EXPECT_EQ(element.getTag(), "rt");
+}
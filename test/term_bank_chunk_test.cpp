@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/core/dictionary/term_bank_chunk.h"
+
+namespace
+{
+    std::unique_ptr<DicEntry> makeEntry(const std::string& term, const std::string& reading, const std::string& text)
+    {
+        auto entry = std::make_unique<DicEntry>(term, reading);
+        entry->setInfoTag("名");
+        entry->setPosTag("\"引用\"\n");
+        entry->setSearchRank(-3);
+        entry->setSequenceNumber(1234567890123);
+
+        const auto root = std::make_shared<HTMLElement>("div");
+        root->setData({{"meaning", ""}});
+        root->addContent(std::make_shared<HTMLElement>("span", text));
+        entry->addElement(root);
+        return entry;
+    }
+}
+
+
+TEST(TermBankChunkTest, WritesTheSameJsonAsTheEntries)
+{
+    std::vector<std::unique_ptr<DicEntry>> entries;
+    entries.push_back(makeEntry("実験", "じっけん", "人間の行動を実験的に研究する。"));
+    entries.push_back(makeEntry("試験", "", "\\ と \t を含む"));
+
+    TermBankChunk chunk;
+    for (const auto& entry : entries)
+        chunk.addEntry(*entry);
+
+    std::string expected;
+    ASSERT_FALSE(glz::write_json(entries, expected));
+
+    std::string json;
+    chunk.writeJson(json);
+    EXPECT_EQ(json, expected);
+}
+
+TEST(TermBankChunkTest, SerializedEntriesWriteTheSameJson)
+{
+    const auto entry = makeEntry("実験", "じっけん", "人間の行動を実験的に研究する。");
+
+    const SerializedEntry serialized = TermBankChunk::serialize(*entry);
+    EXPECT_EQ(serialized.term, "実験");
+    EXPECT_EQ(serialized.posTag, "\"引用\"\n");
+    EXPECT_EQ(serialized.searchRank, -3);
+    EXPECT_EQ(serialized.sequenceNumber, 1234567890123);
+    EXPECT_EQ(serialized.estimatedSize, entry->estimateSerializedSize());
+
+    TermBankChunk fromEntry;
+    fromEntry.addEntry(*entry);
+    TermBankChunk fromSerialized;
+    fromSerialized.addEntry(serialized);
+
+    std::string expected;
+    fromEntry.writeJson(expected);
+    std::string json;
+    fromSerialized.writeJson(json);
+    EXPECT_EQ(json, expected);
+}
+
+TEST(TermBankChunkTest, KeepsEntriesInOrderAcrossClears)
+{
+    TermBankChunk chunk;
+    EXPECT_TRUE(chunk.empty());
+
+    std::string json;
+    chunk.writeJson(json);
+    EXPECT_EQ(json, "[]");
+
+    for (int round = 0; round < 2; ++round)
+    {
+        chunk.addEntry(TermBankChunk::serialize(*makeEntry("一", "いち", "一")));
+        chunk.addEntry(*makeEntry("実験", "じっけん", "実験"));
+        chunk.addEntry(TermBankChunk::serialize(*makeEntry("二", "に", "二")));
+
+        ASSERT_EQ(chunk.size(), 3);
+        EXPECT_EQ(chunk.getTerm(0), "一");
+        EXPECT_EQ(chunk.getTerm(1), "実験");
+        EXPECT_EQ(chunk.getReading(1), "じっけん");
+        EXPECT_EQ(chunk.getTerm(2), "二");
+        EXPECT_EQ(chunk.getReading(2), "に");
+
+        chunk.clear();
+        EXPECT_TRUE(chunk.empty());
+    }
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/utils/trace_recorder.h"
+
+#include <algorithm>
+#include <thread>
+
+using Profiling::ScopedTrace;
+using Profiling::TraceRecorder;
+
+namespace
+{
+    std::vector<const Profiling::TraceEventJson*> findEvents(const Profiling::TraceFile& trace, const std::string_view name)
+    {
+        std::vector<const Profiling::TraceEventJson*> events;
+        for (const auto& event : trace.traceEvents)
+        {
+            if (event.name == name)
+                events.push_back(&event);
+        }
+        return events;
+    }
+}
+
+
+class TraceRecorderTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        TraceRecorder::clearAll();
+        TraceRecorder::setEnabled(true);
+    }
+
+    void TearDown() override
+    {
+        TraceRecorder::setEnabled(false);
+    }
+};
+
+
+TEST_F(TraceRecorderTest, RecordsNestedEventsInOrder)
+{
+    TraceRecorder::setThreadName("parser");
+    {
+        ScopedTrace batch("batch", "parser");
+        {
+            ScopedTrace page("processFile", "parser");
+            ASSERT_TRUE(page.isActive());
+            page.setDetail("0000000001.xml");
+        }
+        ScopedTrace flush("flushChunk", "dictionary");
+    }
+    TraceRecorder::setEnabled(false);
+
+    const auto trace = TraceRecorder::buildTrace();
+
+    const auto batches = findEvents(trace, "batch");
+    const auto pages = findEvents(trace, "processFile");
+    ASSERT_EQ(batches.size(), 1);
+    ASSERT_EQ(pages.size(), 1);
+
+    EXPECT_EQ(batches[0]->ph, "X");
+    EXPECT_EQ(batches[0]->cat, "parser");
+    EXPECT_EQ(pages[0]->args.at("detail"), "0000000001.xml");
+    EXPECT_EQ(pages[0]->tid, batches[0]->tid);
+
+    // The page lies within the batch, which is listed first
+    EXPECT_LE(batches[0]->ts, pages[0]->ts);
+    EXPECT_GE(batches[0]->ts + batches[0]->dur.value(), pages[0]->ts + pages[0]->dur.value());
+    EXPECT_LT(batches[0] - trace.traceEvents.data(), pages[0] - trace.traceEvents.data());
+
+    const auto names = findEvents(trace, "thread_name");
+    ASSERT_FALSE(names.empty());
+    EXPECT_EQ(names[0]->ph, "M");
+    EXPECT_TRUE(std::ranges::any_of(names, [](const auto* event) { return event->args.at("name") == "parser"; }));
+}
+
+TEST_F(TraceRecorderTest, SeparatesThreads)
+{
+    std::thread reader([] {
+        TraceRecorder::setThreadName("readAhead");
+        ScopedTrace trace("readPage", "readAhead");
+    });
+    reader.join();
+
+    {
+        ScopedTrace trace("batch", "parser");
+    }
+    TraceRecorder::setEnabled(false);
+
+    const auto trace = TraceRecorder::buildTrace();
+    const auto reads = findEvents(trace, "readPage");
+    const auto batches = findEvents(trace, "batch");
+    ASSERT_EQ(reads.size(), 1);
+    ASSERT_EQ(batches.size(), 1);
+    EXPECT_NE(reads[0]->tid, batches[0]->tid);
+}
+
+TEST_F(TraceRecorderTest, DisabledRecordsNothing)
+{
+    TraceRecorder::setEnabled(false);
+    {
+        ScopedTrace trace("batch", "parser");
+        EXPECT_FALSE(trace.isActive());
+    }
+
+    EXPECT_TRUE(findEvents(TraceRecorder::buildTrace(), "batch").empty());
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/utils/xml_loader.h"
+
+namespace
+{
+    std::string makePage(const std::string& headword, const size_t meanings)
+    {
+        std::string page = "<entry><headword>" + headword + "</headword>";
+        for (size_t i = 0; i < meanings; ++i)
+            page += "<meaning>" + std::to_string(i) + "</meaning>";
+        return page + "</entry>";
+    }
+}
+
+
+TEST(XMLLoaderTest, DocumentsOutsideTheScopeSurviveTheNextPage)
+{
+    XMLLoader& loader = XMLLoader::forCurrentThread();
+
+    {
+        const XMLLoader::ArenaScope scope(loader, true);
+        std::string page = makePage("一", 10);
+        ASSERT_NE(loader.loadBuffer(page, "first.xml"), nullptr);
+    }
+
+    // Allocated from the heap, so reusing the arena for the next page leaves it alone
+    pugi::xml_document kept;
+    kept.append_child("kept").text().set("残る");
+
+    {
+        const XMLLoader::ArenaScope scope(loader, true);
+        std::string page = makePage("二", 10000);
+        const pugi::xml_document* document = loader.loadBuffer(page, "second.xml");
+        ASSERT_NE(document, nullptr);
+        EXPECT_STREQ(document->child("entry").child("headword").text().get(), "二");
+    }
+
+    EXPECT_STREQ(kept.child("kept").text().get(), "残る");
+}
+
+TEST(XMLLoaderTest, LoadsWithoutAScope)
+{
+    XMLLoader& loader = XMLLoader::forCurrentThread();
+
+    std::string page = makePage("三", 3);
+    const pugi::xml_document* document = loader.loadBuffer(page, "third.xml");
+    ASSERT_NE(document, nullptr);
+    EXPECT_STREQ(document->child("entry").child("headword").text().get(), "三");
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/core/xml_parser.h"
+
+#include <filesystem>
+
+namespace
+{
+    /**
+     * Exposes the conversion functions of XMLParser without a dictionary behind it
+     */
+    class TestParser final : public XMLParser
+    {
+    public:
+        explicit TestParser(const ParserConfig& config) : XMLParser(config) {}
+
+        using XMLParser::convertElementToYomitan;
+        using XMLParser::getClassList;
+
+    protected:
+        int processFile([[maybe_unused]] FileUtils::PageFile& page) override
+        {
+            return 0;
+        }
+    };
+}
+
+
+class XMLParserTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() / "xml_parser_test";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory / "pages");
+
+        config.dictionaryPath = directory / "pages";
+        config.readAheadPages = 0;
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::path directory;
+    ParserConfig config;
+};
+
+
+TEST_F(XMLParserTest, SplitsEveryClass)
+{
+    pugi::xml_document document;
+    ASSERT_TRUE(document.load_string(R"(<div class="  meaning sub-head&#9;level-1 "/>)"));
+
+    const auto classList = TestParser::getClassList(document.first_child());
+    ASSERT_EQ(classList.size(), 3);
+    EXPECT_EQ(classList.getClasses()[0], "meaning");
+    EXPECT_EQ(classList.getClasses()[1], "sub-head");
+    EXPECT_EQ(classList.getClasses()[2], "level-1");
+
+    EXPECT_TRUE(TestParser::getClassList(document.append_child("span")).empty());
+}
+
+TEST_F(XMLParserTest, KeepsClassesBeyondInlineCapacity)
+{
+    std::string classes;
+    for (size_t i = 0; i < ClassList::INLINE_CLASSES + 3; ++i)
+        classes += "c" + std::to_string(i) + " ";
+
+    const ClassList classList(classes);
+    ASSERT_EQ(classList.size(), ClassList::INLINE_CLASSES + 3);
+    EXPECT_EQ(classList.getClasses().front(), "c0");
+    EXPECT_EQ(classList.getClasses().back(), "c10");
+}
+
+TEST_F(XMLParserTest, ConvertsClassesAndAttributesToData)
+{
+    const TestParser parser(config);
+
+    pugi::xml_document document;
+    ASSERT_TRUE(document.load_string(R"(<div class="meaning sub-head" data-level="1" alt="ignored">text</div>)"));
+
+    const auto element = parser.convertElementToYomitan(document.first_child());
+    ASSERT_NE(element, nullptr);
+
+    const auto& data = element->getData();
+    ASSERT_TRUE(data.has_value());
+    EXPECT_NE(data->find("meaning"), nullptr);
+    EXPECT_NE(data->find("sub_head"), nullptr);
+    EXPECT_EQ(*data->find("data_level"), "1");
+    EXPECT_EQ(data->find("alt"), nullptr);
+}
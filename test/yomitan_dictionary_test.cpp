@@ -0,0 +1,350 @@
+#include <gtest/gtest.h>
+#include "yomitan_dictionary_builder/core/dictionary/yomitan_dictionary.h"
+#include "yomitan_dictionary_builder/core/lookup_index.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    std::unique_ptr<DicEntry> makeEntry(const size_t sections)
+    {
+        auto entry = std::make_unique<DicEntry>("実験", "じっけん");
+
+        const auto root = std::make_shared<HTMLElement>("div");
+        for (size_t i = 0; i < sections; ++i)
+        {
+            const auto section = std::make_shared<HTMLElement>("div");
+            section->setData({{"meaning", ""}, {"level", std::to_string(i % 3)}});
+            section->addContent(std::make_shared<HTMLElement>("span", std::to_string(i + 1)));
+            section->addContent("人間の行動を実験的に研究する心理学の一分野。");
+
+            const auto link = std::make_shared<HTMLElement>("a", "参照");
+            link->setHref("?query=実験&wildcards=off");
+            section->addContent(link);
+
+            root->addContent(section);
+        }
+
+        entry->addElement(root);
+        entry->setSequenceNumber(static_cast<long>(sections));
+        return entry;
+    }
+
+    std::vector<std::filesystem::path> getTermBanks(const std::filesystem::path& directory)
+    {
+        std::vector<std::filesystem::path> termBanks;
+        for (const auto& file : std::filesystem::directory_iterator(directory))
+        {
+            if (file.path().filename().string().starts_with("term_bank_"))
+                termBanks.push_back(file.path());
+        }
+        std::ranges::sort(termBanks);
+        return termBanks;
+    }
+
+    std::string readFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::ostringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+}
+
+
+TEST(YomitanDictionaryTest, EstimatedSizeIsCloseToSerializedSize)
+{
+    for (const size_t sections : {1, 10, 100})
+    {
+        const auto entry = makeEntry(sections);
+
+        std::string json;
+        ASSERT_FALSE(glz::write_json(*entry, json));
+
+        const auto estimate = static_cast<double>(entry->estimateSerializedSize());
+        EXPECT_NEAR(estimate, static_cast<double>(json.size()), static_cast<double>(json.size()) * 0.1) << sections << " sections";
+    }
+}
+
+TEST(YomitanDictionaryTest, ChunksAreBoundedByBytes)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "yomitan_dictionary_chunk_test";
+    std::filesystem::remove_all(directory);
+
+    const size_t entrySize = makeEntry(20)->estimateSerializedSize();
+
+    YomitanDictionaryConfig config;
+    config.title = "test";
+    config.formatPretty = false;
+    config.CHUNK_SIZE = 1000;
+    config.CHUNK_BYTES = entrySize * 10;
+    config.tempDir = directory;
+    config.foldDuplicates = false;
+
+    {
+        YomitanDictionary dictionary(config);
+        for (size_t i = 0; i < 95; ++i)
+            ASSERT_TRUE(dictionary.addEntry(makeEntry(20)));
+        ASSERT_TRUE(dictionary.flush());
+    }
+
+    // 10 entries per term bank instead of the 1000 entry limit
+    const auto termBanks = getTermBanks(directory);
+    EXPECT_EQ(termBanks.size(), 10);
+    for (const auto& termBank : termBanks)
+        EXPECT_LE(std::filesystem::file_size(termBank), config.CHUNK_BYTES * 11 / 10);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(YomitanDictionaryTest, EntryLimitStillApplies)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "yomitan_dictionary_entry_limit_test";
+    std::filesystem::remove_all(directory);
+
+    YomitanDictionaryConfig config;
+    config.title = "test";
+    config.CHUNK_SIZE = 5;
+    config.tempDir = directory;
+    config.foldDuplicates = false;
+
+    {
+        YomitanDictionary dictionary(config);
+        for (size_t i = 0; i < 12; ++i)
+            ASSERT_TRUE(dictionary.addEntry(makeEntry(1)));
+        ASSERT_TRUE(dictionary.flush());
+    }
+
+    EXPECT_EQ(getTermBanks(directory).size(), 3);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(YomitanDictionaryTest, ContentHashIgnoresDataOrderAndSequenceNumber)
+{
+    const auto entry = makeEntry(3);
+
+    auto reordered = std::make_unique<DicEntry>("実験", "じっけん");
+    const auto root = std::make_shared<HTMLElement>("div");
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const auto section = std::make_shared<HTMLElement>("div");
+        section->setData({{"level", std::to_string(i % 3)}, {"meaning", ""}});
+        section->addContent(std::make_shared<HTMLElement>("span", std::to_string(i + 1)));
+        section->addContent("人間の行動を実験的に研究する心理学の一分野。");
+
+        const auto link = std::make_shared<HTMLElement>("a", "参照");
+        link->setHref("?query=実験&wildcards=off");
+        section->addContent(link);
+
+        root->addContent(section);
+    }
+    reordered->addElement(root);
+    reordered->setSequenceNumber(42);
+
+    EXPECT_EQ(entry->getContentHash(), reordered->getContentHash());
+
+    const auto otherReading = std::make_unique<DicEntry>("実験", "じっけんてき");
+    otherReading->addElement(root);
+    EXPECT_NE(reordered->getContentHash(), otherReading->getContentHash());
+
+    EXPECT_NE(makeEntry(3)->getContentHash(), makeEntry(4)->getContentHash());
+}
+
+TEST(YomitanDictionaryTest, FoldsDuplicateEntries)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "yomitan_dictionary_fold_test";
+    std::filesystem::remove_all(directory);
+
+    YomitanDictionaryConfig config;
+    config.title = "test";
+    config.tempDir = directory;
+
+    const size_t entrySize = makeEntry(2)->estimateSerializedSize();
+
+    {
+        YomitanDictionary dictionary(config);
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(1)));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(2)));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(2)));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(2)));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(3)));
+
+        EXPECT_EQ(dictionary.getEntryCount(), 3);
+        EXPECT_EQ(dictionary.getDuplicateStats().entries, 2);
+        EXPECT_EQ(dictionary.getDuplicateStats().bytes, entrySize * 2);
+        ASSERT_TRUE(dictionary.flush());
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(YomitanDictionaryTest, ReplayedEntriesKeepTheirOrder)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "yomitan_dictionary_replay_test";
+    std::filesystem::remove_all(directory);
+
+    YomitanDictionaryConfig config;
+    config.title = "test";
+    config.CHUNK_SIZE = 4;
+
+    // Converted pages around a cached one, which is captured on the cold run and replayed on the next
+    CapturedEntries captured;
+    std::vector<std::string> coldTermBanks;
+    {
+        config.tempDir = directory / "cold";
+        YomitanDictionary dictionary(config);
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(1)));
+        dictionary.beginCapture();
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(2)));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(1)));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(3)));
+        captured = dictionary.endCapture();
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(4)));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(5)));
+        ASSERT_TRUE(dictionary.flush());
+
+        for (const auto& termBank : getTermBanks(*config.tempDir))
+            coldTermBanks.push_back(readFile(termBank));
+    }
+
+    ASSERT_EQ(captured.entries.size(), 3);
+    ASSERT_EQ(captured.contentHashes.size(), 3);
+    EXPECT_EQ(captured.entries[1].sequenceNumber, 1);
+
+    {
+        config.tempDir = directory / "cached";
+        YomitanDictionary dictionary(config);
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(1)));
+        for (size_t i = 0; i < captured.entries.size(); ++i)
+            ASSERT_TRUE(dictionary.addSerializedEntry(captured.entries[i], captured.contentHashes[i]));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(4)));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(5)));
+
+        EXPECT_EQ(dictionary.getEntryCount(), 5);
+        EXPECT_EQ(dictionary.getDuplicateStats().entries, 1);
+        ASSERT_TRUE(dictionary.flush());
+
+        std::vector<std::string> cachedTermBanks;
+        for (const auto& termBank : getTermBanks(*config.tempDir))
+            cachedTermBanks.push_back(readFile(termBank));
+        EXPECT_EQ(cachedTermBanks, coldTermBanks);
+    }
+
+    EXPECT_EQ(coldTermBanks.size(), 2);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(YomitanDictionaryTest, CheckpointRestoresContentHashes)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "yomitan_dictionary_fold_checkpoint_test";
+    std::filesystem::remove_all(directory);
+
+    YomitanDictionaryConfig config;
+    config.title = "test";
+    config.tempDir = directory;
+
+    std::vector<int> termBanks;
+    size_t entryCount = 0;
+    {
+        YomitanDictionary dictionary(config);
+        ASSERT_TRUE(dictionary.restoreCheckpoint({}, 0));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(1)));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(2)));
+
+        const auto checkpoint = dictionary.checkpoint();
+        ASSERT_TRUE(checkpoint.has_value());
+        termBanks = checkpoint.value();
+        entryCount = dictionary.getEntryCount();
+
+        // Added after the checkpoint, so forgotten on restore
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(3)));
+        ASSERT_TRUE(dictionary.checkpoint().has_value());
+    }
+
+    {
+        YomitanDictionary dictionary(config);
+        ASSERT_TRUE(dictionary.restoreCheckpoint(termBanks, entryCount));
+
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(2)));
+        ASSERT_TRUE(dictionary.addEntry(makeEntry(3)));
+        EXPECT_EQ(dictionary.getDuplicateStats().entries, 1);
+        EXPECT_EQ(dictionary.getEntryCount(), entryCount + 1);
+        ASSERT_TRUE(dictionary.flush());
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(YomitanDictionaryTest, LookupIndexFindsEntriesByTermAndReading)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "yomitan_dictionary_lookup_index_test";
+    std::filesystem::remove_all(directory);
+
+    YomitanDictionaryConfig config;
+    config.title = "test";
+    config.tempDir = directory / "temp";
+    config.CHUNK_SIZE = 2;
+    config.lookupIndexPath = directory / "test.lookup";
+
+    {
+        YomitanDictionary dictionary(config);
+        ASSERT_TRUE(dictionary.addEntry(std::make_unique<DicEntry>("実験", "じっけん")));
+        ASSERT_TRUE(dictionary.addEntry(std::make_unique<DicEntry>("試験", "しけん")));
+        ASSERT_TRUE(dictionary.addEntry(std::make_unique<DicEntry>("テスト", "")));
+        ASSERT_TRUE(dictionary.exportDictionary((directory / "test/").string()));
+    }
+
+    const LookupIndexReader index(directory / "test.lookup");
+    EXPECT_EQ(index.getRecordCount(), 3);
+    EXPECT_EQ(index.getKeyCount(), 5);
+
+    const auto experiment = index.findKanaInsensitive("ジッケン");
+    ASSERT_EQ(experiment.size(), 1);
+    EXPECT_EQ(experiment[0].key, "じっけん");
+    EXPECT_EQ(index.findExact("実験")[0].recordId, experiment[0].recordId);
+    EXPECT_NE(index.findExact("試験")[0].recordId, experiment[0].recordId);
+    EXPECT_EQ(index.findExact("テスト")[0].recordId, 2);
+    EXPECT_FALSE(index.getRecord(experiment[0].recordId).empty());
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(YomitanDictionaryTest, ResumedConversionWritesNoLookupIndex)
+{
+    const auto directory = std::filesystem::temp_directory_path() / "yomitan_dictionary_resumed_lookup_index_test";
+    std::filesystem::remove_all(directory);
+
+    YomitanDictionaryConfig config;
+    config.title = "test";
+    config.tempDir = directory / "temp";
+    config.lookupIndexPath = directory / "test.lookup";
+
+    std::vector<int> termBanks;
+    size_t entryCount = 0;
+    {
+        YomitanDictionary dictionary(config);
+        ASSERT_TRUE(dictionary.restoreCheckpoint({}, 0));
+        ASSERT_TRUE(dictionary.addEntry(std::make_unique<DicEntry>("実験", "じっけん")));
+
+        const auto checkpoint = dictionary.checkpoint();
+        ASSERT_TRUE(checkpoint.has_value());
+        termBanks = checkpoint.value();
+        entryCount = dictionary.getEntryCount();
+    }
+
+    // The index can't continue from the checkpoint
+    {
+        YomitanDictionary dictionary(config);
+        ASSERT_TRUE(dictionary.restoreCheckpoint(termBanks, entryCount));
+        ASSERT_TRUE(dictionary.addEntry(std::make_unique<DicEntry>("試験", "しけん")));
+        ASSERT_TRUE(dictionary.exportDictionary((directory / "test/").string()));
+    }
+
+    EXPECT_FALSE(std::filesystem::exists(directory / "test.lookup"));
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,95 @@
+#include "yomitan_dictionary_builder/config/config_loader.h"
+#include "yomitan_dictionary_builder/core/entry_store.h"
+#include "yomitan_dictionary_builder/parsers/MDict/mdict_exporter.h"
+
+#include <iostream>
+#include <string_view>
+
+namespace
+{
+    void printUsage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " --config <dictionaries.yaml> --dictionary <name> [--store <path>]"
+                  << " [--yomitan <output directory>] [--mdict]" << std::endl;
+    }
+}
+
+
+int main(const int argc, char* argv[])
+{
+    std::filesystem::path configPath;
+    std::string dictionaryName;
+    std::optional<std::filesystem::path> storePath;
+    std::optional<std::filesystem::path> yomitanOutput;
+    bool emitMDict = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--config" && hasValue)
+            configPath = argv[++i];
+        else if (argument == "--dictionary" && hasValue)
+            dictionaryName = argv[++i];
+        else if (argument == "--store" && hasValue)
+            storePath = argv[++i];
+        else if (argument == "--yomitan" && hasValue)
+            yomitanOutput = argv[++i];
+        else if (argument == "--mdict")
+            emitMDict = true;
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (configPath.empty() || dictionaryName.empty() || (!yomitanOutput.has_value() && !emitMDict))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        const auto configLoader = ConfigLoader::loadFromFile(configPath);
+        auto [yomitanConfig, mDictConfig, parserConfig] = configLoader.getDictionaryConfig(dictionaryName);
+
+        if (!storePath.has_value())
+            storePath = parserConfig.entryStorePath;
+
+        if (!storePath.has_value())
+        {
+            std::cerr << "No entry store given and no entryStorePath configured for " << dictionaryName << std::endl;
+            return 1;
+        }
+
+        const EntryStoreReader store(storePath.value());
+        std::cout << "Read " << store.size() << " entries from " << storePath->string() << std::endl;
+
+        if (yomitanOutput.has_value())
+        {
+            YomitanDictionary dictionary(yomitanConfig);
+            if (!store.emit(dictionary) || !dictionary.exportDictionary(yomitanOutput->string()))
+                return 1;
+        }
+
+        if (emitMDict)
+        {
+            MDictExporter exporter(mDictConfig, parserConfig);
+            exporter.addStoredEntries(store);
+            exporter.finalize();
+
+            const auto stats = exporter.exportStats();
+            std::cout << "Exported " << stats.totalEntries << " MDict entries with " << stats.totalKeys << " keys" << std::endl;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "yomitan_dictionary_builder/utils/corpus_generator.h"
+
+#include <iostream>
+#include <string_view>
+
+namespace
+{
+    void printUsage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " --output <directory> [--pages <n>] [--seed <n>]"
+                  << " [--max-sections <n>] [--max-subitems <n>] [--images <n>] [--no-assets]" << std::endl;
+    }
+}
+
+
+int main(const int argc, char* argv[])
+{
+    CorpusOptions options;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view argument = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (argument == "--output" && hasValue)
+                options.outputDirectory = argv[++i];
+            else if (argument == "--pages" && hasValue)
+                options.pageCount = std::stoull(argv[++i]);
+            else if (argument == "--seed" && hasValue)
+                options.seed = std::stoull(argv[++i]);
+            else if (argument == "--max-sections" && hasValue)
+                options.maxSections = std::stoull(argv[++i]);
+            else if (argument == "--max-subitems" && hasValue)
+                options.maxSubItems = std::stoull(argv[++i]);
+            else if (argument == "--images" && hasValue)
+                options.imageCount = std::stoull(argv[++i]);
+            else if (argument == "--no-assets")
+                options.writeAssets = false;
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (options.outputDirectory.empty())
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    CorpusGenerator generator(options);
+    if (!generator.generate())
+        return 1;
+
+    const auto& stats = generator.getStats();
+    std::cout << "Generated " << stats.pages << " pages (" << stats.pageBytes / (1024 * 1024) << " MiB), "
+              << stats.indexKeys << " index keys, " << stats.subItems << " sub items, "
+              << stats.imageReferences << " image and " << stats.audioReferences << " audio references" << std::endl;
+    std::cout << "Config: " << (options.outputDirectory / "corpus.yaml").string() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "yomitan_dictionary_builder/lookup/lookup_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+    void printUsage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " --socket <path> --index <lookup index> [--mode <exact|prefix|kana>]"
+                  << " [--connections <n>] [--seconds <n>] [--keys <n>]" << std::endl;
+    }
+
+    double percentile(const std::vector<uint64_t>& sorted, const double fraction)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        const auto index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1));
+        return static_cast<double>(sorted[index]) / 1000.0;
+    }
+}
+
+
+int main(const int argc, char* argv[])
+{
+    std::filesystem::path socketPath;
+    std::filesystem::path indexPath;
+    Lookup::Mode mode = Lookup::Mode::Exact;
+    size_t connections = 4;
+    size_t seconds = 10;
+    size_t keySample = 100000;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view argument = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (argument == "--socket" && hasValue)
+                socketPath = argv[++i];
+            else if (argument == "--index" && hasValue)
+                indexPath = argv[++i];
+            else if (argument == "--mode" && hasValue)
+                mode = Lookup::parseMode(argv[++i]).value();
+            else if (argument == "--connections" && hasValue)
+                connections = std::max<size_t>(std::stoull(argv[++i]), 1);
+            else if (argument == "--seconds" && hasValue)
+                seconds = std::stoull(argv[++i]);
+            else if (argument == "--keys" && hasValue)
+                keySample = std::max<size_t>(std::stoull(argv[++i]), 1);
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (socketPath.empty() || indexPath.empty())
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        // Requests use keys of the served dictionary, picked evenly over the sorted keys
+        std::vector<std::string> keys;
+        {
+            const LookupIndexReader index(indexPath);
+            const size_t keyCount = index.getKeyCount();
+            if (keyCount == 0)
+            {
+                std::cerr << "The lookup index has no keys" << std::endl;
+                return 1;
+            }
+
+            const size_t step = std::max<size_t>(keyCount / keySample, 1);
+            for (size_t i = 0; i < keyCount && keys.size() < keySample; i += step)
+                keys.emplace_back(index.getKey(i).key);
+        }
+
+        std::vector<std::unique_ptr<Lookup::Client>> clients;
+        for (size_t i = 0; i < connections; ++i)
+            clients.push_back(std::make_unique<Lookup::Client>(socketPath));
+
+        // Every connection sends its next request once the previous one is answered
+        std::vector<std::vector<uint64_t>> latencies(connections);
+        std::atomic<bool> failed = false;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < connections; ++i)
+        {
+            workers.emplace_back([&, i] {
+                std::mt19937_64 random(i);
+                std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+
+                while (!failed && std::chrono::steady_clock::now() < deadline)
+                {
+                    const auto start = std::chrono::steady_clock::now();
+                    const auto response = clients[i]->lookup(mode, keys[pick(random)]);
+                    const auto end = std::chrono::steady_clock::now();
+
+                    if (!response.has_value() || !response->ok)
+                    {
+                        failed = true;
+                        return;
+                    }
+
+                    latencies[i].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                }
+            });
+        }
+
+        for (auto& worker : workers)
+            worker.join();
+
+        if (failed)
+        {
+            std::cerr << "A request failed" << std::endl;
+            return 1;
+        }
+
+        std::vector<uint64_t> all;
+        for (const auto& connectionLatencies : latencies)
+            all.insert(all.end(), connectionLatencies.begin(), connectionLatencies.end());
+        std::ranges::sort(all);
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << all.size() << " requests over " << connections << " connections in " << seconds << " s, "
+                  << static_cast<double>(all.size()) / static_cast<double>(std::max<size_t>(seconds, 1)) << " QPS" << std::endl
+                  << "latency us: p50 " << percentile(all, 0.50) << ", p90 " << percentile(all, 0.90)
+                  << ", p99 " << percentile(all, 0.99) << ", max " << percentile(all, 1.0) << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "yomitan_dictionary_builder/lookup/lookup_server.h"
+
+#include <csignal>
+#include <iostream>
+#include <string_view>
+
+namespace
+{
+    Lookup::Server* runningServer = nullptr;
+
+    void handleSignal(int)
+    {
+        if (runningServer)
+            runningServer->stop();
+    }
+
+    void printUsage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " --index <lookup index> [--socket <path>] [--http <port>]" << std::endl;
+    }
+}
+
+
+int main(const int argc, char* argv[])
+{
+    std::filesystem::path indexPath;
+    std::optional<std::filesystem::path> socketPath;
+    std::optional<uint16_t> httpPort;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view argument = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (argument == "--index" && hasValue)
+                indexPath = argv[++i];
+            else if (argument == "--socket" && hasValue)
+                socketPath = argv[++i];
+            else if (argument == "--http" && hasValue)
+                httpPort = static_cast<uint16_t>(std::stoul(argv[++i]));
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (indexPath.empty() || (!socketPath.has_value() && !httpPort.has_value()))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        const LookupIndexReader index(indexPath);
+        Lookup::Server server(index);
+
+        if (socketPath.has_value() && !server.listenUnix(socketPath.value()))
+            return 1;
+        if (httpPort.has_value() && !server.listenHttp(httpPort.value()))
+            return 1;
+
+        std::cout << "Serving " << index.getKeyCount() << " keys and " << index.getRecordCount() << " records from "
+                  << indexPath.string() << std::endl;
+        if (socketPath.has_value())
+            std::cout << "Socket: " << socketPath->string() << std::endl;
+        if (httpPort.has_value())
+            std::cout << "HTTP: http://127.0.0.1:" << server.getHttpPort() << "/lookup?q=" << std::endl;
+
+        runningServer = &server;
+        std::signal(SIGINT, handleSignal);
+        std::signal(SIGTERM, handleSignal);
+        std::signal(SIGPIPE, SIG_IGN);
+
+        server.run();
+        runningServer = nullptr;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}